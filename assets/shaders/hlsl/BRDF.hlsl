@@ -9,6 +9,7 @@
 #include "LightingUtil.hlsli"
 #include "BRDF.hlsli"
 #include "Shadow.hlsli"
+#include "SphericalHarmonics.hlsli"
 
 ConstantBuffer<ConstantBuffer_Pass>						cb_Pass					: register(b0);
 
@@ -93,7 +94,9 @@ HDR_FORMAT PS(VertexOut pin) : SV_Target {
 	const float3 kS = FresnelSchlickRoughness(saturate(dot(normalW, viewW)), fresnelR0, roughness);
 	const float3 kD = 1.f - kS;
 
-	const float3 diffIrrad = gi_DiffuseIrrad.SampleLevel(gsamLinearClamp, normalW, 0).rgb;
+	const float3 diffIrrad = cb_Pass.IrradianceSHEnabled ?
+		SphericalHarmonics::EvaluateIrradiance(cb_Pass.IrradianceSH, normalW) :
+		gi_DiffuseIrrad.SampleLevel(gsamLinearClamp, normalW, 0).rgb;
 	const float3 diffuse = diffIrrad * albedo.rgb;
 
 	const float aoCoeiff = gi_AOCoeiff.SampleLevel(gsamLinearClamp, pin.TexC, 0);
@@ -19,6 +19,25 @@ uint3 Load3x32BitIndices(uint offsetBytes, uint instID, ByteAddressBuffer indice
 	return indices.Load3(offsetBytes);
 }
 
+uint3 Load3x16BitIndices(uint offsetBytes, uint instID, ByteAddressBuffer indices) {
+	// Byte address buffer loads must be aligned to 4 bytes, so read the two dwords that hold the three indices.
+	const uint dwordAlignedOffset = offsetBytes & ~3;
+	const uint2 four16BitIndices = indices.Load2(dwordAlignedOffset);
+
+	if (dwordAlignedOffset == offsetBytes) {
+		return uint3(
+			four16BitIndices.x & 0xffff,
+			four16BitIndices.x >> 16,
+			four16BitIndices.y & 0xffff);
+	}
+	else {
+		return uint3(
+			four16BitIndices.x >> 16,
+			four16BitIndices.y & 0xffff,
+			four16BitIndices.y >> 16);
+	}
+}
+
 // Retrieve hit world position.
 float3 HitWorldPosition() {
 	return WorldRayOrigin() + RayTCurrent() * WorldRayDirection();
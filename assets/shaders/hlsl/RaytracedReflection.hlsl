@@ -24,6 +24,7 @@
 
 #include "DXR_ShadingHelpers.hlsli"
 #include "Random.hlsli"
+#include "SphericalHarmonics.hlsli"
 
 typedef BuiltInTriangleIntersectionAttributes Attributes;
 
@@ -53,7 +54,11 @@ ConstantBuffer<ConstantBuffer_Object>					lcb_Obj							: register(b0, space1);
 ConstantBuffer<ConstantBuffer_Material>					lcb_Mat							: register(b1, space1);
 
 StructuredBuffer<Vertex>								lsb_Vertices					: register(t0, space1);
-StructuredBuffer<uint>									lsb_Indices						: register(t1, space1);
+ByteAddressBuffer										lab_Indices						: register(t1, space1);
+
+cbuffer lcbRootConstants : register(b2, space1) {
+	uint	lgIndexStride;
+}
 
 struct RayPayload {
 	float4	Irrad;
@@ -116,7 +121,10 @@ void RadianceRayGen() {
 [shader("closesthit")]
 void RadianceClosestHit(inout RayPayload payload, Attributes attr) {
 	const uint startIndex = PrimitiveIndex() * 3;
-	const uint3 indices = { lsb_Indices[startIndex], lsb_Indices[startIndex + 1], lsb_Indices[startIndex + 2] };
+	
+	uint3 indices;
+	if (lgIndexStride == 2) indices = Load3x16BitIndices(startIndex * 2, 0, lab_Indices);
+	else indices = Load3x32BitIndices(startIndex * 4, 0, lab_Indices);
 
 	Vertex vertices[3] = {
 		lsb_Vertices[indices[0]],
@@ -187,7 +195,9 @@ void RadianceClosestHit(inout RayPayload payload, Attributes attr) {
 
 	const float3 radiance = max(ComputeBRDF(cb_Pass.Lights, mat, hitPosition, normalW, viewW, shadowFactor, cb_Pass.LightCount), (float3)0);
 
-	const float3 diffIrradSamp = gi_DiffuseIrrad.SampleLevel(gsamLinearClamp, normalW, 0).xyz;
+	const float3 diffIrradSamp = cb_Pass.IrradianceSHEnabled ?
+		SphericalHarmonics::EvaluateIrradiance(cb_Pass.IrradianceSH, normalW) :
+		gi_DiffuseIrrad.SampleLevel(gsamLinearClamp, normalW, 0).xyz;
 	const float3 diffuseIrradiance = diffIrradSamp * albedo.rgb;
 
 	const float3 reflectedW = reflect(fromEye, normalW);
@@ -0,0 +1,24 @@
+#ifndef __SPHERICALHARMONICS_HLSLI__
+#define __SPHERICALHARMONICS_HLSLI__
+
+namespace SphericalHarmonics {
+	// Evaluates irradiance over pi from the nine coefficients SphericalHarmonics::ConvolveIrradiance
+	// produces; the w components are unused.
+	float3 EvaluateIrradiance(float4 sh[9], float3 n) {
+		float3 result = sh[0].rgb * 0.282095f;
+
+		result += sh[1].rgb * (0.488603f * n.y);
+		result += sh[2].rgb * (0.488603f * n.z);
+		result += sh[3].rgb * (0.488603f * n.x);
+
+		result += sh[4].rgb * (1.092548f * n.x * n.y);
+		result += sh[5].rgb * (1.092548f * n.y * n.z);
+		result += sh[6].rgb * (0.315392f * (3.f * n.z * n.z - 1.f));
+		result += sh[7].rgb * (1.092548f * n.x * n.z);
+		result += sh[8].rgb * (0.546274f * (n.x * n.x - n.y * n.y));
+
+		return max(result, (float3)0.f);
+	}
+}
+
+#endif // __SPHERICALHARMONICS_HLSLI__
\ No newline at end of file
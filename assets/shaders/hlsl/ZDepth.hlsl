@@ -21,6 +21,7 @@ Shadow_ZDepth_RootConstants(b3)
 Texture2D gi_TexMaps[NUM_TEXTURE_MAPS] : register(t0);
 
 VERTEX_IN
+POSITION_VERTEX_IN
 
 struct VertexOut {
 	float4	PosW		: SV_POSITION;
@@ -44,6 +45,16 @@ VertexOut VS(VertexIn vin) {
 	return vout;
 }
 
+// Reads the quantized position-only stream. It carries no texture coordinates, so alpha-tested
+// materials are drawn through VS with the PS compiled under ALPHA_TEST instead.
+VertexOut VS_Quantized(PositionVertexIn vin) {
+	VertexOut vout = (VertexOut)0;
+
+	vout.PosW = mul(vin.PosQ, cb_Obj.QuantizedWorld);
+
+	return vout;
+}
+
 float4x4 GetViewProjMatrix(in Light light, in uint face) {
 	switch (face) {
 	case 0: return light.Mat0;
@@ -56,7 +67,7 @@ float4x4 GetViewProjMatrix(in Light light, in uint face) {
 	}
 }
 
-[maxvertexcount(18)]
+[maxvertexcount(3)]
 void GS(triangle VertexOut gin[3], inout TriangleStream<GeoOut> triStream) {
 	GeoOut gout = (GeoOut)0;
 	
@@ -76,21 +87,17 @@ void GS(triangle VertexOut gin[3], inout TriangleStream<GeoOut> triStream) {
 	}
 	// Point light or Spot light
 	else {
-		[loop]
-		for (uint face = 0; face < 6; ++face) {
-			gout.ArrayIndex = face;
-
-			const float4x4 viewProj = GetViewProjMatrix(light, face);
+		// Each cube face is drawn separately with its own caster list.
+		gout.ArrayIndex = gFaceIndex;
 
-			[unroll]
-			for (uint i = 0; i < 3; ++i) {				
-				gout.PosH = mul(gin[i].PosW, viewProj);
-				gout.TexC = gin[i].TexC;
+		const float4x4 viewProj = GetViewProjMatrix(light, gFaceIndex);
 
-				triStream.Append(gout);
-			}
+		[unroll]
+		for (uint i = 0; i < 3; ++i) {				
+			gout.PosH = mul(gin[i].PosW, viewProj);
+			gout.TexC = gin[i].TexC;
 
-			triStream.RestartStrip();
+			triStream.Append(gout);
 		}
 	}	
 }
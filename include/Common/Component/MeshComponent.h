@@ -19,6 +19,7 @@ public:
 
 	void SetVisibility(BOOL visible);
 	void SetPickable(BOOL pickable);
+	void SetOccluder(BOOL occluder);
 
 private:
 	void* mModel;
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <Windows.h>
+
+// Deterministic checks of the CPU-side engine code, run instead of the game with -selfcheck on the
+// command line. They need neither a window nor a GPU. Every check runs even if an earlier one failed;
+// failures are logged and the result tells whether all of them passed.
+namespace SelfCheck {
+	BOOL Run();
+}
\ No newline at end of file
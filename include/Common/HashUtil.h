@@ -1,5 +1,10 @@
 #pragma once
 
+#include <Windows.h>
+
 namespace hu {
 	size_t hash_combine(size_t seed, size_t value);
+
+	// 64-bit MurmurHash2 (MurmurHash64A) over a block of memory; stable across runs, used for content hashes.
+	UINT64 hash_bytes(const void* data, size_t size, UINT64 seed = 0);
 }
\ No newline at end of file
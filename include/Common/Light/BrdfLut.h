@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <DirectXMath.h>
+
+#include "Common/Texture/DdsFile.h"
+#include "Common/Util/BakeManifest.h"
+
+namespace BrdfLutFormat {
+	enum Type {
+		E_R16G16_Float = 0,
+		// A quarter of the float footprint; the quantization is below what the scale and bias show.
+		E_R8G8_Unorm
+	};
+}
+
+namespace BrdfLutMethod {
+	enum Type {
+		// Hammersley importance sampling of the GGX lobe.
+		E_Integrated = 0,
+		// Karis' analytic fit of the integral; cheap enough for a few texels per axis.
+		E_AnalyticFit
+	};
+}
+
+// Generates the second term of the split-sum approximation on the CPU: the scale A and bias B of
+// F0 in the directional albedo of GGX with Schlick's Fresnel, over NdotV along u and roughness along
+// v, at texel centers. Rows are generated in parallel, and each texel depends only on its own
+// coordinates, so the output is the same for any thread count.
+// With energy compensation, the third channel holds 1 - (A + B), the energy that single scattering
+// loses and that multiple scattering returns; the texture then has four channels.
+namespace BrdfLut {
+	// Bumped whenever the output of the same settings changes.
+	static const UINT Version = 1;
+
+	struct Settings {
+		UINT Size = 256;
+		UINT SampleCount = 1024;
+		BrdfLutFormat::Type Format = BrdfLutFormat::E_R16G16_Float;
+		BrdfLutMethod::Type Method = BrdfLutMethod::E_Integrated;
+		// Off by default, since the lighting shaders only read A and B.
+		BOOL EnergyCompensation = FALSE;
+	};
+
+	DXGI_FORMAT OutputFormat(const Settings& settings);
+
+	DirectX::XMFLOAT2 Integrate(FLOAT NdotV, FLOAT roughness, UINT sampleCount);
+	DirectX::XMFLOAT2 AnalyticFit(FLOAT NdotV, FLOAT roughness);
+
+	// Size x Size texels of OutputFormat, tightly packed, row after row.
+	BOOL Generate(const Settings& settings, UINT64 numThreads, std::vector<BYTE>& texels);
+
+	void DescribeBake(const Settings& settings, BakeManifest& manifest);
+
+	// Generates the LUT and saves it as a DDS to path, then the manifest to manifestPath.
+	BOOL Bake(const std::string& path, const std::string& manifestPath, const Settings& settings, UINT64 numThreads);
+
+	BOOL IsBakeCurrent(const std::string& manifestPath, const Settings& settings);
+}
\ No newline at end of file
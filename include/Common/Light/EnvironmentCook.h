@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+
+#include "Common/Texture/CubeMapConverter.h"
+#include "BrdfLut.h"
+#include "EnvironmentPrefilter.h"
+
+// Cook step of the image-based lighting inputs, run before the game with -cook on the command line.
+// It bakes whatever is missing or stale next to the environment and leaves the rest; the renderer
+// only loads the results and never bakes them itself.
+namespace EnvironmentCook {
+	static const UINT PrefilteredMipLevels = 5;
+
+	// Where the bakes go; the renderer loads the prefiltered environment and the LUT from here.
+	static const CHAR* const PrefilteredEnvironmentPaths[PrefilteredMipLevels] = {
+		"./../../assets/textures/gen_prefiltered_environment_cubemap_ml0.dds",
+		"./../../assets/textures/gen_prefiltered_environment_cubemap_ml1.dds",
+		"./../../assets/textures/gen_prefiltered_environment_cubemap_ml2.dds",
+		"./../../assets/textures/gen_prefiltered_environment_cubemap_ml3.dds",
+		"./../../assets/textures/gen_prefiltered_environment_cubemap_ml4.dds"
+	};
+	static const CHAR* const PrefilteredEnvironmentManifestPath = "./../../assets/textures/gen_prefiltered_environment.manifest";
+	static const CHAR* const EnvironmentCubeMapPath = "./../../assets/textures/gen_environment_cubemap.dds";
+	static const CHAR* const EnvironmentCubeMapManifestPath = "./../../assets/textures/gen_environment_cubemap.manifest";
+	static const CHAR* const IntegratedBrdfMapPath = "./../../assets/textures/gen_integrated_brdf_map.dds";
+	static const CHAR* const IntegratedBrdfManifestPath = "./../../assets/textures/gen_integrated_brdf_map.manifest";
+
+	struct Settings {
+		// Cube map of the environment with a full mip chain per face, resampled on the CPU.
+		UINT CubeMapSize = 1024;
+		ResampleFilter::Type CubeMapFilter = ResampleFilter::E_Cubic;
+
+		EnvironmentPrefilter::Settings Prefilter;
+		BrdfLut::Settings BrdfLut;
+	};
+
+	// Cooks the DDS environment at path into its cube map and prefiltered mips, and the BRDF LUT,
+	// which does not depend on it. A Radiance or OpenEXR source is first cooked into the DDS next
+	// to it, which is the path the renderer is then given.
+	BOOL Cook(const std::string& environment, const Settings& settings, UINT64 numThreads);
+}
\ No newline at end of file
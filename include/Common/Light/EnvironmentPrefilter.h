@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <DirectXMath.h>
+
+#include "Common/Texture/DdsFile.h"
+#include "Common/Util/BakeManifest.h"
+
+// Offline baker for the prefiltered environment of split-sum specular image-based lighting. Each
+// mip convolves an equirectangular environment with the GGX lobe of its roughness, assuming the
+// view along the normal. The lobe is importance sampled with a Hammersley set shared by every
+// texel, and each sample reads the source mip whose texels cover about as much solid angle as the
+// sample does, which removes the fireflies of sparse sampling without raising the sample count.
+// Rows are prefiltered in parallel on a TaskQueue.
+// Bakes come with a manifest of the source content hash and these settings, so the renderer only
+// loads outputs that match the environment it was given and never bakes at runtime.
+namespace EnvironmentPrefilter {
+	// Bumped whenever the output of the same source and settings changes.
+	static const UINT Version = 1;
+
+	struct Settings {
+		// Extent of mip 0; each mip halves it.
+		UINT Width = 4096;
+		UINT Height = 2048;
+		UINT MipLevels = 5;
+		UINT SampleCount = 1024;
+		// Roughness of mip m is m times this, as the renderer selects the mips.
+		FLOAT RoughnessStep = 1.f / 6.f;
+	};
+
+	// Prefilters mip 0 of an equirectangular map into settings.MipLevels levels of linear RGBA,
+	// finest first.
+	BOOL Prefilter(
+		const DdsFile::Subresource& environment,
+		DXGI_FORMAT format,
+		const Settings& settings,
+		UINT64 numThreads,
+		std::vector<std::vector<DirectX::XMFLOAT4>>& mips);
+
+	void DescribeBake(UINT64 sourceHash, const Settings& settings, BakeManifest& manifest);
+
+	// Prefilters the equirectangular map at sourcePath and saves each mip as its own
+	// R16G16B16A16_FLOAT DDS to outputPaths, then the manifest to manifestPath.
+	BOOL Bake(
+		const std::string& sourcePath,
+		const std::vector<std::string>& outputPaths,
+		const std::string& manifestPath,
+		const Settings& settings,
+		UINT64 numThreads);
+
+	// Whether the manifest at manifestPath records a bake of the current content of sourcePath with
+	// these settings.
+	BOOL IsBakeCurrent(const std::string& sourcePath, const std::string& manifestPath, const Settings& settings);
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include "Common/Texture/DdsFile.h"
+
+// Order-2 spherical harmonics of RGB functions on the sphere, for diffuse image-based lighting.
+// The radiance of an environment is projected onto the nine real basis functions, each texel
+// weighted by the solid angle it covers, and convolved with the clamped cosine. The result is
+// 27 floats that shaders evaluate analytically instead of sampling an irradiance cube map.
+// Equirectangular maps follow the layout of Equirectangular.hlsli, and cube maps the Direct3D face
+// order, so the coefficients line up with the maps the IrradianceMap pass renders.
+namespace SphericalHarmonics {
+	static const UINT CoefficientCount = 9;
+
+	// Width in bands of the Hann window ConvolveIrradiance applies by default.
+	static const FLOAT DefaultWindowWidth = 5.f;
+
+	// Ordered by band: l = 0, then l = 1 with m = -1, 0, 1, then l = 2 with m = -2 to 2.
+	struct SH9 {
+		DirectX::XMFLOAT3 Coefficients[CoefficientCount];
+	};
+
+	void EvaluateBasis(const DirectX::XMFLOAT3& dir, FLOAT basis[CoefficientCount]);
+
+	BOOL ProjectEquirectangular(const DdsFile::Subresource& map, DXGI_FORMAT format, SH9& radiance);
+	// Projects mip 0 of the first six slices.
+	BOOL ProjectCubeMap(const DdsFile& cubeMap, SH9& radiance);
+	// ProjectCubeMap for cube maps and ProjectEquirectangular on mip 0 of anything else.
+	BOOL ProjectEnvironment(const DdsFile& environment, SH9& radiance);
+
+	// Gives the irradiance over pi: the radiance a white Lambertian surface reflects, which is what
+	// the diffuse irradiance map stores. The Hann window damps the higher bands, which otherwise ring
+	// into negative values opposite bright sources; a width of 0 leaves them as they are.
+	void ConvolveIrradiance(const SH9& radiance, FLOAT windowWidth, SH9& irradiance);
+
+	// Value of the function in direction dir, which must be normalized. On the output of
+	// ConvolveIrradiance it is the irradiance over pi of a surface facing dir.
+	DirectX::XMFLOAT3 Evaluate(const SH9& sh, const DirectX::XMFLOAT3& dir);
+}
\ No newline at end of file
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <DirectXCollision.h>
+
+#include "Common/Util/MappedFile.h"
+#include "Mesh.h"
+#include "VertexFormat.h"
+
+// Binary image of an imported mesh that can be used straight from a mapped file.
+// The header is followed by 16-byte aligned sections: full-precision vertex stream, position-only
+// stream for depth passes (empty if quantizing would lose too much), index stream, submesh table,
+// meshlet table with its vertex and triangle lists, LOD table, material table, triangle BVH and the
+// list of source files the image depends on. Quantized positions are relative to the mesh AABB.
+// Indices are stored compressed with IndexCodec and decoded to 16 or 32 bits into a buffer the image
+// owns when it is opened, so only the vertex streams and tables are read in place. The content hash
+// covers every byte after the header and is only checked on request; the source hash and importer
+// version are recorded for the caller to decide whether the image is stale.
+class CookedMesh {
+public:
+	static const UINT FileMagic = 0x4853454D; // "MESH"
+	static const UINT FormatVersion = 8;
+	static const UINT64 SectionAlignment = 16;
+
+	struct Section {
+		UINT64 Offset;
+		UINT64 Size;
+	};
+
+	struct Header {
+		UINT Magic;
+		UINT FormatVersion;
+		UINT ImporterVersion;
+		UINT VertexStride;
+
+		UINT64 SourceHash;
+		UINT64 ContentHash;
+		UINT64 FileSize;
+
+		UINT VertexCount;
+		UINT IndexCount;
+		// Submeshes per level of detail.
+		UINT SubmeshCount;
+		UINT DependencyCount;
+		// Size of a decoded index, 2 or 4 bytes.
+		UINT IndexStride;
+		UINT MeshletCount;
+		UINT LodCount;
+		UINT MaterialCount;
+
+		DirectX::XMFLOAT3 BoundsMin;
+		DirectX::XMFLOAT3 BoundsMax;
+
+		Section Vertices;
+		Section Positions;
+		Section Indices;
+		Section Submeshes;
+		Section Meshlets;
+		Section MeshletVertices;
+		Section MeshletTriangles;
+		Section Lods;
+		Section Materials;
+		Section Bvh;
+		Section Dependencies;
+	};
+
+	struct Submesh {
+		UINT IndexCount;
+		UINT StartIndexLocation;
+		INT BaseVertexLocation;
+		UINT MaterialIndex;
+
+		DirectX::XMFLOAT3 BoundsMin;
+		DirectX::XMFLOAT3 BoundsMax;
+	};
+
+public:
+	CookedMesh() = default;
+	virtual ~CookedMesh() = default;
+
+	CookedMesh(const CookedMesh&) = delete;
+	CookedMesh& operator=(const CookedMesh&) = delete;
+
+public:
+	__forceinline BOOL IsValid() const;
+
+	__forceinline UINT ImporterVersion() const;
+	__forceinline UINT64 SourceHash() const;
+	__forceinline UINT64 ContentHash() const;
+
+	__forceinline const Vertex* Vertices() const;
+	__forceinline UINT VertexCount() const;
+	__forceinline UINT VertexBufferByteSize() const;
+
+	// Stored as VertexFormat::PositionOnly(); PositionBufferByteSize() is zero if the stream was left out.
+	__forceinline const BYTE* Positions() const;
+	__forceinline UINT PositionBufferByteSize() const;
+
+	VertexQuantization Quantization() const;
+
+	// Decoded index buffer of IndexStride()-byte indices, relative to each submesh's base vertex.
+	// The full-detail level comes first; the coarser levels of detail follow it.
+	__forceinline const BYTE* IndexData() const;
+	__forceinline UINT IndexStride() const;
+	__forceinline UINT IndexCount() const;
+	__forceinline UINT IndexBufferByteSize() const;
+
+	// Material ranges of a level of detail, sorted by material; SubmeshCount() of them per level.
+	__forceinline const Submesh* Submeshes(UINT lod = 0) const;
+	__forceinline UINT SubmeshCount() const;
+	__forceinline UINT MaterialCount() const;
+
+	__forceinline const Meshlet* Meshlets() const;
+	__forceinline UINT MeshletCount() const;
+	__forceinline const UINT* MeshletVertices() const;
+	__forceinline const BYTE* MeshletTriangles() const;
+
+	// Always holds at least the full-detail level.
+	__forceinline const MeshLod* Lods() const;
+	__forceinline UINT LodCount() const;
+
+	DirectX::BoundingBox Bounds() const;
+
+public:
+	// Builds the image in memory. Until it is saved and reopened, the accessors point into that buffer.
+	// Every subset of the mesh becomes a submesh that refers to its entry in materials.
+	// The position-only stream is written only if positionStream is set.
+	// Meshes whose vertices fit in 16 bits get 16-bit indices, larger ones 32-bit indices.
+	BOOL Cook(
+		const Mesh& mesh,
+		const std::vector<Material>& materials,
+		BOOL positionStream,
+		UINT importerVersion,
+		UINT64 sourceHash,
+		const std::vector<std::string>& dependencies);
+	BOOL Save(const std::string& path) const;
+
+	// Maps the file and validates its layout. The content hash is left to VerifyContent.
+	BOOL Open(const std::string& path);
+	void Close();
+
+	// Hashes every byte after the header and compares the result with the recorded content hash.
+	BOOL VerifyContent() const;
+
+	BOOL LoadMaterials(std::vector<Material>& materials) const;
+	BOOL LoadBvh(TriangleBvh& bvh) const;
+	BOOL LoadDependencies(std::vector<std::string>& dependencies) const;
+
+private:
+	BOOL Validate(const BYTE* data, UINT64 size) const;
+	BOOL DecodeIndices();
+
+	template <typename T>
+	__forceinline const T* SectionData(const Section& section) const;
+
+private:
+	MappedFile mFile;
+	std::vector<BYTE> mImage;
+	std::vector<BYTE> mIndices;
+
+	const BYTE* mData = nullptr;
+	const Header* mHeader = nullptr;
+};
+
+#include "CookedMesh.inl"
\ No newline at end of file
@@ -0,0 +1,97 @@
+#ifndef __COOKEDMESH_INL__
+#define __COOKEDMESH_INL__
+
+BOOL CookedMesh::IsValid() const {
+	return mHeader != nullptr;
+}
+
+UINT CookedMesh::ImporterVersion() const {
+	return mHeader->ImporterVersion;
+}
+
+UINT64 CookedMesh::SourceHash() const {
+	return mHeader->SourceHash;
+}
+
+UINT64 CookedMesh::ContentHash() const {
+	return mHeader->ContentHash;
+}
+
+const Vertex* CookedMesh::Vertices() const {
+	return SectionData<Vertex>(mHeader->Vertices);
+}
+
+UINT CookedMesh::VertexCount() const {
+	return mHeader->VertexCount;
+}
+
+UINT CookedMesh::VertexBufferByteSize() const {
+	return static_cast<UINT>(mHeader->Vertices.Size);
+}
+
+const BYTE* CookedMesh::Positions() const {
+	return SectionData<BYTE>(mHeader->Positions);
+}
+
+UINT CookedMesh::PositionBufferByteSize() const {
+	return static_cast<UINT>(mHeader->Positions.Size);
+}
+
+const BYTE* CookedMesh::IndexData() const {
+	return mIndices.data();
+}
+
+UINT CookedMesh::IndexStride() const {
+	return mHeader->IndexStride;
+}
+
+UINT CookedMesh::IndexCount() const {
+	return mHeader->IndexCount;
+}
+
+UINT CookedMesh::IndexBufferByteSize() const {
+	return mHeader->IndexCount * mHeader->IndexStride;
+}
+
+const CookedMesh::Submesh* CookedMesh::Submeshes(UINT lod) const {
+	return SectionData<Submesh>(mHeader->Submeshes) + static_cast<size_t>(lod) * mHeader->SubmeshCount;
+}
+
+UINT CookedMesh::SubmeshCount() const {
+	return mHeader->SubmeshCount;
+}
+
+UINT CookedMesh::MaterialCount() const {
+	return mHeader->MaterialCount;
+}
+
+const Meshlet* CookedMesh::Meshlets() const {
+	return SectionData<Meshlet>(mHeader->Meshlets);
+}
+
+UINT CookedMesh::MeshletCount() const {
+	return mHeader->MeshletCount;
+}
+
+const UINT* CookedMesh::MeshletVertices() const {
+	return SectionData<UINT>(mHeader->MeshletVertices);
+}
+
+const BYTE* CookedMesh::MeshletTriangles() const {
+	return SectionData<BYTE>(mHeader->MeshletTriangles);
+}
+
+const MeshLod* CookedMesh::Lods() const {
+	return SectionData<MeshLod>(mHeader->Lods);
+}
+
+UINT CookedMesh::LodCount() const {
+	return mHeader->LodCount;
+}
+
+template <typename T>
+const T* CookedMesh::SectionData(const Section& section) const {
+	return reinterpret_cast<const T*>(mData + section.Offset);
+}
+
+#endif // __COOKEDMESH_INL__
\ No newline at end of file
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Mesh.h"
+
+class MappedFile;
+
+// glTF 2.0 reader for binary (.glb) and JSON (.gltf) files with external buffers. The files are
+// memory-mapped and the JSON is indexed without copying its strings. Vertex and index accessors
+// are read in place when they already match the engine layout (interleaved Vertex attributes,
+// 32-bit indices); anything else is gathered into copies owned by the scene. Views returned by
+// the scene stay valid until it is closed.
+// Only triangle lists are imported; sparse accessors and base64 data URIs are not supported.
+class GltfScene {
+public:
+	static const UINT GlbMagic = 0x46546C67;		// "glTF"
+	static const UINT GlbVersion = 2;
+	static const UINT JsonChunkType = 0x4E4F534A;	// "JSON"
+	static const UINT BinChunkType = 0x004E4942;	// "BIN\0"
+	// Guards the recursive JSON parser against malicious nesting.
+	static const UINT MaxJsonDepth = 64;
+
+public:
+	struct Primitive {
+		const Vertex* Vertices;
+		UINT VertexCount;
+		const UINT* Indices;
+		UINT IndexCount;
+		// Index into Materials, or -1 for the default material.
+		INT Material;
+		// Whether the views point into the mapped file rather than into gathered copies.
+		BOOL VerticesInPlace;
+		BOOL IndicesInPlace;
+	};
+
+	struct MeshInfo {
+		std::string Name;
+		UINT FirstPrimitive;
+		UINT PrimitiveCount;
+	};
+
+	struct Node {
+		std::string Name;
+		INT Parent;
+		// Index into Meshes, or -1 for transform-only nodes.
+		INT Mesh;
+		DirectX::XMFLOAT4X4 Local;
+		DirectX::XMFLOAT4X4 World;
+		// Whether the node is reachable from the roots of the default scene.
+		BOOL InScene;
+	};
+
+public:
+	GltfScene();
+	virtual ~GltfScene();
+
+	GltfScene(const GltfScene&) = delete;
+	GltfScene& operator=(const GltfScene&) = delete;
+
+public:
+	__forceinline const std::vector<Primitive>& Primitives() const;
+	__forceinline const std::vector<MeshInfo>& Meshes() const;
+	__forceinline const std::vector<Node>& Nodes() const;
+	__forceinline const std::vector<Material>& Materials() const;
+	// External buffer files, relative to the directory of the opened file.
+	__forceinline const std::vector<std::string>& Buffers() const;
+
+public:
+	BOOL Open(const std::string& path);
+	void Close();
+
+private:
+	class JsonDocument;
+	struct JsonValue;
+	struct AccessorView;
+
+	BOOL ParseDocument(const BYTE* data, UINT64 size);
+	BOOL LoadBuffers();
+	BOOL LoadMeshes();
+	BOOL LoadPrimitive(const JsonValue& primitive, Primitive& result);
+	BOOL LoadNodes();
+	void LoadMaterials();
+
+	BOOL GetAccessor(INT index, AccessorView& view) const;
+
+private:
+	std::unique_ptr<JsonDocument> mJson;
+	std::string mDirectory;
+
+	std::vector<std::unique_ptr<MappedFile>> mFiles;
+	// Embedded BIN chunk of a .glb file.
+	const BYTE* mBinChunk = nullptr;
+	UINT64 mBinChunkSize = 0;
+
+	struct BufferRange {
+		const BYTE* Data;
+		UINT64 Size;
+	};
+	std::vector<BufferRange> mBufferRanges;
+	std::vector<std::string> mBuffers;
+
+	// Copies for accessors that could not be used in place.
+	std::vector<std::vector<Vertex>> mVertexCopies;
+	std::vector<std::vector<UINT>> mIndexCopies;
+
+	std::vector<Primitive> mPrimitives;
+	std::vector<MeshInfo> mMeshes;
+	std::vector<Node> mNodes;
+	std::vector<Material> mMaterials;
+};
+
+#include "GltfScene.inl"
\ No newline at end of file
@@ -0,0 +1,24 @@
+#ifndef __GLTFSCENE_INL__
+#define __GLTFSCENE_INL__
+
+const std::vector<GltfScene::Primitive>& GltfScene::Primitives() const {
+	return mPrimitives;
+}
+
+const std::vector<GltfScene::MeshInfo>& GltfScene::Meshes() const {
+	return mMeshes;
+}
+
+const std::vector<GltfScene::Node>& GltfScene::Nodes() const {
+	return mNodes;
+}
+
+const std::vector<Material>& GltfScene::Materials() const {
+	return mMaterials;
+}
+
+const std::vector<std::string>& GltfScene::Buffers() const {
+	return mBuffers;
+}
+
+#endif // __GLTFSCENE_INL__
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vector>
+
+#include <Windows.h>
+
+// Index buffer helpers for the cooker. Meshes whose vertices fit in 16 bits get 16-bit indices,
+// larger meshes 32-bit indices. Indices are stored compressed: every index is coded relative to the
+// next vertex that has not been referenced yet, which is zero for new vertices and small for
+// vertices shared with recent triangles once the buffer is in vertex cache and fetch order.
+// Codes are zigzag-encoded and written as LEB128 varints.
+namespace IndexCodec {
+	static const UINT MaxVertices16 = 65536;
+
+	__forceinline BOOL Fits16Bit(UINT vertexCount);
+
+	void Encode(const UINT* indices, UINT count, std::vector<BYTE>& encoded);
+
+	// Both fail if the stream is truncated, holds other than count indices, or decodes an
+	// index that does not fit the destination type.
+	BOOL Decode(const BYTE* encoded, UINT64 size, UINT count, UINT* indices);
+	BOOL Decode(const BYTE* encoded, UINT64 size, UINT count, USHORT* indices);
+}
+
+#include "IndexCodec.inl"
\ No newline at end of file
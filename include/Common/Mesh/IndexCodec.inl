@@ -0,0 +1,8 @@
+#ifndef __INDEXCODEC_INL__
+#define __INDEXCODEC_INL__
+
+BOOL IndexCodec::Fits16Bit(UINT vertexCount) {
+	return vertexCount <= MaxVertices16;
+}
+
+#endif // __INDEXCODEC_INL__
\ No newline at end of file
@@ -5,11 +5,54 @@
 
 #include "Common/Helper/MathHelper.h"
 #include "Vertex.h"
+#include "TriangleBvh.h"
+#include "MeshletBuilder.h"
+
+// Level of detail as a range of the index buffer; level 0 is the full-detail mesh.
+struct MeshLod {
+	UINT StartIndexLocation;
+	UINT IndexCount;
+	// Geometric error of the level in the units of the mesh's local space.
+	FLOAT Error;
+};
+
+// Run of the index buffer drawn with one material. Importers sort the triangles by material and
+// merge them into one subset per material, so a mesh needs one draw per subset.
+struct MeshSubset {
+	UINT StartIndexLocation;
+	UINT IndexCount;
+	// Index into the material list returned with the mesh.
+	UINT MaterialIndex;
+	// Run of Mesh::Meshlets built from the subset's triangles; meshlets never mix materials.
+	UINT FirstMeshlet;
+	UINT MeshletCount;
+};
 
 struct Mesh {
-	std::unordered_map<Vertex, UINT>	UniqueVertices;
 	std::vector<Vertex>					Vertices;
 	std::vector<UINT>					Indices;
+
+	// Material ranges of Indices, sorted by material. A mesh without subsets is drawn as a
+	// single range with the first material.
+	std::vector<MeshSubset>				Subsets;
+
+	// Built at import time for exact CPU ray queries such as picking.
+	TriangleBvh							Bvh;
+
+	// Clusters of the index buffer for per-cluster culling. Each meshlet owns a run of
+	// MeshletVertices (indices into Vertices) and a run of MeshletTriangles (three
+	// meshlet-local vertex indices per triangle).
+	std::vector<Meshlet>				Meshlets;
+	std::vector<UINT>					MeshletVertices;
+	std::vector<BYTE>					MeshletTriangles;
+
+	// Coarser levels of detail. Their indices are stored back to back in LodIndices, and the ranges in
+	// Lods count from the start of Indices as if both lists were one buffer.
+	std::vector<MeshLod>				Lods;
+	std::vector<UINT>					LodIndices;
+	// Material ranges of each coarser level, Subsets.size() per level in the order of Subsets. Every
+	// level keeps the indices of one subset together, so the ranges of a level cover its LOD range.
+	std::vector<MeshSubset>				LodSubsets;
 };
 
 struct Material {
@@ -22,4 +65,6 @@ struct Material {
 	DirectX::XMFLOAT4 Albedo			= { 1.f, 1.f, 1.f, 1.f };
 	FLOAT Specular						= 0.5f;
 	FLOAT Roughness						= 0.5f;
+	// Texels whose diffuse alpha falls below the cutoff are discarded, also in depth-only passes.
+	BOOL AlphaTested					= FALSE;
 };
\ No newline at end of file
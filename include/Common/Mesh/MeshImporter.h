@@ -2,8 +2,39 @@
 
 #include "Mesh.h"
 
+class CookedMesh;
+
 class MeshImporter {
 public:
-	static BOOL LoadObj(const std::string& file, Mesh& mesh, Material& mat);
-	static BOOL LoadFbx(const std::string& file);
+	// Bump whenever the importer output changes so that cooked meshes are rebuilt.
+	static const UINT Version = 7;
+
+public:
+	// Parses the file, sorts the triangles into one subset per material, optimizes each subset for
+	// the vertex cache, overdraw and vertex fetch, and builds the triangle BVH, meshlets and LOD chain.
+	// Mesh::Subsets index into the returned materials.
+	// The material libraries the file depends on are reported if requested.
+	static BOOL LoadObj(
+		const std::string& file,
+		Mesh& mesh,
+		std::vector<Material>& materials,
+		UINT64 numThreads = 1,
+		std::vector<std::string>* dependencies = nullptr);
+	// Flattens the node instances of the default scene of a .glb or .gltf file into one mesh in scene
+	// space and post-processes it like LoadObj. Primitives that need no transform are copied straight
+	// from the mapped file; primitives sharing a material end up in one subset.
+	// The external buffers the file depends on are reported if requested.
+	static BOOL LoadGltf(
+		const std::string& file,
+		Mesh& mesh,
+		std::vector<Material>& materials,
+		std::vector<std::string>* dependencies = nullptr);
+	// Maps the cooked image of the file, importing and cooking it first if it is missing or stale.
+	// The importer is selected by the file extension. The source, its dependencies and the image are
+	// only hashed when their sizes or write times differ from the stamps saved with the image.
+	static BOOL LoadCooked(const std::string& file, CookedMesh& cooked, UINT64 numThreads = 1);
+	// Loads the file through tinyobjloader. Kept to validate the native parser.
+	static BOOL LoadObjReference(const std::string& file, Mesh& mesh, std::vector<Material>& materials);
+	// Loads the file with both parsers and reports any difference in the resulting meshes.
+	static BOOL ValidateObj(const std::string& file, UINT64 numThreads = 1);
 };
\ No newline at end of file
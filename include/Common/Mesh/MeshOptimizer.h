@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+
+#include "Mesh.h"
+
+// Offline reordering passes run on imported meshes before they are cooked.
+// Importers first sort the triangles by material into subsets. The index buffer of each subset is
+// then ordered for the post-transform vertex cache (Forsyth) and split into clusters that are
+// sorted so outward-facing geometry is drawn first (Sander et al.). Finally the vertex buffer is
+// rearranged into first-use order for the vertex fetch.
+namespace MeshOptimizer {
+	// Size of the LRU cache modelled by the vertex cache ordering.
+	static const UINT OptimizerCacheSize = 32;
+	// Size of the FIFO cache used to measure the result and to find cluster boundaries.
+	static const UINT FifoCacheSize = 16;
+	// Cluster splitting may raise the ACMR of the vertex cache ordering by at most this factor.
+	static const FLOAT OverdrawThreshold = 1.05f;
+
+	struct CacheStatistics {
+		// Average cache miss ratio: transformed vertices per triangle. 0.5 is the ideal for a regular grid, 3 the worst.
+		FLOAT Acmr = 0.f;
+		// Average transform to vertex ratio: transformed vertices per referenced vertex. 1 is ideal.
+		FLOAT Atvr = 0.f;
+	};
+
+	CacheStatistics AnalyzeVertexCache(const std::vector<UINT>& indices, UINT vertexCount, UINT cacheSize = FifoCacheSize);
+
+	void OptimizeVertexCache(std::vector<UINT>& indices, UINT vertexCount);
+	// Expects indices already ordered by OptimizeVertexCache.
+	void OptimizeOverdraw(std::vector<UINT>& indices, const std::vector<Vertex>& vertices, FLOAT threshold = OverdrawThreshold);
+	// Vertices that are not referenced by any triangle are dropped.
+	void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<UINT>& indices);
+
+	// Stably sorts the triangles into one subset per material, filling Mesh::Subsets. triangleMaterials
+	// holds an index into materials for every triangle; out-of-range indices select a default material.
+	// Materials no triangle uses are dropped and the subsets refer to the compacted list.
+	void SortByMaterial(Mesh& mesh, std::vector<Material>& materials, const std::vector<UINT>& triangleMaterials);
+
+	// Runs all passes on each subset, so triangles never cross subset boundaries, and logs the cache
+	// statistics before and after.
+	BOOL Optimize(Mesh& mesh);
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+
+#include "Mesh.h"
+
+// Offline quadric error metric simplification (Garland and Heckbert) by half-edge collapses, so
+// simplified index buffers keep referring to the original vertex buffer. Every collapse is costed
+// with the area-weighted plane quadric of the vertex being removed plus a normal and texture
+// coordinate term scaled by the edge length, which keeps the attribute cost in the same units.
+// Collapses are applied in cost order in passes of independent edges. Vertices on open borders and
+// on attribute seams (several vertices at one position) are never moved, and collapses that would
+// fold a triangle or break the manifold are rejected.
+namespace MeshSimplifier {
+	// Attribute cost weights, relative to the squared position error.
+	static const FLOAT NormalWeight = 0.25f;
+	static const FLOAT TexCoordWeight = 1.f;
+	// A collapse is rejected if a remaining triangle would turn by more than acos of this.
+	static const FLOAT MinNormalCosine = 0.25f;
+
+	// Every LOD level aims for this fraction of the triangles of the previous one.
+	static const FLOAT LodReduction = 0.5f;
+	// The chain stops once a level would keep more than this fraction of the previous level,
+	static const FLOAT MinLodReduction = 0.85f;
+	// would drop below this many triangles,
+	static const UINT MinLodTriangles = 64;
+	// or would need a larger error than this, relative to the mesh extent.
+	static const FLOAT MaxLodError = 0.05f;
+	static const UINT MaxLodCount = 6;
+
+	// Largest side of the mesh AABB; relative errors are in units of it.
+	FLOAT Extent(const std::vector<Vertex>& vertices);
+
+	// Collapses edges until at most targetIndexCount indices are left or no collapse stays within
+	// targetError, relative to Extent(). Returns the geometric (position) error of the result,
+	// also relative to Extent().
+	FLOAT Simplify(
+		const std::vector<Vertex>& vertices,
+		const std::vector<UINT>& indices,
+		UINT targetIndexCount,
+		FLOAT targetError,
+		std::vector<UINT>& result,
+		BOOL lockBorder = TRUE);
+
+	// Fills Mesh::Lods, Mesh::LodIndices and Mesh::LodSubsets with a chain simplified from the
+	// full-detail index buffer one subset at a time, each level ordered for the vertex cache.
+	// Logs the triangle count and error per level.
+	BOOL BuildLods(Mesh& mesh);
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include <DirectXMath.h>
+
+#include "Vertex.h"
+
+// Cluster of at most MeshletBuilder::MaxVertices vertices and MaxTriangles triangles with the
+// bounds used to cull it on its own.
+struct Meshlet {
+	// Bounding sphere of the cluster vertices.
+	DirectX::XMFLOAT3 Center;
+	FLOAT Radius;
+
+	// Normal cone: every triangle faces away from a viewer at p when
+	// dot(normalize(ConeApex - p), ConeAxis) >= ConeCutoff. Clusters whose normals spread too far
+	// have a zero axis and a cutoff of one, so the test never passes.
+	DirectX::XMFLOAT3 ConeApex;
+	FLOAT ConeCutoff;
+	DirectX::XMFLOAT3 ConeAxis;
+
+	// Runs in the meshlet vertex list and the meshlet triangle list (in triangles).
+	UINT VertexOffset;
+	UINT VertexCount;
+	UINT TriangleOffset;
+	UINT TriangleCount;
+};
+
+// Partitions an index buffer into meshlets. Each cluster is grown from a seed triangle by
+// repeatedly adding the neighbouring triangle that brings in the fewest new vertices, with ties
+// broken towards the cluster's average normal to keep the normal cone narrow. When no neighbour
+// fits, the next unassigned triangle in index order is taken, which stays local for buffers that
+// have been ordered for the vertex cache.
+namespace MeshletBuilder {
+	static const UINT MaxVertices = 64;
+	static const UINT MaxTriangles = 124;
+	// Weight of the normal agreement against the number of new vertices when picking the next triangle.
+	static const FLOAT ConeWeight = 0.25f;
+	// Clusters whose triangle normals deviate from the axis by more than acos of this get no cone.
+	static const FLOAT MinConeCosine = 0.1f;
+
+	// Meshlet triangles are stored as three local vertex indices each, so maxVertices must not exceed 256.
+	void Build(
+		const std::vector<Vertex>& vertices,
+		const std::vector<UINT>& indices,
+		std::vector<Meshlet>& meshlets,
+		std::vector<UINT>& meshletVertices,
+		std::vector<BYTE>& meshletTriangles,
+		UINT maxVertices = MaxVertices,
+		UINT maxTriangles = MaxTriangles);
+
+	// Computes the bounding sphere and normal cone of a meshlet whose runs are already set.
+	void ComputeBounds(
+		const std::vector<Vertex>& vertices,
+		const UINT* meshletVertices,
+		const BYTE* meshletTriangles,
+		Meshlet& meshlet);
+
+	__forceinline BOOL IsBackfacing(const Meshlet& meshlet, DirectX::FXMVECTOR viewPos);
+
+	// Checks that the meshlets hold every triangle exactly once within the limits, that the spheres
+	// enclose their vertices, and that no cluster the cone test rejects from a ring of viewpoints around
+	// the mesh has a triangle facing the viewer. Logs the share of clusters culled by the cone test.
+	BOOL Validate(
+		const std::vector<Vertex>& vertices,
+		const std::vector<UINT>& indices,
+		const std::vector<Meshlet>& meshlets,
+		const std::vector<UINT>& meshletVertices,
+		const std::vector<BYTE>& meshletTriangles,
+		UINT maxVertices = MaxVertices,
+		UINT maxTriangles = MaxTriangles);
+}
+
+#include "MeshletBuilder.inl"
\ No newline at end of file
@@ -0,0 +1,9 @@
+#ifndef __MESHLETBUILDER_INL__
+#define __MESHLETBUILDER_INL__
+
+BOOL MeshletBuilder::IsBackfacing(const Meshlet& meshlet, DirectX::FXMVECTOR viewPos) {
+	const DirectX::XMVECTOR toApex = DirectX::XMVector3Normalize(DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&meshlet.ConeApex), viewPos));
+	return DirectX::XMVectorGetX(DirectX::XMVector3Dot(toApex, DirectX::XMLoadFloat3(&meshlet.ConeAxis))) >= meshlet.ConeCutoff;
+}
+
+#endif // __MESHLETBUILDER_INL__
\ No newline at end of file
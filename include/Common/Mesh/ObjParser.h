@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Mesh.h"
+
+// Native Wavefront OBJ/MTL reader. The file is memory-mapped and split at line boundaries into
+// chunks that are parsed in parallel; the chunks are then merged straight into the mesh.
+// Polygons are triangulated as fans and missing normals or texture coordinates are zeroed.
+// Triangles are sorted by their usemtl material into Mesh::Subsets.
+// The output matches the tinyobjloader-based MeshImporter::LoadObjReference.
+namespace ObjParser {
+	// Chunks are not made smaller than this, so small files are parsed on the calling thread.
+	static const UINT64 MinChunkSize = 1 << 20;
+	// Number of chunks created per thread to even out the work between threads.
+	static const UINT64 ChunksPerThread = 4;
+
+	// Identical vertices are merged; a positive weld epsilon also merges vertices within that distance per component.
+	// Only the materials used by the triangles are returned, in library order, followed by a default
+	// material if some triangles have none.
+	// The material libraries referenced by the file are reported relative to the base directory if requested.
+	BOOL Load(
+		const std::string& file,
+		const std::string& baseDir,
+		Mesh& mesh,
+		std::vector<Material>& materials,
+		UINT64 numThreads = 1,
+		FLOAT weldEpsilon = 0.f,
+		std::vector<std::string>* materialLibs = nullptr);
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <iosfwd>
+#include <vector>
+#include <DirectXCollision.h>
+
+#include "Common/Helper/MathHelper.h"
+#include "Vertex.h"
+
+// Bounding volume hierarchy over the triangles of a single mesh, built with binned SAH.
+// Nodes are 32 bytes and siblings are stored next to each other, so a node only needs the
+// index of its first child. Triangles are copied into leaf order in a form ready for the
+// Moller-Trumbore test, which keeps the structure self-contained and serializable.
+class TriangleBvh {
+public:
+	// Number of centroid bins evaluated per axis when searching for a split.
+	static const UINT BinCount = 16;
+	// Leaves hold at most this many triangles, which matches the SIMD width of the triangle test.
+	static const UINT MaxLeafTriangles = 4;
+
+	struct Node {
+		DirectX::XMFLOAT3 Min;
+		// First child for interior nodes (the second child follows it), first triangle for leaves.
+		UINT LeftFirst;
+		DirectX::XMFLOAT3 Max;
+		// Zero for interior nodes.
+		UINT TriangleCount;
+
+		__forceinline BOOL IsLeaf() const;
+	};
+	static_assert(sizeof(Node) == 32, "TriangleBvh::Node must stay 32 bytes");
+
+	struct Triangle {
+		DirectX::XMFLOAT3 V0;
+		DirectX::XMFLOAT3 Edge1;
+		DirectX::XMFLOAT3 Edge2;
+	};
+
+	struct Hit {
+		FLOAT T = 0.f;
+		// Barycentric coordinates of the hit point relative to the second and third vertex.
+		FLOAT U = 0.f;
+		FLOAT V = 0.f;
+		// Index of the triangle in the source index buffer (index / 3).
+		UINT Triangle = 0;
+	};
+
+public:
+	TriangleBvh() = default;
+
+public:
+	__forceinline UINT NodeCount() const;
+	__forceinline UINT TriangleCount() const;
+	__forceinline BOOL IsEmpty() const;
+
+	DirectX::BoundingBox Bounds() const;
+
+public:
+	BOOL Build(const std::vector<Vertex>& vertices, const std::vector<UINT>& indices);
+	void Clear();
+
+	// Finds the closest triangle hit by origin + t * dir for t in (0, maxT). Both faces are considered.
+	BOOL RayCast(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR dir, FLOAT maxT, Hit& hit) const;
+
+	BOOL Save(std::ostream& stream) const;
+	BOOL Load(std::istream& stream);
+	// Reads an image written by Save from memory, e.g. a section of a mapped file.
+	BOOL Load(const BYTE* data, UINT64 size);
+
+private:
+	void UpdateBounds(Node& node, const std::vector<DirectX::XMFLOAT3>& triMins, const std::vector<DirectX::XMFLOAT3>& triMaxs) const;
+	FLOAT FindBestSplit(
+		const Node& node,
+		const std::vector<DirectX::XMFLOAT3>& triMins,
+		const std::vector<DirectX::XMFLOAT3>& triMaxs,
+		const std::vector<DirectX::XMFLOAT3>& centroids,
+		UINT& axis,
+		FLOAT& position) const;
+
+	void IntersectLeaf(const Node& node, DirectX::FXMVECTOR origin, DirectX::FXMVECTOR dir, FLOAT& maxT, Hit& hit, BOOL& found) const;
+
+private:
+	std::vector<Node> mNodes;
+	std::vector<Triangle> mTriangles;
+
+	// Maps triangles in leaf order back to their index in the source index buffer.
+	std::vector<UINT> mTriangleIndices;
+};
+
+#include "TriangleBvh.inl"
\ No newline at end of file
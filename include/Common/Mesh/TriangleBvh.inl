@@ -0,0 +1,20 @@
+#ifndef __TRIANGLEBVH_INL__
+#define __TRIANGLEBVH_INL__
+
+BOOL TriangleBvh::Node::IsLeaf() const {
+	return TriangleCount > 0;
+}
+
+UINT TriangleBvh::NodeCount() const {
+	return static_cast<UINT>(mNodes.size());
+}
+
+UINT TriangleBvh::TriangleCount() const {
+	return static_cast<UINT>(mTriangles.size());
+}
+
+BOOL TriangleBvh::IsEmpty() const {
+	return mNodes.empty();
+}
+
+#endif // __TRIANGLEBVH_INL__
\ No newline at end of file
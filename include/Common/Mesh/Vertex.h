@@ -2,6 +2,7 @@
 
 #ifndef HLSL
 	#include <array>
+	#include <cstring>
 	#include <vector>
 	#include <d3d12.h>
 
@@ -39,19 +40,30 @@ private:
 	namespace std {
 		template<> struct hash<Vertex> {
 			size_t operator()(const Vertex& vert) const {
-				size_t pos = hu::hash_combine(0, static_cast<size_t>(vert.Position.x));
-				pos = hu::hash_combine(pos, static_cast<size_t>(vert.Position.y));
-				pos = hu::hash_combine(pos, static_cast<size_t>(vert.Position.z));
+				size_t pos = hu::hash_combine(0, Bits(vert.Position.x));
+				pos = hu::hash_combine(pos, Bits(vert.Position.y));
+				pos = hu::hash_combine(pos, Bits(vert.Position.z));
 	
-				size_t normal = hu::hash_combine(0, static_cast<size_t>(vert.Normal.x));
-				normal = hu::hash_combine(normal, static_cast<size_t>(vert.Normal.y));
-				normal = hu::hash_combine(normal, static_cast<size_t>(vert.Normal.z));
+				size_t normal = hu::hash_combine(0, Bits(vert.Normal.x));
+				normal = hu::hash_combine(normal, Bits(vert.Normal.y));
+				normal = hu::hash_combine(normal, Bits(vert.Normal.z));
 	
-				size_t texc = hu::hash_combine(0, static_cast<size_t>(vert.TexCoord.x));
-				texc = hu::hash_combine(texc, static_cast<size_t>(vert.TexCoord.y));
+				size_t texc = hu::hash_combine(0, Bits(vert.TexCoord.x));
+				texc = hu::hash_combine(texc, Bits(vert.TexCoord.y));
 	
 				return hu::hash_combine(hu::hash_combine(pos, normal), texc);
 			}
+
+		private:
+			// Hashes the bit pattern rather than the truncated value; -0 is folded into +0.
+			static size_t Bits(FLOAT value) {
+				value += 0.f;
+
+				UINT bits;
+				std::memcpy(&bits, &value, sizeof(UINT));
+
+				return static_cast<size_t>(bits);
+			}
 		};
 	}
 #else 
@@ -63,4 +75,13 @@ private:
 			float2 TexC		: TEXCOORD;	\
 		};
 	#endif 
+
+	// Layout of VertexFormat::PositionOnly() for depth-only passes. PosQ is in [0, 1] over the mesh
+	// AABB with w = 1; ConstantBuffer_Object::QuantizedWorld takes it straight to world space.
+	#ifndef POSITION_VERTEX_IN
+	#define POSITION_VERTEX_IN				\
+		struct PositionVertexIn {			\
+			float4 PosQ		: POSITION;	\
+		};
+	#endif
 #endif
\ No newline at end of file
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <vector>
+#include <d3d12.h>
+
+#include "Common/Helper/MathHelper.h"
+#include "Vertex.h"
+
+namespace PositionEncoding {
+	enum Type {
+		E_Float3 = 0,
+		// x, y and z relative to the mesh AABB; w is always one so the stream can be fed to mul() as is.
+		E_Unorm16x4,
+		Count
+	};
+}
+
+namespace NormalEncoding {
+	enum Type {
+		E_None = 0,
+		E_Float3,
+		// Octahedral mapping in [-1, 1]; decode with DecodeNormal(n * 0.5 + 0.5) from ValuePackaging.hlsli.
+		E_OctSnorm16x2,
+		Count
+	};
+}
+
+namespace TexCoordEncoding {
+	enum Type {
+		E_None = 0,
+		E_Float2,
+		E_Half2,
+		Count
+	};
+}
+
+// Maps quantized positions in [0, 1] back into the local space of the mesh.
+struct VertexQuantization {
+	DirectX::XMFLOAT3 Offset = { 0.f, 0.f, 0.f };
+	DirectX::XMFLOAT3 Scale = { 1.f, 1.f, 1.f };
+
+	static VertexQuantization FromBounds(const DirectX::XMFLOAT3& min, const DirectX::XMFLOAT3& max);
+	static VertexQuantization FromVertices(const Vertex* vertices, UINT count);
+
+	// Fold into the world matrix so the shaders can transform quantized positions directly.
+	DirectX::XMMATRIX DequantizeMatrix() const;
+};
+
+struct VertexEncodingError {
+	// Largest per-component distance in the local space of the mesh.
+	FLOAT Position = 0.f;
+	// Largest angle between the source and decoded normals in degrees.
+	FLOAT NormalDegrees = 0.f;
+	FLOAT TexCoord = 0.f;
+};
+
+// Describes how each vertex attribute is stored in a stream and converts Vertex data to and from it.
+// Attributes are packed in position, normal, texcoord order without padding.
+class VertexFormat {
+public:
+	VertexFormat(
+		PositionEncoding::Type position = PositionEncoding::E_Float3,
+		NormalEncoding::Type normal = NormalEncoding::E_Float3,
+		TexCoordEncoding::Type texCoord = TexCoordEncoding::E_Float2);
+	virtual ~VertexFormat() = default;
+
+public:
+	// Same layout as Vertex.
+	static VertexFormat Full();
+	// 8 bytes per vertex, for depth-only passes.
+	static VertexFormat PositionOnly();
+
+	// Rebuilds a format from the value returned by Id().
+	static VertexFormat FromId(UINT id);
+
+public:
+	__forceinline PositionEncoding::Type Position() const;
+	__forceinline NormalEncoding::Type Normal() const;
+	__forceinline TexCoordEncoding::Type TexCoord() const;
+
+	__forceinline UINT Stride() const;
+	// Packs the encodings into one value for serialization.
+	__forceinline UINT Id() const;
+
+	__forceinline D3D12_INPUT_LAYOUT_DESC InputLayoutDesc() const;
+
+	BOOL operator==(const VertexFormat& other) const;
+
+public:
+	void Encode(const Vertex* vertices, UINT count, const VertexQuantization& quant, BYTE* dst) const;
+	void Decode(const BYTE* src, UINT count, const VertexQuantization& quant, Vertex* vertices) const;
+
+	VertexEncodingError MeasureError(const Vertex* vertices, UINT count, const VertexQuantization& quant) const;
+
+private:
+	void BuildLayout();
+
+private:
+	PositionEncoding::Type mPosition;
+	NormalEncoding::Type mNormal;
+	TexCoordEncoding::Type mTexCoord;
+
+	UINT mNormalOffset = 0;
+	UINT mTexCoordOffset = 0;
+	UINT mStride = 0;
+
+	std::vector<D3D12_INPUT_ELEMENT_DESC> mInputLayout;
+};
+
+#include "VertexFormat.inl"
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef __VERTEXFORMAT_INL__
+#define __VERTEXFORMAT_INL__
+
+PositionEncoding::Type VertexFormat::Position() const {
+	return mPosition;
+}
+
+NormalEncoding::Type VertexFormat::Normal() const {
+	return mNormal;
+}
+
+TexCoordEncoding::Type VertexFormat::TexCoord() const {
+	return mTexCoord;
+}
+
+UINT VertexFormat::Stride() const {
+	return mStride;
+}
+
+UINT VertexFormat::Id() const {
+	return static_cast<UINT>(mPosition) | (static_cast<UINT>(mNormal) << 8) | (static_cast<UINT>(mTexCoord) << 16);
+}
+
+D3D12_INPUT_LAYOUT_DESC VertexFormat::InputLayoutDesc() const {
+	return { mInputLayout.data(), static_cast<UINT>(mInputLayout.size()) };
+}
+
+#endif // __VERTEXFORMAT_INL__
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+
+#include "Vertex.h"
+
+// Merges identical vertices while an index buffer is being built. Vertices are hashed by the bit
+// patterns of their components (-0 is treated as +0) into an open-addressing table with linear
+// probing. With a positive epsilon the components are first snapped to a grid of that spacing,
+// so vertices that differ only by rounding noise are merged as well.
+class VertexWelder {
+public:
+	static const UINT EmptySlot = 0xFFFFFFFF;
+	static const UINT MinCapacity = 64;
+
+private:
+	struct Slot {
+		UINT Hash;
+		UINT Index;
+	};
+
+	struct Key {
+		UINT Values[8];
+	};
+
+public:
+	VertexWelder(FLOAT epsilon = 0.f);
+	virtual ~VertexWelder() = default;
+
+public:
+	__forceinline UINT UniqueCount() const;
+
+public:
+	// Sizes the table for the expected number of unique vertices so that it does not grow while welding.
+	void Reserve(size_t vertexCount);
+	void Clear();
+
+	// Returns the index of an equal vertex previously welded into the list, or appends the vertex.
+	// The same list must be passed on every call.
+	UINT Weld(const Vertex& vertex, std::vector<Vertex>& vertices);
+
+private:
+	void MakeKey(const Vertex& vertex, Key& key) const;
+	static UINT Hash(const Key& key);
+
+	void Rehash(size_t capacity);
+
+private:
+	std::vector<Slot> mSlots;
+	UINT mCount = 0;
+
+	FLOAT mEpsilon;
+	FLOAT mInvEpsilon;
+};
+
+#include "VertexWelder.inl"
\ No newline at end of file
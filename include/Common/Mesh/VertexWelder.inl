@@ -0,0 +1,8 @@
+#ifndef __VERTEXWELDER_INL__
+#define __VERTEXWELDER_INL__
+
+UINT VertexWelder::UniqueCount() const {
+	return mCount;
+}
+
+#endif // __VERTEXWELDER_INL__
\ No newline at end of file
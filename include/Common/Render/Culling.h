@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+#include <DirectXCollision.h>
+
+#include "Common/Helper/MathHelper.h"
+
+struct RenderItem;
+struct Light;
+struct Meshlet;
+
+class WorkerPool;
+
+namespace Culling {
+	namespace Plane {
+		enum {
+			E_Left = 0,
+			E_Right,
+			E_Bottom,
+			E_Top,
+			E_Near,
+			E_Far,
+			Count
+		};
+	}
+
+	// Inward-facing, normalized planes (n.x, n.y, n.z, d); a point p is inside when dot(n, p) + d >= 0.
+	struct Frustum {
+		DirectX::XMFLOAT4 Planes[Plane::Count];
+		UINT PlaneCount = Plane::Count;
+	};
+
+	// Directional, tube and rectangle lights use the first view only; point and spot lights use one
+	// view per cube face.
+	static const UINT MaxShadowViews = 6;
+
+	struct ShadowCasterLists {
+		std::vector<RenderItem*> Views[MaxShadowViews];
+	};
+
+	// Render items are batched by this many boxes for the SIMD plane tests.
+	static const UINT BatchSize = 4;
+	// Lists smaller than this are culled on the calling thread.
+	static const UINT MinItemsPerTask = 1024;
+
+	// Extracts the frustum planes from a row-major view-projection matrix (D3D clip space, 0 <= z <= w).
+	void ExtractFrustum(Frustum& frustum, DirectX::FXMMATRIX viewProj);
+
+	// Transforms the local-space AABB of each render item by its world matrix and keeps the items
+	// whose oriented box touches the frustum. The order of the input list is preserved.
+	// Large lists are split into chunks culled on the worker pool, if one is given.
+	BOOL CullRenderItems(
+		const Frustum& frustum,
+		const std::vector<RenderItem*>& ritems,
+		std::vector<RenderItem*>& visibles,
+		WorkerPool* const pool = nullptr);
+
+	// Brute-force reference that tests the eight world-space corners of each box one by one.
+	// It must agree with CullRenderItems and exists to validate the batched path.
+	void CullRenderItemsReference(
+		const Frustum& frustum,
+		const std::vector<RenderItem*>& ritems,
+		std::vector<RenderItem*>& visibles);
+
+	// Keeps the indices of the meshlets whose bounding sphere touches the frustum and whose normal cone
+	// does not face away from the viewer. The frustum and the view position are in the mesh's local space.
+	void CullMeshlets(
+		const Frustum& frustum,
+		DirectX::FXMVECTOR viewPos,
+		const Meshlet* meshlets,
+		UINT count,
+		std::vector<UINT>& visibles);
+
+	// Builds one caster list per shadow view of the light. Each view volume (the orthographic box of a
+	// directional light or one cube face of a point/spot light) is cropped to the light-space bounds of
+	// the visible receivers and extended from the light up to the farthest receiver, so casters outside
+	// the camera frustum are kept while casters that cannot shadow any visible receiver are rejected.
+	// Spot lights additionally reject casters outside the outer cone. Views without receivers get empty lists.
+	// Tube and rectangle lights have no shadow views; their single list keeps the casters within range of
+	// the tube segment or the rectangle, as long as a visible receiver is within range too.
+	BOOL CullShadowCasters(
+		const Light& light,
+		FLOAT range,
+		const std::vector<RenderItem*>& receivers,
+		const std::vector<RenderItem*>& casters,
+		ShadowCasterLists& lists,
+		WorkerPool* const pool = nullptr);
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vector>
+#include <DirectXCollision.h>
+
+#include "Common/Helper/MathHelper.h"
+#include "Common/Render/Culling.h"
+
+// Dynamic bounding volume hierarchy in the style of Box2D's b2DynamicTree and Bullet's dbvt.
+// Leaves store "fat" AABBs enlarged by a margin so that small movements do not touch the tree;
+// a leaf is only removed and reinserted once its object leaves the fat box. The tree is kept
+// balanced with AVL-like rotations on the way back up after every insertion and removal.
+class DynamicAabbTree {
+public:
+	static const INT NullNode = -1;
+
+private:
+	struct Node {
+		DirectX::XMFLOAT3 Min;
+		DirectX::XMFLOAT3 Max;
+
+		void* UserData = nullptr;
+
+		INT Parent = NullNode;
+		INT Next = NullNode;
+		INT Child1 = NullNode;
+		INT Child2 = NullNode;
+
+		// Leaf = 0, free node = -1.
+		INT Height = -1;
+
+		__forceinline BOOL IsLeaf() const;
+	};
+
+public:
+	DynamicAabbTree(FLOAT margin = 0.1f);
+	virtual ~DynamicAabbTree() = default;
+
+public:
+	__forceinline void* UserData(INT proxyId) const;
+	__forceinline INT Height() const;
+	__forceinline UINT ProxyCount() const;
+
+	DirectX::BoundingBox FatAABB(INT proxyId) const;
+
+public:
+	INT CreateProxy(const DirectX::BoundingBox& aabb, void* const userData);
+	void DestroyProxy(INT proxyId);
+
+	// Returns TRUE if the proxy had to be reinserted because the box left its fat AABB.
+	BOOL MoveProxy(INT proxyId, const DirectX::BoundingBox& aabb);
+
+	// Invokes callback(proxyId) for every proxy whose fat AABB overlaps the box.
+	template <typename Callback>
+	void QueryOverlap(const DirectX::BoundingBox& aabb, Callback&& callback) const;
+
+	// Invokes callback(proxyId) for every proxy whose fat AABB touches the frustum.
+	// Subtrees that are fully inside are reported without further plane tests.
+	template <typename Callback>
+	void QueryFrustum(const Culling::Frustum& frustum, Callback&& callback) const;
+
+	// Walks the proxies whose fat AABB is hit by origin + t * dir for t in [0, maxT].
+	// callback(proxyId, maxT) returns the new maximum distance: return maxT to continue unchanged,
+	// a smaller value to clip the ray (e.g. at the closest exact hit), or 0 to stop the query.
+	template <typename Callback>
+	void RayCast(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR dir, FLOAT maxT, Callback&& callback) const;
+
+	// Checks parent links, heights and bounds of the whole tree. Intended for debugging.
+	BOOL Validate() const;
+
+private:
+	INT AllocateNode();
+	void FreeNode(INT nodeId);
+
+	void InsertLeaf(INT leaf);
+	void RemoveLeaf(INT leaf);
+
+	INT Balance(INT iA);
+
+	void Combine(Node& dst, const Node& a, const Node& b) const;
+	__forceinline FLOAT SurfaceArea(const DirectX::XMFLOAT3& min, const DirectX::XMFLOAT3& max) const;
+
+	BOOL ValidateNode(INT index) const;
+
+private:
+	std::vector<Node> mNodes;
+
+	INT mRoot = NullNode;
+	INT mFreeList = NullNode;
+
+	UINT mProxyCount = 0;
+
+	FLOAT mMargin;
+};
+
+#include "DynamicAabbTree.inl"
\ No newline at end of file
@@ -0,0 +1,154 @@
+#ifndef __DYNAMICAABBTREE_INL__
+#define __DYNAMICAABBTREE_INL__
+
+BOOL DynamicAabbTree::Node::IsLeaf() const {
+	return Child1 == NullNode;
+}
+
+void* DynamicAabbTree::UserData(INT proxyId) const {
+	return mNodes[proxyId].UserData;
+}
+
+INT DynamicAabbTree::Height() const {
+	return mRoot == NullNode ? 0 : mNodes[mRoot].Height;
+}
+
+UINT DynamicAabbTree::ProxyCount() const {
+	return mProxyCount;
+}
+
+FLOAT DynamicAabbTree::SurfaceArea(const DirectX::XMFLOAT3& min, const DirectX::XMFLOAT3& max) const {
+	const FLOAT dx = max.x - min.x;
+	const FLOAT dy = max.y - min.y;
+	const FLOAT dz = max.z - min.z;
+	return 2.f * (dx * dy + dy * dz + dz * dx);
+}
+
+template <typename Callback>
+void DynamicAabbTree::QueryOverlap(const DirectX::BoundingBox& aabb, Callback&& callback) const {
+	if (mRoot == NullNode) return;
+
+	const DirectX::XMFLOAT3 qMin(aabb.Center.x - aabb.Extents.x, aabb.Center.y - aabb.Extents.y, aabb.Center.z - aabb.Extents.z);
+	const DirectX::XMFLOAT3 qMax(aabb.Center.x + aabb.Extents.x, aabb.Center.y + aabb.Extents.y, aabb.Center.z + aabb.Extents.z);
+
+	std::vector<INT> stack;
+	stack.reserve(64);
+	stack.push_back(mRoot);
+
+	while (!stack.empty()) {
+		const INT index = stack.back();
+		stack.pop_back();
+
+		const Node& node = mNodes[index];
+		if (node.Max.x < qMin.x || node.Min.x > qMax.x ||
+			node.Max.y < qMin.y || node.Min.y > qMax.y ||
+			node.Max.z < qMin.z || node.Min.z > qMax.z) continue;
+
+		if (node.IsLeaf()) {
+			callback(index);
+		}
+		else {
+			stack.push_back(node.Child1);
+			stack.push_back(node.Child2);
+		}
+	}
+}
+
+template <typename Callback>
+void DynamicAabbTree::QueryFrustum(const Culling::Frustum& frustum, Callback&& callback) const {
+	if (mRoot == NullNode) return;
+
+	// The second element tells whether the subtree is already known to be fully inside.
+	std::vector<std::pair<INT, BOOL>> stack;
+	stack.reserve(64);
+	stack.emplace_back(mRoot, FALSE);
+
+	while (!stack.empty()) {
+		const auto entry = stack.back();
+		stack.pop_back();
+
+		const Node& node = mNodes[entry.first];
+		BOOL contained = entry.second;
+
+		if (!contained) {
+			const FLOAT cx = 0.5f * (node.Max.x + node.Min.x);
+			const FLOAT cy = 0.5f * (node.Max.y + node.Min.y);
+			const FLOAT cz = 0.5f * (node.Max.z + node.Min.z);
+			const FLOAT ex = 0.5f * (node.Max.x - node.Min.x);
+			const FLOAT ey = 0.5f * (node.Max.y - node.Min.y);
+			const FLOAT ez = 0.5f * (node.Max.z - node.Min.z);
+
+			BOOL outside = FALSE;
+			contained = TRUE;
+			for (UINT p = 0; p < frustum.PlaneCount; ++p) {
+				const auto& plane = frustum.Planes[p];
+				const FLOAT dist = plane.x * cx + plane.y * cy + plane.z * cz + plane.w;
+				const FLOAT radius = std::abs(plane.x) * ex + std::abs(plane.y) * ey + std::abs(plane.z) * ez;
+
+				if (dist + radius < 0.f) {
+					outside = TRUE;
+					break;
+				}
+				if (dist - radius < 0.f) contained = FALSE;
+			}
+			if (outside) continue;
+		}
+
+		if (node.IsLeaf()) {
+			callback(entry.first);
+		}
+		else {
+			stack.emplace_back(node.Child1, contained);
+			stack.emplace_back(node.Child2, contained);
+		}
+	}
+}
+
+template <typename Callback>
+void DynamicAabbTree::RayCast(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR dir, FLOAT maxT, Callback&& callback) const {
+	if (mRoot == NullNode) return;
+
+	DirectX::XMFLOAT3 o, d;
+	DirectX::XMStoreFloat3(&o, origin);
+	DirectX::XMStoreFloat3(&d, dir);
+
+	// Division by zero yields infinities, which the slab test below handles correctly.
+	const DirectX::XMFLOAT3 invD(1.f / d.x, 1.f / d.y, 1.f / d.z);
+
+	std::vector<INT> stack;
+	stack.reserve(64);
+	stack.push_back(mRoot);
+
+	while (!stack.empty()) {
+		const INT index = stack.back();
+		stack.pop_back();
+
+		const Node& node = mNodes[index];
+
+		FLOAT t0 = 0.f;
+		FLOAT t1 = maxT;
+		{
+			const FLOAT tx0 = (node.Min.x - o.x) * invD.x;
+			const FLOAT tx1 = (node.Max.x - o.x) * invD.x;
+			const FLOAT ty0 = (node.Min.y - o.y) * invD.y;
+			const FLOAT ty1 = (node.Max.y - o.y) * invD.y;
+			const FLOAT tz0 = (node.Min.z - o.z) * invD.z;
+			const FLOAT tz1 = (node.Max.z - o.z) * invD.z;
+
+			t0 = MathHelper::Max(t0, MathHelper::Max(MathHelper::Min(tx0, tx1), MathHelper::Max(MathHelper::Min(ty0, ty1), MathHelper::Min(tz0, tz1))));
+			t1 = MathHelper::Min(t1, MathHelper::Min(MathHelper::Max(tx0, tx1), MathHelper::Min(MathHelper::Max(ty0, ty1), MathHelper::Max(tz0, tz1))));
+		}
+		if (t0 > t1) continue;
+
+		if (node.IsLeaf()) {
+			maxT = callback(index, maxT);
+			if (maxT <= 0.f) return;
+		}
+		else {
+			stack.push_back(node.Child1);
+			stack.push_back(node.Child2);
+		}
+	}
+}
+
+#endif // __DYNAMICAABBTREE_INL__
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <DirectXCollision.h>
+
+#include "Common/Mesh/Mesh.h"
+
+// Runtime level of detail selection by projected screen size. The geometric error of each level
+// is projected at the distance of the closest point of the item's bounds, and the coarsest level
+// whose error stays below a pixel threshold is drawn. Coarser levels are only taken once they
+// pass a tighter threshold, so items resting near a switching distance do not alternate.
+namespace LodSelector {
+	// Largest projected geometric error in pixels.
+	static const FLOAT MaxPixelError = 1.f;
+	// Fraction of MaxPixelError a coarser level has to meet before it replaces the current one.
+	static const FLOAT Hysteresis = 0.75f;
+
+	// Pixels covered by one unit of the item's local space. projScaleY is element (1, 1) of the projection matrix.
+	FLOAT ProjectedScale(
+		const DirectX::BoundingBox& localBounds,
+		DirectX::FXMMATRIX world,
+		DirectX::FXMVECTOR eyePos,
+		FLOAT projScaleY,
+		UINT screenHeight,
+		FLOAT nearZ);
+
+	// Expects levels ordered from full detail with non-decreasing errors.
+	UINT SelectLod(const MeshLod* lods, UINT lodCount, UINT currentLod, FLOAT projectedScale);
+}
\ No newline at end of file
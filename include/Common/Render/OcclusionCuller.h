@@ -0,0 +1,112 @@
+#pragma once
+
+#include <vector>
+#include <DirectXCollision.h>
+
+#include "Common/Helper/MathHelper.h"
+
+struct RenderItem;
+
+class WorkerPool;
+
+// Software occlusion culling. Designated occluder meshes are rasterized on the CPU into a small
+// depth buffer, from which a hierarchy of min/max depths is built; object bounds are then tested
+// against the hierarchy before draw submission. Nothing here touches the GPU, so it runs headless.
+// Rasterization is conservative: a pixel is written only where a triangle covers all of it, with the
+// farthest depth the triangle has there, so an object is never reported hidden by mistake.
+class OcclusionCuller {
+public:
+	static const UINT Width = 256;
+	static const UINT Height = 128;
+
+	// The depth buffer is split into bands of rows that are rasterized in parallel.
+	static const UINT BandHeight = 16;
+	static const UINT BandCount = Height / BandHeight;
+
+	// Level 0 is the full-resolution buffer; the last level is 2x1 texels.
+	static const UINT LevelCount = 8;
+
+	// Meshes with more triangles than this are not accepted as occluders; a coarser level of detail is used instead.
+	static const UINT MaxOccluderTriangles = 16384;
+
+private:
+	struct OccluderMesh {
+		std::vector<DirectX::XMFLOAT3> Positions;
+		std::vector<UINT> Indices;
+	};
+
+	struct Occluder {
+		UINT MeshIndex;
+		DirectX::XMFLOAT4X4 World;
+	};
+
+	// Screen-space triangle prepared for rasterization: edge functions E(x, y) = A * x + B * y + C,
+	// positive inside, and the depth plane Z(x, y) = ZA * x + ZB * y + ZC.
+	struct ScreenTriangle {
+		FLOAT EdgeA[3];
+		FLOAT EdgeB[3];
+		FLOAT EdgeC[3];
+		FLOAT ZA;
+		FLOAT ZB;
+		FLOAT ZC;
+		INT MinX;
+		INT MaxX;
+		INT MinY;
+		INT MaxY;
+	};
+
+public:
+	OcclusionCuller();
+	virtual ~OcclusionCuller() = default;
+
+public:
+	__forceinline UINT OccluderCount() const;
+
+public:
+	// Registers triangle geometry that can later be drawn as an occluder and returns its index.
+	// Positions are read from the first three floats of each vertex.
+	BOOL AddMesh(
+		const void* const vertices,
+		UINT vertexCount,
+		UINT vertexStride,
+		const UINT* const indices,
+		UINT indexCount,
+		UINT& meshIndex);
+
+	// Starts a new frame with the given row-major view-projection matrix and drops the previous occluders.
+	void BeginFrame(DirectX::FXMMATRIX viewProj);
+	void AddOccluder(UINT meshIndex, DirectX::FXMMATRIX world);
+
+	// Rasterizes the occluders added since BeginFrame and builds the depth hierarchy.
+	// The bands are spread over the worker pool, if one is given.
+	BOOL Rasterize(WorkerPool* const pool = nullptr);
+
+	// Returns FALSE only if the box, transformed by the world matrix, is entirely hidden behind the occluders.
+	BOOL IsVisible(const DirectX::BoundingBox& aabb, DirectX::FXMMATRIX world) const;
+
+	// Keeps the render items that are not hidden. The order of the input list is preserved.
+	void CullRenderItems(const std::vector<RenderItem*>& ritems, std::vector<RenderItem*>& visibles) const;
+
+private:
+	void SetupTriangles(const Occluder& occluder);
+	void SetupTriangle(const DirectX::XMFLOAT4& c0, const DirectX::XMFLOAT4& c1, const DirectX::XMFLOAT4& c2);
+
+	void RasterizeBand(UINT band);
+	void BuildHierarchy();
+
+	BOOL TestTexel(UINT level, UINT x, UINT y, const INT rect[4], FLOAT minZ, UINT depth) const;
+
+private:
+	std::vector<OccluderMesh> mMeshes;
+	std::vector<Occluder> mOccluders;
+
+	DirectX::XMFLOAT4X4 mViewProj;
+
+	std::vector<ScreenTriangle> mTriangles;
+	std::vector<UINT> mBandBins[BandCount];
+
+	std::vector<FLOAT> mMaxDepth[LevelCount];
+	std::vector<FLOAT> mMinDepth[LevelCount];
+};
+
+#include "OcclusionCuller.inl"
\ No newline at end of file
@@ -0,0 +1,8 @@
+#ifndef __OCCLUSIONCULLER_INL__
+#define __OCCLUSIONCULLER_INL__
+
+UINT OcclusionCuller::OccluderCount() const {
+	return static_cast<UINT>(mOccluders.size());
+}
+
+#endif // __OCCLUSIONCULLER_INL__
\ No newline at end of file
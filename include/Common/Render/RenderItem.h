@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include <d3d12.h>
 #include <DirectXCollision.h>
 
@@ -40,5 +42,24 @@ struct RenderItem {
 	UINT StartIndexLocation = 0;
 	UINT BaseVertexLocation = 0;
 
+	// Level of detail the draw parameters currently refer to.
+	UINT LodIndex = 0;
+
+	struct Subset {
+		UINT IndexCount;
+		UINT StartIndexLocation;
+		MaterialData* Material;
+	};
+
+	// One draw per material of the geometry at the current level of detail. Items without subsets
+	// draw IndexCount indices with Material, which otherwise is the material of the first subset.
+	std::vector<Subset> Subsets;
+
 	BOOL Pickable = TRUE;
+
+	// Whether the item is rasterized into the software occlusion buffer.
+	BOOL Occluder = FALSE;
+
+	// Proxy of the world-space AABB in the scene tree; -1 if the item is not registered.
+	INT ProxyId = -1;
 };
\ No newline at end of file
@@ -74,6 +74,7 @@ public:
 	virtual void UpdateModel(void* const model, const Transform& trans) = 0;
 	virtual void SetModelVisibility(void* const model, BOOL visible) = 0;
 	virtual void SetModelPickable(void* const model, BOOL pickable) = 0;
+	virtual void SetModelOccluder(void* const model, BOOL occluder) = 0;
 
 	virtual BOOL SetCubeMap(const std::string& file) = 0;
 	virtual BOOL SetEquirectangularMap(const std::string& file) = 0;
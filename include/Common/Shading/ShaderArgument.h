@@ -73,11 +73,14 @@ namespace ShaderArgument {
 
 	namespace Debug {
 		static BOOL ShowCollisionBox = FALSE;
+		// Compares the batched frustum culling against the brute-force reference every frame.
+		static BOOL ValidateCulling = FALSE;
 	}
 
 	namespace IrradianceMap {
 		static BOOL ShowIrradianceCubeMap = FALSE;
 		static FLOAT MipLevel = 0.f;
+		static BOOL UseIrradianceSH = TRUE;
 	}
 
 	namespace Pixelization {
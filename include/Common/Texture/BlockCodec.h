@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Windows.h>
+
+namespace CompressionQuality {
+	enum Type {
+		// Principal-axis endpoints with one refinement pass; BC7 and BC6H try a single mode.
+		E_Fast = 0,
+		// A few refinement passes; BC7 and BC6H also try the best-guess two-subset partitions.
+		E_Normal,
+		// Every mode and more partitions, rotations and refinement passes.
+		E_High
+	};
+}
+
+// Encoders and decoders for single 4x4 blocks of the BC formats. Texels are in row-major order with
+// four channels each: RGBA8 for BC1 to BC5 and BC7, and RGBA floats for BC6H, whose alpha is
+// ignored. Decoders write the same layouts.
+// BC6H blocks are encoded as BC6H_UF16, so negative inputs are clamped to zero; the decoder reads
+// both variants.
+namespace BlockCodec {
+	static const UINT BlockTexels = 16;
+
+	// BC1 blocks with texels whose alpha is below one half use the three-color mode with
+	// transparent black; otherwise alpha is ignored.
+	void EncodeBC1(const BYTE* texels, CompressionQuality::Type quality, BYTE* block);
+	void EncodeBC3(const BYTE* texels, CompressionQuality::Type quality, BYTE* block);
+	// Encodes one channel of the texels into an 8-byte BC4 block.
+	void EncodeBC4(const BYTE* texels, UINT channel, CompressionQuality::Type quality, BYTE* block);
+	// Encodes the red and green channels.
+	void EncodeBC5(const BYTE* texels, CompressionQuality::Type quality, BYTE* block);
+	void EncodeBC7(const BYTE* texels, CompressionQuality::Type quality, BYTE* block);
+	void EncodeBC6H(const FLOAT* texels, CompressionQuality::Type quality, BYTE* block);
+
+	void DecodeBC1(const BYTE* block, BYTE* texels);
+	void DecodeBC3(const BYTE* block, BYTE* texels);
+	// Writes the decoded values into one channel of the texels.
+	void DecodeBC4(const BYTE* block, UINT channel, BYTE* texels);
+	// Writes red and green; blue is zero and alpha opaque.
+	void DecodeBC5(const BYTE* block, BYTE* texels);
+	void DecodeBC7(const BYTE* block, BYTE* texels);
+	// Writes one for alpha. Reserved modes decode to zero.
+	void DecodeBC6H(const BYTE* block, BOOL isSigned, FLOAT* texels);
+}
\ No newline at end of file
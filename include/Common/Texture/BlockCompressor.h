@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "BlockCodec.h"
+#include "DdsFile.h"
+
+// Compresses whole textures into BC blocks for the asset pipeline. Rows of blocks are encoded in
+// parallel on a TaskQueue. Partial blocks at the right and bottom edges replicate the edge texels,
+// and the error report only counts the texels of the texture.
+// 8-bit sources are encoded as stored, so sRGB sources should target the _SRGB formats. Float
+// sources are clamped to [0, 1] for the LDR formats.
+namespace BlockCompressor {
+	struct Report {
+		// Mean squared error per channel over the channels the format stores: in 8-bit units for
+		// the LDR formats and in linear values for BC6H.
+		DOUBLE Mse = 0.0;
+		// In dB. The peak is 255 for the LDR formats and the largest source value for BC6H.
+		DOUBLE Psnr = 0.0;
+	};
+
+	// BC1, BC3 and BC7 (UNORM and SRGB), BC4_UNORM, BC5_UNORM and BC6H_UF16.
+	BOOL IsSupported(DXGI_FORMAT format);
+	// 8-bit RGBA and BGRA (UNORM and SRGB), R16G16B16A16_FLOAT, R32G32B32A32_FLOAT and R32G32B32_FLOAT.
+	BOOL IsSupportedSource(DXGI_FORMAT format);
+
+	// Compresses one subresource into tightly packed rows of blocks, slice after slice for 3D textures.
+	BOOL Compress(
+		const DdsFile::Subresource& source,
+		DXGI_FORMAT sourceFormat,
+		DXGI_FORMAT format,
+		CompressionQuality::Type quality,
+		UINT64 numThreads,
+		std::vector<BYTE>& blocks,
+		Report* report = nullptr);
+
+	// Compresses every subresource, saves the texture to path, and logs its PSNR over all subresources.
+	BOOL CompressTexture(
+		const DdsFile& source,
+		DXGI_FORMAT format,
+		CompressionQuality::Type quality,
+		UINT64 numThreads,
+		const std::string& path,
+		Report* report = nullptr);
+}
\ No newline at end of file
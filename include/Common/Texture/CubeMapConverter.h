@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <DirectXMath.h>
+
+#include "DdsFile.h"
+
+namespace ResampleFilter {
+	enum Type {
+		E_Bilinear = 0,
+		// Catmull-Rom; sharper, with the ringing clamped at zero so bright HDR sources stay positive.
+		E_Cubic
+	};
+}
+
+// Resamples environments between the equirectangular layout of Equirectangular.hlsli and cube maps
+// in the Direct3D face order, on the CPU, for cooking environments at build time. Faces are stored
+// one after another in one array of texels.
+// Filter taps that fall off a face are fetched from the neighboring face the same direction hits,
+// and taps past a pole of an equirectangular map continue on the opposite meridian, so neither
+// layout shows seams. When the destination is much coarser than the source, a box-filtered source
+// mip closer to its texel footprint is read instead, so minification does not alias.
+// Rows are resampled in parallel on a TaskQueue, across all faces at once.
+namespace CubeMapConverter {
+	// Direction through (s, t) in [-1, 1] on a face, with s to the right and t down the face.
+	DirectX::XMFLOAT3 CubeDirection(UINT face, FLOAT s, FLOAT t);
+	// Face a direction hits, and where.
+	void CubeFace(const DirectX::XMFLOAT3& dir, UINT& face, FLOAT& s, FLOAT& t);
+
+	BOOL EquirectangularToCube(
+		const std::vector<DirectX::XMFLOAT4>& equirectangular,
+		UINT width, UINT height,
+		UINT faceSize,
+		ResampleFilter::Type filter,
+		UINT64 numThreads,
+		std::vector<DirectX::XMFLOAT4>& faces);
+
+	BOOL CubeToEquirectangular(
+		const std::vector<DirectX::XMFLOAT4>& faces,
+		UINT faceSize,
+		UINT width, UINT height,
+		ResampleFilter::Type filter,
+		UINT64 numThreads,
+		std::vector<DirectX::XMFLOAT4>& equirectangular);
+
+	// Converts mip 0 of an equirectangular texture in any TexelDecoder format and saves the cube map
+	// to path as R16G16B16A16_FLOAT, with a full mip chain of every face when generateMips is set.
+	BOOL CookCubeMap(
+		const DdsFile& equirectangular,
+		UINT faceSize,
+		ResampleFilter::Type filter,
+		BOOL generateMips,
+		UINT64 numThreads,
+		const std::string& path);
+
+	// Converts mip 0 of a cube map and saves the equirectangular map to path as R16G16B16A16_FLOAT.
+	BOOL CookEquirectangular(
+		const DdsFile& cubeMap,
+		UINT width, UINT height,
+		ResampleFilter::Type filter,
+		UINT64 numThreads,
+		const std::string& path);
+}
\ No newline at end of file
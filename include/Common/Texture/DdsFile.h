@@ -0,0 +1,84 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Common/Util/MappedFile.h"
+#include "TextureFormat.h"
+
+// Reader and writer for DirectDraw Surface files built on the structures of DDS.h. Open maps the
+// file and indexes its subresources in place, so uploading a texture pages the texels in straight
+// from the file instead of reading them into a temporary buffer first. Handles 1D, 2D, 3D, array
+// and cube textures with full or partial mip chains, the DX10 header extension, and the legacy
+// pixel formats that map to a DXGI format without swizzling.
+// Subresource views stay valid until the file is closed.
+class DdsFile {
+public:
+	// Largest extent and array size accepted; they match the Direct3D 12 limits for 2D textures.
+	static const UINT MaxDimension = 16384;
+	static const UINT MaxArraySize = 2048;
+
+public:
+	struct Description {
+		TextureDimension::Type Dimension;
+		DXGI_FORMAT Format;
+		UINT Width;
+		UINT Height;
+		UINT Depth;
+		// Array slices; cube maps have six slices per cube.
+		UINT ArraySize;
+		UINT MipLevels;
+		BOOL IsCube;
+		// DDS_ALPHA_MODE of the texels.
+		UINT AlphaMode;
+	};
+
+	// Surface of one mip level of one array slice. A 3D subresource is Depth slices of SlicePitch
+	// bytes each. Subresources of opened files are tightly packed.
+	struct Subresource {
+		const BYTE* Data;
+		UINT64 RowPitch;
+		UINT64 SlicePitch;
+		UINT Width;
+		UINT Height;
+		UINT Depth;
+		// Rows of texels, or rows of blocks for block-compressed formats.
+		UINT RowCount;
+	};
+
+public:
+	DdsFile() = default;
+	virtual ~DdsFile() = default;
+
+	DdsFile(const DdsFile&) = delete;
+	DdsFile& operator=(const DdsFile&) = delete;
+
+public:
+	__forceinline const Description& Desc() const;
+	// In Direct3D subresource order: every mip of slice 0, then every mip of slice 1 and so on.
+	__forceinline const std::vector<Subresource>& Subresources() const;
+	__forceinline const Subresource& GetSubresource(UINT mip, UINT slice) const;
+
+public:
+	BOOL Open(const std::string& path);
+	// Indexes an image held in memory. The caller keeps the memory alive while the views are used.
+	BOOL Parse(const BYTE* data, UINT64 size);
+	void Close();
+
+	// Serializes a texture with a DX10 header. Subresources are given in the order above with only
+	// Data, RowPitch and SlicePitch read; padded rows are repacked tightly.
+	static BOOL Write(const Description& desc, const std::vector<Subresource>& subresources, std::vector<BYTE>& image);
+	static BOOL Save(const std::string& path, const Description& desc, const std::vector<Subresource>& subresources);
+
+	// Tightly packed layout of the subresources of desc, with Data left null. Fails for
+	// descriptions the file format or the limits above do not allow.
+	static BOOL ComputeLayout(const Description& desc, std::vector<Subresource>& layout, UINT64& totalSize);
+
+private:
+	MappedFile mFile;
+
+	Description mDesc = {};
+	std::vector<Subresource> mSubresources;
+};
+
+#include "DdsFile.inl"
\ No newline at end of file
@@ -0,0 +1,16 @@
+#ifndef __DDSFILE_INL__
+#define __DDSFILE_INL__
+
+const DdsFile::Description& DdsFile::Desc() const {
+	return mDesc;
+}
+
+const std::vector<DdsFile::Subresource>& DdsFile::Subresources() const {
+	return mSubresources;
+}
+
+const DdsFile::Subresource& DdsFile::GetSubresource(UINT mip, UINT slice) const {
+	return mSubresources[slice * mDesc.MipLevels + mip];
+}
+
+#endif // __DDSFILE_INL__
\ No newline at end of file
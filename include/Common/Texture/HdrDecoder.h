@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Common/Util/BakeManifest.h"
+#include "BlockCodec.h"
+#include "DdsFile.h"
+
+namespace HdrFormat {
+	enum Type {
+		E_Unknown = 0,
+		// Radiance RGBE (.hdr), flat or run-length encoded.
+		E_Radiance,
+		// Single-part scanline OpenEXR (.exr) with NONE, RLE, ZIPS, ZIP or PIZ compression.
+		E_OpenExr
+	};
+}
+
+// Decodes high dynamic range source images into R16G16B16A16_FLOAT, so raw captures can be cooked
+// into textures without converting them by hand first.
+// The run-length encoded rows of a Radiance file are indexed in one sequential pass and then decoded
+// in parallel; the chunks of an EXR file are independent and are decompressed in parallel outright.
+// Either way the texels are converted to half floats a row at a time with the DirectXMath stream
+// conversions, and every row is written by exactly one task, so the output does not depend on the
+// thread count.
+// EXR channels R, G, B and A are used, or Y alone as grey; missing color channels decode as zero and
+// a missing alpha as one.
+namespace HdrDecoder {
+	static const UINT Version = 1;
+
+	struct Settings {
+		// R16G16B16A16_FLOAT or BC6H_UF16.
+		DXGI_FORMAT Format = DXGI_FORMAT_BC6H_UF16;
+		CompressionQuality::Type Quality = CompressionQuality::E_Fast;
+		// Box filtered, so bright texels do not ring into their neighbors.
+		BOOL GenerateMips = FALSE;
+	};
+
+	// From the leading bytes of a file.
+	HdrFormat::Type Identify(const BYTE* data, UINT64 size);
+	// From the extension of a path.
+	BOOL IsHdrSource(const std::string& path);
+
+	// surface receives a view of the decoded image, backed by texels.
+	BOOL Decode(
+		const BYTE* data,
+		UINT64 size,
+		UINT64 numThreads,
+		std::vector<BYTE>& texels,
+		DdsFile::Subresource& surface);
+
+	void DescribeBake(UINT64 sourceHash, const Settings& settings, BakeManifest& manifest);
+
+	// Decodes the source and saves it to path as a 2D texture in the format of the settings.
+	BOOL Cook(
+		const std::string& sourcePath,
+		const std::string& path,
+		const std::string& manifestPath,
+		const Settings& settings,
+		UINT64 numThreads);
+
+	BOOL IsCookCurrent(const std::string& sourcePath, const std::string& manifestPath, const Settings& settings);
+}
\ No newline at end of file
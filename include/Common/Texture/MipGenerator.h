@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "DdsFile.h"
+
+namespace MipFilter {
+	enum Type {
+		// Area average over the footprint of each texel.
+		E_Box = 0,
+		// Kaiser-windowed sinc; sharper, with slight ringing that is clamped for UNORM formats.
+		E_Kaiser
+	};
+}
+
+// Builds mip chains on the CPU, for the asset pipeline and for textures loaded without mips. Every
+// level is filtered from the one above in linear light with a separable filter whose weights are
+// precomputed per axis. Each destination texel covers exactly its share of the source, so the odd
+// extents of non-power-of-two textures are resampled rather than dropping a row or column.
+// sRGB formats are decoded to linear before filtering and encoded again afterwards; alpha is
+// always linear. The levels are kept in float between passes, so rounding does not accumulate
+// down the chain.
+// Averaging lowers the coverage of alpha-tested textures. With an alpha reference set, the
+// alpha of every mip is scaled so the fraction of texels passing the test matches mip 0.
+// Rows of a level are filtered in parallel on a TaskQueue, and GenerateTextures spreads whole
+// textures over the threads instead.
+namespace MipGenerator {
+	struct Settings {
+		MipFilter::Type Filter = MipFilter::E_Kaiser;
+		// Alpha test threshold whose coverage is preserved; 0 leaves alpha as filtered.
+		FLOAT AlphaReference = 0.f;
+		// Wraps around the edges, for tiling textures, instead of clamping to them.
+		BOOL Wrap = FALSE;
+	};
+
+	// 8-bit RGBA and BGRA (UNORM and SRGB), R16G16B16A16_FLOAT and R32G32B32A32_FLOAT.
+	BOOL IsSupported(DXGI_FORMAT format);
+
+	// Builds mips 1 and below of a 2D surface, down to 1x1. mips receives the tightly packed
+	// subresources, finest first, backed by texels.
+	BOOL Generate(
+		const DdsFile::Subresource& source,
+		DXGI_FORMAT format,
+		const Settings& settings,
+		UINT64 numThreads,
+		std::vector<BYTE>& texels,
+		std::vector<DdsFile::Subresource>& mips);
+
+	// Replaces the mips of every array slice of a 2D texture with a full chain generated from mip 0,
+	// and saves the texture to path.
+	BOOL GenerateTexture(const DdsFile& source, const Settings& settings, UINT64 numThreads, const std::string& path);
+
+	// GenerateTexture for each pair of source and destination paths, one texture per thread.
+	BOOL GenerateTextures(
+		const std::vector<std::pair<std::string, std::string>>& files,
+		const Settings& settings,
+		UINT64 numThreads);
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <vector>
+#include <DirectXMath.h>
+
+#include "DdsFile.h"
+
+// Decodes 2D surfaces into linear RGBA floats for the CPU bakers. sRGB formats are converted to
+// linear, BGRA is swizzled to RGBA, formats without alpha decode it as one, and BC6H blocks go
+// through BlockCodec.
+namespace TexelDecoder {
+	// 8-bit RGBA and BGRA (UNORM and SRGB), R16G16B16A16_FLOAT, R32G32B32A32_FLOAT, R32G32B32_FLOAT
+	// and BC6H.
+	BOOL IsSupported(DXGI_FORMAT format);
+
+	// Decodes the first depth slice of a surface into Width x Height texels, row after row.
+	BOOL Decode(const DdsFile::Subresource& surface, DXGI_FORMAT format, std::vector<DirectX::XMFLOAT4>& texels);
+}
\ No newline at end of file
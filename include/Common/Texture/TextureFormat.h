@@ -0,0 +1,30 @@
+#pragma once
+
+#include <Windows.h>
+#include <dxgiformat.h>
+
+namespace TextureDimension {
+	enum Type {
+		E_Texture1D = 0,
+		E_Texture2D,
+		E_Texture3D
+	};
+}
+
+// Memory layout of DXGI formats, independent of any graphics API. Surfaces are tightly packed:
+// rows of texels, or rows of 4x4 blocks for block-compressed formats, without padding.
+namespace TextureFormat {
+	// Bits per texel, averaged over the block for block-compressed formats; 0 for formats without a
+	// plain texel layout (video, packed 4:2:2 and planar formats).
+	UINT BitsPerPixel(DXGI_FORMAT format);
+	BOOL IsBlockCompressed(DXGI_FORMAT format);
+
+	// Rows are block rows for block-compressed formats. Fails for formats BitsPerPixel does not know.
+	BOOL ComputePitch(DXGI_FORMAT format, UINT width, UINT height, UINT64& rowPitch, UINT& rowCount);
+
+	__forceinline UINT MipExtent(UINT extent, UINT mip);
+	// Length of the full mip chain of a texture whose largest extent is extent.
+	__forceinline UINT MipCount(UINT extent);
+}
+
+#include "TextureFormat.inl"
\ No newline at end of file
@@ -0,0 +1,18 @@
+#ifndef __TEXTUREFORMAT_INL__
+#define __TEXTUREFORMAT_INL__
+
+UINT TextureFormat::MipExtent(UINT extent, UINT mip) {
+	const UINT result = mip < 32 ? extent >> mip : 0;
+	return result > 0 ? result : 1;
+}
+
+UINT TextureFormat::MipCount(UINT extent) {
+	UINT count = 1;
+	while (extent > 1) {
+		extent >>= 1;
+		++count;
+	}
+	return count;
+}
+
+#endif // __TEXTUREFORMAT_INL__
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "DdsFile.h"
+
+// Deduplicates textures by content. A texture is identified by a 64-bit hash of its DDS data, the
+// description and every subresource, and a secondary index maps normalized paths to the same
+// texture so a path seen before resolves without opening the file again. The hash is kept in a
+// manifest next to each file, so the texels are only read again once the file changes. Identical images under
+// different paths share one texture, and so one GPU resource and one descriptor in the renderers.
+// Textures are reference counted; their ids are chosen by the caller when they are first registered.
+class TextureRegistry {
+public:
+	struct Statistics {
+		// Distinct textures and the references to them.
+		UINT Textures = 0;
+		UINT References = 0;
+		// Acquisitions resolved by path and by content.
+		UINT PathHits = 0;
+		UINT ContentHits = 0;
+		// Texel bytes of the distinct textures, and those the hits did not load again.
+		UINT64 UniqueBytes = 0;
+		UINT64 SavedBytes = 0;
+	};
+
+public:
+	TextureRegistry() = default;
+	virtual ~TextureRegistry() = default;
+
+	TextureRegistry(const TextureRegistry&) = delete;
+	TextureRegistry& operator=(const TextureRegistry&) = delete;
+
+public:
+	__forceinline const Statistics& Stats() const;
+
+public:
+	// Resolves the DDS file at path to a registered texture, or registers it under newTexture when
+	// neither its path nor its content is known yet. Either way the texture gains a reference, and
+	// created tells whether the caller still has to create it.
+	BOOL Acquire(const std::string& path, UINT newTexture, UINT& texture, BOOL& created);
+	// Drops a reference and returns TRUE if it was the last one; the caller then destroys the texture.
+	BOOL Release(UINT texture);
+	void Clear();
+
+	static UINT64 ContentHash(const DdsFile& file);
+	// ContentHash of the file at path, taken from the manifest at path + ".hash" when that was written
+	// for the same file size and write time, and computed and stored there otherwise.
+	static UINT64 CachedContentHash(const std::string& path, const DdsFile& file);
+	// Lower case with forward slashes and the dot segments resolved.
+	static std::string NormalizePath(const std::string& path);
+
+private:
+	struct Entry {
+		UINT64 Hash;
+		UINT64 Bytes;
+		UINT References;
+		std::vector<std::string> Paths;
+	};
+
+	std::unordered_map<UINT, Entry> mEntries;
+	std::unordered_map<UINT64, UINT> mHashes;
+	std::unordered_map<std::string, UINT> mPaths;
+
+	Statistics mStats;
+};
+
+#include "TextureRegistry.inl"
\ No newline at end of file
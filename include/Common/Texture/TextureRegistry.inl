@@ -0,0 +1,8 @@
+#ifndef __TEXTUREREGISTRY_INL__
+#define __TEXTUREREGISTRY_INL__
+
+const TextureRegistry::Statistics& TextureRegistry::Stats() const {
+	return mStats;
+}
+
+#endif // __TEXTUREREGISTRY_INL__
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "DdsFile.h"
+
+// GPU side of the TextureStreamer, implemented by the renderers.
+class TextureStreamingDevice {
+public:
+	virtual ~TextureStreamingDevice() = default;
+
+public:
+	// Replaces the GPU copy of the texture with one that holds mips [firstMip, MipLevels) of source.
+	virtual BOOL SetResidentMips(UINT texture, const DdsFile& source, UINT firstMip) = 0;
+	// Whether the copy the last SetResidentMips replaced may still be in use by the GPU. The streamer
+	// leaves such textures as they are until it is released.
+	virtual BOOL IsReplacing(UINT texture) const = 0;
+	virtual void ReleaseTexture(UINT texture) = 0;
+};
+
+// Streams the finer mips of textures in and out under a memory budget. A texture starts with only
+// its mip tail resident: the mips no larger than TailExtent, which are never evicted. Every frame the
+// renderer reports each visible use of a texture; Update turns the finest mip requested into a
+// target and moves textures one mip per step towards their targets, highest priority first, within
+// an upload budget per frame. Mips stay resident for EvictionDelay frames after the last request
+// that needed them. Whenever the targets exceed the memory budget, the textures with the lowest
+// priority are held back to coarser mips first.
+// All decisions are made on the CPU from the sizes of the DDS subresources. Textures are identified
+// by ids the caller chooses, and the device receives the same ids.
+class TextureStreamer {
+public:
+	// Largest extent of the mips that make up the resident tail.
+	static const UINT TailExtent = 64;
+	// Frames a mip stays wanted after the last request that needed it.
+	static const UINT EvictionDelay = 60;
+
+public:
+	struct Settings {
+		// Bytes all resident mips may take together.
+		UINT64 MemoryBudget = 512ull << 20;
+		// Bytes of newly resident mips per Update. The first step of an update always proceeds, so a
+		// mip larger than the budget still streams in.
+		UINT64 UploadBudget = 16ull << 20;
+	};
+
+	struct Statistics {
+		UINT64 ResidentBytes = 0;
+		// Bytes the targets of the last update would take before the memory budget was applied.
+		UINT64 RequestedBytes = 0;
+		UINT64 UploadedBytes = 0;
+		UINT Upgrades = 0;
+		UINT Downgrades = 0;
+		// Textures the memory budget holds coarser than requested.
+		UINT BudgetLimited = 0;
+	};
+
+public:
+	TextureStreamer(TextureStreamingDevice* device);
+	virtual ~TextureStreamer();
+
+	TextureStreamer(const TextureStreamer&) = delete;
+	TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+public:
+	__forceinline const Settings& GetSettings() const;
+	__forceinline void SetSettings(const Settings& settings);
+
+	// Counters of the last update.
+	__forceinline const Statistics& Stats() const;
+
+public:
+	// Opens the DDS file and makes its mip tail resident right away.
+	BOOL AddTexture(UINT texture, const std::string& path);
+	void RemoveTexture(UINT texture);
+	void Clear();
+
+	// Reports a use of the texture for this frame. uvPerUnit is the texture coordinate span of one
+	// unit of the surface's local space, and pixelsPerUnit the pixels that unit covers on screen.
+	// The requested mip is the one whose texels are closest to one per pixel, and the priority is
+	// the screen size of the whole texture. Unknown textures are ignored.
+	void Request(UINT texture, FLOAT uvPerUnit, FLOAT pixelsPerUnit);
+
+	// Applies the requests made since the last update and clears them.
+	BOOL Update();
+
+private:
+	struct Entry;
+
+	BOOL SetResidentMip(UINT texture, Entry& entry, UINT mip);
+	void ApplyBudget(std::vector<std::pair<UINT, Entry*>>& entries);
+
+private:
+	TextureStreamingDevice* mDevice;
+
+	Settings mSettings;
+	Statistics mStats;
+
+	std::unordered_map<UINT, std::unique_ptr<Entry>> mEntries;
+	UINT64 mResidentBytes = 0;
+	UINT64 mFrame = 0;
+};
+
+#include "TextureStreamer.inl"
\ No newline at end of file
@@ -0,0 +1,16 @@
+#ifndef __TEXTURESTREAMER_INL__
+#define __TEXTURESTREAMER_INL__
+
+const TextureStreamer::Settings& TextureStreamer::GetSettings() const {
+	return mSettings;
+}
+
+void TextureStreamer::SetSettings(const Settings& settings) {
+	mSettings = settings;
+}
+
+const TextureStreamer::Statistics& TextureStreamer::Stats() const {
+	return mStats;
+}
+
+#endif // __TEXTURESTREAMER_INL__
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <Windows.h>
+
+// Records what a baked asset was produced from: the content hash of its source and the parameters
+// of the baker, as sorted key/value lines next to the outputs. A loader rebuilds the manifest it
+// expects and compares it with the file instead of trusting that outputs with the right names are
+// current. Bakers write the manifest last, so an interrupted bake never matches.
+class BakeManifest {
+public:
+	BakeManifest() = default;
+	virtual ~BakeManifest() = default;
+
+public:
+	void Set(const std::string& key, const std::string& value);
+	void Set(const std::string& key, UINT64 value);
+	void Set(const std::string& key, FLOAT value);
+	// Written as 16 hexadecimal digits.
+	void SetHash(const std::string& key, UINT64 hash);
+	// Fails if the key is missing or its value is not a hash.
+	BOOL GetHash(const std::string& key, UINT64& hash) const;
+
+	BOOL Load(const std::string& path);
+	BOOL Save(const std::string& path) const;
+
+	// Whether the manifest at path exists and holds exactly these entries.
+	BOOL Matches(const std::string& path) const;
+
+private:
+	std::map<std::string, std::string> mEntries;
+};
\ No newline at end of file
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <Windows.h>
+
+// Decoder for DEFLATE streams (RFC 1951) and their zlib wrapping (RFC 1950), for the compressed
+// chunks of source image formats. The output goes into a caller-sized buffer, as the containers
+// record the uncompressed size; producing more fails instead of truncating. Huffman codes up to
+// FastBits long are decoded with a single table lookup, and the rare longer ones bit by bit.
+namespace Inflate {
+	static const UINT FastBits = 10;
+
+	// Decodes a raw DEFLATE stream; written receives the bytes produced.
+	BOOL DecompressRaw(const BYTE* src, UINT64 srcSize, BYTE* dst, UINT64 dstSize, UINT64& written);
+
+	// Decodes a zlib stream and verifies its Adler-32 checksum.
+	BOOL Decompress(const BYTE* src, UINT64 srcSize, BYTE* dst, UINT64 dstSize, UINT64& written);
+}
\ No newline at end of file
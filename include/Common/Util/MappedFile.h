@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <Windows.h>
+
+// Read-only view of a whole file mapped into the address space.
+class MappedFile {
+public:
+	MappedFile() = default;
+	virtual ~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+public:
+	__forceinline const BYTE* Data() const;
+	__forceinline UINT64 Size() const;
+
+public:
+	BOOL Open(const std::string& path);
+	void Close();
+
+private:
+	HANDLE mFile = INVALID_HANDLE_VALUE;
+	HANDLE mMapping = NULL;
+
+	const BYTE* mData = nullptr;
+	UINT64 mSize = 0;
+};
+
+#include "MappedFile.inl"
\ No newline at end of file
@@ -0,0 +1,12 @@
+#ifndef __MAPPEDFILE_INL__
+#define __MAPPEDFILE_INL__
+
+const BYTE* MappedFile::Data() const {
+	return mData;
+}
+
+UINT64 MappedFile::Size() const {
+	return mSize;
+}
+
+#endif // __MAPPEDFILE_INL__
\ No newline at end of file
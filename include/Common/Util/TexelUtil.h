@@ -0,0 +1,31 @@
+#pragma once
+
+#include <functional>
+#include <DirectXMath.h>
+#include <Windows.h>
+
+// Helpers shared by the CPU texture cookers and light bakers.
+namespace TexelUtil {
+	// A float RGBA surface, tightly packed, row after row.
+	struct Level {
+		UINT Width;
+		UINT Height;
+		const DirectX::XMFLOAT4* Texels;
+	};
+
+	// Calls body with bands [begin, end) of rows of about texelsPerTask texels each, in parallel on a
+	// TaskQueue when there are threads to spare. Fails when any band does.
+	BOOL ForEachBand(
+		UINT rows,
+		UINT64 rowTexels,
+		UINT64 texelsPerTask,
+		UINT64 numThreads,
+		const std::function<BOOL(UINT, UINT)>& body);
+
+	// Van der Corput radical inverse in base 2, the second coordinate of the Hammersley set.
+	FLOAT RadicalInverse(UINT bits);
+
+	// Bilinear sample of an equirectangular level at (u, v) in [0, 1]; longitude wraps around and
+	// latitude clamps at the poles.
+	DirectX::XMVECTOR Bilinear(const Level& level, FLOAT u, FLOAT v);
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <Windows.h>
+
+// Threads that are created once and then wait for work, for jobs that run every frame where
+// spawning threads per call (as TaskQueue does) would cost more than the work itself.
+// The calling thread takes part in every run, so a pool without workers runs everything inline.
+class WorkerPool {
+public:
+	WorkerPool() = default;
+	virtual ~WorkerPool();
+
+public:
+	// Workers plus the calling thread.
+	__forceinline UINT ThreadCount() const;
+
+public:
+	BOOL Initialize(UINT numWorkers);
+	void CleanUp();
+
+	// Calls task(i) for every i in [0, taskCount) and returns once all calls are done. Fails when any
+	// call does. Runs must not overlap, and a task must not run the pool again.
+	BOOL Run(UINT taskCount, const std::function<BOOL(UINT)>& task);
+
+private:
+	void WorkerLoop();
+	void ExecuteTasks();
+
+private:
+	std::vector<std::thread> mWorkers;
+
+	std::mutex mMutex;
+	std::condition_variable mWakeUp;
+	std::condition_variable mDone;
+
+	const std::function<BOOL(UINT)>* mTask = nullptr;
+	UINT mTaskCount = 0;
+	std::atomic<UINT> mNextTask = 0;
+	std::atomic<BOOL> mStatus = TRUE;
+
+	// Incremented by every run; each worker handles a run exactly once.
+	UINT64 mGeneration = 0;
+	UINT mBusyWorkers = 0;
+	BOOL bStopping = FALSE;
+};
+
+#include "WorkerPool.inl"
\ No newline at end of file
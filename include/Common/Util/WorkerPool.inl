@@ -0,0 +1,8 @@
+#ifndef __WORKERPOOL_INL__
+#define __WORKERPOOL_INL__
+
+UINT WorkerPool::ThreadCount() const {
+	return static_cast<UINT>(mWorkers.size()) + 1;
+}
+
+#endif // __WORKERPOOL_INL__
\ No newline at end of file
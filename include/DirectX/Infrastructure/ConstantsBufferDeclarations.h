@@ -8,6 +8,8 @@ struct ConstantBuffer_Object {
 	DirectX::XMFLOAT4X4 TexTransform;
 	DirectX::XMFLOAT4	Center;
 	DirectX::XMFLOAT4	Extents;
+	// World matrix of the quantized position stream; equal to World for geometries without one.
+	DirectX::XMFLOAT4X4 QuantizedWorld;
 };
 
 struct ConstantBuffer_Material {
@@ -40,10 +42,12 @@ struct ConstantBuffer_Pass {
 	UINT				LightCount;
 
 	DirectX::XMFLOAT2	JitteredOffset;
+	// Whether shaders take diffuse irradiance from IrradianceSH instead of the irradiance cube map.
+	UINT				IrradianceSHEnabled;
 	FLOAT				ConstantPad0;
-	FLOAT				ConstantPad1;
 
 	DirectX::XMFLOAT4	AmbientLight;
+	DirectX::XMFLOAT4	IrradianceSH[9];
 
 	Light				Lights[MaxLights];
 };
@@ -113,6 +113,7 @@ namespace Shadow {
 #ifndef Shadow_ZDepth_RCSTRUCT
 	#define Shadow_ZDepth_RCSTRUCT {	\
 		UINT gLightIndex;				\
+		UINT gFaceIndex;				\
 	};
 #endif
 #ifndef Shadow_Shadow_RCSTRUCT			
@@ -160,6 +161,7 @@ namespace Shadow {
 			struct Struct Shadow_ZDepth_RCSTRUCT
 			enum {
 				E_LightIndex = 0,
+				E_FaceIndex,
 				Count
 			};
 		}
@@ -427,14 +429,6 @@ namespace Pixelation {
 }
 
 namespace IrradianceMap {
-#ifndef IrradianceMap_ConvoluteSpecularIrradiance_RCSTRUCT
-	#define IrradianceMap_ConvoluteSpecularIrradiance_RCSTRUCT {	\
-		UINT	gMipLevel;											\
-		FLOAT	gRoughness;											\
-		FLOAT	gResolution;										\
-	};
-#endif
-
 #ifdef HLSL
 	typedef HDR_FORMAT	DiffuseIrradCubeMapFormat;
 	typedef HDR_FORMAT	DiffuseIrradEquirectMapFormat;
@@ -443,10 +437,6 @@ namespace IrradianceMap {
 	typedef HDR_FORMAT	PrefilteredEnvEquirectMapFormat;
 	typedef HDR_FORMAT	EquirectMapFormat;
 	typedef float2		IntegratedBrdfMapFormat;
-
-	#ifndef IrradianceMap_ConvoluteSpecularIrradiance_RootConstants
-		#define IrradianceMap_ConvoluteSpecularIrradiance_RootConstants(reg) cbuffer cbRootConstants : register(reg) IrradianceMap_ConvoluteSpecularIrradiance_RCSTRUCT
-	#endif
 #else
 	static const DXGI_FORMAT DiffuseIrradCubeMapFormat			= HDR_FORMAT;
 	static const DXGI_FORMAT DiffuseIrradEquirectMapFormat		= HDR_FORMAT;
@@ -465,18 +455,6 @@ namespace IrradianceMap {
 			Count
 		};
 	}
-
-	namespace RootConstant {
-		namespace ConvoluteSpecularIrradiance {
-			struct Struct IrradianceMap_ConvoluteSpecularIrradiance_RCSTRUCT
-			enum {
-				E_MipLevel = 0,
-				E_Roughness,
-				E_Resolution,
-				Count
-			};
-		}
-	}
 #endif
 }
 
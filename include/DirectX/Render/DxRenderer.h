@@ -1,13 +1,20 @@
 #pragma once
 
 #include <Windows.h>
+#include <future>
 
 const INT gNumFrameResources = 3;
 
 #include "Common/Helper/MathHelper.h"
+#include "Common/Render/Culling.h"
+#include "Common/Render/DynamicAabbTree.h"
+#include "Common/Render/OcclusionCuller.h"
 #include "Common/Render/RenderItem.h"
 #include "Common/Light/Light.h"
+#include "Common/Texture/TextureRegistry.h"
+#include "Common/Texture/TextureStreamer.h"
 #include "Common/Util/Locker.h"
+#include "Common/Util/WorkerPool.h"
 #include "DirectX/Render/DxLowRenderer.h"
 
 #include "HlslCompaction.h"
@@ -61,7 +68,7 @@ namespace DebugMapLayout {
 	};
 }
 
-class DxRenderer : public Renderer, public DxLowRenderer {
+class DxRenderer : public Renderer, public DxLowRenderer, public TextureStreamingDevice {
 public:
 	DxRenderer();
 	virtual ~DxRenderer();
@@ -81,6 +88,7 @@ public:
 	virtual void UpdateModel(void* const model, const Transform& trans) override;
 	virtual void SetModelVisibility(void* const model, BOOL visible) override;
 	virtual void SetModelPickable(void* const model, BOOL pickable) override;
+	virtual void SetModelOccluder(void* const model, BOOL occluder) override;
 
 	virtual BOOL SetCubeMap(const std::string& file) override;
 	virtual BOOL SetEquirectangularMap(const std::string& file) override;
@@ -90,10 +98,17 @@ public:
 	virtual BOOL CreateRtvAndDsvDescriptorHeaps();
 
 	BOOL AddGeometry(const std::string& file);
-	BOOL AddMaterial(const std::string& file, const Material& material);
+	BOOL AddMaterial(const std::string& name, const Material& material);
 	void* AddRenderItem(const std::string& file, const Transform& trans, RenderType::Type type);
 
-	UINT AddTexture(const std::string& file, const Material& material);
+	UINT AddTexture(const Material& material);
+
+	virtual BOOL SetResidentMips(UINT texture, const DdsFile& source, UINT firstMip) override;
+	virtual BOOL IsReplacing(UINT texture) const override;
+	virtual void ReleaseTexture(UINT texture) override;
+
+	BOOL SubmitStreamingUploads();
+
 private:
 	BOOL CompileShaders();
 	BOOL BuildGeometries();
@@ -117,6 +132,10 @@ private:
 	BOOL UpdateCB_RTAO(FLOAT delta);
 	BOOL UpdateCB_Debug(FLOAT delta);
 
+	BOOL CullRenderItems();
+	void SelectLods();
+	BOOL StreamTextures();
+
 	BOOL AddBLAS(ID3D12GraphicsCommandList4* const cmdList, MeshGeometry* const geo);
 	BOOL BuildTLAS(ID3D12GraphicsCommandList4* const cmdList);
 	BOOL UpdateTLAS(ID3D12GraphicsCommandList4* const cmdList);
@@ -168,11 +187,25 @@ private:
 
 	std::unordered_map<std::string, std::unique_ptr<MeshGeometry>> mGeometries;
 	std::unordered_map<std::string, std::unique_ptr<MaterialData>> mMaterials;
-	std::unordered_map<std::string, std::unique_ptr<Texture>> mTextures;
+	// Keyed by descriptor index, which also identifies the texture to the registry and the streamer.
+	std::unordered_map<UINT, std::unique_ptr<Texture>> mTextures;
+
+	// Materials with identical diffuse maps share one texture; the textures stream their mips.
+	std::unique_ptr<TextureRegistry> mTextureRegistry;
+	std::unique_ptr<TextureStreamer> mTextureStreamer;
+	// Mips streamed in during a frame are uploaded in one batch, submitted ahead of the frame's draws.
+	// Nothing waits for the batches; their upload heaps are freed as the futures complete.
+	std::unique_ptr<DirectX::ResourceUploadBatch> mStreamingUpload;
+	BOOL bStreamingUploadOpen = FALSE;
+	std::vector<std::future<void>> mStreamingUploads;
 
 	std::vector<std::unique_ptr<RenderItem>> mRitems;
 	std::vector<RenderItem*> mRitemRefs[RenderType::Count];
 
+	// Per-view visible lists rebuilt every frame by CPU frustum culling.
+	std::vector<RenderItem*> mVisibleRitemRefs[RenderType::Count];
+	Culling::ShadowCasterLists mShadowCasters[MaxLights];
+
 	UINT mCurrDescriptorIndex = 0;
 	CD3DX12_CPU_DESCRIPTOR_HANDLE mhCpuDescForTexMaps;
 	CD3DX12_GPU_DESCRIPTOR_HANDLE mhGpuDescForTexMaps;
@@ -220,6 +253,12 @@ private:
 
 	std::unordered_map<DebugMapLayout::Type, BOOL> mDebugMapStates;
 
+	// World-space bounds of the opaque render items for picking and spatial queries.
+	std::unique_ptr<DynamicAabbTree> mSceneTree;
+	std::unique_ptr<OcclusionCuller> mOcclusionCuller;
+	// Persistent threads for the per-frame culling and occluder rasterization.
+	std::unique_ptr<WorkerPool> mWorkerPool;
+
 	RenderItem* mPickedRitem = nullptr;
 	RenderItem* mSkySphere = nullptr;
 
@@ -5,6 +5,8 @@
 #include <unordered_map>
 #include <wrl.h>
 
+#include "Common/Light/BrdfLut.h"
+#include "Common/Light/SphericalHarmonics.h"
 #include "Common/Util/Locker.h"
 #include "DirectX/Util/MipmapGenerator.h"
 
@@ -22,8 +24,6 @@ namespace IrradianceMap {
 	namespace RootSignature {
 		enum {
 			E_ConvoluteDiffuseIrradiance = 0,
-			E_ConvolutePrefilteredIrradiance,
-			E_IntegrateBRDF,
 			E_DrawSkySphere,
 			Count
 		};
@@ -36,22 +36,6 @@ namespace IrradianceMap {
 			};
 		}
 
-		namespace ConvoluteSpecularIrradiance {
-			enum {
-				ECB_ConvEquirectToConv = 0,
-				EC_Consts,
-				ESI_Environment,
-				Count
-			};
-		}
-
-		namespace IntegrateBRDF {
-			enum {
-				ECB_Pass = 0,
-				Count
-			};
-		}
-
 		namespace DrawSkySphere {
 			enum {
 				ECB_Pass = 0,
@@ -67,8 +51,6 @@ namespace IrradianceMap {
 			EG_ConvEquirectToCube = 0,
 			EG_ConvCubeToEquirect,
 			EG_ConvoluteDiffuseIrradiance,
-			EG_ConvolutePrefilteredIrradiance,
-			EG_IntegrateBRDF,
 			EG_DrawSkySphere,
 			Count
 		};
@@ -78,12 +60,6 @@ namespace IrradianceMap {
 		enum Type : std::uint8_t {
 			E_None				= 1 << 0,
 			E_DiffuseIrradiance	= 1 << 1,
-			E_IntegratedBRDF	= 1 << 2,
-			E_PrefilteredL0		= 1 << 3,
-			E_PrefilteredL1		= 1 << 4,
-			E_PrefilteredL2		= 1 << 5,
-			E_PrefilteredL3		= 1 << 6,
-			E_PrefilteredL4		= 1 << 7,
 		};
 	}
 
@@ -95,7 +71,6 @@ namespace IrradianceMap {
 		+ 1				// Diffuse Irradiance CubeMap(1)
 		+ 1				// Diffuse Irradiance Equirectangular Map(1)
 		+ MaxMipLevel	// Prefiltered Irradiance CubeMap(5)
-		+ 1				// Integrated BRDF Map(1)
 		+ MaxMipLevel;	// Prefiltered Irradiance Equirectangular Map(5)
 
 	class IrradianceMapClass {
@@ -115,6 +90,10 @@ namespace IrradianceMap {
 
 		__forceinline constexpr D3D12_GPU_DESCRIPTOR_HANDLE DiffuseIrradianceEquirectMapSrv() const;
 
+		// Irradiance over pi of the current environment map in order-2 spherical harmonics.
+		__forceinline constexpr BOOL IrradianceSHAvailable() const;
+		__forceinline constexpr const SphericalHarmonics::SH9& IrradianceSH() const;
+
 		UINT Size() const;
 
 	public:
@@ -131,6 +110,7 @@ namespace IrradianceMap {
 		BOOL BuildDescriptors();
 
 		BOOL SetEquirectangularMap(ID3D12CommandQueue* const queue, const std::string& file);
+		void SetBrdfLutSettings(const BrdfLut::Settings& settings);
 
 		BOOL Update(
 			ID3D12Device5* const device,
@@ -138,7 +118,6 @@ namespace IrradianceMap {
 			ID3D12DescriptorHeap* const descHeap,
 			ID3D12GraphicsCommandList* const cmdList,
 			EquirectangularConverter::EquirectangularConverterClass* const converter,
-			D3D12_GPU_VIRTUAL_ADDRESS cbPass,
 			D3D12_GPU_VIRTUAL_ADDRESS cbConvEquirectToCube,
 			MipmapGenerator::MipmapGeneratorClass* const generator);
 		BOOL DrawSkySphere(
@@ -169,12 +148,6 @@ namespace IrradianceMap {
 		void GenerateDiffuseIrradiance(
 			ID3D12GraphicsCommandList* const cmdList,
 			D3D12_GPU_VIRTUAL_ADDRESS cbConvEquirectToCube);
-		void GeneratePrefilteredEnvironment(
-			ID3D12GraphicsCommandList* const cmdList,
-			D3D12_GPU_VIRTUAL_ADDRESS cbConvEquirectToCube);
-		void GenerateIntegratedBrdf(
-			ID3D12GraphicsCommandList* const cmdList,
-			D3D12_GPU_VIRTUAL_ADDRESS cbPass);
 
 	private:
 		Locker<ID3D12Device5>* md3dDevice;
@@ -220,7 +193,10 @@ namespace IrradianceMap {
 		std::unique_ptr<GpuResource> mIntegratedBrdfMap;
 		CD3DX12_CPU_DESCRIPTOR_HANDLE mhIntegratedBrdfMapCpuSrv;
 		CD3DX12_GPU_DESCRIPTOR_HANDLE mhIntegratedBrdfMapGpuSrv;
-		CD3DX12_CPU_DESCRIPTOR_HANDLE mhIntegratedBrdfMapCpuRtv;
+
+		// Settings the loaded LUT is expected to be baked with; others are warned about when the
+		// environment is next updated.
+		BrdfLut::Settings mBrdfLutSettings;
 
 		D3D12_VIEWPORT mCubeMapViewport;
 		D3D12_RECT mCubeMapScissorRect;
@@ -228,6 +204,12 @@ namespace IrradianceMap {
 		D3D12_VIEWPORT mIrradEquirectMapViewport;
 		D3D12_RECT mIrradEquirectMapScissorRect;
 
+		// Source of the prefiltered environment, whose bake manifest must match before it is loaded.
+		std::string mEquirectangularMapPath;
+
+		SphericalHarmonics::SH9 mIrradianceSH = {};
+		BOOL bIrradianceSHAvailable = FALSE;
+
 		BOOL bNeedToUpdate = FALSE;
 		Save::Type mNeedToSave = Save::E_None;
 	};
@@ -29,4 +29,12 @@ constexpr D3D12_GPU_DESCRIPTOR_HANDLE IrradianceMap::IrradianceMapClass::Diffuse
 	return mhDiffuseIrradianceEquirectMapGpuSrv;
 }
 
+constexpr BOOL IrradianceMap::IrradianceMapClass::IrradianceSHAvailable() const {
+	return bIrradianceSHAvailable;
+}
+
+constexpr const SphericalHarmonics::SH9& IrradianceMap::IrradianceMapClass::IrradianceSH() const {
+	return mIrradianceSH;
+}
+
 #endif // __IRRADIANCEMAP_INL__
\ No newline at end of file
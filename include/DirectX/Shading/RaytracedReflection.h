@@ -56,14 +56,23 @@ namespace RaytracedReflection {
 				ECB_Mat,
 				ESB_Vertices,
 				ESB_Indices,
+				EC_Consts,
 				Count
 			};
 
+			namespace RootConstantsLayout {
+				enum {
+					E_IndexStride = 0,
+					Count
+				};
+			}
+
 			struct RootArguments {
 				D3D12_GPU_VIRTUAL_ADDRESS	CB_Object;
 				D3D12_GPU_VIRTUAL_ADDRESS	CB_Material;
 				D3D12_GPU_VIRTUAL_ADDRESS	SB_Vertices;
 				D3D12_GPU_VIRTUAL_ADDRESS	AB_Indices;
+				UINT						IndexStride;
 			};
 		}
 	}
@@ -3,6 +3,7 @@
 #include <DirectX/d3dx12.h>
 #include <wrl.h>
 
+#include "Common/Render/Culling.h"
 #include "Common/Util/Locker.h"
 #include "DirectX/Infrastructure/GpuResource.h"
 #include "DirectX/Shading/Samplers.h"
@@ -48,6 +49,10 @@ namespace Shadow {
 	namespace PipelineState {
 		enum {
 			EG_ZDepth = 0,
+			// Draws geometries from their quantized position-only stream.
+			EG_ZDepthQuantized,
+			// Draws alpha-tested materials from the full vertices, discarding cut-out texels.
+			EG_ZDepthAlphaTested,
 			EG_ZDepthCube,
 			EC_Shadow,
 			Count
@@ -129,7 +134,7 @@ namespace Shadow {
 			UINT matCBByteSize,
 			D3D12_GPU_DESCRIPTOR_HANDLE si_pos,
 			D3D12_GPU_DESCRIPTOR_HANDLE si_texMaps,
-			const std::vector<RenderItem*>& ritems,
+			const Culling::ShadowCasterLists& casters,
 			GpuResource* const dst_zdepth,
 			GpuResource* const dst_faceIDCube,
 			UINT lightType,
@@ -154,7 +159,7 @@ namespace Shadow {
 			UINT objCBByteSize, UINT matCBByteSize,
 			D3D12_GPU_DESCRIPTOR_HANDLE si_texMaps,
 			BOOL needCubemap, UINT index,
-			const std::vector<RenderItem*>& ritems);
+			const Culling::ShadowCasterLists& casters);
 		void CopyZDepth(
 			ID3D12GraphicsCommandList* const cmdList,
 			GpuResource* const dst_zdepth, 
@@ -18,6 +18,11 @@
 #endif
 
 class GpuResource;
+class DdsFile;
+
+namespace DirectX {
+	class ResourceUploadBatch;
+}
 
 struct D3D12BufferCreateInfo {
 	UINT64					Size	  = 0;
@@ -81,6 +86,17 @@ namespace D3D12Util {
 	BOOL CreateBuffer(ID3D12Device* const device, D3D12BufferCreateInfo& info, ID3D12Resource** resource, ID3D12InfoQueue* infoQueue = nullptr);
 	BOOL CreateConstantBuffer(ID3D12Device* const device, ID3D12Resource** resource, UINT64 size);
 
+	// Creates a texture for the DDS file and queues the upload of its subresources. The texels are
+	// copied out of the file before returning, so the file may be closed right after. The texture
+	// ends up in D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE once the batch has executed.
+	// A nonzero firstMip leaves out the finer mips: the texture's mip 0 is mip firstMip of the file.
+	BOOL CreateTexture(
+		ID3D12Device* const device,
+		DirectX::ResourceUploadBatch& resourceUpload,
+		const DdsFile& dds,
+		ID3D12Resource** resource,
+		UINT firstMip = 0);
+
 	D3D12_CPU_DESCRIPTOR_HANDLE GetCpuHandle(ID3D12DescriptorHeap* const descHeap, INT index, UINT descriptorSize);
 	D3D12_GPU_DESCRIPTOR_HANDLE GetGpuHandle(ID3D12DescriptorHeap* const descHeap, INT index, UINT descriptorSize);
 
@@ -1,7 +1,10 @@
 #pragma once
 
 #include "Common/Helper/MathHelper.h"
+#include "Common/Mesh/Mesh.h"
+#include "Common/Mesh/TriangleBvh.h"
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <wrl.h>
@@ -21,6 +24,9 @@ struct SubmeshGeometry {
 	UINT StartIndexLocation	= 0;
 	INT BaseVertexLocation	= 0;
 
+	// Index into the materials of the mesh the submesh is drawn with.
+	UINT MaterialIndex		= 0;
+
 	// Bounding box of the geometry defined by this submesh. 
 	// This is used in later chapters of the book.
 	DirectX::BoundingBox AABB;
@@ -41,17 +47,40 @@ struct MeshGeometry {
 	Microsoft::WRL::ComPtr<ID3D12Resource> VertexBufferUploader = nullptr;
 	Microsoft::WRL::ComPtr<ID3D12Resource> IndexBufferUploader = nullptr;
 
+	// Quantized positions for depth-only passes; null for geometries without the stream.
+	Microsoft::WRL::ComPtr<ID3D12Resource> PositionBufferGPU = nullptr;
+	Microsoft::WRL::ComPtr<ID3D12Resource> PositionBufferUploader = nullptr;
+
 	// Data about the buffers.
 	UINT VertexByteStride		= 0;
 	UINT VertexBufferByteSize	= 0;
 	DXGI_FORMAT IndexFormat		= DXGI_FORMAT_R16_UINT;
 	UINT IndexBufferByteSize	= 0;
+	UINT PositionByteStride		= 0;
+	UINT PositionBufferByteSize	= 0;
+
+	// Maps the quantized positions back into the local space of the mesh.
+	DirectX::XMFLOAT4X4 Dequantize = MathHelper::Identity4x4();
 
 	// A MeshGeometry may store multiple geometries in one vertex/index buffer.
 	// Use this container to define the Submesh geometries so we can draw
 	// the Submeshes individually.
 	std::unordered_map<std::string, SubmeshGeometry> DrawArgs;
 
+	// Levels of detail stored in the index buffer, starting with the full-detail mesh.
+	// Empty for geometries without a chain, which are always drawn from DrawArgs.
+	std::vector<MeshLod> Lods;
+
+	// Material ranges of the cooked mesh, SubsetCount of them per level of detail.
+	std::vector<SubmeshGeometry> Subsets;
+	UINT SubsetCount = 0;
+
+	// CPU-side triangle hierarchy in the local space of the mesh for exact ray queries.
+	std::unique_ptr<TriangleBvh> Bvh;
+
+	// Index of the geometry in the occlusion culler; -1 until the mesh is first used as an occluder.
+	INT OccluderMeshIndex = -1;
+
 	D3D12_VERTEX_BUFFER_VIEW VertexBufferView() const {
 		D3D12_VERTEX_BUFFER_VIEW vbv;
 		vbv.BufferLocation = VertexBufferGPU->GetGPUVirtualAddress();
@@ -61,6 +90,15 @@ struct MeshGeometry {
 		return vbv;
 	}
 
+	D3D12_VERTEX_BUFFER_VIEW PositionBufferView() const {
+		D3D12_VERTEX_BUFFER_VIEW vbv;
+		vbv.BufferLocation = PositionBufferGPU->GetGPUVirtualAddress();
+		vbv.StrideInBytes = PositionByteStride;
+		vbv.SizeInBytes = PositionBufferByteSize;
+
+		return vbv;
+	}
+
 	D3D12_INDEX_BUFFER_VIEW IndexBufferView() const {
 		D3D12_INDEX_BUFFER_VIEW ibv;
 		ibv.BufferLocation = IndexBufferGPU->GetGPUVirtualAddress();
@@ -74,6 +112,7 @@ struct MeshGeometry {
 	void DisposeUploaders() {
 		VertexBufferUploader = nullptr;
 		IndexBufferUploader  = nullptr;
+		PositionBufferUploader = nullptr;
 	}
 };
 
@@ -82,6 +121,14 @@ struct Texture {
 
 	Microsoft::WRL::ComPtr<ID3D12Resource> Resource   = nullptr;
 	Microsoft::WRL::ComPtr<ID3D12Resource> UploadHeap = nullptr;
+
+	// Streamed textures alternate between the descriptors DescriptorIndex and DescriptorIndex + 1, so a
+	// replacement never rewrites the descriptor frames in flight still read. SrvIndex is the current one.
+	UINT SrvIndex = 0;
+
+	// Copy replaced last, kept until the GPU passes RetireFence.
+	Microsoft::WRL::ComPtr<ID3D12Resource> Retired = nullptr;
+	UINT64 RetireFence = 0;
 };
 
 struct MaterialData {
@@ -109,4 +156,7 @@ struct MaterialData {
 	FLOAT Metailic	= 0.f;
 	FLOAT Specular  = 0.5f;
 	DirectX::XMFLOAT4X4 MatTransform = MathHelper::Identity4x4();
+
+	// Depth passes need texture coordinates to discard cut-out texels, so they read the full vertices.
+	BOOL AlphaTested = FALSE;
 };
\ No newline at end of file
@@ -107,6 +107,15 @@ namespace VulkanHelper {
 		UINT inWidth,
 		UINT inHeight);
 
+	// Copies a region per mip level, with the levels laid out one after another in the buffer.
+	void CopyBufferToImage(
+		const VkDevice& inDevice,
+		const VkQueue& inQueue,
+		const VkCommandPool& inCommandPool,
+		const VkBuffer& inBuffer,
+		const VkImage& inImage,
+		const std::vector<VkBufferImageCopy>& inRegions);
+
 	BOOL GenerateMipmaps(
 		const VkPhysicalDevice& inPhysicalDevice,
 		const VkDevice& inDevice,
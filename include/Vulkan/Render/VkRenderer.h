@@ -90,6 +90,7 @@ public:
 	virtual void UpdateModel(void* const model, const Transform& trans) override;
 	virtual void SetModelVisibility(void* const model, BOOL visible) override;
 	virtual void SetModelPickable(void* const model, BOOL pickable) override;
+	virtual void SetModelOccluder(void* const model, BOOL occluder) override;
 
 	virtual BOOL SetCubeMap(const std::string& file) override;
 	virtual BOOL SetEquirectangularMap(const std::string& file) override;
@@ -36,4 +36,8 @@ void MeshComponent::SetVisibility(BOOL visible) {
 
 void MeshComponent::SetPickable(BOOL pickable) {
 	GameWorld::GetWorld()->GetRenderer()->SetModelPickable(mModel, FALSE);
+}
+
+void MeshComponent::SetOccluder(BOOL occluder) {
+	GameWorld::GetWorld()->GetRenderer()->SetModelOccluder(mModel, occluder);
 }
\ No newline at end of file
@@ -0,0 +1,528 @@
+#include "Common/Debug/SelfCheck.h"
+#include "Common/Debug/Logger.h"
+#include "Common/Light/SphericalHarmonics.h"
+#include "Common/Mesh/IndexCodec.h"
+#include "Common/Texture/CubeMapConverter.h"
+#include "Common/Texture/HdrDecoder.h"
+#include "Common/Texture/TextureStreamer.h"
+#include "Common/Util/MappedFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <DirectXPackedVector.h>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+#undef max
+#undef min
+
+namespace {
+	const UINT RestartIndex32 = 0xFFFFFFFF;
+	const UINT RestartIndex16 = 0xFFFF;
+
+	BOOL CheckIndexRoundTrip(const std::vector<UINT>& indices) {
+		const UINT count = static_cast<UINT>(indices.size());
+
+		std::vector<BYTE> encoded;
+		IndexCodec::Encode(indices.data(), count, encoded);
+
+		std::vector<UINT> decoded(count);
+		if (!IndexCodec::Decode(encoded.data(), encoded.size(), count, decoded.data())) ReturnFalse(L"32-bit decode failed");
+		if (decoded != indices) ReturnFalse(L"32-bit round trip changed the indices");
+
+		UINT maxIndex = 0;
+		for (const auto index : indices) maxIndex = std::max(maxIndex, index);
+
+		std::vector<USHORT> decoded16(count);
+		const BOOL fits16 = maxIndex <= std::numeric_limits<USHORT>::max();
+		if (IndexCodec::Decode(encoded.data(), encoded.size(), count, decoded16.data()) != fits16)
+			ReturnFalse(L"16-bit decode " << (fits16 ? L"failed" : L"accepted an index that does not fit"));
+
+		if (fits16) {
+			for (UINT i = 0; i < count; ++i)
+				if (decoded16[i] != indices[i]) ReturnFalse(L"16-bit round trip changed index " << i);
+		}
+
+		// Every strict prefix of a non-empty stream is truncated.
+		if (!encoded.empty() && IndexCodec::Decode(encoded.data(), encoded.size() - 1, count, decoded.data()))
+			ReturnFalse(L"Truncated stream was accepted");
+		// So is a stream holding fewer indices than requested.
+		if (IndexCodec::Decode(encoded.data(), encoded.size(), count + 1, std::vector<UINT>(count + 1).data()))
+			ReturnFalse(L"Stream with too few indices was accepted");
+
+		return TRUE;
+	}
+
+	BOOL CheckIndexCodec() {
+		// Empty input encodes to nothing.
+		{
+			std::vector<BYTE> encoded;
+			IndexCodec::Encode(nullptr, 0, encoded);
+			if (!encoded.empty()) ReturnFalse(L"Empty index buffer encoded to " << encoded.size() << L" bytes");
+			if (!IndexCodec::Decode(encoded.data(), 0, 0, static_cast<UINT*>(nullptr))) ReturnFalse(L"Empty stream was rejected");
+			CheckReturn(CheckIndexRoundTrip({}));
+		}
+		// Triangle list in vertex cache order.
+		CheckReturn(CheckIndexRoundTrip({ 0, 1, 2, 2, 1, 3, 2, 3, 4, 4, 3, 5, 0, 2, 6 }));
+		// Strips with restart indices of both widths between them.
+		CheckReturn(CheckIndexRoundTrip({ 0, 1, 2, 3, RestartIndex16, 4, 5, 6, 7, RestartIndex16, 1, 5 }));
+		CheckReturn(CheckIndexRoundTrip({ 0, 1, 2, 3, RestartIndex32, 4, 5, 6, 7, RestartIndex32, RestartIndex32, 2, 6 }));
+		// Deltas near the 32-bit limits in both directions.
+		CheckReturn(CheckIndexRoundTrip({ 0, 0xFFFFFFFE, 1, 0xFFFFFFFF, 0, 0x80000000, 0x7FFFFFFF, 0x80000001, 0xFFFFFFFF, 0 }));
+
+		// A code pointing below zero must be rejected rather than wrap.
+		const BYTE negative[] = { 0x01 };
+		UINT index;
+		if (IndexCodec::Decode(negative, sizeof(negative), 1, &index)) ReturnFalse(L"Index below zero was accepted");
+
+		return TRUE;
+	}
+
+	// Stands in for the GPU side of the TextureStreamer and only records what it was asked to do.
+	class MockStreamingDevice : public TextureStreamingDevice {
+	public:
+		BOOL SetResidentMips(UINT texture, const DdsFile& source, UINT firstMip) override {
+			if (firstMip >= source.Desc().MipLevels) ReturnFalse(L"Texture " << texture << L" was set to mip " << firstMip);
+
+			ResidentMips[texture] = firstMip;
+			return TRUE;
+		}
+
+		BOOL IsReplacing(UINT texture) const override {
+			return Replacing.count(texture) != 0;
+		}
+
+		void ReleaseTexture(UINT texture) override {
+			ResidentMips.erase(texture);
+		}
+
+	public:
+		std::unordered_map<UINT, UINT> ResidentMips;
+		std::unordered_set<UINT> Replacing;
+	};
+
+	// A 256x256 RGBA8 texture with its full mip chain. Its tail starts at mip 2.
+	const UINT StreamedExtent = 256;
+	const UINT64 StreamedMipBytes[] = { 262144, 65536, 21844 };
+	const UINT StreamedTailMip = 2;
+
+	BOOL SaveStreamedTexture(const std::string& path) {
+		DdsFile::Description desc = {};
+		desc.Dimension = TextureDimension::E_Texture2D;
+		desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		desc.Width = StreamedExtent;
+		desc.Height = StreamedExtent;
+		desc.Depth = 1;
+		desc.ArraySize = 1;
+		desc.MipLevels = TextureFormat::MipCount(StreamedExtent);
+
+		std::vector<DdsFile::Subresource> layout;
+		UINT64 totalSize;
+		CheckReturn(DdsFile::ComputeLayout(desc, layout, totalSize));
+
+		std::vector<BYTE> texels(static_cast<size_t>(totalSize));
+		UINT64 offset = 0;
+		for (auto& subresource : layout) {
+			subresource.Data = texels.data() + offset;
+			offset += subresource.SlicePitch;
+		}
+
+		return DdsFile::Save(path, desc, layout);
+	}
+
+	// Two textures streamed against a device that only records the resident mips: residency one mip
+	// per update, textures in replacement left alone, eviction after EvictionDelay frames, the
+	// memory budget holding back the lower priority, and the upload budget pacing the uploads.
+	BOOL CheckTextureStreaming(const std::filesystem::path& scratch) {
+		const std::string path = (scratch / "Streamed.dds").string();
+		CheckReturn(SaveStreamedTexture(path));
+
+		const UINT A = 1;
+		const UINT B = 2;
+		// Bytes of mips [mip, MipLevels).
+		const UINT64 Bytes[] = {
+			StreamedMipBytes[0] + StreamedMipBytes[1] + StreamedMipBytes[2],
+			StreamedMipBytes[1] + StreamedMipBytes[2],
+			StreamedMipBytes[2] };
+
+		MockStreamingDevice device;
+		TextureStreamer streamer(&device);
+
+		const auto Expect = [&](UINT mipA, UINT mipB, const WCHAR* const step) {
+			if (device.ResidentMips[A] != mipA || device.ResidentMips[B] != mipB)
+				ReturnFalse(step << L": mips " << device.ResidentMips[A] << L" and " << device.ResidentMips[B]
+					<< L" are resident instead of " << mipA << L" and " << mipB);
+			if (streamer.Stats().ResidentBytes > streamer.GetSettings().MemoryBudget)
+				ReturnFalse(step << L": " << streamer.Stats().ResidentBytes << L" bytes exceed the memory budget");
+			return TRUE;
+		};
+		// Pixels per unit of a texture spanning one unit; the extent requests mip 0 and half of it mip 1.
+		const auto Request = [&](FLOAT pixelsA, FLOAT pixelsB) {
+			if (pixelsA > 0.f) streamer.Request(A, 1.f, pixelsA);
+			if (pixelsB > 0.f) streamer.Request(B, 1.f, pixelsB);
+			return streamer.Update();
+		};
+
+		const FLOAT Full = static_cast<FLOAT>(StreamedExtent);
+		const FLOAT Half = Full * 0.5f;
+
+		CheckReturn(streamer.AddTexture(A, path));
+		CheckReturn(streamer.AddTexture(B, path));
+		CheckReturn(Expect(StreamedTailMip, StreamedTailMip, L"Added"));
+
+		// One mip per update towards the request.
+		CheckReturn(Request(Full * 2.f, Half));
+		CheckReturn(Expect(1, 1, L"First update"));
+		CheckReturn(Request(Full * 2.f, Half));
+		CheckReturn(Expect(0, 1, L"Second update"));
+		if (streamer.Stats().ResidentBytes != Bytes[0] + Bytes[1])
+			ReturnFalse(L"Resident bytes are " << streamer.Stats().ResidentBytes << L" instead of " << Bytes[0] + Bytes[1]);
+
+		// A texture whose previous copy is still in use waits.
+		device.Replacing.insert(B);
+		CheckReturn(Request(Full * 2.f, Full));
+		CheckReturn(Expect(0, 1, L"Replacing"));
+		device.Replacing.clear();
+		CheckReturn(Request(Full * 2.f, Full));
+		CheckReturn(Expect(0, 0, L"Replaced"));
+
+		// Mips stay for EvictionDelay frames after the last request, then drop back to the tail.
+		for (UINT frame = 1; frame < TextureStreamer::EvictionDelay; ++frame) {
+			CheckReturn(Request(0.f, 0.f));
+			CheckReturn(Expect(0, 0, L"Before eviction"));
+		}
+		CheckReturn(Request(0.f, 0.f));
+		CheckReturn(Expect(StreamedTailMip, StreamedTailMip, L"Eviction"));
+		if (streamer.Stats().Downgrades != 2) ReturnFalse(L"Eviction downgraded " << streamer.Stats().Downgrades << L" textures");
+
+		// Room for one full chain and one chain from mip 1: the lower priority is held back.
+		TextureStreamer::Settings settings;
+		settings.MemoryBudget = Bytes[0] + Bytes[1];
+		settings.UploadBudget = Bytes[0] * 2;
+		streamer.SetSettings(settings);
+
+		CheckReturn(Request(Full * 2.f, Full));
+		CheckReturn(Expect(1, 1, L"Budget, first update"));
+		if (streamer.Stats().RequestedBytes != Bytes[0] * 2 || streamer.Stats().BudgetLimited != 1)
+			ReturnFalse(L"Budget: " << streamer.Stats().RequestedBytes << L" bytes requested and "
+				<< streamer.Stats().BudgetLimited << L" textures limited");
+		CheckReturn(Request(Full * 2.f, Full));
+		CheckReturn(Expect(0, 1, L"Budget, second update"));
+
+		// Swapping the priorities evicts the finest mip of one to make room for the other.
+		CheckReturn(Request(Full, Full * 2.f));
+		CheckReturn(Expect(1, 0, L"Swapped priorities"));
+		if (streamer.Stats().Downgrades != 1 || streamer.Stats().Upgrades != 1)
+			ReturnFalse(L"Swapped priorities: " << streamer.Stats().Downgrades << L" downgrades and "
+				<< streamer.Stats().Upgrades << L" upgrades");
+
+		// The first upload of an update always proceeds, later ones wait for the next update.
+		settings.MemoryBudget = Bytes[0] * 2;
+		settings.UploadBudget = 1;
+		streamer.SetSettings(settings);
+
+		streamer.RemoveTexture(A);
+		if (device.ResidentMips.count(A) != 0) ReturnFalse(L"Removed texture was not released");
+		CheckReturn(streamer.AddTexture(A, path));
+
+		CheckReturn(Request(Full, Full * 2.f));
+		if (streamer.Stats().Upgrades != 1 || streamer.Stats().UploadedBytes != StreamedMipBytes[1])
+			ReturnFalse(L"Upload budget: " << streamer.Stats().Upgrades << L" upgrades of "
+				<< streamer.Stats().UploadedBytes << L" bytes");
+		CheckReturn(Expect(1, 0, L"Upload budget"));
+
+		streamer.Clear();
+		if (!device.ResidentMips.empty()) ReturnFalse(L"Clear left " << device.ResidentMips.size() << L" textures");
+
+		return TRUE;
+	}
+
+	// Environment whose irradiance order-2 spherical harmonics hold exactly: red is brighter above the
+	// horizon, a step whose only even band is the constant while the clamped cosine has no odd bands
+	// above the first, and green and blue vary in bands 1 and 2.
+	XMFLOAT4 TestEnvironment(const XMFLOAT3& dir) {
+		return XMFLOAT4(
+			dir.y > 0.f ? 1.f : 0.25f,
+			0.5f + 0.4f * dir.x,
+			0.5f + 0.4f * dir.x * dir.z,
+			1.f);
+	}
+
+	// Direction of the center of a texel of an equirectangular map, as ProjectEquirectangular reads it.
+	XMFLOAT3 EquirectangularDirection(DOUBLE u, DOUBLE v) {
+		const DOUBLE phi = (u - 0.5) * 2.0 * XM_PI;
+		const DOUBLE lat = (0.5 - v) * XM_PI;
+		return XMFLOAT3(
+			static_cast<FLOAT>(std::cos(phi) * std::cos(lat)),
+			static_cast<FLOAT>(std::sin(lat)),
+			static_cast<FLOAT>(std::sin(phi) * std::cos(lat)));
+	}
+
+	void BuildTestEquirectangular(UINT width, UINT height, std::vector<XMFLOAT4>& texels) {
+		texels.resize(static_cast<size_t>(width) * height);
+		for (UINT y = 0; y < height; ++y) {
+			for (UINT x = 0; x < width; ++x)
+				texels[static_cast<size_t>(y) * width + x] = TestEnvironment(EquirectangularDirection((x + 0.5) / width, (y + 0.5) / height));
+		}
+	}
+
+	// Tightly packed R32G32B32A32_FLOAT view of texels.
+	DdsFile::Subresource FloatSurface(const XMFLOAT4* texels, UINT width, UINT height) {
+		DdsFile::Subresource surface = {};
+		surface.Data = reinterpret_cast<const BYTE*>(texels);
+		surface.RowPitch = width * sizeof(XMFLOAT4);
+		surface.SlicePitch = surface.RowPitch * height;
+		surface.Width = width;
+		surface.Height = height;
+		surface.Depth = 1;
+		surface.RowCount = height;
+		return surface;
+	}
+
+	// Largest difference from the test environment in the channels that are smooth around dir; red
+	// steps at the horizon, where any filter blurs it.
+	FLOAT EnvironmentError(const XMFLOAT3& dir, const XMFLOAT4& texel) {
+		const FLOAT length = std::sqrt(dir.x * dir.x + dir.y * dir.y + dir.z * dir.z);
+		const XMFLOAT3 n(dir.x / length, dir.y / length, dir.z / length);
+		const XMFLOAT4 expected = TestEnvironment(n);
+
+		FLOAT error = std::max(std::abs(texel.y - expected.y), std::abs(texel.z - expected.z));
+		if (std::abs(n.y) > 0.1f) error = std::max(error, std::abs(texel.x - expected.x));
+		return error;
+	}
+
+	// Irradiance over pi of a surface facing normal, by summing the cosine-weighted radiance over a
+	// fine latitude-longitude grid.
+	XMFLOAT3 IntegrateIrradiance(const XMFLOAT3& normal) {
+		const UINT Width = 1024;
+		const UINT Height = 512;
+
+		DOUBLE sum[3] = {};
+		for (UINT y = 0; y < Height; ++y) {
+			const DOUBLE latTop = (0.5 - static_cast<DOUBLE>(y) / Height) * XM_PI;
+			const DOUBLE latBottom = (0.5 - static_cast<DOUBLE>(y + 1) / Height) * XM_PI;
+			const DOUBLE solidAngle = 2.0 * XM_PI / Width * (std::sin(latTop) - std::sin(latBottom));
+
+			for (UINT x = 0; x < Width; ++x) {
+				const XMFLOAT3 dir = EquirectangularDirection((x + 0.5) / Width, (y + 0.5) / Height);
+				const DOUBLE cosine = normal.x * dir.x + normal.y * dir.y + normal.z * dir.z;
+				if (cosine <= 0.0) continue;
+
+				const XMFLOAT4 radiance = TestEnvironment(dir);
+				sum[0] += radiance.x * cosine * solidAngle;
+				sum[1] += radiance.y * cosine * solidAngle;
+				sum[2] += radiance.z * cosine * solidAngle;
+			}
+		}
+
+		return XMFLOAT3(
+			static_cast<FLOAT>(sum[0] / XM_PI),
+			static_cast<FLOAT>(sum[1] / XM_PI),
+			static_cast<FLOAT>(sum[2] / XM_PI));
+	}
+
+	// Projects the test environment from an equirectangular map and compares the irradiance the
+	// coefficients give with the brute-force integration, facing the axes and a few diagonals.
+	BOOL CheckSphericalHarmonics() {
+		const UINT Width = 256;
+		const UINT Height = 128;
+		const FLOAT Tolerance = 1e-3f;
+
+		std::vector<XMFLOAT4> texels;
+		BuildTestEquirectangular(Width, Height, texels);
+
+		SphericalHarmonics::SH9 radiance;
+		CheckReturn(SphericalHarmonics::ProjectEquirectangular(FloatSurface(texels.data(), Width, Height), DXGI_FORMAT_R32G32B32A32_FLOAT, radiance));
+
+		SphericalHarmonics::SH9 irradiance;
+		SphericalHarmonics::ConvolveIrradiance(radiance, 0.f, irradiance);
+
+		const FLOAT d = 0.57735027f;
+		const XMFLOAT3 normals[] = {
+			{ 1.f, 0.f, 0.f }, { -1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f },
+			{ 0.f, -1.f, 0.f }, { 0.f, 0.f, 1.f }, { 0.f, 0.f, -1.f },
+			{ d, d, d }, { -d, d, d }, { d, -d, -d } };
+
+		for (const auto& normal : normals) {
+			const XMFLOAT3 expected = IntegrateIrradiance(normal);
+			const XMFLOAT3 result = SphericalHarmonics::Evaluate(irradiance, normal);
+
+			const FLOAT error = std::max({
+				std::abs(result.x - expected.x), std::abs(result.y - expected.y), std::abs(result.z - expected.z) });
+			if (error > Tolerance)
+				ReturnFalse(L"Irradiance facing (" << normal.x << L", " << normal.y << L", " << normal.z << L") is off by " << error);
+		}
+
+		return TRUE;
+	}
+
+	// Converts the test environment to a cube map and back, comparing the texels with the function
+	// they sample and the projections of both layouts, which line up only when the faces are
+	// oriented the way ProjectCubeMap reads them.
+	BOOL CheckCubeMapConverter() {
+		const UINT Width = 256;
+		const UINT Height = 128;
+		const UINT FaceSize = 48;
+		const FLOAT Tolerance = 0.02f;
+
+		std::vector<XMFLOAT4> equirectangular;
+		BuildTestEquirectangular(Width, Height, equirectangular);
+
+		for (const auto filter : { ResampleFilter::E_Bilinear, ResampleFilter::E_Cubic }) {
+			std::vector<XMFLOAT4> faces;
+			CheckReturn(CubeMapConverter::EquirectangularToCube(equirectangular, Width, Height, FaceSize, filter, 4, faces));
+
+			for (UINT face = 0; face < 6; ++face) {
+				for (UINT y = 0; y < FaceSize; ++y) {
+					for (UINT x = 0; x < FaceSize; ++x) {
+						const FLOAT s = 2.f * (x + 0.5f) / FaceSize - 1.f;
+						const FLOAT t = 2.f * (y + 0.5f) / FaceSize - 1.f;
+						const XMFLOAT4& texel = faces[(static_cast<size_t>(face) * FaceSize + y) * FaceSize + x];
+
+						const FLOAT error = EnvironmentError(CubeMapConverter::CubeDirection(face, s, t), texel);
+						if (error > Tolerance) ReturnFalse(L"Face " << face << L" texel (" << x << L", " << y << L") is off by " << error);
+					}
+				}
+			}
+
+			std::vector<XMFLOAT4> back;
+			CheckReturn(CubeMapConverter::CubeToEquirectangular(faces, FaceSize, Width, Height, filter, 4, back));
+
+			for (UINT y = 0; y < Height; ++y) {
+				for (UINT x = 0; x < Width; ++x) {
+					const FLOAT error = EnvironmentError(
+						EquirectangularDirection((x + 0.5) / Width, (y + 0.5) / Height), back[static_cast<size_t>(y) * Width + x]);
+					if (error > Tolerance) ReturnFalse(L"Equirectangular texel (" << x << L", " << y << L") is off by " << error);
+				}
+			}
+
+			// A cube map in memory for ProjectCubeMap.
+			DdsFile::Description desc = {};
+			desc.Dimension = TextureDimension::E_Texture2D;
+			desc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+			desc.Width = FaceSize;
+			desc.Height = FaceSize;
+			desc.Depth = 1;
+			desc.ArraySize = 6;
+			desc.MipLevels = 1;
+			desc.IsCube = TRUE;
+
+			std::vector<DdsFile::Subresource> surfaces;
+			for (UINT face = 0; face < 6; ++face)
+				surfaces.push_back(FloatSurface(faces.data() + static_cast<size_t>(face) * FaceSize * FaceSize, FaceSize, FaceSize));
+
+			std::vector<BYTE> image;
+			CheckReturn(DdsFile::Write(desc, surfaces, image));
+
+			DdsFile cubeMap;
+			CheckReturn(cubeMap.Parse(image.data(), image.size()));
+
+			SphericalHarmonics::SH9 fromCube, fromEquirectangular;
+			CheckReturn(SphericalHarmonics::ProjectCubeMap(cubeMap, fromCube));
+			CheckReturn(SphericalHarmonics::ProjectEquirectangular(
+				FloatSurface(equirectangular.data(), Width, Height), DXGI_FORMAT_R32G32B32A32_FLOAT, fromEquirectangular));
+
+			for (UINT i = 0; i < SphericalHarmonics::CoefficientCount; ++i) {
+				const XMFLOAT3& a = fromCube.Coefficients[i];
+				const XMFLOAT3& b = fromEquirectangular.Coefficients[i];
+				const FLOAT error = std::max({ std::abs(a.x - b.x), std::abs(a.y - b.y), std::abs(a.z - b.z) });
+				if (error > Tolerance) ReturnFalse(L"Coefficient " << i << L" of the cube map projection is off by " << error);
+			}
+		}
+
+		return TRUE;
+	}
+
+	const std::string ReferenceImagePath = "./../../assets/selfcheck/";
+	const UINT ReferenceImageWidth = 32;
+	const UINT ReferenceImageHeight = 16;
+
+	// The image every reference file holds: red in steps of four texels, green flat in the top and
+	// bottom halves, blue bright along the diagonal, and alpha halved on the right. The OpenEXR files
+	// store alpha as a float channel and the rest as half floats, with a data window that does not
+	// start at the origin.
+	XMFLOAT4 ReferenceTexel(UINT x, UINT y) {
+		return XMFLOAT4(
+			0.25f * (x / 4 + 1),
+			y < 4 ? 0.5f : 8.f,
+			x == y ? 64.f : 0.125f,
+			x < 16 ? 1.f : 0.5f);
+	}
+
+	// Decodes a reference file with one and with several threads and compares every texel with the
+	// reference image. RGBE keeps 8 bits of mantissa under the exponent of the brightest channel, so
+	// Radiance texels may be off by a step of that.
+	BOOL CheckReferenceImage(const std::string& name, BOOL rgbe) {
+		MappedFile file;
+		CheckReturn(file.Open(ReferenceImagePath + name));
+
+		for (const UINT64 numThreads : { 1, 4 }) {
+			std::vector<BYTE> texels;
+			DdsFile::Subresource surface;
+			CheckReturn(HdrDecoder::Decode(file.Data(), file.Size(), numThreads, texels, surface));
+
+			if (surface.Width != ReferenceImageWidth || surface.Height != ReferenceImageHeight)
+				ReturnFalse(name.c_str() << L" decoded to " << surface.Width << L'x' << surface.Height);
+
+			for (UINT y = 0; y < surface.Height; ++y) {
+				const HALF* const row = reinterpret_cast<const HALF*>(surface.Data + y * surface.RowPitch);
+
+				for (UINT x = 0; x < surface.Width; ++x) {
+					const XMFLOAT4 expected = ReferenceTexel(x, y);
+					const FLOAT values[4] = { expected.x, expected.y, expected.z, rgbe ? 1.f : expected.w };
+					const FLOAT tolerance = rgbe ? std::max({ expected.x, expected.y, expected.z }) / 128.f : 0.f;
+
+					for (UINT c = 0; c < 4; ++c) {
+						const FLOAT value = XMConvertHalfToFloat(row[x * 4 + c]);
+						if (std::abs(value - values[c]) > tolerance)
+							ReturnFalse(name.c_str() << L" texel (" << x << L", " << y << L") channel " << c << L" is " << value << L" instead of " << values[c]);
+					}
+				}
+			}
+		}
+
+		return TRUE;
+	}
+
+	BOOL CheckHdrDecoder() {
+		CheckReturn(CheckReferenceImage("reference_rle.hdr", TRUE));
+		CheckReturn(CheckReferenceImage("reference_flat.hdr", TRUE));
+		CheckReturn(CheckReferenceImage("reference_zip.exr", FALSE));
+		CheckReturn(CheckReferenceImage("reference_piz.exr", FALSE));
+
+		return TRUE;
+	}
+}
+
+BOOL SelfCheck::Run() {
+	BOOL passed = TRUE;
+
+	const auto Check = [&](const std::wstring& name, const std::function<BOOL()>& check) {
+		const BOOL result = check();
+		WLogln(result ? L"[Passed] " : L"[Failed] ", name);
+
+		passed = passed && result;
+	};
+
+	// Files the checks write go to a scratch directory that is removed afterwards.
+	std::error_code error;
+	const std::filesystem::path scratch = std::filesystem::temp_directory_path(error) / "MyGameEngine_SelfCheck";
+	std::filesystem::create_directories(scratch, error);
+
+	Check(L"IndexCodec", CheckIndexCodec);
+	Check(L"SphericalHarmonics", CheckSphericalHarmonics);
+	Check(L"CubeMapConverter", CheckCubeMapConverter);
+	Check(L"HdrDecoder", CheckHdrDecoder);
+	Check(L"TextureStreamer", [&] { return CheckTextureStreaming(scratch); });
+
+	std::filesystem::remove_all(scratch, error);
+
+	return passed;
+}
\ No newline at end of file
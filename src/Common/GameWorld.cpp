@@ -13,6 +13,8 @@
 #include "Prefab/BoxActor.h"
 
 #ifdef _DirectX
+#include "Common/Debug/SelfCheck.h"
+#include "Common/Light/EnvironmentCook.h"
 #include "DirectX/Render/DxRenderer.h"
 #else
 #include "Vulkan/Render/VkRenderer.h"
@@ -22,6 +24,8 @@
 #include <imgui/backends/imgui_impl_win32.h>
 
 #include <exception>
+#include <string>
+#include <thread>
 
 #undef min
 #undef max
@@ -31,8 +35,25 @@ using namespace DirectX;
 // Forward declare message handler from imgui_impl_win32.cpp
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
+namespace {
+	const std::string EnvironmentMapPath = "./../../assets/textures/forest_hdr.dds";
+}
+
 INT WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance, PSTR cmdLine, INT showCmd) {
 	try {
+#ifdef _DirectX
+		const std::string args(cmdLine);
+
+		if (args.find("-selfcheck") != std::string::npos) {
+			if (!Logger::LogHelper::StaticInit()) return -1;
+			return SelfCheck::Run() ? 0 : -1;
+		}
+		if (args.find("-cook") != std::string::npos) {
+			if (!Logger::LogHelper::StaticInit()) return -1;
+			return EnvironmentCook::Cook(EnvironmentMapPath, EnvironmentCook::Settings(), std::thread::hardware_concurrency()) ? 0 : -1;
+		}
+#endif
+
 		GameWorld game;
 
 		if (!game.Initialize()) return -1;
@@ -486,7 +507,7 @@ BOOL GameWorld::Draw() {
 }
 
 BOOL GameWorld::LoadData() {
-	CheckReturn(mRenderer->SetEquirectangularMap("./../../assets/textures/forest_hdr.dds"));
+	CheckReturn(mRenderer->SetEquirectangularMap(EnvironmentMapPath));
 
 	XMFLOAT4 rot;
 	XMStoreFloat4(&rot, XMQuaternionRotationAxis(UnitVector::UpVector, XM_PI));
@@ -1,5 +1,44 @@
 #include "Common/HashUtil.h"
 
+#include <cstring>
+
 size_t hu::hash_combine(size_t seed, size_t value) {
 	return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+UINT64 hu::hash_bytes(const void* data, size_t size, UINT64 seed) {
+	const UINT64 m = 0xc6a4a7935bd1e995ull;
+	const INT r = 47;
+
+	const BYTE* p = reinterpret_cast<const BYTE*>(data);
+	const BYTE* const end = p + (size & ~static_cast<size_t>(7));
+
+	UINT64 h = seed ^ (size * m);
+
+	for (; p != end; p += 8) {
+		UINT64 k;
+		std::memcpy(&k, p, sizeof(UINT64));
+
+		k *= m;
+		k ^= k >> r;
+		k *= m;
+
+		h ^= k;
+		h *= m;
+	}
+
+	const size_t remaining = size & 7;
+	if (remaining > 0) {
+		UINT64 k = 0;
+		std::memcpy(&k, p, remaining);
+
+		h ^= k;
+		h *= m;
+	}
+
+	h ^= h >> r;
+	h *= m;
+	h ^= h >> r;
+
+	return h;
 }
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include "Common/Light/BrdfLut.h"
+#include "Common/Debug/Logger.h"
+#include "Common/Util/TaskQueue.h"
+#include "Common/Util/TexelUtil.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <DirectXPackedVector.h>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+#undef max
+#undef min
+
+namespace {
+	// Below this the lobe degenerates to a delta that the samples miss.
+	const FLOAT MinRoughness = 0.04f;
+
+	// Schlick-GGX with the IBL remapping k = a / 2 of GeometryShlickGGX_IBL.
+	DOUBLE GeometrySmith(DOUBLE NdotV, DOUBLE NdotL, DOUBLE roughness) {
+		const DOUBLE k = roughness * roughness * 0.5;
+		const DOUBLE gv = NdotV / (NdotV * (1.0 - k) + k);
+		const DOUBLE gl = NdotL / (NdotL * (1.0 - k) + k);
+		return gv * gl;
+	}
+
+	BYTE ToUnorm8(FLOAT value) {
+		return static_cast<BYTE>(std::min(std::max(value, 0.f), 1.f) * 255.f + 0.5f);
+	}
+}
+
+DXGI_FORMAT BrdfLut::OutputFormat(const Settings& settings) {
+	if (settings.Format == BrdfLutFormat::E_R8G8_Unorm)
+		return settings.EnergyCompensation ? DXGI_FORMAT_R8G8B8A8_UNORM : DXGI_FORMAT_R8G8_UNORM;
+
+	return settings.EnergyCompensation ? DXGI_FORMAT_R16G16B16A16_FLOAT : DXGI_FORMAT_R16G16_FLOAT;
+}
+
+XMFLOAT2 BrdfLut::Integrate(FLOAT NdotV, FLOAT roughness, UINT sampleCount) {
+	roughness = std::max(roughness, MinRoughness);
+
+	// V in the xz-plane around N = +Z.
+	const DOUBLE vx = std::sqrt(std::max(1.0 - static_cast<DOUBLE>(NdotV) * NdotV, 0.0));
+	const DOUBLE vz = NdotV;
+
+	const DOUBLE a = static_cast<DOUBLE>(roughness) * roughness;
+	const DOUBLE a2 = a * a;
+
+	DOUBLE A = 0.0;
+	DOUBLE B = 0.0;
+
+	for (UINT i = 0; i < sampleCount; ++i) {
+		const DOUBLE phi = 2.0 * XM_PI * i / sampleCount;
+		const DOUBLE xi = TexelUtil::RadicalInverse(i);
+
+		const DOUBLE cosTheta = std::sqrt((1.0 - xi) / (1.0 + (a2 - 1.0) * xi));
+		const DOUBLE sinTheta = std::sqrt(1.0 - cosTheta * cosTheta);
+
+		const DOUBLE hx = std::cos(phi) * sinTheta;
+		const DOUBLE hz = cosTheta;
+
+		const DOUBLE VdotH = vx * hx + vz * hz;
+		const DOUBLE NdotL = 2.0 * VdotH * hz - vz;
+		if (NdotL <= 0.0) continue;
+
+		const DOUBLE G = GeometrySmith(vz, NdotL, roughness);
+		const DOUBLE visibility = G * std::max(VdotH, 0.0) / (hz * vz);
+		const DOUBLE Fc = std::pow(1.0 - std::max(VdotH, 0.0), 5.0);
+
+		A += (1.0 - Fc) * visibility;
+		B += Fc * visibility;
+	}
+
+	return XMFLOAT2(static_cast<FLOAT>(A / sampleCount), static_cast<FLOAT>(B / sampleCount));
+}
+
+// Karis, "Physically Based Shading on Mobile".
+XMFLOAT2 BrdfLut::AnalyticFit(FLOAT NdotV, FLOAT roughness) {
+	const FLOAT r0 = roughness * -1.f + 1.f;
+	const FLOAT r1 = roughness * -0.0275f + 0.0425f;
+	const FLOAT r2 = roughness * -0.572f + 1.04f;
+	const FLOAT r3 = roughness * 0.022f - 0.04f;
+
+	const FLOAT a004 = std::min(r0 * r0, std::exp2(-9.28f * NdotV)) * r0 + r1;
+	return XMFLOAT2(a004 * -1.04f + r2, a004 * 1.04f + r3);
+}
+
+BOOL BrdfLut::Generate(const Settings& settings, UINT64 numThreads, std::vector<BYTE>& texels) {
+	if (settings.Size == 0) ReturnFalse(L"Empty BRDF LUT");
+	if (settings.Method == BrdfLutMethod::E_Integrated && settings.SampleCount == 0) ReturnFalse(L"BRDF LUT without samples");
+
+	const UINT size = settings.Size;
+	const UINT channels = settings.EnergyCompensation ? 4 : 2;
+	const BOOL unorm = settings.Format == BrdfLutFormat::E_R8G8_Unorm;
+	const UINT texelSize = channels * (unorm ? 1 : 2);
+
+	texels.resize(static_cast<size_t>(size) * size * texelSize);
+
+	const auto generateRow = [&](UINT y) {
+		const FLOAT roughness = (y + 0.5f) / size;
+		BYTE* row = texels.data() + static_cast<size_t>(y) * size * texelSize;
+
+		for (UINT x = 0; x < size; ++x) {
+			const FLOAT NdotV = (x + 0.5f) / size;
+			const XMFLOAT2 ab = settings.Method == BrdfLutMethod::E_AnalyticFit ?
+				AnalyticFit(NdotV, roughness) : Integrate(NdotV, roughness, settings.SampleCount);
+
+			const FLOAT values[4] = { ab.x, ab.y, std::max(1.f - ab.x - ab.y, 0.f), 1.f };
+
+			BYTE* texel = row + static_cast<size_t>(x) * texelSize;
+			for (UINT c = 0; c < channels; ++c) {
+				if (unorm) {
+					texel[c] = ToUnorm8(values[c]);
+				}
+				else {
+					const HALF half = XMConvertFloatToHalf(values[c]);
+					std::memcpy(texel + c * sizeof(HALF), &half, sizeof(HALF));
+				}
+			}
+		}
+	};
+
+	if (numThreads > 1 && size > 1) {
+		TaskQueue taskQueue;
+		for (UINT y = 0; y < size; ++y) {
+			taskQueue.AddTask([&generateRow, y] {
+				generateRow(y);
+				return true;
+			});
+		}
+
+		CheckReturn(taskQueue.Run(std::min<UINT64>(numThreads, size)));
+	}
+	else {
+		for (UINT y = 0; y < size; ++y)
+			generateRow(y);
+	}
+
+	return TRUE;
+}
+
+void BrdfLut::DescribeBake(const Settings& settings, BakeManifest& manifest) {
+	manifest.Set("Baker", std::string("BrdfLut"));
+	manifest.Set("Version", static_cast<UINT64>(Version));
+	manifest.Set("Size", static_cast<UINT64>(settings.Size));
+	manifest.Set("Format", static_cast<UINT64>(OutputFormat(settings)));
+	manifest.Set("Method", static_cast<UINT64>(settings.Method));
+	// The fit does not sample; its output is the same for any count.
+	manifest.Set("SampleCount", static_cast<UINT64>(settings.Method == BrdfLutMethod::E_Integrated ? settings.SampleCount : 0));
+}
+
+BOOL BrdfLut::Bake(const std::string& path, const std::string& manifestPath, const Settings& settings, UINT64 numThreads) {
+	std::vector<BYTE> texels;
+	CheckReturn(Generate(settings, numThreads, texels));
+
+	DdsFile::Description desc = {};
+	desc.Dimension = TextureDimension::E_Texture2D;
+	desc.Format = OutputFormat(settings);
+	desc.Width = settings.Size;
+	desc.Height = settings.Size;
+	desc.Depth = 1;
+	desc.ArraySize = 1;
+	desc.MipLevels = 1;
+
+	DdsFile::Subresource surface = {};
+	surface.Data = texels.data();
+	surface.Width = settings.Size;
+	surface.Height = settings.Size;
+	surface.Depth = 1;
+	surface.RowCount = settings.Size;
+	surface.RowPitch = texels.size() / settings.Size;
+	surface.SlicePitch = texels.size();
+
+	CheckReturn(DdsFile::Save(path, desc, std::vector<DdsFile::Subresource>{ surface }));
+
+	BakeManifest manifest;
+	DescribeBake(settings, manifest);
+	CheckReturn(manifest.Save(manifestPath));
+
+	return TRUE;
+}
+
+BOOL BrdfLut::IsBakeCurrent(const std::string& manifestPath, const Settings& settings) {
+	BakeManifest expected;
+	DescribeBake(settings, expected);
+
+	return expected.Matches(manifestPath);
+}
\ No newline at end of file
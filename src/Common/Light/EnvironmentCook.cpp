@@ -0,0 +1,100 @@
+#include "Common/Light/EnvironmentCook.h"
+#include "Common/Debug/Logger.h"
+#include "Common/Texture/HdrDecoder.h"
+#include "Common/Texture/TextureRegistry.h"
+
+#include <iterator>
+#include <vector>
+
+#undef max
+#undef min
+
+namespace {
+	// Bumped whenever the cube map of the same source and settings changes.
+	const UINT CubeMapVersion = 1;
+
+	void DescribeCubeMap(UINT64 sourceHash, const EnvironmentCook::Settings& settings, BakeManifest& manifest) {
+		manifest.Set("Baker", std::string("CubeMapConverter"));
+		manifest.Set("Version", static_cast<UINT64>(CubeMapVersion));
+		manifest.SetHash("SourceHash", sourceHash);
+		manifest.Set("FaceSize", static_cast<UINT64>(settings.CubeMapSize));
+		manifest.Set("Filter", static_cast<UINT64>(settings.CubeMapFilter));
+	}
+
+	BOOL CookCubeMap(const std::string& environment, const EnvironmentCook::Settings& settings, UINT64 numThreads) {
+		DdsFile source;
+		CheckReturn(source.Open(environment));
+
+		BakeManifest manifest;
+		DescribeCubeMap(TextureRegistry::ContentHash(source), settings, manifest);
+
+		if (manifest.Matches(EnvironmentCook::EnvironmentCubeMapManifestPath)) {
+			WLogln(L"Environment cube map is up to date");
+			return TRUE;
+		}
+
+		WLogln(L"Converting the environment to a cube map...");
+
+		CheckReturn(CubeMapConverter::CookCubeMap(
+			source, settings.CubeMapSize, settings.CubeMapFilter, TRUE, numThreads, EnvironmentCook::EnvironmentCubeMapPath));
+		CheckReturn(manifest.Save(EnvironmentCook::EnvironmentCubeMapManifestPath));
+
+		return TRUE;
+	}
+
+	BOOL CookPrefilteredEnvironment(const std::string& environment, const EnvironmentPrefilter::Settings& settings, UINT64 numThreads) {
+		if (settings.MipLevels != EnvironmentCook::PrefilteredMipLevels)
+			ReturnFalse(L"The renderer loads " << EnvironmentCook::PrefilteredMipLevels << L" prefiltered mips, not " << settings.MipLevels);
+
+		if (EnvironmentPrefilter::IsBakeCurrent(environment, EnvironmentCook::PrefilteredEnvironmentManifestPath, settings)) {
+			WLogln(L"Prefiltered environment is up to date");
+			return TRUE;
+		}
+
+		WLogln(L"Prefiltering the environment...");
+
+		const std::vector<std::string> paths(
+			std::begin(EnvironmentCook::PrefilteredEnvironmentPaths), std::end(EnvironmentCook::PrefilteredEnvironmentPaths));
+		CheckReturn(EnvironmentPrefilter::Bake(environment, paths, EnvironmentCook::PrefilteredEnvironmentManifestPath, settings, numThreads));
+
+		return TRUE;
+	}
+
+	BOOL CookBrdfLut(const BrdfLut::Settings& settings, UINT64 numThreads) {
+		if (BrdfLut::IsBakeCurrent(EnvironmentCook::IntegratedBrdfManifestPath, settings)) {
+			WLogln(L"Integrated BRDF map is up to date");
+			return TRUE;
+		}
+
+		WLogln(L"Integrating the BRDF map...");
+
+		CheckReturn(BrdfLut::Bake(EnvironmentCook::IntegratedBrdfMapPath, EnvironmentCook::IntegratedBrdfManifestPath, settings, numThreads));
+
+		return TRUE;
+	}
+}
+
+BOOL EnvironmentCook::Cook(const std::string& environment, const Settings& settings, UINT64 numThreads) {
+	std::string path = environment;
+
+	if (HdrDecoder::IsHdrSource(environment)) {
+		const auto index = environment.rfind('.');
+		path = environment.substr(0, index) + ".dds";
+
+		const std::string manifest = environment.substr(0, index) + ".manifest";
+		HdrDecoder::Settings hdrSettings;
+
+		if (!HdrDecoder::IsCookCurrent(environment, manifest, hdrSettings)) {
+			WLogln(L"Decoding ", std::wstring(environment.begin(), environment.end()), L"...");
+			CheckReturn(HdrDecoder::Cook(environment, path, manifest, hdrSettings, numThreads));
+		}
+	}
+
+	WLogln(L"Cooking ", std::wstring(path.begin(), path.end()), L"...");
+
+	CheckReturn(CookCubeMap(path, settings, numThreads));
+	CheckReturn(CookPrefilteredEnvironment(path, settings.Prefilter, numThreads));
+	CheckReturn(CookBrdfLut(settings.BrdfLut, numThreads));
+
+	return TRUE;
+}
\ No newline at end of file
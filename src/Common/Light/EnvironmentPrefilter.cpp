@@ -0,0 +1,242 @@
+#include "Common/Light/EnvironmentPrefilter.h"
+#include "Common/Debug/Logger.h"
+#include "Common/Texture/MipGenerator.h"
+#include "Common/Texture/TexelDecoder.h"
+#include "Common/Texture/TextureRegistry.h"
+#include "Common/Util/TexelUtil.h"
+
+#include <algorithm>
+#include <cmath>
+#include <DirectXPackedVector.h>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+#undef max
+#undef min
+
+namespace {
+	// Rows per task; rows of the coarse mips are cheap, so several go together.
+	const UINT64 TexelsPerTask = 1 << 12;
+
+	// A direction of the lobe around +Z, its cosine weight and the source mip it reads.
+	struct Sample {
+		XMFLOAT3 Direction;
+		FLOAT Weight;
+		FLOAT Lod;
+	};
+
+	// Builds the lobe once per mip; with the view along the normal it is the same for every texel.
+	void BuildSamples(FLOAT roughness, UINT sampleCount, const TexelUtil::Level& source, UINT width, std::vector<Sample>& samples) {
+		samples.clear();
+
+		// A mirror lobe reads the source at the footprint of one output texel.
+		if (roughness <= 0.f) {
+			const FLOAT lod = std::max(std::log2(static_cast<FLOAT>(source.Width) / width), 0.f);
+			samples.push_back({ XMFLOAT3(0.f, 0.f, 1.f), 1.f, lod });
+			return;
+		}
+
+		const FLOAT a = roughness * roughness;
+		const FLOAT a2 = a * a;
+		const FLOAT texelSolidAngle = 4.f * XM_PI / (static_cast<FLOAT>(source.Width) * source.Height);
+
+		for (UINT i = 0; i < sampleCount; ++i) {
+			const FLOAT phi = 2.f * XM_PI * i / sampleCount;
+			const FLOAT xi = TexelUtil::RadicalInverse(i);
+
+			const FLOAT cosTheta = std::sqrt((1.f - xi) / (1.f + (a2 - 1.f) * xi));
+			const FLOAT sinTheta = std::sqrt(1.f - cosTheta * cosTheta);
+			const XMFLOAT3 h(std::cos(phi) * sinTheta, std::sin(phi) * sinTheta, cosTheta);
+
+			// L reflects V = N = +Z about H.
+			const XMFLOAT3 l(2.f * cosTheta * h.x, 2.f * cosTheta * h.y, 2.f * cosTheta * cosTheta - 1.f);
+			if (l.z <= 0.f) continue;
+
+			// With V = N the pdf of L reduces to D / 4.
+			const FLOAT denom = cosTheta * cosTheta * (a2 - 1.f) + 1.f;
+			const FLOAT pdf = a2 / (XM_PI * denom * denom) * 0.25f;
+			const FLOAT sampleSolidAngle = 1.f / (sampleCount * pdf + 1e-6f);
+
+			// One mip coarser than the matching footprint smooths the overlap between samples.
+			const FLOAT lod = std::max(0.5f * std::log2(sampleSolidAngle / texelSolidAngle) + 1.f, 0.f);
+
+			samples.push_back({ l, l.z, lod });
+		}
+	}
+
+	// Same layout as Equirectangular.hlsli.
+	XMVECTOR SampleEquirectangular(const std::vector<TexelUtil::Level>& levels, FXMVECTOR dir, FLOAT lod) {
+		XMFLOAT3 d;
+		XMStoreFloat3(&d, dir);
+
+		const FLOAT u = std::atan2(d.z, d.x) / (2.f * XM_PI) + 0.5f;
+		const FLOAT v = 0.5f - std::asin(std::min(std::max(d.y, -1.f), 1.f)) / XM_PI;
+
+		const FLOAT maxLod = static_cast<FLOAT>(levels.size() - 1);
+		lod = std::min(lod, maxLod);
+
+		const UINT fine = static_cast<UINT>(lod);
+		const FLOAT t = lod - fine;
+
+		const XMVECTOR color = TexelUtil::Bilinear(levels[fine], u, v);
+		if (t <= 0.f) return color;
+
+		return XMVectorLerp(color, TexelUtil::Bilinear(levels[fine + 1], u, v), t);
+	}
+}
+
+BOOL EnvironmentPrefilter::Prefilter(
+		const DdsFile::Subresource& environment,
+		DXGI_FORMAT format,
+		const Settings& settings,
+		UINT64 numThreads,
+		std::vector<std::vector<XMFLOAT4>>& mips) {
+	if (settings.Width == 0 || settings.Height == 0 || settings.MipLevels == 0) ReturnFalse(L"Empty prefiltered environment");
+
+	std::vector<XMFLOAT4> source;
+	CheckReturn(TexelDecoder::Decode(environment, format, source));
+
+	// The source chain is box filtered in float; the lobes do the rest of the smoothing.
+	DdsFile::Subresource top = {};
+	top.Data = reinterpret_cast<const BYTE*>(source.data());
+	top.Width = environment.Width;
+	top.Height = environment.Height;
+	top.Depth = 1;
+	top.RowCount = environment.Height;
+	top.RowPitch = static_cast<UINT64>(environment.Width) * sizeof(XMFLOAT4);
+	top.SlicePitch = top.RowPitch * environment.Height;
+
+	MipGenerator::Settings mipSettings;
+	mipSettings.Filter = MipFilter::E_Box;
+
+	std::vector<BYTE> chainTexels;
+	std::vector<DdsFile::Subresource> chain;
+	CheckReturn(MipGenerator::Generate(top, DXGI_FORMAT_R32G32B32A32_FLOAT, mipSettings, numThreads, chainTexels, chain));
+
+	std::vector<TexelUtil::Level> levels;
+	levels.push_back({ top.Width, top.Height, source.data() });
+	for (const auto& mip : chain)
+		levels.push_back({ mip.Width, mip.Height, reinterpret_cast<const XMFLOAT4*>(mip.Data) });
+
+	mips.resize(settings.MipLevels);
+
+	std::vector<Sample> samples;
+	for (UINT mip = 0; mip < settings.MipLevels; ++mip) {
+		const UINT width = std::max(settings.Width >> mip, 1u);
+		const UINT height = std::max(settings.Height >> mip, 1u);
+
+		BuildSamples(settings.RoughnessStep * mip, settings.SampleCount, levels[0], width, samples);
+
+		auto& texels = mips[mip];
+		texels.resize(static_cast<size_t>(width) * height);
+
+		CheckReturn(TexelUtil::ForEachBand(height, static_cast<UINT64>(width) * samples.size(), TexelsPerTask, numThreads, [&](UINT begin, UINT end) {
+			for (UINT y = begin; y < end; ++y) {
+				const FLOAT lat = (0.5f - (y + 0.5f) / height) * XM_PI;
+				const FLOAT cosLat = std::cos(lat);
+				const FLOAT sinLat = std::sin(lat);
+
+				for (UINT x = 0; x < width; ++x) {
+					const FLOAT phi = ((x + 0.5f) / width - 0.5f) * 2.f * XM_PI;
+					const XMVECTOR n = XMVectorSet(std::cos(phi) * cosLat, sinLat, std::sin(phi) * cosLat, 0.f);
+
+					// Same tangent frame as ImportanceSampleGGX in BRDF.hlsli.
+					const XMVECTOR up = std::abs(XMVectorGetZ(n)) < 0.999f ? XMVectorSet(0.f, 0.f, 1.f, 0.f) : XMVectorSet(1.f, 0.f, 0.f, 0.f);
+					const XMVECTOR tangent = XMVector3Normalize(XMVector3Cross(up, n));
+					const XMVECTOR bitangent = XMVector3Cross(n, tangent);
+
+					XMVECTOR sum = XMVectorZero();
+					FLOAT totalWeight = 0.f;
+
+					for (const auto& sample : samples) {
+						XMVECTOR l = XMVectorScale(tangent, sample.Direction.x);
+						l = XMVectorMultiplyAdd(XMVectorReplicate(sample.Direction.y), bitangent, l);
+						l = XMVectorMultiplyAdd(XMVectorReplicate(sample.Direction.z), n, l);
+
+						sum = XMVectorMultiplyAdd(XMVectorReplicate(sample.Weight), SampleEquirectangular(levels, l, sample.Lod), sum);
+						totalWeight += sample.Weight;
+					}
+
+					XMVECTOR color = totalWeight > 0.f ? XMVectorScale(sum, 1.f / totalWeight) : XMVectorZero();
+					color = XMVectorSetW(color, 1.f);
+					XMStoreFloat4(&texels[static_cast<size_t>(y) * width + x], color);
+				}
+			}
+
+			return TRUE;
+		}));
+	}
+
+	return TRUE;
+}
+
+void EnvironmentPrefilter::DescribeBake(UINT64 sourceHash, const Settings& settings, BakeManifest& manifest) {
+	manifest.Set("Baker", std::string("EnvironmentPrefilter"));
+	manifest.Set("Version", static_cast<UINT64>(Version));
+	manifest.SetHash("SourceHash", sourceHash);
+	manifest.Set("Width", static_cast<UINT64>(settings.Width));
+	manifest.Set("Height", static_cast<UINT64>(settings.Height));
+	manifest.Set("MipLevels", static_cast<UINT64>(settings.MipLevels));
+	manifest.Set("SampleCount", static_cast<UINT64>(settings.SampleCount));
+	manifest.Set("RoughnessStep", settings.RoughnessStep);
+}
+
+BOOL EnvironmentPrefilter::Bake(
+		const std::string& sourcePath,
+		const std::vector<std::string>& outputPaths,
+		const std::string& manifestPath,
+		const Settings& settings,
+		UINT64 numThreads) {
+	if (outputPaths.size() != settings.MipLevels) ReturnFalse(L"Expected one output path per prefiltered mip");
+
+	DdsFile source;
+	CheckReturn(source.Open(sourcePath));
+	if (source.Desc().IsCube) ReturnFalse(L"The prefiltered environment is baked from an equirectangular map: " << sourcePath.c_str());
+
+	std::vector<std::vector<XMFLOAT4>> mips;
+	CheckReturn(Prefilter(source.GetSubresource(0, 0), source.Desc().Format, settings, numThreads, mips));
+
+	for (UINT mip = 0; mip < settings.MipLevels; ++mip) {
+		DdsFile::Description desc = {};
+		desc.Dimension = TextureDimension::E_Texture2D;
+		desc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+		desc.Width = std::max(settings.Width >> mip, 1u);
+		desc.Height = std::max(settings.Height >> mip, 1u);
+		desc.Depth = 1;
+		desc.ArraySize = 1;
+		desc.MipLevels = 1;
+
+		std::vector<HALF> halves(mips[mip].size() * 4);
+		XMConvertFloatToHalfStream(halves.data(), sizeof(HALF), reinterpret_cast<const FLOAT*>(mips[mip].data()), sizeof(FLOAT), halves.size());
+
+		DdsFile::Subresource surface = {};
+		surface.Data = reinterpret_cast<const BYTE*>(halves.data());
+		surface.Width = desc.Width;
+		surface.Height = desc.Height;
+		surface.Depth = 1;
+		surface.RowCount = desc.Height;
+		surface.RowPitch = static_cast<UINT64>(desc.Width) * 4 * sizeof(HALF);
+		surface.SlicePitch = surface.RowPitch * desc.Height;
+
+		CheckReturn(DdsFile::Save(outputPaths[mip], desc, std::vector<DdsFile::Subresource>{ surface }));
+
+		WLogln(L"Baked prefiltered environment mip-level ", std::to_wstring(mip), L": ", std::wstring(outputPaths[mip].begin(), outputPaths[mip].end()));
+	}
+
+	BakeManifest manifest;
+	DescribeBake(TextureRegistry::ContentHash(source), settings, manifest);
+	CheckReturn(manifest.Save(manifestPath));
+
+	return TRUE;
+}
+
+BOOL EnvironmentPrefilter::IsBakeCurrent(const std::string& sourcePath, const std::string& manifestPath, const Settings& settings) {
+	DdsFile source;
+	if (!source.Open(sourcePath)) return FALSE;
+
+	BakeManifest expected;
+	DescribeBake(TextureRegistry::ContentHash(source), settings, expected);
+
+	return expected.Matches(manifestPath);
+}
\ No newline at end of file
@@ -0,0 +1,175 @@
+#include "Common/Light/SphericalHarmonics.h"
+#include "Common/Debug/Logger.h"
+#include "Common/Texture/CubeMapConverter.h"
+#include "Common/Texture/TexelDecoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+
+#undef max
+#undef min
+
+namespace {
+	struct Accumulator {
+		DOUBLE Sums[SphericalHarmonics::CoefficientCount][3] = {};
+		DOUBLE Weight = 0.0;
+
+		void Add(const XMFLOAT3& dir, const XMFLOAT4& radiance, DOUBLE solidAngle) {
+			FLOAT basis[SphericalHarmonics::CoefficientCount];
+			SphericalHarmonics::EvaluateBasis(dir, basis);
+
+			for (UINT i = 0; i < SphericalHarmonics::CoefficientCount; ++i) {
+				const DOUBLE w = basis[i] * solidAngle;
+				Sums[i][0] += radiance.x * w;
+				Sums[i][1] += radiance.y * w;
+				Sums[i][2] += radiance.z * w;
+			}
+			Weight += solidAngle;
+		}
+
+		// Rescales the sums so the weights cover the sphere exactly, absorbing the discretization error.
+		void Resolve(SphericalHarmonics::SH9& sh) const {
+			const DOUBLE scale = Weight > 0.0 ? 4.0 * XM_PI / Weight : 0.0;
+			for (UINT i = 0; i < SphericalHarmonics::CoefficientCount; ++i) {
+				sh.Coefficients[i] = XMFLOAT3(
+					static_cast<FLOAT>(Sums[i][0] * scale),
+					static_cast<FLOAT>(Sums[i][1] * scale),
+					static_cast<FLOAT>(Sums[i][2] * scale));
+			}
+		}
+	};
+
+	// Integral of the solid angle over the cube face from the center to (x, y) on the plane at distance 1.
+	DOUBLE AreaElement(DOUBLE x, DOUBLE y) {
+		return std::atan2(x * y, std::sqrt(x * x + y * y + 1.0));
+	}
+}
+
+void SphericalHarmonics::EvaluateBasis(const XMFLOAT3& dir, FLOAT basis[CoefficientCount]) {
+	const FLOAT x = dir.x;
+	const FLOAT y = dir.y;
+	const FLOAT z = dir.z;
+
+	basis[0] = 0.282095f;
+
+	basis[1] = 0.488603f * y;
+	basis[2] = 0.488603f * z;
+	basis[3] = 0.488603f * x;
+
+	basis[4] = 1.092548f * x * y;
+	basis[5] = 1.092548f * y * z;
+	basis[6] = 0.315392f * (3.f * z * z - 1.f);
+	basis[7] = 1.092548f * x * z;
+	basis[8] = 0.546274f * (x * x - y * y);
+}
+
+BOOL SphericalHarmonics::ProjectEquirectangular(const DdsFile::Subresource& map, DXGI_FORMAT format, SH9& radiance) {
+	std::vector<XMFLOAT4> texels;
+	CheckReturn(TexelDecoder::Decode(map, format, texels));
+
+	const UINT width = map.Width;
+	const UINT height = map.Height;
+	const DOUBLE deltaPhi = 2.0 * XM_PI / width;
+
+	Accumulator accumulator;
+	for (UINT y = 0; y < height; ++y) {
+		// Rows run from the north pole down; each covers the band between its two latitudes.
+		const DOUBLE latTop = (0.5 - static_cast<DOUBLE>(y) / height) * XM_PI;
+		const DOUBLE latBottom = (0.5 - static_cast<DOUBLE>(y + 1) / height) * XM_PI;
+		const DOUBLE lat = (latTop + latBottom) * 0.5;
+		const DOUBLE solidAngle = deltaPhi * (std::sin(latTop) - std::sin(latBottom));
+
+		const FLOAT cosLat = static_cast<FLOAT>(std::cos(lat));
+		const FLOAT sinLat = static_cast<FLOAT>(std::sin(lat));
+
+		for (UINT x = 0; x < width; ++x) {
+			const DOUBLE phi = ((x + 0.5) / width - 0.5) * 2.0 * XM_PI;
+			const XMFLOAT3 dir(
+				static_cast<FLOAT>(std::cos(phi)) * cosLat,
+				sinLat,
+				static_cast<FLOAT>(std::sin(phi)) * cosLat);
+
+			accumulator.Add(dir, texels[static_cast<size_t>(y) * width + x], solidAngle);
+		}
+	}
+
+	accumulator.Resolve(radiance);
+
+	return TRUE;
+}
+
+BOOL SphericalHarmonics::ProjectCubeMap(const DdsFile& cubeMap, SH9& radiance) {
+	const auto& desc = cubeMap.Desc();
+	if (!desc.IsCube || desc.ArraySize < 6) ReturnFalse(L"Not a cube map");
+
+	Accumulator accumulator;
+	std::vector<XMFLOAT4> texels;
+
+	for (UINT face = 0; face < 6; ++face) {
+		const auto& surface = cubeMap.GetSubresource(0, face);
+		CheckReturn(TexelDecoder::Decode(surface, desc.Format, texels));
+
+		const DOUBLE invWidth = 2.0 / surface.Width;
+		const DOUBLE invHeight = 2.0 / surface.Height;
+
+		for (UINT y = 0; y < surface.Height; ++y) {
+			const DOUBLE t0 = y * invHeight - 1.0;
+			const DOUBLE t1 = t0 + invHeight;
+
+			for (UINT x = 0; x < surface.Width; ++x) {
+				const DOUBLE s0 = x * invWidth - 1.0;
+				const DOUBLE s1 = s0 + invWidth;
+
+				const DOUBLE solidAngle = AreaElement(s0, t0) - AreaElement(s0, t1) - AreaElement(s1, t0) + AreaElement(s1, t1);
+
+				XMFLOAT3 dir = CubeMapConverter::CubeDirection(face, static_cast<FLOAT>((s0 + s1) * 0.5), static_cast<FLOAT>((t0 + t1) * 0.5));
+				XMStoreFloat3(&dir, XMVector3Normalize(XMLoadFloat3(&dir)));
+
+				accumulator.Add(dir, texels[static_cast<size_t>(y) * surface.Width + x], solidAngle);
+			}
+		}
+	}
+
+	accumulator.Resolve(radiance);
+
+	return TRUE;
+}
+
+BOOL SphericalHarmonics::ProjectEnvironment(const DdsFile& environment, SH9& radiance) {
+	if (environment.Desc().IsCube) return ProjectCubeMap(environment, radiance);
+	return ProjectEquirectangular(environment.GetSubresource(0, 0), environment.Desc().Format, radiance);
+}
+
+void SphericalHarmonics::ConvolveIrradiance(const SH9& radiance, FLOAT windowWidth, SH9& irradiance) {
+	// Clamped cosine lobe per band (pi, 2pi/3, pi/4), divided by pi.
+	static const FLOAT Lobes[3] = { 1.f, 2.f / 3.f, 0.25f };
+
+	for (UINT band = 0; band < 3; ++band) {
+		FLOAT window = 1.f;
+		if (windowWidth > 0.f)
+			window = band < windowWidth ? 0.5f * (1.f + std::cos(XM_PI * band / windowWidth)) : 0.f;
+
+		const FLOAT scale = Lobes[band] * window;
+		for (UINT i = band * band; i < (band + 1) * (band + 1); ++i) {
+			const XMFLOAT3& c = radiance.Coefficients[i];
+			irradiance.Coefficients[i] = XMFLOAT3(c.x * scale, c.y * scale, c.z * scale);
+		}
+	}
+}
+
+XMFLOAT3 SphericalHarmonics::Evaluate(const SH9& sh, const XMFLOAT3& dir) {
+	FLOAT basis[CoefficientCount];
+	EvaluateBasis(dir, basis);
+
+	XMFLOAT3 result(0.f, 0.f, 0.f);
+	for (UINT i = 0; i < CoefficientCount; ++i) {
+		result.x += sh.Coefficients[i].x * basis[i];
+		result.y += sh.Coefficients[i].y * basis[i];
+		result.z += sh.Coefficients[i].z * basis[i];
+	}
+
+	return result;
+}
\ No newline at end of file
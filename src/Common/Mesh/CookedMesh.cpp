@@ -0,0 +1,429 @@
+#include "Common/Mesh/CookedMesh.h"
+#include "Common/Mesh/IndexCodec.h"
+#include "Common/Debug/Logger.h"
+#include "Common/HashUtil.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace DirectX;
+
+namespace {
+	struct MaterialRecord {
+		XMFLOAT4X4 MatTransform;
+		XMFLOAT4 Albedo;
+		FLOAT Specular;
+		FLOAT Roughness;
+		UINT AlphaTested;
+	};
+
+	__forceinline UINT64 AlignUp(UINT64 value, UINT64 alignment) {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	CookedMesh::Section AppendSection(std::vector<BYTE>& image, const void* data, UINT64 size) {
+		CookedMesh::Section section;
+		section.Offset = AlignUp(image.size(), CookedMesh::SectionAlignment);
+		section.Size = size;
+
+		image.resize(section.Offset + size);
+		if (size > 0) std::memcpy(image.data() + section.Offset, data, size);
+
+		return section;
+	}
+
+	void AppendString(std::vector<BYTE>& blob, const std::string& str) {
+		const UINT length = static_cast<UINT>(str.size());
+		const size_t offset = blob.size();
+
+		blob.resize(offset + sizeof(UINT) + length);
+		std::memcpy(blob.data() + offset, &length, sizeof(UINT));
+		std::memcpy(blob.data() + offset + sizeof(UINT), str.data(), length);
+	}
+
+	BOOL ReadString(const BYTE*& p, const BYTE* const end, std::string& str) {
+		UINT length;
+		if (static_cast<UINT64>(end - p) < sizeof(UINT)) return FALSE;
+		std::memcpy(&length, p, sizeof(UINT));
+		p += sizeof(UINT);
+
+		if (static_cast<UINT64>(end - p) < length) return FALSE;
+		str.assign(reinterpret_cast<const char*>(p), length);
+		p += length;
+
+		return TRUE;
+	}
+
+	BOOL IsInside(const CookedMesh::Section& section, UINT64 fileSize) {
+		return section.Offset % CookedMesh::SectionAlignment == 0 &&
+			section.Offset <= fileSize && section.Size <= fileSize - section.Offset;
+	}
+}
+
+BoundingBox CookedMesh::Bounds() const {
+	BoundingBox aabb;
+	BoundingBox::CreateFromPoints(aabb, XMLoadFloat3(&mHeader->BoundsMin), XMLoadFloat3(&mHeader->BoundsMax));
+	return aabb;
+}
+
+VertexQuantization CookedMesh::Quantization() const {
+	return VertexQuantization::FromBounds(mHeader->BoundsMin, mHeader->BoundsMax);
+}
+
+BOOL CookedMesh::Cook(
+		const Mesh& mesh,
+		const std::vector<Material>& materials,
+		BOOL positionStream,
+		UINT importerVersion,
+		UINT64 sourceHash,
+		const std::vector<std::string>& dependencies) {
+	Close();
+
+	Header header = {};
+	header.Magic = FileMagic;
+	header.FormatVersion = FormatVersion;
+	header.ImporterVersion = importerVersion;
+	header.VertexStride = sizeof(Vertex);
+	header.SourceHash = sourceHash;
+	header.VertexCount = static_cast<UINT>(mesh.Vertices.size());
+	header.IndexCount = static_cast<UINT>(mesh.Indices.size());
+	header.MeshletCount = static_cast<UINT>(mesh.Meshlets.size());
+	header.DependencyCount = static_cast<UINT>(dependencies.size());
+
+	XMVECTOR vMin = XMVectorReplicate(+MathHelper::Infinity);
+	XMVECTOR vMax = XMVectorReplicate(-MathHelper::Infinity);
+	for (const auto& vertex : mesh.Vertices) {
+		const XMVECTOR P = XMLoadFloat3(&vertex.Position);
+
+		vMin = XMVectorMin(vMin, P);
+		vMax = XMVectorMax(vMax, P);
+	}
+	if (mesh.Vertices.empty()) vMin = vMax = XMVectorZero();
+
+	XMStoreFloat3(&header.BoundsMin, vMin);
+	XMStoreFloat3(&header.BoundsMax, vMax);
+
+	std::vector<MeshSubset> subsets(mesh.Subsets);
+	if (subsets.empty()) subsets.push_back({ 0, header.IndexCount, 0, 0, 0 });
+
+	std::vector<MeshLod> lods(mesh.Lods);
+	if (lods.empty()) lods.push_back({ 0, header.IndexCount, 0.f });
+
+	// A mesh without materials is drawn with the default material.
+	const std::vector<Material> defaultMaterials(1);
+	const std::vector<Material>& materialList = materials.empty() ? defaultMaterials : materials;
+
+	for (const auto& subset : subsets) {
+		if (subset.MaterialIndex >= materialList.size()) ReturnFalse(L"Subset material out of range: " << subset.MaterialIndex);
+	}
+	if (!mesh.Subsets.empty() && mesh.LodSubsets.size() != (lods.size() - 1) * subsets.size())
+		ReturnFalse(L"LOD subset count mismatch: " << mesh.LodSubsets.size());
+
+	std::vector<UINT> indices(mesh.Indices);
+	std::vector<Submesh> submeshes;
+
+	const auto AddSubmesh = [&](UINT indexCount, UINT startIndexLocation, INT baseVertexLocation, UINT materialIndex) {
+		Submesh submesh = {};
+		submesh.IndexCount = indexCount;
+		submesh.StartIndexLocation = startIndexLocation;
+		submesh.BaseVertexLocation = baseVertexLocation;
+		submesh.MaterialIndex = materialIndex;
+		submeshes.push_back(submesh);
+	};
+
+	header.IndexStride = IndexCodec::Fits16Bit(header.VertexCount) ? sizeof(USHORT) : sizeof(UINT);
+
+	// The coarser levels of detail follow the full-detail indices.
+	indices.insert(indices.end(), mesh.LodIndices.begin(), mesh.LodIndices.end());
+
+	for (const auto& subset : subsets)
+		AddSubmesh(subset.IndexCount, subset.StartIndexLocation, 0, subset.MaterialIndex);
+
+	for (size_t l = 1, levels = lods.size(); l < levels; ++l) {
+		if (mesh.Subsets.empty()) {
+			AddSubmesh(lods[l].IndexCount, lods[l].StartIndexLocation, 0, 0);
+		}
+		else {
+			for (size_t i = 0, end = subsets.size(); i < end; ++i) {
+				const auto& subset = mesh.LodSubsets[(l - 1) * end + i];
+				AddSubmesh(subset.IndexCount, subset.StartIndexLocation, 0, subset.MaterialIndex);
+			}
+		}
+	}
+
+	header.IndexCount = static_cast<UINT>(indices.size());
+	header.LodCount = static_cast<UINT>(lods.size());
+	header.SubmeshCount = static_cast<UINT>(submeshes.size() / lods.size());
+	header.MaterialCount = static_cast<UINT>(materialList.size());
+
+	for (auto& submesh : submeshes) {
+		submesh.BoundsMin = header.BoundsMin;
+		submesh.BoundsMax = header.BoundsMax;
+
+		if (header.SubmeshCount == 1 || submesh.IndexCount == 0) continue;
+
+		XMVECTOR rMin = XMVectorReplicate(+MathHelper::Infinity);
+		XMVECTOR rMax = XMVectorReplicate(-MathHelper::Infinity);
+		for (UINT j = 0; j < submesh.IndexCount; ++j) {
+			const UINT index = indices[submesh.StartIndexLocation + j] + static_cast<UINT>(submesh.BaseVertexLocation);
+			const XMVECTOR P = XMLoadFloat3(&mesh.Vertices[index].Position);
+
+			rMin = XMVectorMin(rMin, P);
+			rMax = XMVectorMax(rMax, P);
+		}
+
+		XMStoreFloat3(&submesh.BoundsMin, rMin);
+		XMStoreFloat3(&submesh.BoundsMax, rMax);
+	}
+
+	std::vector<BYTE> encodedIndices;
+	IndexCodec::Encode(indices.data(), header.IndexCount, encodedIndices);
+
+	std::vector<BYTE> materialTable;
+	for (const auto& mat : materialList) {
+		MaterialRecord record;
+		record.MatTransform = mat.MatTransform;
+		record.Albedo = mat.Albedo;
+		record.Specular = mat.Specular;
+		record.Roughness = mat.Roughness;
+		record.AlphaTested = mat.AlphaTested ? 1 : 0;
+
+		const size_t offset = materialTable.size();
+		materialTable.resize(offset + sizeof(MaterialRecord));
+		std::memcpy(materialTable.data() + offset, &record, sizeof(MaterialRecord));
+
+		AppendString(materialTable, mat.Name);
+		AppendString(materialTable, mat.DiffuseMapFileName);
+		AppendString(materialTable, mat.NormalMapFileName);
+		AppendString(materialTable, mat.AlphaMapFileName);
+	}
+
+	std::ostringstream bvhStream(std::ios::binary);
+	CheckReturn(mesh.Bvh.Save(bvhStream));
+	const std::string bvh = bvhStream.str();
+
+	const VertexQuantization quant = VertexQuantization::FromBounds(header.BoundsMin, header.BoundsMax);
+	const VertexFormat positionFormat = VertexFormat::PositionOnly();
+
+	std::vector<BYTE> positions;
+	if (positionStream) {
+		positions.resize(static_cast<size_t>(positionFormat.Stride()) * header.VertexCount);
+		positionFormat.Encode(mesh.Vertices.data(), header.VertexCount, quant, positions.data());
+	}
+
+	std::vector<BYTE> deps;
+	for (const auto& dep : dependencies)
+		AppendString(deps, dep);
+
+	mImage.assign(sizeof(Header), 0);
+	header.Vertices = AppendSection(mImage, mesh.Vertices.data(), sizeof(Vertex) * mesh.Vertices.size());
+	header.Positions = AppendSection(mImage, positions.data(), positions.size());
+	header.Indices = AppendSection(mImage, encodedIndices.data(), encodedIndices.size());
+	header.Submeshes = AppendSection(mImage, submeshes.data(), sizeof(Submesh) * submeshes.size());
+	header.Meshlets = AppendSection(mImage, mesh.Meshlets.data(), sizeof(Meshlet) * mesh.Meshlets.size());
+	header.MeshletVertices = AppendSection(mImage, mesh.MeshletVertices.data(), sizeof(UINT) * mesh.MeshletVertices.size());
+	header.MeshletTriangles = AppendSection(mImage, mesh.MeshletTriangles.data(), mesh.MeshletTriangles.size());
+	header.Lods = AppendSection(mImage, lods.data(), sizeof(MeshLod) * lods.size());
+	header.Materials = AppendSection(mImage, materialTable.data(), materialTable.size());
+	header.Bvh = AppendSection(mImage, bvh.data(), bvh.size());
+	header.Dependencies = AppendSection(mImage, deps.data(), deps.size());
+
+	header.FileSize = mImage.size();
+	header.ContentHash = hu::hash_bytes(mImage.data() + sizeof(Header), mImage.size() - sizeof(Header));
+	std::memcpy(mImage.data(), &header, sizeof(Header));
+
+	mData = mImage.data();
+	mHeader = reinterpret_cast<const Header*>(mData);
+
+	// Decode the stream that was just written so a codec fault never reaches the disk.
+	BOOL matches = DecodeIndices();
+	for (UINT i = 0; matches && i < header.IndexCount; ++i) {
+		const UINT index = header.IndexStride == sizeof(USHORT) ?
+			reinterpret_cast<const USHORT*>(mIndices.data())[i] :
+			reinterpret_cast<const UINT*>(mIndices.data())[i];
+		matches = index == indices[i];
+	}
+	if (!matches) {
+		Close();
+		ReturnFalse(L"Index compression round trip failed");
+	}
+
+	return TRUE;
+}
+
+BOOL CookedMesh::Save(const std::string& path) const {
+	if (!IsValid()) ReturnFalse(L"No cooked mesh to save");
+
+	std::error_code error;
+	const std::filesystem::path parent = std::filesystem::path(path).parent_path();
+	if (!parent.empty()) std::filesystem::create_directories(parent, error);
+
+	std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+	if (!stream.is_open()) ReturnFalse(L"Failed to create the cooked mesh: " << path.c_str());
+
+	stream.write(reinterpret_cast<const char*>(mData), static_cast<std::streamsize>(mHeader->FileSize));
+	if (!stream.good()) ReturnFalse(L"Failed to write the cooked mesh: " << path.c_str());
+
+	return TRUE;
+}
+
+BOOL CookedMesh::Open(const std::string& path) {
+	Close();
+
+	CheckReturn(mFile.Open(path));
+
+	if (!Validate(mFile.Data(), mFile.Size())) {
+		mFile.Close();
+		ReturnFalse(L"Invalid cooked mesh: " << path.c_str());
+	}
+
+	mData = mFile.Data();
+	mHeader = reinterpret_cast<const Header*>(mData);
+
+	if (!DecodeIndices()) {
+		Close();
+		ReturnFalse(L"Corrupted index stream in the cooked mesh: " << path.c_str());
+	}
+
+	return TRUE;
+}
+
+void CookedMesh::Close() {
+	mFile.Close();
+	std::vector<BYTE>().swap(mImage);
+	std::vector<BYTE>().swap(mIndices);
+
+	mData = nullptr;
+	mHeader = nullptr;
+}
+
+BOOL CookedMesh::VerifyContent() const {
+	if (!IsValid()) ReturnFalse(L"No cooked mesh to verify");
+
+	if (hu::hash_bytes(mData + sizeof(Header), mHeader->FileSize - sizeof(Header)) != mHeader->ContentHash)
+		ReturnFalse(L"Cooked mesh content hash mismatch");
+
+	return TRUE;
+}
+
+BOOL CookedMesh::LoadMaterials(std::vector<Material>& materials) const {
+	const BYTE* p = mData + mHeader->Materials.Offset;
+	const BYTE* const end = p + mHeader->Materials.Size;
+
+	materials.resize(mHeader->MaterialCount);
+	for (auto& mat : materials) {
+		if (static_cast<UINT64>(end - p) < sizeof(MaterialRecord)) ReturnFalse(L"Cooked material table is truncated");
+
+		MaterialRecord record;
+		std::memcpy(&record, p, sizeof(MaterialRecord));
+		p += sizeof(MaterialRecord);
+
+		mat.MatTransform = record.MatTransform;
+		mat.Albedo = record.Albedo;
+		mat.Specular = record.Specular;
+		mat.Roughness = record.Roughness;
+		mat.AlphaTested = record.AlphaTested != 0;
+
+		if (!ReadString(p, end, mat.Name) ||
+			!ReadString(p, end, mat.DiffuseMapFileName) ||
+			!ReadString(p, end, mat.NormalMapFileName) ||
+			!ReadString(p, end, mat.AlphaMapFileName))
+			ReturnFalse(L"Cooked material table is truncated");
+	}
+
+	return TRUE;
+}
+
+BOOL CookedMesh::LoadBvh(TriangleBvh& bvh) const {
+	return bvh.Load(mData + mHeader->Bvh.Offset, mHeader->Bvh.Size);
+}
+
+BOOL CookedMesh::LoadDependencies(std::vector<std::string>& dependencies) const {
+	const BYTE* p = mData + mHeader->Dependencies.Offset;
+	const BYTE* const end = p + mHeader->Dependencies.Size;
+
+	dependencies.resize(mHeader->DependencyCount);
+	for (auto& dep : dependencies) {
+		if (!ReadString(p, end, dep)) ReturnFalse(L"Cooked dependency list is truncated");
+	}
+
+	return TRUE;
+}
+
+BOOL CookedMesh::Validate(const BYTE* data, UINT64 size) const {
+	if (size < sizeof(Header)) ReturnFalse(L"Cooked mesh is smaller than its header");
+
+	Header header;
+	std::memcpy(&header, data, sizeof(Header));
+
+	if (header.Magic != FileMagic) ReturnFalse(L"Invalid cooked mesh magic");
+	if (header.FormatVersion != FormatVersion) ReturnFalse(L"Unsupported cooked mesh version: " << header.FormatVersion);
+	if (header.VertexStride != sizeof(Vertex)) ReturnFalse(L"Cooked vertex stride mismatch: " << header.VertexStride);
+	if (header.FileSize != size) ReturnFalse(L"Cooked mesh size mismatch: " << header.FileSize << L" != " << size);
+	if (header.IndexStride != sizeof(USHORT) && header.IndexStride != sizeof(UINT)) ReturnFalse(L"Invalid index stride: " << header.IndexStride);
+
+	const UINT64 positionStride = VertexFormat::PositionOnly().Stride();
+
+	if (!IsInside(header.Vertices, size) || header.Vertices.Size != sizeof(Vertex) * static_cast<UINT64>(header.VertexCount) ||
+		!IsInside(header.Positions, size) || (header.Positions.Size != 0 && header.Positions.Size != positionStride * header.VertexCount) ||
+		// Every index takes at least one byte in the compressed stream.
+		!IsInside(header.Indices, size) || header.Indices.Size < header.IndexCount ||
+		!IsInside(header.Submeshes, size) || header.Submeshes.Size != sizeof(Submesh) * static_cast<UINT64>(header.SubmeshCount) * header.LodCount ||
+		!IsInside(header.Meshlets, size) || header.Meshlets.Size != sizeof(Meshlet) * static_cast<UINT64>(header.MeshletCount) ||
+		!IsInside(header.MeshletVertices, size) || header.MeshletVertices.Size % sizeof(UINT) != 0 ||
+		!IsInside(header.MeshletTriangles, size) || header.MeshletTriangles.Size % 3 != 0 ||
+		!IsInside(header.Lods, size) || header.Lods.Size != sizeof(MeshLod) * static_cast<UINT64>(header.LodCount) || header.LodCount == 0 ||
+		!IsInside(header.Materials, size) ||
+		!IsInside(header.Bvh, size) ||
+		!IsInside(header.Dependencies, size))
+		ReturnFalse(L"Cooked mesh section out of range");
+
+	const MeshLod* const lods = reinterpret_cast<const MeshLod*>(data + header.Lods.Offset);
+	for (UINT i = 0; i < header.LodCount; ++i) {
+		MeshLod lod;
+		std::memcpy(&lod, lods + i, sizeof(MeshLod));
+
+		if (static_cast<UINT64>(lod.StartIndexLocation) + lod.IndexCount > header.IndexCount)
+			ReturnFalse(L"Cooked LOD " << i << L" out of range");
+	}
+
+	const Submesh* const submeshes = reinterpret_cast<const Submesh*>(data + header.Submeshes.Offset);
+	for (UINT64 i = 0, end = static_cast<UINT64>(header.SubmeshCount) * header.LodCount; i < end; ++i) {
+		Submesh submesh;
+		std::memcpy(&submesh, submeshes + i, sizeof(Submesh));
+
+		if (static_cast<UINT64>(submesh.StartIndexLocation) + submesh.IndexCount > header.IndexCount ||
+			submesh.MaterialIndex >= header.MaterialCount)
+			ReturnFalse(L"Cooked submesh " << i << L" out of range");
+	}
+
+	// Meshlet runs are read without further checks, so keep them inside their lists.
+	const Meshlet* const meshlets = reinterpret_cast<const Meshlet*>(data + header.Meshlets.Offset);
+	const UINT64 meshletVertexCount = header.MeshletVertices.Size / sizeof(UINT);
+	const UINT64 meshletTriangleCount = header.MeshletTriangles.Size / 3;
+	for (UINT i = 0; i < header.MeshletCount; ++i) {
+		Meshlet meshlet;
+		std::memcpy(&meshlet, meshlets + i, sizeof(Meshlet));
+
+		if (static_cast<UINT64>(meshlet.VertexOffset) + meshlet.VertexCount > meshletVertexCount ||
+			static_cast<UINT64>(meshlet.TriangleOffset) + meshlet.TriangleCount > meshletTriangleCount)
+			ReturnFalse(L"Cooked meshlet " << i << L" out of range");
+	}
+
+	return TRUE;
+}
+
+BOOL CookedMesh::DecodeIndices() {
+	const BYTE* const encoded = mData + mHeader->Indices.Offset;
+	const UINT64 encodedSize = mHeader->Indices.Size;
+	const UINT count = mHeader->IndexCount;
+
+	mIndices.resize(static_cast<size_t>(count) * mHeader->IndexStride);
+
+	if (mHeader->IndexStride == sizeof(USHORT))
+		return IndexCodec::Decode(encoded, encodedSize, count, reinterpret_cast<USHORT*>(mIndices.data()));
+	else
+		return IndexCodec::Decode(encoded, encodedSize, count, reinterpret_cast<UINT*>(mIndices.data()));
+}
\ No newline at end of file
@@ -0,0 +1,974 @@
+#include "Common/Mesh/GltfScene.h"
+#include "Common/Debug/Logger.h"
+#include "Common/Util/MappedFile.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+#undef max
+#undef min
+
+using namespace DirectX;
+
+namespace {
+	namespace JsonType {
+		enum Type {
+			E_Null = 0,
+			E_Bool,
+			E_Number,
+			E_String,
+			E_Array,
+			E_Object
+		};
+	}
+
+	namespace ComponentType {
+		enum Type {
+			E_Byte			= 5120,
+			E_UnsignedByte	= 5121,
+			E_Short			= 5122,
+			E_UnsignedShort	= 5123,
+			E_UnsignedInt	= 5125,
+			E_Float			= 5126
+		};
+	}
+
+	const INT TriangleMode = 4;
+	// Longest number literal accepted by the JSON parser.
+	const UINT MaxNumberLength = 63;
+
+	__forceinline UINT ReadUint(const BYTE* data) {
+		UINT value;
+		std::memcpy(&value, data, sizeof(UINT));
+		return value;
+	}
+
+	__forceinline BOOL IsWhitespace(char c) {
+		return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+	}
+
+	__forceinline BOOL IsNumberChar(char c) {
+		return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+	}
+
+	__forceinline BOOL IsAligned(const void* data, size_t alignment) {
+		return reinterpret_cast<UINT_PTR>(data) % alignment == 0;
+	}
+
+	UINT ComponentSize(UINT type) {
+		switch (type) {
+		case ComponentType::E_Byte:
+		case ComponentType::E_UnsignedByte:
+			return 1;
+		case ComponentType::E_Short:
+		case ComponentType::E_UnsignedShort:
+			return 2;
+		case ComponentType::E_UnsignedInt:
+		case ComponentType::E_Float:
+			return 4;
+		default:
+			return 0;
+		}
+	}
+
+	void AppendUtf8(UINT codePoint, std::string& str) {
+		if (codePoint < 0x80) {
+			str.push_back(static_cast<char>(codePoint));
+		}
+		else if (codePoint < 0x800) {
+			str.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+			str.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+		}
+		else if (codePoint < 0x10000) {
+			str.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+			str.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+			str.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+		}
+		else {
+			str.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+			str.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+			str.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+			str.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+		}
+	}
+
+	BOOL ReadHex4(const char* text, const char* end, UINT& value) {
+		if (end - text < 4) return FALSE;
+
+		value = 0;
+		for (UINT i = 0; i < 4; ++i) {
+			const char c = text[i];
+			value <<= 4;
+			if (c >= '0' && c <= '9') value |= c - '0';
+			else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+			else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+			else return FALSE;
+		}
+
+		return TRUE;
+	}
+}
+
+// Strings point into the mapped document with their escapes unresolved. Containers own a run
+// of JsonDocument::mChildren; objects store their members there as key/value pairs.
+struct GltfScene::JsonValue {
+	JsonType::Type Type;
+	const char* Text;
+	UINT Length;
+	DOUBLE Number;
+	UINT First;
+	UINT Count;
+};
+
+// Read-only DOM over a JSON text that is kept alive by the caller. Lookups tolerate null values
+// so that optional properties can be chained.
+class GltfScene::JsonDocument {
+public:
+	BOOL Parse(const char* text, UINT64 size);
+
+	const JsonValue* Root() const;
+	const JsonValue* Member(const JsonValue* object, const char* key) const;
+	const JsonValue* Element(const JsonValue* array, UINT index) const;
+	UINT Size(const JsonValue* array) const;
+
+	DOUBLE Number(const JsonValue* object, const char* key, DOUBLE fallback) const;
+	INT Int(const JsonValue* object, const char* key, INT fallback) const;
+	BOOL Bool(const JsonValue* object, const char* key, BOOL fallback) const;
+	std::string String(const JsonValue* object, const char* key) const;
+
+	static BOOL Equals(const JsonValue* value, const char* str);
+	static std::string Unescape(const JsonValue* value);
+
+private:
+	BOOL ParseValue(UINT depth, UINT& index);
+	void SkipWhitespace();
+
+private:
+	const char* mCursor = nullptr;
+	const char* mEnd = nullptr;
+
+	std::vector<JsonValue> mValues;
+	std::vector<UINT> mChildren;
+};
+
+BOOL GltfScene::JsonDocument::Parse(const char* text, UINT64 size) {
+	mCursor = text;
+	mEnd = text + size;
+	mValues.clear();
+	mChildren.clear();
+
+	UINT root = 0;
+	CheckReturn(ParseValue(0, root));
+
+	SkipWhitespace();
+	// GLB pads the JSON chunk with spaces; anything else after the root value is an error.
+	if (mCursor != mEnd && *mCursor != '\0') ReturnFalse(L"Unexpected data after the JSON document");
+
+	return TRUE;
+}
+
+const GltfScene::JsonValue* GltfScene::JsonDocument::Root() const {
+	return mValues.empty() ? nullptr : &mValues[0];
+}
+
+const GltfScene::JsonValue* GltfScene::JsonDocument::Member(const JsonValue* object, const char* key) const {
+	if (object == nullptr || object->Type != JsonType::E_Object) return nullptr;
+
+	for (UINT i = 0; i < object->Count; ++i) {
+		const UINT member = object->First + 2 * i;
+		// Member names in glTF never contain escapes, so they are compared raw.
+		if (Equals(&mValues[mChildren[member]], key)) return &mValues[mChildren[member + 1]];
+	}
+
+	return nullptr;
+}
+
+const GltfScene::JsonValue* GltfScene::JsonDocument::Element(const JsonValue* array, UINT index) const {
+	if (array == nullptr || array->Type != JsonType::E_Array || index >= array->Count) return nullptr;
+	return &mValues[mChildren[array->First + index]];
+}
+
+UINT GltfScene::JsonDocument::Size(const JsonValue* array) const {
+	if (array == nullptr || array->Type != JsonType::E_Array) return 0;
+	return array->Count;
+}
+
+DOUBLE GltfScene::JsonDocument::Number(const JsonValue* object, const char* key, DOUBLE fallback) const {
+	const JsonValue* value = Member(object, key);
+	return value != nullptr && value->Type == JsonType::E_Number ? value->Number : fallback;
+}
+
+INT GltfScene::JsonDocument::Int(const JsonValue* object, const char* key, INT fallback) const {
+	return static_cast<INT>(Number(object, key, fallback));
+}
+
+BOOL GltfScene::JsonDocument::Bool(const JsonValue* object, const char* key, BOOL fallback) const {
+	const JsonValue* value = Member(object, key);
+	return value != nullptr && value->Type == JsonType::E_Bool ? value->Number != 0. : fallback;
+}
+
+std::string GltfScene::JsonDocument::String(const JsonValue* object, const char* key) const {
+	return Unescape(Member(object, key));
+}
+
+BOOL GltfScene::JsonDocument::Equals(const JsonValue* value, const char* str) {
+	if (value == nullptr || value->Type != JsonType::E_String) return FALSE;
+
+	const size_t length = std::strlen(str);
+	return value->Length == length && std::memcmp(value->Text, str, length) == 0;
+}
+
+std::string GltfScene::JsonDocument::Unescape(const JsonValue* value) {
+	std::string str;
+	if (value == nullptr || value->Type != JsonType::E_String) return str;
+
+	str.reserve(value->Length);
+
+	const char* end = value->Text + value->Length;
+	for (const char* c = value->Text; c < end; ++c) {
+		if (*c != '\\' || c + 1 == end) {
+			str.push_back(*c);
+			continue;
+		}
+
+		switch (*++c) {
+		case 'b': str.push_back('\b'); break;
+		case 'f': str.push_back('\f'); break;
+		case 'n': str.push_back('\n'); break;
+		case 'r': str.push_back('\r'); break;
+		case 't': str.push_back('\t'); break;
+		case 'u': {
+			UINT codePoint = 0;
+			if (!ReadHex4(c + 1, end, codePoint)) break;
+			c += 4;
+
+			// Combines a UTF-16 surrogate pair.
+			UINT low = 0;
+			if (codePoint >= 0xD800 && codePoint < 0xDC00 && end - c > 2 && c[1] == '\\' && c[2] == 'u' &&
+					ReadHex4(c + 3, end, low) && low >= 0xDC00 && low < 0xE000) {
+				codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+				c += 6;
+			}
+
+			AppendUtf8(codePoint, str);
+			break;
+		}
+		default: str.push_back(*c); break;
+		}
+	}
+
+	return str;
+}
+
+BOOL GltfScene::JsonDocument::ParseValue(UINT depth, UINT& index) {
+	if (depth > MaxJsonDepth) ReturnFalse(L"JSON nesting is too deep");
+
+	SkipWhitespace();
+	if (mCursor == mEnd) ReturnFalse(L"Unexpected end of JSON");
+
+	index = static_cast<UINT>(mValues.size());
+	mValues.push_back(JsonValue{});
+
+	const char c = *mCursor;
+
+	if (c == '{' || c == '[') {
+		const BOOL object = c == '{';
+		const char close = object ? '}' : ']';
+		++mCursor;
+
+		std::vector<UINT> children;
+
+		SkipWhitespace();
+		if (mCursor != mEnd && *mCursor == close) {
+			++mCursor;
+		}
+		else {
+			for (;;) {
+				UINT child = 0;
+
+				if (object) {
+					SkipWhitespace();
+					if (mCursor == mEnd || *mCursor != '"') ReturnFalse(L"Expected a JSON member name");
+
+					CheckReturn(ParseValue(depth + 1, child));
+					children.push_back(child);
+
+					SkipWhitespace();
+					if (mCursor == mEnd || *mCursor != ':') ReturnFalse(L"Expected ':' after a JSON member name");
+					++mCursor;
+				}
+
+				CheckReturn(ParseValue(depth + 1, child));
+				children.push_back(child);
+
+				SkipWhitespace();
+				if (mCursor == mEnd) ReturnFalse(L"Unexpected end of JSON");
+
+				const char next = *mCursor++;
+				if (next == close) break;
+				if (next != ',') ReturnFalse(L"Unexpected character in JSON: " << next);
+			}
+		}
+
+		// Taken after parsing the children, which may have reallocated the value list.
+		JsonValue& value = mValues[index];
+		value.Type = object ? JsonType::E_Object : JsonType::E_Array;
+		value.First = static_cast<UINT>(mChildren.size());
+		value.Count = static_cast<UINT>(object ? children.size() / 2 : children.size());
+
+		mChildren.insert(mChildren.end(), children.begin(), children.end());
+
+		return TRUE;
+	}
+
+	JsonValue& value = mValues[index];
+
+	if (c == '"') {
+		const char* begin = ++mCursor;
+		while (mCursor < mEnd && *mCursor != '"') {
+			if (*mCursor == '\\') ++mCursor;
+			++mCursor;
+		}
+		if (mCursor >= mEnd) ReturnFalse(L"Unterminated JSON string");
+
+		value.Type = JsonType::E_String;
+		value.Text = begin;
+		value.Length = static_cast<UINT>(mCursor - begin);
+		++mCursor;
+
+		return TRUE;
+	}
+
+	const size_t remaining = static_cast<size_t>(mEnd - mCursor);
+
+	if (remaining >= 4 && std::memcmp(mCursor, "true", 4) == 0) {
+		value.Type = JsonType::E_Bool;
+		value.Number = 1.;
+		mCursor += 4;
+		return TRUE;
+	}
+	if (remaining >= 5 && std::memcmp(mCursor, "false", 5) == 0) {
+		value.Type = JsonType::E_Bool;
+		value.Number = 0.;
+		mCursor += 5;
+		return TRUE;
+	}
+	if (remaining >= 4 && std::memcmp(mCursor, "null", 4) == 0) {
+		value.Type = JsonType::E_Null;
+		mCursor += 4;
+		return TRUE;
+	}
+
+	const char* begin = mCursor;
+	while (mCursor < mEnd && IsNumberChar(*mCursor)) ++mCursor;
+
+	const size_t length = static_cast<size_t>(mCursor - begin);
+	if (length == 0 || length > MaxNumberLength) ReturnFalse(L"Invalid JSON value");
+
+	// The document is not null-terminated, so the literal is copied before conversion.
+	char number[MaxNumberLength + 1];
+	std::memcpy(number, begin, length);
+	number[length] = '\0';
+
+	char* numberEnd = nullptr;
+	value.Type = JsonType::E_Number;
+	value.Number = std::strtod(number, &numberEnd);
+	if (numberEnd != number + length) ReturnFalse(L"Invalid JSON number: " << number);
+
+	return TRUE;
+}
+
+void GltfScene::JsonDocument::SkipWhitespace() {
+	while (mCursor < mEnd && IsWhitespace(*mCursor)) ++mCursor;
+}
+
+struct GltfScene::AccessorView {
+	const BYTE* Data;
+	UINT Count;
+	UINT Stride;
+	UINT ComponentType;
+	UINT ComponentCount;
+	BOOL Normalized;
+	INT BufferView;
+};
+
+namespace {
+	// Converts a component to float, applying the normalization rules of the specification.
+	FLOAT ReadComponent(const BYTE* data, UINT type, BOOL normalized) {
+		switch (type) {
+		case ComponentType::E_Float: {
+			FLOAT value;
+			std::memcpy(&value, data, sizeof(FLOAT));
+			return value;
+		}
+		case ComponentType::E_UnsignedByte:
+			return normalized ? *data / 255.f : static_cast<FLOAT>(*data);
+		case ComponentType::E_Byte: {
+			const FLOAT value = static_cast<FLOAT>(static_cast<INT8>(*data));
+			return normalized ? std::max(value / 127.f, -1.f) : value;
+		}
+		case ComponentType::E_UnsignedShort: {
+			USHORT value;
+			std::memcpy(&value, data, sizeof(USHORT));
+			return normalized ? value / 65535.f : static_cast<FLOAT>(value);
+		}
+		case ComponentType::E_Short: {
+			SHORT value;
+			std::memcpy(&value, data, sizeof(SHORT));
+			return normalized ? std::max(value / 32767.f, -1.f) : static_cast<FLOAT>(value);
+		}
+		case ComponentType::E_UnsignedInt: {
+			UINT value;
+			std::memcpy(&value, data, sizeof(UINT));
+			return static_cast<FLOAT>(value);
+		}
+		default:
+			return 0.f;
+		}
+	}
+}
+
+GltfScene::GltfScene() = default;
+
+GltfScene::~GltfScene() = default;
+
+BOOL GltfScene::Open(const std::string& path) {
+	Close();
+
+	mDirectory = std::filesystem::path(path).parent_path().string();
+	if (!mDirectory.empty()) mDirectory += '/';
+
+	auto file = std::make_unique<MappedFile>();
+	CheckReturn(file->Open(path));
+
+	const BYTE* data = file->Data();
+	const UINT64 size = file->Size();
+	mFiles.push_back(std::move(file));
+
+	if (size >= 12 && ReadUint(data) == GlbMagic) {
+		const UINT version = ReadUint(data + 4);
+		const UINT length = ReadUint(data + 8);
+
+		if (version != GlbVersion) ReturnFalse(L"Unsupported GLB version: " << version);
+		if (length > size) ReturnFalse(L"The GLB file is truncated: " << path.c_str());
+
+		const BYTE* json = nullptr;
+		UINT jsonSize = 0;
+
+		// Chunks are 4-byte aligned; the JSON chunk comes first and unknown chunks are skipped.
+		for (UINT64 offset = 12; offset + 8 <= length; ) {
+			const UINT chunkLength = ReadUint(data + offset);
+			const UINT chunkType = ReadUint(data + offset + 4);
+			if (offset + 8 + chunkLength > length) ReturnFalse(L"The GLB chunk at " << offset << L" is truncated");
+
+			const BYTE* chunk = data + offset + 8;
+
+			if (offset == 12) {
+				if (chunkType != JsonChunkType) ReturnFalse(L"The first GLB chunk is not JSON");
+				json = chunk;
+				jsonSize = chunkLength;
+			}
+			else if (chunkType == BinChunkType && mBinChunk == nullptr) {
+				mBinChunk = chunk;
+				mBinChunkSize = chunkLength;
+			}
+
+			offset += 8 + chunkLength;
+		}
+
+		if (json == nullptr) ReturnFalse(L"The GLB file has no JSON chunk: " << path.c_str());
+
+		CheckReturn(ParseDocument(json, jsonSize));
+	}
+	else {
+		CheckReturn(ParseDocument(data, size));
+	}
+
+	CheckReturn(LoadBuffers());
+	// Materials first, so that primitives can validate their material index.
+	LoadMaterials();
+	CheckReturn(LoadMeshes());
+	CheckReturn(LoadNodes());
+
+	return TRUE;
+}
+
+void GltfScene::Close() {
+	mJson.reset();
+	mDirectory.clear();
+
+	mFiles.clear();
+	mBinChunk = nullptr;
+	mBinChunkSize = 0;
+
+	mBufferRanges.clear();
+	mBuffers.clear();
+
+	mVertexCopies.clear();
+	mIndexCopies.clear();
+
+	mPrimitives.clear();
+	mMeshes.clear();
+	mNodes.clear();
+	mMaterials.clear();
+}
+
+BOOL GltfScene::ParseDocument(const BYTE* data, UINT64 size) {
+	mJson = std::make_unique<JsonDocument>();
+	CheckReturn(mJson->Parse(reinterpret_cast<const char*>(data), size));
+
+	const JsonValue* root = mJson->Root();
+	if (root->Type != JsonType::E_Object) ReturnFalse(L"The glTF document is not a JSON object");
+
+	const std::string version = mJson->String(mJson->Member(root, "asset"), "version");
+	if (version.compare(0, 2, "2.") != 0) ReturnFalse(L"Unsupported glTF version: " << version.c_str());
+
+	return TRUE;
+}
+
+BOOL GltfScene::LoadBuffers() {
+	const JsonValue* buffers = mJson->Member(mJson->Root(), "buffers");
+
+	for (UINT i = 0, end = mJson->Size(buffers); i < end; ++i) {
+		const JsonValue* buffer = mJson->Element(buffers, i);
+		const UINT64 byteLength = static_cast<UINT64>(mJson->Number(buffer, "byteLength", 0.));
+
+		BufferRange range = {};
+
+		const JsonValue* uri = mJson->Member(buffer, "uri");
+		if (uri == nullptr) {
+			// Only the first buffer of a .glb file may refer to the BIN chunk.
+			if (i != 0 || mBinChunk == nullptr) ReturnFalse(L"Buffer " << i << L" has no data");
+			range = { mBinChunk, mBinChunkSize };
+		}
+		else {
+			const std::string name = JsonDocument::Unescape(uri);
+			if (name.compare(0, 5, "data:") == 0) ReturnFalse(L"Buffer " << i << L" is a data URI, which is not supported");
+
+			auto file = std::make_unique<MappedFile>();
+			CheckReturn(file->Open(mDirectory + name));
+
+			range = { file->Data(), file->Size() };
+			mFiles.push_back(std::move(file));
+			mBuffers.push_back(name);
+		}
+
+		if (range.Size < byteLength) ReturnFalse(L"Buffer " << i << L" is truncated");
+		// The BIN chunk may be padded past the declared length.
+		range.Size = byteLength;
+
+		mBufferRanges.push_back(range);
+	}
+
+	return TRUE;
+}
+
+BOOL GltfScene::LoadMeshes() {
+	const JsonValue* meshes = mJson->Member(mJson->Root(), "meshes");
+
+	for (UINT i = 0, end = mJson->Size(meshes); i < end; ++i) {
+		const JsonValue* mesh = mJson->Element(meshes, i);
+
+		MeshInfo info = {};
+		info.Name = mJson->String(mesh, "name");
+		info.FirstPrimitive = static_cast<UINT>(mPrimitives.size());
+
+		const JsonValue* primitives = mJson->Member(mesh, "primitives");
+
+		for (UINT j = 0, count = mJson->Size(primitives); j < count; ++j) {
+			const JsonValue* primitive = mJson->Element(primitives, j);
+
+			if (mJson->Int(primitive, "mode", TriangleMode) != TriangleMode) {
+				WLogln(L"Skipping primitive ", std::to_wstring(j), L" of mesh ", std::to_wstring(i), L": only triangle lists are supported");
+				continue;
+			}
+
+			Primitive result = {};
+			CheckReturn(LoadPrimitive(*primitive, result));
+
+			mPrimitives.push_back(result);
+			++info.PrimitiveCount;
+		}
+
+		mMeshes.push_back(std::move(info));
+	}
+
+	return TRUE;
+}
+
+BOOL GltfScene::LoadPrimitive(const JsonValue& primitive, Primitive& result) {
+	const JsonValue* attributes = mJson->Member(&primitive, "attributes");
+
+	AccessorView position = {};
+	CheckReturn(GetAccessor(mJson->Int(attributes, "POSITION", -1), position));
+	if (position.ComponentType != ComponentType::E_Float || position.ComponentCount != 3)
+		ReturnFalse(L"POSITION must be a float VEC3 accessor");
+
+	const INT normalIndex = mJson->Int(attributes, "NORMAL", -1);
+	const INT texCoordIndex = mJson->Int(attributes, "TEXCOORD_0", -1);
+
+	AccessorView normal = {};
+	if (normalIndex >= 0) {
+		CheckReturn(GetAccessor(normalIndex, normal));
+		if (normal.ComponentType != ComponentType::E_Float || normal.ComponentCount != 3 || normal.Count != position.Count)
+			ReturnFalse(L"NORMAL must be a float VEC3 accessor matching POSITION");
+	}
+
+	AccessorView texCoord = {};
+	if (texCoordIndex >= 0) {
+		CheckReturn(GetAccessor(texCoordIndex, texCoord));
+		if (texCoord.ComponentCount != 2 || texCoord.Count != position.Count)
+			ReturnFalse(L"TEXCOORD_0 must be a VEC2 accessor matching POSITION");
+	}
+
+	result.VertexCount = position.Count;
+
+	const INT material = mJson->Int(&primitive, "material", -1);
+	result.Material = material >= 0 && material < static_cast<INT>(mMaterials.size()) ? material : -1;
+
+	// Interleaved buffers laid out exactly like Vertex are used straight from the mapped file.
+	result.VerticesInPlace =
+		normalIndex >= 0 && texCoordIndex >= 0 &&
+		position.BufferView == normal.BufferView && position.BufferView == texCoord.BufferView &&
+		position.Stride == sizeof(Vertex) && normal.Stride == sizeof(Vertex) && texCoord.Stride == sizeof(Vertex) &&
+		normal.Data == position.Data + offsetof(Vertex, Normal) &&
+		texCoord.Data == position.Data + offsetof(Vertex, TexCoord) &&
+		texCoord.ComponentType == ComponentType::E_Float &&
+		IsAligned(position.Data, alignof(Vertex));
+
+	if (result.VerticesInPlace) {
+		result.Vertices = reinterpret_cast<const Vertex*>(position.Data);
+	}
+	else {
+		std::vector<Vertex> vertices(position.Count);
+
+		const UINT texCoordSize = ComponentSize(texCoord.ComponentType);
+
+		for (UINT i = 0; i < position.Count; ++i) {
+			Vertex& vertex = vertices[i];
+
+			const BYTE* p = position.Data + static_cast<size_t>(i) * position.Stride;
+			std::memcpy(&vertex.Position, p, sizeof(XMFLOAT3));
+
+			if (normalIndex >= 0) {
+				const BYTE* n = normal.Data + static_cast<size_t>(i) * normal.Stride;
+				std::memcpy(&vertex.Normal, n, sizeof(XMFLOAT3));
+			}
+
+			if (texCoordIndex >= 0) {
+				const BYTE* t = texCoord.Data + static_cast<size_t>(i) * texCoord.Stride;
+				vertex.TexCoord.x = ReadComponent(t, texCoord.ComponentType, texCoord.Normalized);
+				vertex.TexCoord.y = ReadComponent(t + texCoordSize, texCoord.ComponentType, texCoord.Normalized);
+			}
+		}
+
+		mVertexCopies.push_back(std::move(vertices));
+		// Moving the outer list keeps the element buffers, so the pointer stays valid.
+		result.Vertices = mVertexCopies.back().data();
+	}
+
+	const INT indicesIndex = mJson->Int(&primitive, "indices", -1);
+
+	if (indicesIndex >= 0) {
+		AccessorView indices = {};
+		CheckReturn(GetAccessor(indicesIndex, indices));
+		if (indices.ComponentCount != 1) ReturnFalse(L"Index accessors must be SCALAR");
+
+		result.IndexCount = indices.Count;
+		result.IndicesInPlace =
+			indices.ComponentType == ComponentType::E_UnsignedInt &&
+			indices.Stride == sizeof(UINT) &&
+			IsAligned(indices.Data, alignof(UINT));
+
+		if (result.IndicesInPlace) {
+			result.Indices = reinterpret_cast<const UINT*>(indices.Data);
+		}
+		else {
+			std::vector<UINT> copy(indices.Count);
+
+			switch (indices.ComponentType) {
+			case ComponentType::E_UnsignedByte:
+				for (UINT i = 0; i < indices.Count; ++i)
+					copy[i] = indices.Data[static_cast<size_t>(i) * indices.Stride];
+				break;
+			case ComponentType::E_UnsignedShort:
+				for (UINT i = 0; i < indices.Count; ++i) {
+					USHORT index;
+					std::memcpy(&index, indices.Data + static_cast<size_t>(i) * indices.Stride, sizeof(USHORT));
+					copy[i] = index;
+				}
+				break;
+			case ComponentType::E_UnsignedInt:
+				for (UINT i = 0; i < indices.Count; ++i)
+					std::memcpy(&copy[i], indices.Data + static_cast<size_t>(i) * indices.Stride, sizeof(UINT));
+				break;
+			default:
+				ReturnFalse(L"Unsupported index component type: " << indices.ComponentType);
+			}
+
+			mIndexCopies.push_back(std::move(copy));
+			result.Indices = mIndexCopies.back().data();
+		}
+	}
+	else {
+		std::vector<UINT> copy(position.Count);
+		for (UINT i = 0; i < position.Count; ++i) copy[i] = i;
+
+		result.IndexCount = position.Count;
+		mIndexCopies.push_back(std::move(copy));
+		result.Indices = mIndexCopies.back().data();
+	}
+
+	if (result.IndexCount % 3 != 0) ReturnFalse(L"Triangle list index count is not a multiple of 3: " << result.IndexCount);
+
+	for (UINT i = 0; i < result.IndexCount; ++i) {
+		if (result.Indices[i] >= result.VertexCount)
+			ReturnFalse(L"Index " << result.Indices[i] << L" is out of range for " << result.VertexCount << L" vertices");
+	}
+
+	// The specification requires flat normals when none are provided, so every triangle gets its own vertices.
+	if (normalIndex < 0) {
+		std::vector<Vertex> vertices(result.IndexCount);
+
+		for (UINT i = 0; i < result.IndexCount; i += 3) {
+			for (UINT k = 0; k < 3; ++k) vertices[i + k] = result.Vertices[result.Indices[i + k]];
+
+			const XMVECTOR p0 = XMLoadFloat3(&vertices[i + 0].Position);
+			const XMVECTOR p1 = XMLoadFloat3(&vertices[i + 1].Position);
+			const XMVECTOR p2 = XMLoadFloat3(&vertices[i + 2].Position);
+
+			XMFLOAT3 faceNormal;
+			XMStoreFloat3(&faceNormal, XMVector3Normalize(XMVector3Cross(p1 - p0, p2 - p0)));
+
+			for (UINT k = 0; k < 3; ++k) vertices[i + k].Normal = faceNormal;
+		}
+
+		std::vector<UINT> indices(result.IndexCount);
+		for (UINT i = 0; i < result.IndexCount; ++i) indices[i] = i;
+
+		mVertexCopies.push_back(std::move(vertices));
+		mIndexCopies.push_back(std::move(indices));
+
+		result.Vertices = mVertexCopies.back().data();
+		result.VertexCount = result.IndexCount;
+		result.Indices = mIndexCopies.back().data();
+		result.IndicesInPlace = FALSE;
+	}
+
+	return TRUE;
+}
+
+BOOL GltfScene::LoadNodes() {
+	const JsonValue* root = mJson->Root();
+	const JsonValue* nodes = mJson->Member(root, "nodes");
+	const UINT nodeCount = mJson->Size(nodes);
+
+	mNodes.resize(nodeCount);
+
+	for (UINT i = 0; i < nodeCount; ++i) {
+		const JsonValue* node = mJson->Element(nodes, i);
+		Node& result = mNodes[i];
+
+		result.Name = mJson->String(node, "name");
+		result.Parent = -1;
+		result.Mesh = mJson->Int(node, "mesh", -1);
+		result.InScene = FALSE;
+
+		if (result.Mesh >= static_cast<INT>(mMeshes.size())) ReturnFalse(L"Node " << i << L" refers to an invalid mesh");
+
+		const JsonValue* matrix = mJson->Member(node, "matrix");
+
+		if (mJson->Size(matrix) == 16) {
+			// glTF stores column-vector matrices in column-major order, which reads as the
+			// row-vector matrix of the engine in row-major order.
+			FLOAT m[16];
+			for (UINT k = 0; k < 16; ++k) {
+				const JsonValue* element = mJson->Element(matrix, k);
+				m[k] = element->Type == JsonType::E_Number ? static_cast<FLOAT>(element->Number) : 0.f;
+			}
+			result.Local = XMFLOAT4X4(m);
+		}
+		else {
+			const auto ReadVector = [&](const char* key, UINT count, XMFLOAT4 fallback) {
+				const JsonValue* array = mJson->Member(node, key);
+				if (mJson->Size(array) != count) return fallback;
+
+				FLOAT values[4] = {};
+				for (UINT k = 0; k < count; ++k) values[k] = static_cast<FLOAT>(mJson->Element(array, k)->Number);
+
+				return XMFLOAT4(values);
+			};
+
+			const XMFLOAT4 translation = ReadVector("translation", 3, XMFLOAT4(0.f, 0.f, 0.f, 0.f));
+			const XMFLOAT4 rotation = ReadVector("rotation", 4, XMFLOAT4(0.f, 0.f, 0.f, 1.f));
+			const XMFLOAT4 scale = ReadVector("scale", 3, XMFLOAT4(1.f, 1.f, 1.f, 0.f));
+
+			const XMMATRIX local =
+				XMMatrixScaling(scale.x, scale.y, scale.z) *
+				XMMatrixRotationQuaternion(XMQuaternionNormalize(XMLoadFloat4(&rotation))) *
+				XMMatrixTranslation(translation.x, translation.y, translation.z);
+			XMStoreFloat4x4(&result.Local, local);
+		}
+
+		result.World = result.Local;
+	}
+
+	for (UINT i = 0; i < nodeCount; ++i) {
+		const JsonValue* children = mJson->Member(mJson->Element(nodes, i), "children");
+
+		for (UINT k = 0, end = mJson->Size(children); k < end; ++k) {
+			const INT child = static_cast<INT>(mJson->Element(children, k)->Number);
+
+			if (child < 0 || child >= static_cast<INT>(nodeCount)) ReturnFalse(L"Node " << i << L" has an invalid child");
+			if (child == static_cast<INT>(i) || mNodes[child].Parent >= 0) ReturnFalse(L"Node " << child << L" has more than one parent");
+
+			mNodes[child].Parent = static_cast<INT>(i);
+		}
+	}
+
+	// Instantiates the default scene, or every root node if the file has no scenes.
+	std::vector<UINT> stack;
+
+	const JsonValue* scene = mJson->Element(mJson->Member(root, "scenes"), mJson->Int(root, "scene", 0));
+	if (scene != nullptr) {
+		const JsonValue* sceneNodes = mJson->Member(scene, "nodes");
+
+		for (UINT k = 0, end = mJson->Size(sceneNodes); k < end; ++k) {
+			const INT index = static_cast<INT>(mJson->Element(sceneNodes, k)->Number);
+
+			if (index < 0 || index >= static_cast<INT>(nodeCount) || mNodes[index].Parent >= 0)
+				ReturnFalse(L"The scene refers to an invalid root node: " << index);
+
+			stack.push_back(static_cast<UINT>(index));
+		}
+	}
+	else {
+		for (UINT i = 0; i < nodeCount; ++i) {
+			if (mNodes[i].Parent < 0) stack.push_back(i);
+		}
+	}
+
+	// Parents are visited before their children, so their world matrices are final.
+	while (!stack.empty()) {
+		const UINT index = stack.back();
+		stack.pop_back();
+
+		Node& node = mNodes[index];
+		if (node.InScene) continue;
+		node.InScene = TRUE;
+
+		if (node.Parent >= 0) {
+			const XMMATRIX world = XMLoadFloat4x4(&node.Local) * XMLoadFloat4x4(&mNodes[node.Parent].World);
+			XMStoreFloat4x4(&node.World, world);
+		}
+
+		const JsonValue* children = mJson->Member(mJson->Element(nodes, index), "children");
+		for (UINT k = mJson->Size(children); k > 0; --k)
+			stack.push_back(static_cast<UINT>(mJson->Element(children, k - 1)->Number));
+	}
+
+	return TRUE;
+}
+
+void GltfScene::LoadMaterials() {
+	const JsonValue* root = mJson->Root();
+	const JsonValue* textures = mJson->Member(root, "textures");
+	const JsonValue* images = mJson->Member(root, "images");
+
+	BOOL skippedEmbedded = FALSE;
+
+	// Texture paths are kept relative to the glTF file, as MTL map paths are.
+	const auto TextureUri = [&](const JsonValue* textureInfo) {
+		const INT index = mJson->Int(textureInfo, "index", -1);
+		if (index < 0) return std::string();
+
+		const JsonValue* texture = mJson->Element(textures, index);
+		const JsonValue* image = mJson->Element(images, mJson->Int(texture, "source", -1));
+
+		std::string uri = mJson->String(image, "uri");
+		if (image != nullptr && (uri.empty() || uri.compare(0, 5, "data:") == 0)) {
+			skippedEmbedded = TRUE;
+			uri.clear();
+		}
+
+		return uri;
+	};
+
+	const JsonValue* materials = mJson->Member(root, "materials");
+
+	for (UINT i = 0, end = mJson->Size(materials); i < end; ++i) {
+		const JsonValue* material = mJson->Element(materials, i);
+		const JsonValue* pbr = mJson->Member(material, "pbrMetallicRoughness");
+
+		Material result;
+		result.Name = mJson->String(material, "name");
+
+		const JsonValue* baseColor = mJson->Member(pbr, "baseColorFactor");
+		if (mJson->Size(baseColor) == 4) {
+			result.Albedo = XMFLOAT4(
+				static_cast<FLOAT>(mJson->Element(baseColor, 0)->Number),
+				static_cast<FLOAT>(mJson->Element(baseColor, 1)->Number),
+				static_cast<FLOAT>(mJson->Element(baseColor, 2)->Number),
+				static_cast<FLOAT>(mJson->Element(baseColor, 3)->Number));
+		}
+
+		result.Roughness = static_cast<FLOAT>(mJson->Number(pbr, "roughnessFactor", 1.));
+		result.DiffuseMapFileName = TextureUri(mJson->Member(pbr, "baseColorTexture"));
+		result.NormalMapFileName = TextureUri(mJson->Member(material, "normalTexture"));
+		result.AlphaTested = mJson->String(material, "alphaMode") == "MASK";
+
+		mMaterials.push_back(std::move(result));
+	}
+
+	if (skippedEmbedded) WLogln(L"Images embedded in buffers or data URIs are not supported and were skipped");
+}
+
+BOOL GltfScene::GetAccessor(INT index, AccessorView& view) const {
+	const JsonValue* root = mJson->Root();
+
+	const JsonValue* accessor = index >= 0 ? mJson->Element(mJson->Member(root, "accessors"), index) : nullptr;
+	if (accessor == nullptr) ReturnFalse(L"Invalid accessor: " << index);
+	if (mJson->Member(accessor, "sparse") != nullptr) ReturnFalse(L"Sparse accessors are not supported");
+
+	view.ComponentType = static_cast<UINT>(mJson->Int(accessor, "componentType", 0));
+	const JsonValue* type = mJson->Member(accessor, "type");
+	view.ComponentCount =
+		JsonDocument::Equals(type, "SCALAR") ? 1 :
+		JsonDocument::Equals(type, "VEC2") ? 2 :
+		JsonDocument::Equals(type, "VEC3") ? 3 :
+		JsonDocument::Equals(type, "VEC4") || JsonDocument::Equals(type, "MAT2") ? 4 :
+		JsonDocument::Equals(type, "MAT3") ? 9 :
+		JsonDocument::Equals(type, "MAT4") ? 16 : 0;
+	view.Count = static_cast<UINT>(mJson->Int(accessor, "count", 0));
+	view.Normalized = mJson->Bool(accessor, "normalized", FALSE);
+	view.BufferView = mJson->Int(accessor, "bufferView", -1);
+
+	const UINT componentSize = ComponentSize(view.ComponentType);
+	if (componentSize == 0 || view.ComponentCount == 0) ReturnFalse(L"Accessor " << index << L" has an invalid type");
+
+	const JsonValue* bufferView = view.BufferView >= 0 ? mJson->Element(mJson->Member(root, "bufferViews"), view.BufferView) : nullptr;
+	if (bufferView == nullptr) ReturnFalse(L"Accessor " << index << L" has no valid buffer view");
+
+	const INT buffer = mJson->Int(bufferView, "buffer", -1);
+	if (buffer < 0 || buffer >= static_cast<INT>(mBufferRanges.size())) ReturnFalse(L"Buffer view " << view.BufferView << L" has an invalid buffer");
+
+	const UINT64 viewOffset = static_cast<UINT64>(mJson->Number(bufferView, "byteOffset", 0.));
+	const UINT64 viewLength = static_cast<UINT64>(mJson->Number(bufferView, "byteLength", 0.));
+	const UINT64 accessorOffset = static_cast<UINT64>(mJson->Number(accessor, "byteOffset", 0.));
+
+	const UINT elementSize = componentSize * view.ComponentCount;
+	view.Stride = static_cast<UINT>(mJson->Int(bufferView, "byteStride", 0));
+	if (view.Stride == 0) view.Stride = elementSize;
+
+	const BufferRange& range = mBufferRanges[buffer];
+	if (viewOffset + viewLength > range.Size) ReturnFalse(L"Buffer view " << view.BufferView << L" is out of range");
+	if (view.Count > 0 && accessorOffset + static_cast<UINT64>(view.Count - 1) * view.Stride + elementSize > viewLength)
+		ReturnFalse(L"Accessor " << index << L" is out of range");
+
+	view.Data = range.Data + viewOffset + accessorOffset;
+
+	return TRUE;
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "Common/Mesh/IndexCodec.h"
+
+#include <algorithm>
+#include <limits>
+
+#undef max
+#undef min
+
+namespace {
+	__forceinline void WriteVarint(std::vector<BYTE>& encoded, UINT64 value) {
+		while (value >= 0x80) {
+			encoded.push_back(static_cast<BYTE>(value | 0x80));
+			value >>= 7;
+		}
+		encoded.push_back(static_cast<BYTE>(value));
+	}
+
+	__forceinline BOOL ReadVarint(const BYTE*& p, const BYTE* const end, UINT64& value) {
+		value = 0;
+		for (UINT shift = 0; shift < 64; shift += 7) {
+			if (p == end) return FALSE;
+
+			const BYTE byte = *p++;
+			value |= static_cast<UINT64>(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0) return TRUE;
+		}
+		return FALSE;
+	}
+
+	template <typename T>
+	BOOL DecodeIndices(const BYTE* encoded, UINT64 size, UINT count, T* indices) {
+		const BYTE* p = encoded;
+		const BYTE* const end = encoded + size;
+
+		INT64 next = 0;
+		for (UINT i = 0; i < count; ++i) {
+			UINT64 code;
+			if (!ReadVarint(p, end, code)) return FALSE;
+
+			INT64 index = next;
+			if (code != 0) {
+				const UINT64 zigzag = code - 1;
+				const INT64 delta = static_cast<INT64>(zigzag >> 1) ^ -static_cast<INT64>(zigzag & 1);
+				index = next - 1 - delta;
+			}
+
+			if (index < 0 || index > static_cast<INT64>(std::numeric_limits<T>::max())) return FALSE;
+
+			indices[i] = static_cast<T>(index);
+			next = std::max(next, index + 1);
+		}
+
+		return p == end;
+	}
+}
+
+void IndexCodec::Encode(const UINT* indices, UINT count, std::vector<BYTE>& encoded) {
+	encoded.clear();
+	encoded.reserve(count);
+
+	INT64 next = 0;
+	for (UINT i = 0; i < count; ++i) {
+		const INT64 index = indices[i];
+
+		if (index == next) {
+			WriteVarint(encoded, 0);
+		}
+		else {
+			// Zero is the vertex introduced last, positive values reach back to older vertices.
+			const INT64 delta = next - 1 - index;
+			const UINT64 zigzag = (static_cast<UINT64>(delta) << 1) ^ static_cast<UINT64>(delta >> 63);
+			WriteVarint(encoded, zigzag + 1);
+		}
+
+		next = std::max(next, index + 1);
+	}
+}
+
+BOOL IndexCodec::Decode(const BYTE* encoded, UINT64 size, UINT count, UINT* indices) {
+	return DecodeIndices(encoded, size, count, indices);
+}
+
+BOOL IndexCodec::Decode(const BYTE* encoded, UINT64 size, UINT count, USHORT* indices) {
+	return DecodeIndices(encoded, size, count, indices);
+}
\ No newline at end of file
@@ -1,6 +1,17 @@
 #include "Common/Mesh/MeshImporter.h"
 #include "Common/Debug/Logger.h"
+#include "Common/HashUtil.h"
+#include "Common/Mesh/CookedMesh.h"
+#include "Common/Mesh/GltfScene.h"
 #include "Common/Mesh/Mesh.h"
+#include "Common/Mesh/MeshletBuilder.h"
+#include "Common/Mesh/MeshOptimizer.h"
+#include "Common/Mesh/MeshSimplifier.h"
+#include "Common/Mesh/ObjParser.h"
+#include "Common/Mesh/VertexFormat.h"
+#include "Common/Mesh/VertexWelder.h"
+#include "Common/Util/BakeManifest.h"
+#include "Common/Util/MappedFile.h"
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tinyobjloader/tiny_obj_loader.h>
@@ -8,32 +19,355 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
 
+#include <algorithm>
+#include <cctype>
 #include <DirectXPackedVector.h>
+#include <filesystem>
+
+#undef max
+#undef min
 
 using namespace DirectX;
 using namespace DirectX::PackedVector;
 
 namespace {
 	const std::string BaseDir = "./../../assets/meshes/";
+	const std::string CookedDir = "./../../assets/meshes/cooked/";
+	const std::string CookedExtension = ".mesh";
+	const std::string StampExtension = ".stamp";
+
+	// The quantized position stream is left out when its error exceeds this, relative to the largest
+	// extent of the mesh AABB; depth passes then read the full-precision stream.
+	const FLOAT MaxRelativePositionError = 1e-4f;
+
+	// Hashes the source file and the material libraries or buffers it referenced when it was imported.
+	BOOL HashSource(const std::string& file, const std::vector<std::string>& dependencies, UINT64& hash) {
+		MappedFile source;
+		CheckReturn(source.Open(BaseDir + file));
+		hash = hu::hash_bytes(source.Data(), source.Size());
+
+		for (const auto& dep : dependencies) {
+			// Missing libraries are tolerated by the parser, so only the name is hashed for them.
+			hash = hu::hash_bytes(dep.data(), dep.size(), hash);
+
+			const std::string path = BaseDir + dep;
+			if (!std::filesystem::exists(path)) continue;
+
+			MappedFile lib;
+			CheckReturn(lib.Open(path));
+			hash = hu::hash_bytes(lib.Data(), lib.Size(), hash);
+		}
+
+		return TRUE;
+	}
+
+	void StampFile(BakeManifest& stamps, const std::string& key, const std::string& path) {
+		// Missing libraries are tolerated by the parser, so their absence is recorded too.
+		std::error_code error;
+		const UINT64 size = std::filesystem::file_size(path, error);
+		if (error) {
+			stamps.Set(key, "Missing");
+			return;
+		}
+
+		const auto writeTime = std::filesystem::last_write_time(path, error);
+		if (error) {
+			stamps.Set(key, "Missing");
+			return;
+		}
+
+		stamps.Set(key + ".Size", size);
+		stamps.Set(key + ".WriteTime", static_cast<UINT64>(writeTime.time_since_epoch().count()));
+	}
+
+	// Size and write time of the source, the files it depends on and the cooked image. While they all
+	// match the stamps saved next to the image, neither the sources nor the image are hashed again.
+	void StampFiles(
+			const std::string& file,
+			const std::vector<std::string>& dependencies,
+			const std::string& cookedPath,
+			UINT64 sourceHash,
+			BakeManifest& stamps) {
+		stamps.SetHash("SourceHash", sourceHash);
+		StampFile(stamps, "Source", BaseDir + file);
+		for (size_t i = 0, end = dependencies.size(); i < end; ++i) {
+			stamps.Set("Dependency" + std::to_string(i), dependencies[i]);
+			StampFile(stamps, "Dependency" + std::to_string(i), BaseDir + dependencies[i]);
+		}
+		StampFile(stamps, "Cooked", cookedPath);
+	}
+
+	// Checks that the position-only stream of depth passes stays within tolerance.
+	BOOL UsePositionStream(const Mesh& mesh) {
+		// Matches the quantization CookedMesh derives from the mesh AABB.
+		const VertexQuantization quant = VertexQuantization::FromVertices(mesh.Vertices.data(), static_cast<UINT>(mesh.Vertices.size()));
+		const VertexEncodingError error = VertexFormat::PositionOnly().MeasureError(mesh.Vertices.data(), static_cast<UINT>(mesh.Vertices.size()), quant);
+
+		const FLOAT extent = std::max(std::max(quant.Scale.x, quant.Scale.y), quant.Scale.z);
+		if (error.Position <= MaxRelativePositionError * extent) return TRUE;
+
+		WLogln(L"Leaving out the position-only stream (position error ", std::to_wstring(error.Position), L")");
+		return FALSE;
+	}
+
+	// Builds the meshlets of each subset separately so that no cluster mixes materials.
+	void BuildMeshlets(Mesh& mesh) {
+		if (mesh.Subsets.size() < 2) {
+			MeshletBuilder::Build(mesh.Vertices, mesh.Indices, mesh.Meshlets, mesh.MeshletVertices, mesh.MeshletTriangles);
+			for (auto& subset : mesh.Subsets) {
+				subset.FirstMeshlet = 0;
+				subset.MeshletCount = static_cast<UINT>(mesh.Meshlets.size());
+			}
+			return;
+		}
+
+		mesh.Meshlets.clear();
+		mesh.MeshletVertices.clear();
+		mesh.MeshletTriangles.clear();
+
+		std::vector<UINT> indices;
+		std::vector<Meshlet> meshlets;
+		std::vector<UINT> meshletVertices;
+		std::vector<BYTE> meshletTriangles;
+
+		for (auto& subset : mesh.Subsets) {
+			const auto begin = mesh.Indices.begin() + subset.StartIndexLocation;
+			indices.assign(begin, begin + subset.IndexCount);
+
+			MeshletBuilder::Build(mesh.Vertices, indices, meshlets, meshletVertices, meshletTriangles);
+
+			const UINT vertexOffset = static_cast<UINT>(mesh.MeshletVertices.size());
+			const UINT triangleOffset = static_cast<UINT>(mesh.MeshletTriangles.size() / 3);
+
+			subset.FirstMeshlet = static_cast<UINT>(mesh.Meshlets.size());
+			subset.MeshletCount = static_cast<UINT>(meshlets.size());
+
+			for (auto& meshlet : meshlets) {
+				meshlet.VertexOffset += vertexOffset;
+				meshlet.TriangleOffset += triangleOffset;
+			}
+
+			mesh.Meshlets.insert(mesh.Meshlets.end(), meshlets.begin(), meshlets.end());
+			mesh.MeshletVertices.insert(mesh.MeshletVertices.end(), meshletVertices.begin(), meshletVertices.end());
+			mesh.MeshletTriangles.insert(mesh.MeshletTriangles.end(), meshletTriangles.begin(), meshletTriangles.end());
+		}
+	}
+
+	// Optimizes the mesh for the vertex cache, overdraw and vertex fetch, then builds the data that
+	// refers to the final index buffer.
+	BOOL ProcessMesh(Mesh& mesh) {
+		CheckReturn(MeshOptimizer::Optimize(mesh));
+		CheckReturn(mesh.Bvh.Build(mesh.Vertices, mesh.Indices));
+
+		BuildMeshlets(mesh);
+		CheckReturn(MeshletBuilder::Validate(mesh.Vertices, mesh.Indices, mesh.Meshlets, mesh.MeshletVertices, mesh.MeshletTriangles));
+
+		CheckReturn(MeshSimplifier::BuildLods(mesh));
+
+		return TRUE;
+	}
+
+	BOOL IsGltf(const std::string& file) {
+		std::string extension = std::filesystem::path(file).extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+
+		return extension == ".glb" || extension == ".gltf";
+	}
+
+	// Appends a primitive instance to the mesh, transforming it into scene space.
+	void AppendPrimitive(const GltfScene::Primitive& primitive, const XMFLOAT4X4& world, Mesh& mesh) {
+		const UINT baseVertex = static_cast<UINT>(mesh.Vertices.size());
+		const size_t baseIndex = mesh.Indices.size();
+
+		mesh.Vertices.insert(mesh.Vertices.end(), primitive.Vertices, primitive.Vertices + primitive.VertexCount);
+		mesh.Indices.resize(baseIndex + primitive.IndexCount);
+
+		UINT* indices = mesh.Indices.data() + baseIndex;
+		for (UINT i = 0; i < primitive.IndexCount; ++i) indices[i] = primitive.Indices[i] + baseVertex;
+
+		const XMMATRIX transform = XMLoadFloat4x4(&world);
+		if (XMMatrixIsIdentity(transform)) return;
+
+		// Normals go through the inverse transpose so that non-uniform scales keep them perpendicular.
+		const XMMATRIX normalTransform = XMMatrixTranspose(XMMatrixInverse(nullptr, transform));
+
+		for (UINT i = baseVertex, end = static_cast<UINT>(mesh.Vertices.size()); i < end; ++i) {
+			Vertex& vertex = mesh.Vertices[i];
+			XMStoreFloat3(&vertex.Position, XMVector3TransformCoord(XMLoadFloat3(&vertex.Position), transform));
+			XMStoreFloat3(&vertex.Normal, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&vertex.Normal), normalTransform)));
+		}
+
+		// Mirroring transforms flip the winding, which is restored to keep the front faces.
+		if (XMVectorGetX(XMMatrixDeterminant(transform)) < 0.f) {
+			for (UINT i = 0; i < primitive.IndexCount; i += 3) std::swap(indices[i + 1], indices[i + 2]);
+		}
+	}
 }
 
-BOOL MeshImporter::LoadObj(const std::string& file, Mesh& mesh, Material& mat) {
+BOOL MeshImporter::LoadObj(
+		const std::string& file,
+		Mesh& mesh,
+		std::vector<Material>& materials,
+		UINT64 numThreads,
+		std::vector<std::string>* dependencies) {
+	CheckReturn(ObjParser::Load(file, BaseDir, mesh, materials, numThreads, 0.f, dependencies));
+	CheckReturn(ProcessMesh(mesh));
+
+	return TRUE;
+}
+
+BOOL MeshImporter::LoadGltf(
+		const std::string& file,
+		Mesh& mesh,
+		std::vector<Material>& materials,
+		std::vector<std::string>* dependencies) {
+	GltfScene scene;
+	CheckReturn(scene.Open(BaseDir + file));
+
+	const auto& primitives = scene.Primitives();
+	const auto& meshes = scene.Meshes();
+	const auto& nodes = scene.Nodes();
+
+	size_t vertexCount = 0;
+	size_t indexCount = 0;
+
+	const auto ForEachInstance = [&](auto&& func) {
+		// Files without nodes still get each mesh once.
+		if (nodes.empty()) {
+			const XMFLOAT4X4 identity = MathHelper::Identity4x4();
+			for (const auto& info : meshes) {
+				for (UINT i = 0; i < info.PrimitiveCount; ++i) func(primitives[info.FirstPrimitive + i], identity);
+			}
+			return;
+		}
+
+		for (const auto& node : nodes) {
+			if (!node.InScene || node.Mesh < 0) continue;
+
+			const auto& info = meshes[node.Mesh];
+			for (UINT i = 0; i < info.PrimitiveCount; ++i) func(primitives[info.FirstPrimitive + i], node.World);
+		}
+	};
+
+	ForEachInstance([&](const GltfScene::Primitive& primitive, const XMFLOAT4X4&) {
+		vertexCount += primitive.VertexCount;
+		indexCount += primitive.IndexCount;
+	});
+
+	if (indexCount == 0) ReturnFalse(L"No triangles to import: " << file.c_str());
+	if (vertexCount > 0xFFFFFFFF) ReturnFalse(L"Too many vertices to import: " << file.c_str());
+
+	mesh.Vertices.reserve(vertexCount);
+	mesh.Indices.reserve(indexCount);
+
+	// Primitives without a material map past the end of the list, to the default material.
+	std::vector<UINT> triangleMaterials;
+	triangleMaterials.reserve(indexCount / 3);
+
+	ForEachInstance([&](const GltfScene::Primitive& primitive, const XMFLOAT4X4& world) {
+		AppendPrimitive(primitive, world, mesh);
+		triangleMaterials.insert(triangleMaterials.end(), primitive.IndexCount / 3, static_cast<UINT>(primitive.Material));
+	});
+
+	materials = scene.Materials();
+	MeshOptimizer::SortByMaterial(mesh, materials, triangleMaterials);
+
+	if (dependencies != nullptr) {
+		// Reported relative to the base directory, as the source file is.
+		const std::string directory = std::filesystem::path(file).parent_path().string();
+		for (const auto& buffer : scene.Buffers())
+			dependencies->push_back(directory.empty() ? buffer : directory + "/" + buffer);
+	}
+
+	CheckReturn(ProcessMesh(mesh));
+
+	return TRUE;
+}
+
+BOOL MeshImporter::LoadCooked(const std::string& file, CookedMesh& cooked, UINT64 numThreads) {
+	const std::string cookedPath = CookedDir + file + CookedExtension;
+	const std::string stampPath = cookedPath + StampExtension;
+
+	if (std::filesystem::exists(cookedPath) && cooked.Open(cookedPath)) {
+		std::vector<std::string> dependencies;
+
+		if (cooked.ImporterVersion() == Version && cooked.LoadDependencies(dependencies)) {
+			BakeManifest stamps;
+			StampFiles(file, dependencies, cookedPath, cooked.SourceHash(), stamps);
+			if (stamps.Matches(stampPath)) return TRUE;
+
+			// Some file was touched; the content hashes decide, and the new stamps are kept if they agree.
+			UINT64 sourceHash = 0;
+			if (cooked.VerifyContent() && HashSource(file, dependencies, sourceHash) && sourceHash == cooked.SourceHash()) {
+				stamps.Save(stampPath);
+				return TRUE;
+			}
+		}
+
+		WLogln(L"Cooked mesh is out of date: ", std::wstring(file.begin(), file.end()));
+		cooked.Close();
+	}
+
+	Mesh mesh;
+	std::vector<Material> materials;
+	std::vector<std::string> dependencies;
+	if (IsGltf(file)) {
+		CheckReturn(LoadGltf(file, mesh, materials, &dependencies));
+	}
+	else {
+		CheckReturn(LoadObj(file, mesh, materials, numThreads, &dependencies));
+
+#ifdef _DEBUG
+		// Debug builds cross-check every imported file against tinyobjloader; a mismatch is only reported.
+		if (!ValidateObj(file, numThreads))
+			WLogln(L"Native OBJ parser disagrees with tinyobjloader: ", std::wstring(file.begin(), file.end()));
+#endif
+	}
+
+	UINT64 sourceHash = 0;
+	CheckReturn(HashSource(file, dependencies, sourceHash));
+	CheckReturn(cooked.Cook(mesh, materials, UsePositionStream(mesh), Version, sourceHash, dependencies));
+
+	// The in-memory image is still usable; the next launch simply imports the file again.
+	if (!cooked.Save(cookedPath)) {
+		WLogln(L"Failed to save the cooked mesh: ", std::wstring(cookedPath.begin(), cookedPath.end()));
+		return TRUE;
+	}
+
+	// Stamped after saving so the write time of the image is the final one. Without stamps the next
+	// launch only falls back to the content hashes.
+	BakeManifest stamps;
+	StampFiles(file, dependencies, cookedPath, sourceHash, stamps);
+	stamps.Save(stampPath);
+
+	return TRUE;
+}
+
+BOOL MeshImporter::LoadObjReference(const std::string& file, Mesh& mesh, std::vector<Material>& materials) {
 	tinyobj::attrib_t attrib;
 	std::vector<tinyobj::shape_t> shapes;
-	std::vector<tinyobj::material_t> materials;
+	std::vector<tinyobj::material_t> objMaterials;
 	std::string warn, err;
 
 	{
 		std::stringstream sstream;
 		sstream << BaseDir << file;
-		if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, sstream.str().c_str(), BaseDir.c_str())) {
+		if (!tinyobj::LoadObj(&attrib, &shapes, &objMaterials, &warn, &err, sstream.str().c_str(), BaseDir.c_str())) {
 			std::wstringstream wsstream;
 			wsstream << warn.c_str() << err.c_str();
 			ReturnFalse(wsstream.str());
 		}
 	}
 
+	VertexWelder welder;
+
+	// Faces without a material get -1, which maps past the end of the list to the default material.
+	std::vector<UINT> triangleMaterials;
+
 	for (const auto& shape : shapes) {
+		for (const INT id : shape.mesh.material_ids)
+			triangleMaterials.push_back(static_cast<UINT>(id));
+
 		for (const auto& index : shape.mesh.indices) {
 			Vertex vertex = {};
 
@@ -56,24 +390,68 @@ BOOL MeshImporter::LoadObj(const std::string& file, Mesh& mesh, Material& mat) {
 			};
 			
 
-			if (mesh.UniqueVertices.count(vertex) == 0) {
-				mesh.UniqueVertices[vertex] = static_cast<UINT>(mesh.Vertices.size());
-				mesh.Vertices.push_back(vertex);
-			}
-
-			mesh.Indices.push_back(static_cast<UINT>(mesh.UniqueVertices[vertex]));
+			mesh.Indices.push_back(welder.Weld(vertex, mesh.Vertices));
 		}
 	}
 	
-	for (const auto& material : materials) {
+	for (const auto& material : objMaterials) {
+		Material mat;
 		mat.Name = material.name;
 		mat.DiffuseMapFileName = material.diffuse_texname;
 		mat.Albedo = XMFLOAT4(material.diffuse[0], material.diffuse[1], material.diffuse[2], 1.f);
 		mat.Roughness = material.roughness;
 		mat.Specular = material.specular[0];
+
+		materials.push_back(std::move(mat));
 	}
 
+	MeshOptimizer::SortByMaterial(mesh, materials, triangleMaterials);
+
 	return TRUE;
 }
 
-BOOL MeshImporter::LoadFbx(const std::string& file) { return TRUE; }
\ No newline at end of file
+BOOL MeshImporter::ValidateObj(const std::string& file, UINT64 numThreads) {
+	Mesh mesh;
+	std::vector<Material> materials;
+	// Compares the raw parser output; the optimizer would reorder the index buffer.
+	CheckReturn(ObjParser::Load(file, BaseDir, mesh, materials, numThreads));
+
+	Mesh reference;
+	std::vector<Material> referenceMaterials;
+	CheckReturn(LoadObjReference(file, reference, referenceMaterials));
+
+	if (mesh.Vertices.size() != reference.Vertices.size())
+		ReturnFalse(L"Vertex count mismatch: " << mesh.Vertices.size() << L" != " << reference.Vertices.size());
+	if (mesh.Indices != reference.Indices) ReturnFalse(L"Index buffer mismatch");
+
+	// Both parsers round decimal strings through double, but allow a few ulps of difference.
+	const FLOAT epsilon = 1e-6f;
+	for (size_t i = 0, end = mesh.Vertices.size(); i < end; ++i) {
+		const auto& a = mesh.Vertices[i];
+		const auto& b = reference.Vertices[i];
+
+		if (!XMVector3NearEqual(XMLoadFloat3(&a.Position), XMLoadFloat3(&b.Position), XMVectorReplicate(epsilon)) ||
+			!XMVector3NearEqual(XMLoadFloat3(&a.Normal), XMLoadFloat3(&b.Normal), XMVectorReplicate(epsilon)) ||
+			!XMVector2NearEqual(XMLoadFloat2(&a.TexCoord), XMLoadFloat2(&b.TexCoord), XMVectorReplicate(epsilon)))
+			ReturnFalse(L"Vertex mismatch at " << i);
+	}
+
+	if (mesh.Subsets.size() != reference.Subsets.size())
+		ReturnFalse(L"Subset count mismatch: " << mesh.Subsets.size() << L" != " << reference.Subsets.size());
+	for (size_t i = 0, end = mesh.Subsets.size(); i < end; ++i) {
+		const auto& a = mesh.Subsets[i];
+		const auto& b = reference.Subsets[i];
+
+		if (a.StartIndexLocation != b.StartIndexLocation || a.IndexCount != b.IndexCount || a.MaterialIndex != b.MaterialIndex)
+			ReturnFalse(L"Subset mismatch at " << i);
+	}
+
+	if (materials.size() != referenceMaterials.size())
+		ReturnFalse(L"Material count mismatch: " << materials.size() << L" != " << referenceMaterials.size());
+	for (size_t i = 0, end = materials.size(); i < end; ++i) {
+		if (materials[i].Name != referenceMaterials[i].Name || materials[i].DiffuseMapFileName != referenceMaterials[i].DiffuseMapFileName)
+			ReturnFalse(L"Material mismatch at " << i);
+	}
+
+	return TRUE;
+}
\ No newline at end of file
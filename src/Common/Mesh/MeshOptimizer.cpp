@@ -0,0 +1,436 @@
+#include "Common/Mesh/MeshOptimizer.h"
+#include "Common/Debug/Logger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#undef max
+#undef min
+
+using namespace DirectX;
+
+namespace {
+	const UINT NoPosition = 0xFFFFFFFF;
+
+	// Scoring parameters from Tom Forsyth's "Linear-Speed Vertex Cache Optimisation".
+	const FLOAT CacheDecayPower = 1.5f;
+	const FLOAT LastTriangleScore = 0.75f;
+	const FLOAT ValenceBoostScale = 2.f;
+	const FLOAT ValenceBoostPower = 0.5f;
+	const UINT MaxValenceScore = 64;
+
+	struct ScoreTables {
+		FLOAT Cache[MeshOptimizer::OptimizerCacheSize];
+		FLOAT Valence[MaxValenceScore];
+
+		ScoreTables() {
+			for (UINT i = 0; i < MeshOptimizer::OptimizerCacheSize; ++i) {
+				// The vertices of the last triangle get a fixed score so the next triangle does not reuse them all.
+				if (i < 3) Cache[i] = LastTriangleScore;
+				else {
+					const FLOAT scaler = 1.f / (MeshOptimizer::OptimizerCacheSize - 3);
+					Cache[i] = std::pow(1.f - (i - 3) * scaler, CacheDecayPower);
+				}
+			}
+
+			// Vertices with few remaining triangles are boosted to get rid of them early.
+			Valence[0] = 0.f;
+			for (UINT i = 1; i < MaxValenceScore; ++i)
+				Valence[i] = ValenceBoostScale * std::pow(static_cast<FLOAT>(i), -ValenceBoostPower);
+		}
+	};
+
+	const ScoreTables& GetScoreTables() {
+		static const ScoreTables tables;
+		return tables;
+	}
+
+	__forceinline FLOAT VertexScore(UINT cachePosition, UINT remainingValence) {
+		if (remainingValence == 0) return -1.f;
+
+		const auto& tables = GetScoreTables();
+
+		FLOAT score = cachePosition == NoPosition ? 0.f : tables.Cache[cachePosition];
+		score += tables.Valence[std::min(remainingValence, MaxValenceScore - 1)];
+
+		return score;
+	}
+
+	// Simulates a FIFO cache and returns the number of misses per triangle.
+	class FifoCache {
+	public:
+		// Time starts above the cache size so that untouched vertices count as misses.
+		FifoCache(UINT vertexCount, UINT cacheSize) : mTimestamps(vertexCount, 0), mCacheSize(cacheSize), mTime(cacheSize + 1) {}
+
+	public:
+		// Forgets every cached vertex.
+		void Reset() {
+			mTime += mCacheSize + 1;
+		}
+
+		UINT Triangle(const UINT* tri) {
+			UINT misses = 0;
+
+			for (UINT k = 0; k < 3; ++k) {
+				const UINT v = tri[k];
+				if (mTime - mTimestamps[v] > mCacheSize) {
+					mTimestamps[v] = mTime++;
+					++misses;
+				}
+			}
+
+			return misses;
+		}
+
+	private:
+		std::vector<UINT> mTimestamps;
+		UINT mCacheSize;
+		UINT mTime;
+	};
+}
+
+MeshOptimizer::CacheStatistics MeshOptimizer::AnalyzeVertexCache(const std::vector<UINT>& indices, UINT vertexCount, UINT cacheSize) {
+	CacheStatistics stats;
+
+	const size_t triCount = indices.size() / 3;
+	if (triCount == 0 || vertexCount == 0) return stats;
+
+	FifoCache cache(vertexCount, cacheSize);
+
+	std::vector<BYTE> referenced(vertexCount, 0);
+	UINT uniqueCount = 0;
+	UINT64 misses = 0;
+
+	for (size_t i = 0; i < triCount; ++i) {
+		misses += cache.Triangle(&indices[i * 3]);
+
+		for (UINT k = 0; k < 3; ++k) {
+			BYTE& ref = referenced[indices[i * 3 + k]];
+			if (ref == 0) {
+				ref = 1;
+				++uniqueCount;
+			}
+		}
+	}
+
+	stats.Acmr = static_cast<FLOAT>(misses) / triCount;
+	stats.Atvr = static_cast<FLOAT>(misses) / uniqueCount;
+
+	return stats;
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<UINT>& indices, UINT vertexCount) {
+	const UINT triCount = static_cast<UINT>(indices.size() / 3);
+	if (triCount == 0) return;
+
+	// Triangles adjacent to each vertex, packed in one array.
+	std::vector<UINT> valences(vertexCount, 0);
+	for (const UINT index : indices)
+		++valences[index];
+
+	std::vector<UINT> adjacencyOffsets(vertexCount + 1, 0);
+	for (UINT v = 0; v < vertexCount; ++v)
+		adjacencyOffsets[v + 1] = adjacencyOffsets[v] + valences[v];
+
+	std::vector<UINT> adjacency(indices.size());
+	{
+		std::vector<UINT> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (UINT i = 0; i < triCount; ++i) {
+			for (UINT k = 0; k < 3; ++k)
+				adjacency[fill[indices[i * 3 + k]]++] = i;
+		}
+	}
+
+	std::vector<FLOAT> vertexScores(vertexCount);
+	for (UINT v = 0; v < vertexCount; ++v)
+		vertexScores[v] = VertexScore(NoPosition, valences[v]);
+
+	std::vector<FLOAT> triScores(triCount);
+	std::vector<BYTE> emitted(triCount, 0);
+	for (UINT i = 0; i < triCount; ++i) {
+		triScores[i] = vertexScores[indices[i * 3 + 0]] + vertexScores[indices[i * 3 + 1]] + vertexScores[indices[i * 3 + 2]];
+	}
+
+	std::vector<UINT> output;
+	output.reserve(indices.size());
+
+	// One extra slot holds the vertices pushed out of the cache by the last triangle.
+	UINT cache[OptimizerCacheSize + 3];
+	UINT cacheCount = 0;
+
+	UINT bestTri = 0;
+	for (UINT i = 1; i < triCount; ++i) {
+		if (triScores[i] > triScores[bestTri]) bestTri = i;
+	}
+
+	// Falls back to the next triangle in input order when no cached triangle is left.
+	UINT inputCursor = 0;
+
+	for (UINT emittedCount = 0; emittedCount < triCount; ++emittedCount) {
+		if (bestTri == NoPosition) {
+			while (emitted[inputCursor]) ++inputCursor;
+			bestTri = inputCursor;
+		}
+
+		const UINT* const tri = &indices[bestTri * 3];
+		output.insert(output.end(), tri, tri + 3);
+		emitted[bestTri] = 1;
+
+		// Moves the vertices of the triangle to the front of the LRU cache.
+		UINT newCache[OptimizerCacheSize + 3];
+		UINT newCount = 0;
+		for (UINT k = 0; k < 3; ++k) {
+			const UINT v = tri[k];
+			newCache[newCount++] = v;
+
+			// Removes the triangle from the adjacency of its vertices.
+			UINT* const begin = &adjacency[adjacencyOffsets[v]];
+			UINT* const end = begin + valences[v];
+			UINT* const it = std::find(begin, end, bestTri);
+			std::swap(*it, *(end - 1));
+			--valences[v];
+		}
+		for (UINT i = 0; i < cacheCount; ++i) {
+			const UINT v = cache[i];
+			if (v != tri[0] && v != tri[1] && v != tri[2]) newCache[newCount++] = v;
+		}
+
+		// Rescores the vertices whose cache position changed and the triangles that use them.
+		for (UINT i = 0; i < newCount; ++i) {
+			const UINT v = newCache[i];
+			const UINT position = i < OptimizerCacheSize ? i : NoPosition;
+
+			const FLOAT score = VertexScore(position, valences[v]);
+			const FLOAT delta = score - vertexScores[v];
+			vertexScores[v] = score;
+
+			for (UINT j = adjacencyOffsets[v], end = adjacencyOffsets[v] + valences[v]; j < end; ++j)
+				triScores[adjacency[j]] += delta;
+		}
+
+		// The next triangle is picked among those touching the cache.
+		bestTri = NoPosition;
+		FLOAT bestScore = -1.f;
+
+		for (UINT i = 0; i < newCount; ++i) {
+			const UINT v = newCache[i];
+
+			for (UINT j = adjacencyOffsets[v], end = adjacencyOffsets[v] + valences[v]; j < end; ++j) {
+				const UINT t = adjacency[j];
+				if (triScores[t] > bestScore) {
+					bestScore = triScores[t];
+					bestTri = t;
+				}
+			}
+		}
+
+		cacheCount = std::min(newCount, OptimizerCacheSize);
+		std::copy(newCache, newCache + cacheCount, cache);
+	}
+
+	indices.swap(output);
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<UINT>& indices, const std::vector<Vertex>& vertices, FLOAT threshold) {
+	const UINT triCount = static_cast<UINT>(indices.size() / 3);
+	if (triCount < 2) return;
+
+	const UINT vertexCount = static_cast<UINT>(vertices.size());
+	FifoCache cache(vertexCount, FifoCacheSize);
+
+	// Hard boundaries: triangles that miss the cache on every vertex start a new cluster,
+	// so the clusters can be reordered without adding misses at their seams.
+	std::vector<UINT> hardClusters;
+	for (UINT i = 0; i < triCount; ++i) {
+		if (cache.Triangle(&indices[i * 3]) == 3) hardClusters.push_back(i);
+	}
+	if (hardClusters.empty() || hardClusters[0] != 0) hardClusters.insert(hardClusters.begin(), 0);
+	hardClusters.push_back(triCount);
+
+	// Soft boundaries: each hard cluster is split further wherever the ACMR since the last split,
+	// with a cold cache, stays within the threshold of the cluster's own ACMR.
+	std::vector<UINT> clusters;
+	for (size_t c = 0, end = hardClusters.size() - 1; c < end; ++c) {
+		const UINT begin = hardClusters[c];
+		const UINT last = hardClusters[c + 1];
+
+		cache.Reset();
+		UINT clusterMisses = 0;
+		for (UINT i = begin; i < last; ++i)
+			clusterMisses += cache.Triangle(&indices[i * 3]);
+
+		const FLOAT maxAcmr = threshold * clusterMisses / (last - begin);
+
+		clusters.push_back(begin);
+		cache.Reset();
+
+		UINT runningMisses = 0;
+		UINT runningTris = 0;
+		for (UINT i = begin; i < last; ++i) {
+			runningMisses += cache.Triangle(&indices[i * 3]);
+			++runningTris;
+
+			if (i + 1 < last && static_cast<FLOAT>(runningMisses) / runningTris <= maxAcmr) {
+				clusters.push_back(i + 1);
+				cache.Reset();
+				runningMisses = 0;
+				runningTris = 0;
+			}
+		}
+	}
+	clusters.push_back(triCount);
+
+	const UINT clusterCount = static_cast<UINT>(clusters.size() - 1);
+	if (clusterCount < 2) return;
+
+	// Area-weighted centroid and normal of each cluster and of the whole mesh.
+	std::vector<XMFLOAT3> centroids(clusterCount);
+	std::vector<XMFLOAT3> normals(clusterCount);
+
+	XMVECTOR meshCentroid = XMVectorZero();
+	FLOAT meshArea = 0.f;
+
+	for (UINT c = 0; c < clusterCount; ++c) {
+		XMVECTOR centroid = XMVectorZero();
+		XMVECTOR normal = XMVectorZero();
+		FLOAT area = 0.f;
+
+		for (UINT i = clusters[c]; i < clusters[c + 1]; ++i) {
+			const XMVECTOR p0 = XMLoadFloat3(&vertices[indices[i * 3 + 0]].Position);
+			const XMVECTOR p1 = XMLoadFloat3(&vertices[indices[i * 3 + 1]].Position);
+			const XMVECTOR p2 = XMLoadFloat3(&vertices[indices[i * 3 + 2]].Position);
+
+			// The length of the cross product is twice the triangle area.
+			const XMVECTOR n = XMVector3Cross(p1 - p0, p2 - p0);
+			const FLOAT a = XMVectorGetX(XMVector3Length(n));
+
+			centroid += (p0 + p1 + p2) * (a / 3.f);
+			normal += n;
+			area += a;
+		}
+
+		meshCentroid += centroid;
+		meshArea += area;
+
+		XMStoreFloat3(&centroids[c], area > 0.f ? centroid / area : centroid);
+		XMStoreFloat3(&normals[c], XMVector3Normalize(normal));
+	}
+
+	if (meshArea > 0.f) meshCentroid /= meshArea;
+
+	// Clusters that face away from the center are drawn first, since they tend to occlude the rest.
+	std::vector<FLOAT> sortKeys(clusterCount);
+	for (UINT c = 0; c < clusterCount; ++c)
+		sortKeys[c] = XMVectorGetX(XMVector3Dot(XMLoadFloat3(&centroids[c]) - meshCentroid, XMLoadFloat3(&normals[c])));
+
+	std::vector<UINT> order(clusterCount);
+	for (UINT c = 0; c < clusterCount; ++c)
+		order[c] = c;
+
+	std::stable_sort(order.begin(), order.end(), [&](UINT a, UINT b) {
+		return sortKeys[a] > sortKeys[b];
+	});
+
+	std::vector<UINT> output;
+	output.reserve(indices.size());
+
+	for (const UINT c : order)
+		output.insert(output.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+
+	indices.swap(output);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<UINT>& indices) {
+	std::vector<UINT> remap(vertices.size(), NoPosition);
+
+	std::vector<Vertex> output;
+	output.reserve(vertices.size());
+
+	for (auto& index : indices) {
+		UINT& newIndex = remap[index];
+		if (newIndex == NoPosition) {
+			newIndex = static_cast<UINT>(output.size());
+			output.push_back(vertices[index]);
+		}
+
+		index = newIndex;
+	}
+
+	vertices.swap(output);
+}
+
+void MeshOptimizer::SortByMaterial(Mesh& mesh, std::vector<Material>& materials, const std::vector<UINT>& triangleMaterials) {
+	const UINT materialCount = static_cast<UINT>(materials.size());
+	const UINT triCount = static_cast<UINT>(mesh.Indices.size() / 3);
+
+	// The last slot collects the triangles without a valid material.
+	std::vector<UINT> starts(materialCount + 1, 0);
+	for (UINT i = 0; i < triCount; ++i)
+		++starts[std::min(triangleMaterials[i], materialCount)];
+
+	std::vector<Material> used;
+	mesh.Subsets.clear();
+
+	UINT start = 0;
+	for (UINT m = 0; m <= materialCount; ++m) {
+		const UINT count = starts[m];
+		starts[m] = start;
+		if (count == 0) continue;
+
+		mesh.Subsets.push_back({ start * 3, count * 3, static_cast<UINT>(used.size()), 0, 0 });
+		used.push_back(m < materialCount ? materials[m] : Material());
+
+		start += count;
+	}
+
+	std::vector<UINT> sorted(mesh.Indices.size());
+	for (UINT i = 0; i < triCount; ++i) {
+		const UINT dst = starts[std::min(triangleMaterials[i], materialCount)]++;
+		std::copy_n(mesh.Indices.begin() + i * 3, 3, sorted.begin() + dst * 3);
+	}
+
+	mesh.Indices.swap(sorted);
+	materials.swap(used);
+}
+
+BOOL MeshOptimizer::Optimize(Mesh& mesh) {
+	if (mesh.Indices.size() % 3 != 0) ReturnFalse(L"Index count must be a multiple of three");
+
+	const UINT vertexCount = static_cast<UINT>(mesh.Vertices.size());
+	for (const UINT index : mesh.Indices) {
+		if (index >= vertexCount) ReturnFalse(L"Index out of range: " << index);
+	}
+	for (const auto& subset : mesh.Subsets) {
+		if (subset.IndexCount % 3 != 0 || subset.StartIndexLocation % 3 != 0 ||
+			static_cast<UINT64>(subset.StartIndexLocation) + subset.IndexCount > mesh.Indices.size())
+			ReturnFalse(L"Invalid subset range: " << subset.StartIndexLocation << L", " << subset.IndexCount);
+	}
+
+	const CacheStatistics before = AnalyzeVertexCache(mesh.Indices, vertexCount);
+
+	if (mesh.Subsets.size() > 1) {
+		std::vector<UINT> indices;
+		for (const auto& subset : mesh.Subsets) {
+			const auto begin = mesh.Indices.begin() + subset.StartIndexLocation;
+			indices.assign(begin, begin + subset.IndexCount);
+
+			OptimizeVertexCache(indices, vertexCount);
+			OptimizeOverdraw(indices, mesh.Vertices);
+
+			std::copy(indices.begin(), indices.end(), begin);
+		}
+	}
+	else {
+		OptimizeVertexCache(mesh.Indices, vertexCount);
+		OptimizeOverdraw(mesh.Indices, mesh.Vertices);
+	}
+	OptimizeVertexFetch(mesh.Vertices, mesh.Indices);
+
+	const CacheStatistics after = AnalyzeVertexCache(mesh.Indices, static_cast<UINT>(mesh.Vertices.size()));
+
+	WLogln(L"Vertex cache optimization: ACMR ", std::to_wstring(before.Acmr), L" -> ", std::to_wstring(after.Acmr),
+		L", ATVR ", std::to_wstring(before.Atvr), L" -> ", std::to_wstring(after.Atvr));
+
+	return TRUE;
+}
\ No newline at end of file
@@ -0,0 +1,511 @@
+#include "Common/Mesh/MeshSimplifier.h"
+#include "Common/Mesh/MeshOptimizer.h"
+#include "Common/Debug/Logger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+
+#undef max
+#undef min
+
+using namespace DirectX;
+
+namespace {
+	const UINT NoGroup = 0xFFFFFFFF;
+
+	// Area-weighted sum of squared plane distances, Q(p) = p^T A p + 2 b^T p + c.
+	struct Quadric {
+		DOUBLE A00, A01, A02, A11, A12, A22;
+		DOUBLE B0, B1, B2;
+		DOUBLE C;
+		DOUBLE Weight;
+	};
+
+	struct Vector3d {
+		DOUBLE X, Y, Z;
+	};
+
+	struct Collapse {
+		UINT From;
+		UINT To;
+		DOUBLE Cost;
+		DOUBLE Error;
+	};
+
+	__forceinline Vector3d Sub(const Vector3d& a, const Vector3d& b) {
+		return { a.X - b.X, a.Y - b.Y, a.Z - b.Z };
+	}
+
+	__forceinline Vector3d Cross(const Vector3d& a, const Vector3d& b) {
+		return { a.Y * b.Z - a.Z * b.Y, a.Z * b.X - a.X * b.Z, a.X * b.Y - a.Y * b.X };
+	}
+
+	__forceinline DOUBLE Dot(const Vector3d& a, const Vector3d& b) {
+		return a.X * b.X + a.Y * b.Y + a.Z * b.Z;
+	}
+
+	__forceinline void AddPlane(Quadric& q, const Vector3d& n, DOUBLE d, DOUBLE weight) {
+		q.A00 += weight * n.X * n.X;
+		q.A01 += weight * n.X * n.Y;
+		q.A02 += weight * n.X * n.Z;
+		q.A11 += weight * n.Y * n.Y;
+		q.A12 += weight * n.Y * n.Z;
+		q.A22 += weight * n.Z * n.Z;
+		q.B0 += weight * n.X * d;
+		q.B1 += weight * n.Y * d;
+		q.B2 += weight * n.Z * d;
+		q.C += weight * d * d;
+		q.Weight += weight;
+	}
+
+	__forceinline void AddQuadric(Quadric& q, const Quadric& other) {
+		q.A00 += other.A00; q.A01 += other.A01; q.A02 += other.A02;
+		q.A11 += other.A11; q.A12 += other.A12; q.A22 += other.A22;
+		q.B0 += other.B0; q.B1 += other.B1; q.B2 += other.B2;
+		q.C += other.C;
+		q.Weight += other.Weight;
+	}
+
+	// Mean squared distance of p to the planes of the quadric.
+	__forceinline DOUBLE Evaluate(const Quadric& q, const Vector3d& p) {
+		if (q.Weight <= 0.) return 0.;
+
+		const DOUBLE result =
+			q.A00 * p.X * p.X + q.A11 * p.Y * p.Y + q.A22 * p.Z * p.Z +
+			2. * (q.A01 * p.X * p.Y + q.A02 * p.X * p.Z + q.A12 * p.Y * p.Z) +
+			2. * (q.B0 * p.X + q.B1 * p.Y + q.B2 * p.Z) +
+			q.C;
+
+		return std::max(result, 0.) / q.Weight;
+	}
+
+	// Vertices that share a position form a group; groups with more than one vertex are seams.
+	void BuildPositionGroups(const std::vector<Vertex>& vertices, std::vector<UINT>& groups, std::vector<UINT>& groupSizes) {
+		const UINT vertexCount = static_cast<UINT>(vertices.size());
+
+		std::vector<UINT> order(vertexCount);
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&](UINT a, UINT b) {
+			const XMFLOAT3& pa = vertices[a].Position;
+			const XMFLOAT3& pb = vertices[b].Position;
+			if (pa.x != pb.x) return pa.x < pb.x;
+			if (pa.y != pb.y) return pa.y < pb.y;
+			return pa.z < pb.z;
+		});
+
+		groups.assign(vertexCount, NoGroup);
+		groupSizes.clear();
+
+		for (UINT i = 0; i < vertexCount; ++i) {
+			const XMFLOAT3& p = vertices[order[i]].Position;
+			if (i == 0 || !(vertices[order[i - 1]].Position.x == p.x && vertices[order[i - 1]].Position.y == p.y && vertices[order[i - 1]].Position.z == p.z))
+				groupSizes.push_back(0);
+
+			groups[order[i]] = static_cast<UINT>(groupSizes.size() - 1);
+			++groupSizes.back();
+		}
+	}
+
+	// Locks seam vertices, vertices on open or non-manifold edges (when borders are locked),
+	// and vertices of degenerate index triples.
+	void FindLockedVertices(
+			const std::vector<Vertex>& vertices,
+			const std::vector<UINT>& indices,
+			BOOL lockBorder,
+			std::vector<BYTE>& locked) {
+		std::vector<UINT> groups;
+		std::vector<UINT> groupSizes;
+		BuildPositionGroups(vertices, groups, groupSizes);
+
+		const UINT vertexCount = static_cast<UINT>(vertices.size());
+		locked.assign(vertexCount, 0);
+
+		for (UINT v = 0; v < vertexCount; ++v) {
+			if (groupSizes[groups[v]] > 1) locked[v] = 1;
+		}
+
+		// Directed edges between position groups; a manifold interior edge appears once in each direction.
+		std::unordered_map<UINT64, UINT> edges;
+		edges.reserve(indices.size());
+
+		const auto EdgeKey = [&](UINT a, UINT b) {
+			return (static_cast<UINT64>(groups[a]) << 32) | groups[b];
+		};
+
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			for (UINT k = 0; k < 3; ++k) ++edges[EdgeKey(indices[i + k], indices[i + (k + 1) % 3])];
+		}
+
+		std::vector<BYTE> lockedGroups(groupSizes.size(), 0);
+		for (const auto& edge : edges) {
+			const UINT a = static_cast<UINT>(edge.first >> 32);
+			const UINT b = static_cast<UINT>(edge.first & 0xFFFFFFFF);
+			if (a == b) {
+				lockedGroups[a] = 1;
+				continue;
+			}
+
+			const auto opposite = edges.find((static_cast<UINT64>(b) << 32) | a);
+			const BOOL border = opposite == edges.end();
+			const BOOL nonManifold = edge.second > 1 || (!border && opposite->second > 1);
+			if (nonManifold || (border && lockBorder)) {
+				lockedGroups[a] = 1;
+				lockedGroups[b] = 1;
+			}
+		}
+
+		for (UINT v = 0; v < vertexCount; ++v) {
+			if (lockedGroups[groups[v]]) locked[v] = 1;
+		}
+	}
+
+	class Simplifier {
+	public:
+		Simplifier(const std::vector<Vertex>& vertices, std::vector<UINT>& indices, BOOL lockBorder);
+
+	public:
+		// Runs one pass of independent collapses; returns FALSE if nothing could be collapsed.
+		BOOL Pass(UINT targetIndexCount, DOUBLE maxCost);
+
+		__forceinline DOUBLE MaxError() const { return mMaxError; }
+
+	private:
+		void BuildAdjacency();
+		void FindCollapse(UINT from, UINT to, std::vector<Collapse>& best) const;
+		BOOL HasValidLink(UINT from, UINT to) const;
+		BOOL HasTriangleFlip(UINT from, UINT to) const;
+
+	private:
+		const std::vector<Vertex>& mVertices;
+		std::vector<UINT>& mIndices;
+
+		std::vector<Vector3d> mPositions;
+		std::vector<Quadric> mQuadrics;
+		std::vector<BYTE> mLocked;
+
+		std::vector<UINT> mAdjacencyOffsets;
+		std::vector<UINT> mAdjacency;
+
+		DOUBLE mMaxError = 0.;
+	};
+
+	Simplifier::Simplifier(const std::vector<Vertex>& vertices, std::vector<UINT>& indices, BOOL lockBorder)
+		: mVertices(vertices), mIndices(indices) {
+		const UINT vertexCount = static_cast<UINT>(vertices.size());
+
+		// Positions are normalized to the mesh extent so that costs are scale independent.
+		XMVECTOR vMin = XMVectorReplicate(+MathHelper::Infinity);
+		for (const auto& vertex : vertices) vMin = XMVectorMin(vMin, XMLoadFloat3(&vertex.Position));
+
+		const DOUBLE invExtent = 1. / std::max(static_cast<DOUBLE>(MeshSimplifier::Extent(vertices)), 1e-12);
+
+		XMFLOAT3 origin;
+		XMStoreFloat3(&origin, vMin);
+
+		mPositions.resize(vertexCount);
+		for (UINT v = 0; v < vertexCount; ++v) {
+			const XMFLOAT3& p = vertices[v].Position;
+			mPositions[v] = {
+				(static_cast<DOUBLE>(p.x) - origin.x) * invExtent,
+				(static_cast<DOUBLE>(p.y) - origin.y) * invExtent,
+				(static_cast<DOUBLE>(p.z) - origin.z) * invExtent };
+		}
+
+		mQuadrics.assign(vertexCount, Quadric{});
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			const Vector3d& p0 = mPositions[indices[i + 0]];
+			const Vector3d& p1 = mPositions[indices[i + 1]];
+			const Vector3d& p2 = mPositions[indices[i + 2]];
+
+			Vector3d n = Cross(Sub(p1, p0), Sub(p2, p0));
+			const DOUBLE length = std::sqrt(Dot(n, n));
+			if (length <= 0.) continue;
+
+			n = { n.X / length, n.Y / length, n.Z / length };
+			const DOUBLE d = -Dot(n, p0);
+			const DOUBLE area = length * 0.5;
+
+			for (UINT k = 0; k < 3; ++k) AddPlane(mQuadrics[indices[i + k]], n, d, area);
+		}
+
+		FindLockedVertices(vertices, indices, lockBorder, mLocked);
+	}
+
+	void Simplifier::BuildAdjacency() {
+		const UINT vertexCount = static_cast<UINT>(mVertices.size());
+		const UINT triangleCount = static_cast<UINT>(mIndices.size() / 3);
+
+		mAdjacencyOffsets.assign(vertexCount + 1, 0);
+		for (const UINT index : mIndices) ++mAdjacencyOffsets[index + 1];
+		for (UINT v = 0; v < vertexCount; ++v) mAdjacencyOffsets[v + 1] += mAdjacencyOffsets[v];
+
+		mAdjacency.resize(mIndices.size());
+		std::vector<UINT> cursors(mAdjacencyOffsets.begin(), mAdjacencyOffsets.end() - 1);
+		for (UINT t = 0; t < triangleCount; ++t) {
+			for (UINT k = 0; k < 3; ++k) mAdjacency[cursors[mIndices[t * 3 + k]]++] = t;
+		}
+	}
+
+	void Simplifier::FindCollapse(UINT from, UINT to, std::vector<Collapse>& best) const {
+		if (mLocked[from]) return;
+
+		const Vector3d& target = mPositions[to];
+		const DOUBLE error = Evaluate(mQuadrics[from], target);
+
+		const Vertex& a = mVertices[from];
+		const Vertex& b = mVertices[to];
+
+		const XMVECTOR dn = XMVectorSubtract(XMLoadFloat3(&a.Normal), XMLoadFloat3(&b.Normal));
+		const XMVECTOR dt = XMVectorSubtract(XMLoadFloat2(&a.TexCoord), XMLoadFloat2(&b.TexCoord));
+		const Vector3d edge = Sub(mPositions[from], target);
+
+		const DOUBLE attribute = Dot(edge, edge) * (
+			MeshSimplifier::NormalWeight * XMVectorGetX(XMVector3LengthSq(dn)) +
+			MeshSimplifier::TexCoordWeight * XMVectorGetX(XMVector2LengthSq(dt)));
+
+		const DOUBLE cost = error + attribute;
+		if (cost < best[from].Cost) best[from] = { from, to, cost, error };
+	}
+
+	// The endpoints may only share the neighbours opposite the edge, or the collapse pinches the surface.
+	BOOL Simplifier::HasValidLink(UINT from, UINT to) const {
+		UINT sharedTriangles = 0;
+		std::vector<UINT> fromNeighbours;
+
+		for (UINT a = mAdjacencyOffsets[from]; a < mAdjacencyOffsets[from + 1]; ++a) {
+			const UINT* const tri = &mIndices[mAdjacency[a] * 3];
+			if (tri[0] == to || tri[1] == to || tri[2] == to) ++sharedTriangles;
+
+			for (UINT k = 0; k < 3; ++k) {
+				if (tri[k] != from && tri[k] != to) fromNeighbours.push_back(tri[k]);
+			}
+		}
+
+		std::sort(fromNeighbours.begin(), fromNeighbours.end());
+		fromNeighbours.erase(std::unique(fromNeighbours.begin(), fromNeighbours.end()), fromNeighbours.end());
+
+		std::vector<UINT> common;
+		for (UINT a = mAdjacencyOffsets[to]; a < mAdjacencyOffsets[to + 1]; ++a) {
+			const UINT* const tri = &mIndices[mAdjacency[a] * 3];
+			for (UINT k = 0; k < 3; ++k) {
+				if (tri[k] != to && std::binary_search(fromNeighbours.begin(), fromNeighbours.end(), tri[k])) common.push_back(tri[k]);
+			}
+		}
+
+		std::sort(common.begin(), common.end());
+		const size_t commonCount = std::unique(common.begin(), common.end()) - common.begin();
+
+		return sharedTriangles > 0 && commonCount == sharedTriangles;
+	}
+
+	BOOL Simplifier::HasTriangleFlip(UINT from, UINT to) const {
+		const Vector3d& target = mPositions[to];
+
+		for (UINT a = mAdjacencyOffsets[from]; a < mAdjacencyOffsets[from + 1]; ++a) {
+			const UINT* const tri = &mIndices[mAdjacency[a] * 3];
+			// Triangles on the collapsed edge disappear.
+			if (tri[0] == to || tri[1] == to || tri[2] == to) continue;
+
+			const Vector3d& p0 = mPositions[tri[0]];
+			const Vector3d& p1 = mPositions[tri[1]];
+			const Vector3d& p2 = mPositions[tri[2]];
+
+			const Vector3d& q0 = tri[0] == from ? target : p0;
+			const Vector3d& q1 = tri[1] == from ? target : p1;
+			const Vector3d& q2 = tri[2] == from ? target : p2;
+
+			const Vector3d before = Cross(Sub(p1, p0), Sub(p2, p0));
+			const Vector3d after = Cross(Sub(q1, q0), Sub(q2, q0));
+
+			const DOUBLE lengths = std::sqrt(Dot(before, before) * Dot(after, after));
+			if (Dot(before, after) <= MeshSimplifier::MinNormalCosine * lengths) return TRUE;
+		}
+
+		return FALSE;
+	}
+
+	BOOL Simplifier::Pass(UINT targetIndexCount, DOUBLE maxCost) {
+		BuildAdjacency();
+
+		const UINT vertexCount = static_cast<UINT>(mVertices.size());
+		const UINT triangleCount = static_cast<UINT>(mIndices.size() / 3);
+
+		std::vector<Collapse> best(vertexCount, Collapse{ 0, 0, MathHelper::Infinity, 0. });
+		for (UINT t = 0; t < triangleCount; ++t) {
+			for (UINT k = 0; k < 3; ++k) {
+				const UINT a = mIndices[t * 3 + k];
+				const UINT b = mIndices[t * 3 + (k + 1) % 3];
+
+				FindCollapse(a, b, best);
+				FindCollapse(b, a, best);
+			}
+		}
+
+		std::vector<Collapse> collapses;
+		for (const auto& collapse : best) {
+			if (collapse.Cost <= maxCost) collapses.push_back(collapse);
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+			return a.Cost < b.Cost;
+		});
+
+		const UINT trianglesToRemove = triangleCount - targetIndexCount / 3;
+
+		std::vector<UINT> remap(vertexCount);
+		std::iota(remap.begin(), remap.end(), 0);
+
+		// Vertices whose triangles were changed in this pass; their costs are stale until the next one.
+		std::vector<BYTE> dirty(vertexCount, 0);
+
+		UINT removed = 0;
+		for (const auto& collapse : collapses) {
+			if (removed >= trianglesToRemove) break;
+
+			const UINT from = collapse.From;
+			const UINT to = collapse.To;
+			if (dirty[from] || dirty[to]) continue;
+			if (!HasValidLink(from, to) || HasTriangleFlip(from, to)) continue;
+
+			for (UINT a = mAdjacencyOffsets[from]; a < mAdjacencyOffsets[from + 1]; ++a) {
+				const UINT* const tri = &mIndices[mAdjacency[a] * 3];
+				if (tri[0] == to || tri[1] == to || tri[2] == to) ++removed;
+
+				for (UINT k = 0; k < 3; ++k) dirty[tri[k]] = 1;
+			}
+
+			remap[from] = to;
+			AddQuadric(mQuadrics[to], mQuadrics[from]);
+			mMaxError = std::max(mMaxError, collapse.Error);
+		}
+
+		if (removed == 0) return FALSE;
+
+		size_t write = 0;
+		for (size_t i = 0; i < mIndices.size(); i += 3) {
+			const UINT a = remap[mIndices[i + 0]];
+			const UINT b = remap[mIndices[i + 1]];
+			const UINT c = remap[mIndices[i + 2]];
+			if (a == b || b == c || c == a) continue;
+
+			mIndices[write++] = a;
+			mIndices[write++] = b;
+			mIndices[write++] = c;
+		}
+		mIndices.resize(write);
+
+		return TRUE;
+	}
+}
+
+FLOAT MeshSimplifier::Extent(const std::vector<Vertex>& vertices) {
+	if (vertices.empty()) return 0.f;
+
+	XMVECTOR vMin = XMVectorReplicate(+MathHelper::Infinity);
+	XMVECTOR vMax = XMVectorReplicate(-MathHelper::Infinity);
+	for (const auto& vertex : vertices) {
+		const XMVECTOR P = XMLoadFloat3(&vertex.Position);
+
+		vMin = XMVectorMin(vMin, P);
+		vMax = XMVectorMax(vMax, P);
+	}
+
+	XMFLOAT3 size;
+	XMStoreFloat3(&size, XMVectorSubtract(vMax, vMin));
+
+	return std::max(std::max(size.x, size.y), size.z);
+}
+
+FLOAT MeshSimplifier::Simplify(
+		const std::vector<Vertex>& vertices,
+		const std::vector<UINT>& indices,
+		UINT targetIndexCount,
+		FLOAT targetError,
+		std::vector<UINT>& result,
+		BOOL lockBorder) {
+	result = indices;
+	if (result.size() <= targetIndexCount) return 0.f;
+
+	Simplifier simplifier(vertices, result, lockBorder);
+
+	const DOUBLE maxCost = static_cast<DOUBLE>(targetError) * targetError;
+	while (result.size() > targetIndexCount && simplifier.Pass(targetIndexCount, maxCost));
+
+	return static_cast<FLOAT>(std::sqrt(simplifier.MaxError()));
+}
+
+BOOL MeshSimplifier::BuildLods(Mesh& mesh) {
+	mesh.Lods.clear();
+	mesh.LodIndices.clear();
+	mesh.LodSubsets.clear();
+
+	const UINT indexCount = static_cast<UINT>(mesh.Indices.size());
+	const UINT vertexCount = static_cast<UINT>(mesh.Vertices.size());
+	const FLOAT extent = Extent(mesh.Vertices);
+
+	// Subsets are simplified on their own with their borders locked, so materials never bleed into
+	// each other and the levels stay crack-free where they meet.
+	std::vector<MeshSubset> subsets(mesh.Subsets);
+	if (subsets.empty()) subsets.push_back({ 0, indexCount, 0, 0, 0 });
+
+	std::vector<std::vector<UINT>> subsetIndices(subsets.size());
+	for (size_t s = 0, end = subsets.size(); s < end; ++s) {
+		const auto begin = mesh.Indices.begin() + subsets[s].StartIndexLocation;
+		subsetIndices[s].assign(begin, begin + subsets[s].IndexCount);
+	}
+
+	mesh.Lods.push_back({ 0, indexCount, 0.f });
+
+	UINT previousCount = indexCount;
+	while (mesh.Lods.size() < MaxLodCount) {
+		const UINT targetCount = static_cast<UINT>(previousCount / 3 * LodReduction) * 3;
+		if (targetCount / 3 < MinLodTriangles) break;
+
+		// Every subset aims for the same fraction of its full-detail triangles.
+		const DOUBLE ratio = static_cast<DOUBLE>(targetCount) / indexCount;
+
+		std::vector<UINT> lod;
+		std::vector<MeshSubset> lodSubsets(subsets);
+		FLOAT error = 0.f;
+
+		for (size_t s = 0, end = subsets.size(); s < end; ++s) {
+			const UINT subsetTarget = static_cast<UINT>(subsets[s].IndexCount / 3 * ratio) * 3;
+
+			std::vector<UINT> result;
+			error = std::max(error, Simplify(mesh.Vertices, subsetIndices[s], subsetTarget, MaxLodError, result));
+
+			MeshOptimizer::OptimizeVertexCache(result, vertexCount);
+
+			MeshSubset& lodSubset = lodSubsets[s];
+			lodSubset.StartIndexLocation = indexCount + static_cast<UINT>(mesh.LodIndices.size() + lod.size());
+			lodSubset.IndexCount = static_cast<UINT>(result.size());
+			lodSubset.FirstMeshlet = 0;
+			lodSubset.MeshletCount = 0;
+
+			lod.insert(lod.end(), result.begin(), result.end());
+		}
+
+		if (lod.empty() || lod.size() > previousCount * MinLodReduction) break;
+
+		MeshLod level;
+		level.StartIndexLocation = indexCount + static_cast<UINT>(mesh.LodIndices.size());
+		level.IndexCount = static_cast<UINT>(lod.size());
+		// Each level is simplified from the full mesh, so keep the errors monotonic for the selection.
+		level.Error = std::max(error * extent, mesh.Lods.back().Error);
+
+		mesh.Lods.push_back(level);
+		mesh.LodIndices.insert(mesh.LodIndices.end(), lod.begin(), lod.end());
+		if (!mesh.Subsets.empty()) mesh.LodSubsets.insert(mesh.LodSubsets.end(), lodSubsets.begin(), lodSubsets.end());
+
+		previousCount = level.IndexCount;
+	}
+
+	for (size_t i = 0, end = mesh.Lods.size(); i < end; ++i) {
+		WLogln(L"LOD ", std::to_wstring(i), L": ", std::to_wstring(mesh.Lods[i].IndexCount / 3), L" triangles, error ",
+			std::to_wstring(mesh.Lods[i].Error));
+	}
+
+	return TRUE;
+}
\ No newline at end of file
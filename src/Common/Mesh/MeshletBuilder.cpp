@@ -0,0 +1,347 @@
+#include "Common/Mesh/MeshletBuilder.h"
+#include "Common/Debug/Logger.h"
+#include "Common/Helper/MathHelper.h"
+
+#include <algorithm>
+#include <array>
+#include <DirectXCollision.h>
+
+#undef max
+#undef min
+
+using namespace DirectX;
+
+namespace {
+	const UINT Unassigned = 0xFFFFFFFF;
+
+	// Relative slack for the validation checks, which compare against exact geometry.
+	const FLOAT ValidationEpsilon = 1e-4f;
+
+	typedef std::array<UINT, 3> Triangle;
+
+	// Rotates the triangle so its smallest index comes first, which keeps the winding.
+	__forceinline Triangle Canonical(UINT a, UINT b, UINT c) {
+		if (b < a && b < c) return { b, c, a };
+		if (c < a && c < b) return { c, a, b };
+		return { a, b, c };
+	}
+
+	__forceinline XMVECTOR TriangleNormal(FXMVECTOR p0, FXMVECTOR p1, FXMVECTOR p2) {
+		return XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0));
+	}
+}
+
+void MeshletBuilder::Build(
+		const std::vector<Vertex>& vertices,
+		const std::vector<UINT>& indices,
+		std::vector<Meshlet>& meshlets,
+		std::vector<UINT>& meshletVertices,
+		std::vector<BYTE>& meshletTriangles,
+		UINT maxVertices,
+		UINT maxTriangles) {
+	meshlets.clear();
+	meshletVertices.clear();
+	meshletTriangles.clear();
+
+	const UINT vertexCount = static_cast<UINT>(vertices.size());
+	const UINT triangleCount = static_cast<UINT>(indices.size() / 3);
+
+	// Triangles around each vertex.
+	std::vector<UINT> adjacencyOffsets(vertexCount + 1, 0);
+	for (UINT i = 0; i < triangleCount * 3; ++i) ++adjacencyOffsets[indices[i] + 1];
+	for (UINT v = 0; v < vertexCount; ++v) adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+
+	std::vector<UINT> adjacency(triangleCount * 3);
+	{
+		std::vector<UINT> cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (UINT t = 0; t < triangleCount; ++t) {
+			for (UINT k = 0; k < 3; ++k) adjacency[cursors[indices[t * 3 + k]]++] = t;
+		}
+	}
+
+	// Unit normals; degenerate triangles get a zero normal and do not steer the cone.
+	std::vector<XMFLOAT3> normals(triangleCount);
+	for (UINT t = 0; t < triangleCount; ++t) {
+		const XMVECTOR n = TriangleNormal(
+			XMLoadFloat3(&vertices[indices[t * 3 + 0]].Position),
+			XMLoadFloat3(&vertices[indices[t * 3 + 1]].Position),
+			XMLoadFloat3(&vertices[indices[t * 3 + 2]].Position));
+		const FLOAT length = XMVectorGetX(XMVector3Length(n));
+
+		XMStoreFloat3(&normals[t], length > 0.f ? XMVectorScale(n, 1.f / length) : XMVectorZero());
+	}
+
+	std::vector<BOOL> emitted(triangleCount, FALSE);
+	// Position of each vertex in the meshlet being built.
+	std::vector<UINT> locals(vertexCount, Unassigned);
+
+	Meshlet meshlet = {};
+	XMVECTOR normalSum = XMVectorZero();
+
+	const auto NewVertexCount = [&](UINT t) {
+		UINT count = 0;
+		for (UINT k = 0; k < 3; ++k) count += locals[indices[t * 3 + k]] == Unassigned ? 1 : 0;
+		return count;
+	};
+
+	const auto Flush = [&]() {
+		ComputeBounds(vertices, meshletVertices.data() + meshlet.VertexOffset, meshletTriangles.data() + meshlet.TriangleOffset * 3, meshlet);
+		meshlets.push_back(meshlet);
+
+		for (UINT i = 0; i < meshlet.VertexCount; ++i) locals[meshletVertices[meshlet.VertexOffset + i]] = Unassigned;
+
+		meshlet = {};
+		meshlet.VertexOffset = static_cast<UINT>(meshletVertices.size());
+		meshlet.TriangleOffset = static_cast<UINT>(meshletTriangles.size() / 3);
+		normalSum = XMVectorZero();
+	};
+
+	UINT cursor = 0;
+
+	for (;;) {
+		UINT best = Unassigned;
+
+		if (meshlet.TriangleCount > 0) {
+			const XMVECTOR axis = XMVector3Normalize(normalSum);
+			FLOAT bestScore = MathHelper::Infinity;
+
+			for (UINT i = 0; i < meshlet.VertexCount; ++i) {
+				const UINT v = meshletVertices[meshlet.VertexOffset + i];
+
+				for (UINT a = adjacencyOffsets[v], end = adjacencyOffsets[v + 1]; a < end; ++a) {
+					const UINT t = adjacency[a];
+					if (emitted[t]) continue;
+
+					const UINT newCount = NewVertexCount(t);
+					if (meshlet.VertexCount + newCount > maxVertices) continue;
+
+					const FLOAT score = static_cast<FLOAT>(newCount) - ConeWeight * XMVectorGetX(XMVector3Dot(axis, XMLoadFloat3(&normals[t])));
+					if (score < bestScore) {
+						bestScore = score;
+						best = t;
+					}
+				}
+			}
+		}
+
+		if (best == Unassigned) {
+			while (cursor < triangleCount && emitted[cursor]) ++cursor;
+			if (cursor == triangleCount) break;
+
+			if (meshlet.TriangleCount > 0 && meshlet.VertexCount + NewVertexCount(cursor) > maxVertices) {
+				Flush();
+				continue;
+			}
+
+			best = cursor;
+		}
+
+		for (UINT k = 0; k < 3; ++k) {
+			const UINT v = indices[best * 3 + k];
+			if (locals[v] == Unassigned) {
+				locals[v] = meshlet.VertexCount++;
+				meshletVertices.push_back(v);
+			}
+			meshletTriangles.push_back(static_cast<BYTE>(locals[v]));
+		}
+
+		emitted[best] = TRUE;
+		normalSum = XMVectorAdd(normalSum, XMLoadFloat3(&normals[best]));
+
+		if (++meshlet.TriangleCount == maxTriangles) Flush();
+	}
+
+	if (meshlet.TriangleCount > 0) Flush();
+}
+
+void MeshletBuilder::ComputeBounds(
+		const std::vector<Vertex>& vertices,
+		const UINT* meshletVertices,
+		const BYTE* meshletTriangles,
+		Meshlet& meshlet) {
+	std::vector<XMFLOAT3> positions(meshlet.VertexCount);
+	for (UINT i = 0; i < meshlet.VertexCount; ++i) positions[i] = vertices[meshletVertices[i]].Position;
+
+	BoundingSphere sphere;
+	BoundingSphere::CreateFromPoints(sphere, meshlet.VertexCount, positions.data(), sizeof(XMFLOAT3));
+
+	meshlet.Center = sphere.Center;
+	meshlet.Radius = sphere.Radius;
+
+	// No cone unless one is found below.
+	meshlet.ConeApex = sphere.Center;
+	meshlet.ConeAxis = { 0.f, 0.f, 0.f };
+	meshlet.ConeCutoff = 1.f;
+
+	std::vector<XMFLOAT3> normals;
+	std::vector<XMFLOAT3> corners;
+	normals.reserve(meshlet.TriangleCount);
+	corners.reserve(meshlet.TriangleCount);
+
+	XMVECTOR normalSum = XMVectorZero();
+	for (UINT t = 0; t < meshlet.TriangleCount; ++t) {
+		const XMVECTOR p0 = XMLoadFloat3(&positions[meshletTriangles[t * 3 + 0]]);
+		const XMVECTOR p1 = XMLoadFloat3(&positions[meshletTriangles[t * 3 + 1]]);
+		const XMVECTOR p2 = XMLoadFloat3(&positions[meshletTriangles[t * 3 + 2]]);
+
+		const XMVECTOR n = TriangleNormal(p0, p1, p2);
+		const FLOAT length = XMVectorGetX(XMVector3Length(n));
+		// Degenerate triangles are never rasterized, so they place no constraint on the cone.
+		if (length <= 0.f) continue;
+
+		const XMVECTOR unit = XMVectorScale(n, 1.f / length);
+		normalSum = XMVectorAdd(normalSum, unit);
+
+		normals.emplace_back();
+		corners.emplace_back();
+		XMStoreFloat3(&normals.back(), unit);
+		XMStoreFloat3(&corners.back(), p0);
+	}
+
+	if (normals.empty() || XMVectorGetX(XMVector3LengthSq(normalSum)) <= 0.f) return;
+
+	const XMVECTOR axis = XMVector3Normalize(normalSum);
+
+	FLOAT minDot = 1.f;
+	for (const auto& n : normals)
+		minDot = std::min(minDot, XMVectorGetX(XMVector3Dot(axis, XMLoadFloat3(&n))));
+
+	if (minDot <= MinConeCosine) return;
+
+	// Move the apex back along the axis until it lies behind every triangle plane:
+	// dot(center - t * axis - corner, n) <= 0 for all triangles.
+	const XMVECTOR center = XMLoadFloat3(&meshlet.Center);
+
+	FLOAT maxT = 0.f;
+	for (size_t i = 0, end = normals.size(); i < end; ++i) {
+		const XMVECTOR n = XMLoadFloat3(&normals[i]);
+		const FLOAT dc = XMVectorGetX(XMVector3Dot(XMVectorSubtract(center, XMLoadFloat3(&corners[i])), n));
+		const FLOAT dn = XMVectorGetX(XMVector3Dot(axis, n));
+
+		maxT = std::max(maxT, dc / dn);
+	}
+
+	XMStoreFloat3(&meshlet.ConeApex, XMVectorSubtract(center, XMVectorScale(axis, maxT)));
+	XMStoreFloat3(&meshlet.ConeAxis, axis);
+	// The viewer must be within 90 degrees minus the cone angle of the axis, hence the sine.
+	meshlet.ConeCutoff = std::sqrt(1.f - minDot * minDot);
+}
+
+BOOL MeshletBuilder::Validate(
+		const std::vector<Vertex>& vertices,
+		const std::vector<UINT>& indices,
+		const std::vector<Meshlet>& meshlets,
+		const std::vector<UINT>& meshletVertices,
+		const std::vector<BYTE>& meshletTriangles,
+		UINT maxVertices,
+		UINT maxTriangles) {
+	const UINT vertexCount = static_cast<UINT>(vertices.size());
+	const UINT64 triangleListSize = meshletTriangles.size() / 3;
+
+	std::vector<Triangle> expected;
+	expected.reserve(indices.size() / 3);
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		expected.push_back(Canonical(indices[i], indices[i + 1], indices[i + 2]));
+
+	std::vector<Triangle> actual;
+	actual.reserve(expected.size());
+
+	for (UINT m = 0, end = static_cast<UINT>(meshlets.size()); m < end; ++m) {
+		const auto& meshlet = meshlets[m];
+
+		if (meshlet.VertexCount > maxVertices || meshlet.TriangleCount > maxTriangles)
+			ReturnFalse(L"Meshlet " << m << L" exceeds the limits: " << meshlet.VertexCount << L" vertices, " << meshlet.TriangleCount << L" triangles");
+		if (static_cast<UINT64>(meshlet.VertexOffset) + meshlet.VertexCount > meshletVertices.size() ||
+			static_cast<UINT64>(meshlet.TriangleOffset) + meshlet.TriangleCount > triangleListSize)
+			ReturnFalse(L"Meshlet " << m << L" is out of range");
+
+		const UINT* const localVertices = meshletVertices.data() + meshlet.VertexOffset;
+		const BYTE* const localTriangles = meshletTriangles.data() + meshlet.TriangleOffset * 3;
+
+		for (UINT t = 0; t < meshlet.TriangleCount * 3; ++t) {
+			if (localTriangles[t] >= meshlet.VertexCount) ReturnFalse(L"Meshlet " << m << L" has an invalid local index");
+		}
+		for (UINT i = 0; i < meshlet.VertexCount; ++i) {
+			if (localVertices[i] >= vertexCount) ReturnFalse(L"Meshlet " << m << L" has an invalid vertex index");
+		}
+
+		for (UINT t = 0; t < meshlet.TriangleCount; ++t) {
+			actual.push_back(Canonical(
+				localVertices[localTriangles[t * 3 + 0]],
+				localVertices[localTriangles[t * 3 + 1]],
+				localVertices[localTriangles[t * 3 + 2]]));
+		}
+
+		const XMVECTOR center = XMLoadFloat3(&meshlet.Center);
+		const FLOAT slack = meshlet.Radius * ValidationEpsilon + ValidationEpsilon;
+		for (UINT i = 0; i < meshlet.VertexCount; ++i) {
+			const FLOAT dist = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&vertices[localVertices[i]].Position), center)));
+			if (dist > meshlet.Radius + slack) ReturnFalse(L"Meshlet " << m << L" bounding sphere misses a vertex by " << dist - meshlet.Radius);
+		}
+	}
+
+	std::sort(expected.begin(), expected.end());
+	std::sort(actual.begin(), actual.end());
+	if (expected != actual) ReturnFalse(L"Meshlets do not cover the index buffer exactly once");
+
+	if (meshlets.empty()) return TRUE;
+
+	// Cone culling from viewpoints on the 26 directions of a cube around the mesh, outside its bounds.
+	XMVECTOR vMin = XMVectorReplicate(+MathHelper::Infinity);
+	XMVECTOR vMax = XMVectorReplicate(-MathHelper::Infinity);
+	for (const auto& vertex : vertices) {
+		const XMVECTOR P = XMLoadFloat3(&vertex.Position);
+
+		vMin = XMVectorMin(vMin, P);
+		vMax = XMVectorMax(vMax, P);
+	}
+
+	const XMVECTOR meshCenter = XMVectorScale(XMVectorAdd(vMin, vMax), 0.5f);
+	const FLOAT meshRadius = std::max(XMVectorGetX(XMVector3Length(XMVectorSubtract(vMax, vMin))), 1.f);
+
+	UINT64 tested = 0;
+	UINT64 culled = 0;
+
+	for (INT x = -1; x <= 1; ++x) {
+		for (INT y = -1; y <= 1; ++y) {
+			for (INT z = -1; z <= 1; ++z) {
+				if (x == 0 && y == 0 && z == 0) continue;
+
+				const XMVECTOR dir = XMVector3Normalize(XMVectorSet(static_cast<FLOAT>(x), static_cast<FLOAT>(y), static_cast<FLOAT>(z), 0.f));
+				const XMVECTOR viewPos = XMVectorAdd(meshCenter, XMVectorScale(dir, 2.f * meshRadius));
+
+				for (UINT m = 0, end = static_cast<UINT>(meshlets.size()); m < end; ++m) {
+					const auto& meshlet = meshlets[m];
+
+					++tested;
+					if (!IsBackfacing(meshlet, viewPos)) continue;
+					++culled;
+
+					const UINT* const localVertices = meshletVertices.data() + meshlet.VertexOffset;
+					const BYTE* const localTriangles = meshletTriangles.data() + meshlet.TriangleOffset * 3;
+
+					for (UINT t = 0; t < meshlet.TriangleCount; ++t) {
+						const XMVECTOR p0 = XMLoadFloat3(&vertices[localVertices[localTriangles[t * 3 + 0]]].Position);
+						const XMVECTOR p1 = XMLoadFloat3(&vertices[localVertices[localTriangles[t * 3 + 1]]].Position);
+						const XMVECTOR p2 = XMLoadFloat3(&vertices[localVertices[localTriangles[t * 3 + 2]]].Position);
+
+						const XMVECTOR n = TriangleNormal(p0, p1, p2);
+						const XMVECTOR toView = XMVectorSubtract(viewPos, p0);
+
+						const FLOAT facing = XMVectorGetX(XMVector3Dot(n, toView));
+						const FLOAT scale = XMVectorGetX(XMVector3Length(n)) * XMVectorGetX(XMVector3Length(toView));
+						if (facing > ValidationEpsilon * scale)
+							ReturnFalse(L"Meshlet " << m << L" is rejected by its normal cone but has a triangle facing the viewer");
+					}
+				}
+			}
+		}
+	}
+
+	WLogln(L"Meshlets: ", std::to_wstring(meshlets.size()), L" (",
+		std::to_wstring(static_cast<FLOAT>(meshletVertices.size()) / meshlets.size()), L" vertices, ",
+		std::to_wstring(static_cast<FLOAT>(triangleListSize) / meshlets.size()), L" triangles on average), ",
+		std::to_wstring(100.f * culled / tested), L"% rejected by the cone test from outside views");
+
+	return TRUE;
+}
\ No newline at end of file
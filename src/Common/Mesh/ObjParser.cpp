@@ -0,0 +1,548 @@
+#include "Common/Mesh/ObjParser.h"
+#include "Common/Mesh/MeshOptimizer.h"
+#include "Common/Mesh/VertexWelder.h"
+#include "Common/Debug/Logger.h"
+#include "Common/Util/MappedFile.h"
+#include "Common/Util/TaskQueue.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+#undef max
+#undef min
+
+using namespace DirectX;
+
+namespace {
+	const INT MissingIndex = INT_MIN;
+
+	// Flags of Corner::Relative marking indices that were negative in the file. Those are stored
+	// relative to the start of the chunk and resolved once the chunk offsets are known.
+	const UINT RelativePosition = 1 << 0;
+	const UINT RelativeTexCoord = 1 << 1;
+	const UINT RelativeNormal	= 1 << 2;
+
+	const double Pow10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+	const INT MaxExactPow10 = 22;
+	const UINT MaxMantissaDigits = 19;
+
+	struct Corner {
+		INT Position;
+		INT TexCoord;
+		INT Normal;
+		UINT Relative;
+	};
+
+	// Material selected by a usemtl statement for the triangles from Corner on.
+	struct MaterialSwitch {
+		size_t Corner;
+		std::string Name;
+	};
+
+	struct Chunk {
+		const char* Begin;
+		const char* End;
+
+		std::vector<XMFLOAT3> Positions;
+		std::vector<XMFLOAT3> Normals;
+		std::vector<XMFLOAT2> TexCoords;
+
+		// Three corners per triangle.
+		std::vector<Corner> Corners;
+
+		std::vector<std::string> MaterialLibs;
+		std::vector<MaterialSwitch> MaterialSwitches;
+	};
+
+	__forceinline BOOL IsSpace(char c) {
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	__forceinline BOOL IsDigit(char c) {
+		return c >= '0' && c <= '9';
+	}
+
+	__forceinline BOOL IsEndOfToken(const char* p, const char* end) {
+		return p >= end || IsSpace(*p) || *p == '\n';
+	}
+
+	__forceinline const char* SkipSpaces(const char* p, const char* end) {
+		while (p < end && IsSpace(*p)) ++p;
+		return p;
+	}
+
+	__forceinline const char* SkipLine(const char* p, const char* end) {
+		while (p < end && *p != '\n') ++p;
+		return p < end ? p + 1 : end;
+	}
+
+	__forceinline BOOL StartsWithToken(const char* p, const char* end, const char* token) {
+		const size_t length = std::strlen(token);
+		return static_cast<size_t>(end - p) > length && std::memcmp(p, token, length) == 0 && IsSpace(p[length]);
+	}
+
+	// Returns the rest of the line without surrounding whitespace.
+	std::string ReadRestOfLine(const char* p, const char* end) {
+		p = SkipSpaces(p, end);
+
+		const char* last = p;
+		while (last < end && *last != '\n') ++last;
+		while (last > p && IsSpace(last[-1])) --last;
+
+		return std::string(p, last);
+	}
+
+	// Parses a decimal floating-point number in the manner of std::from_chars: no locale, no
+	// allocation. Up to 19 significant digits are accumulated in an integer and scaled once by a
+	// power of ten. Returns nullptr if there are no digits.
+	const char* ParseFloat(const char* p, const char* end, FLOAT& value) {
+		BOOL negative = FALSE;
+		if (p < end && (*p == '-' || *p == '+')) {
+			negative = *p == '-';
+			++p;
+		}
+
+		UINT64 mantissa = 0;
+		INT exponent = 0;
+		UINT digits = 0;
+		BOOL any = FALSE;
+
+		for (; p < end && IsDigit(*p); ++p) {
+			any = TRUE;
+			if (digits < MaxMantissaDigits) {
+				mantissa = mantissa * 10 + static_cast<UINT64>(*p - '0');
+				if (mantissa != 0) ++digits;
+			}
+			else {
+				++exponent;
+			}
+		}
+
+		if (p < end && *p == '.') {
+			for (++p; p < end && IsDigit(*p); ++p) {
+				any = TRUE;
+				if (digits < MaxMantissaDigits) {
+					mantissa = mantissa * 10 + static_cast<UINT64>(*p - '0');
+					if (mantissa != 0) ++digits;
+					--exponent;
+				}
+			}
+		}
+
+		if (!any) return nullptr;
+
+		if (p < end && (*p == 'e' || *p == 'E')) {
+			const char* q = p + 1;
+
+			BOOL negativeExponent = FALSE;
+			if (q < end && (*q == '-' || *q == '+')) {
+				negativeExponent = *q == '-';
+				++q;
+			}
+
+			if (q < end && IsDigit(*q)) {
+				INT e = 0;
+				for (; q < end && IsDigit(*q); ++q) {
+					if (e < 10000) e = e * 10 + (*q - '0');
+				}
+
+				exponent += negativeExponent ? -e : e;
+				p = q;
+			}
+		}
+
+		double result = static_cast<double>(mantissa);
+		if (exponent < 0) {
+			if (-exponent <= MaxExactPow10) result /= Pow10[-exponent];
+			else result *= std::pow(10.0, exponent);
+		}
+		else if (exponent > 0) {
+			if (exponent <= MaxExactPow10) result *= Pow10[exponent];
+			else result *= std::pow(10.0, exponent);
+		}
+
+		value = static_cast<FLOAT>(negative ? -result : result);
+
+		return p;
+	}
+
+	const char* ParseInt(const char* p, const char* end, INT& value) {
+		BOOL negative = FALSE;
+		if (p < end && (*p == '-' || *p == '+')) {
+			negative = *p == '-';
+			++p;
+		}
+
+		if (p >= end || !IsDigit(*p)) return nullptr;
+
+		INT result = 0;
+		for (; p < end && IsDigit(*p); ++p) result = result * 10 + (*p - '0');
+
+		value = negative ? -result : result;
+
+		return p;
+	}
+
+	// Reads up to count floats from the line; the missing ones are set to zero.
+	const char* ParseFloats(const char* p, const char* end, FLOAT* const values, UINT count) {
+		for (UINT i = 0; i < count; ++i) {
+			p = SkipSpaces(p, end);
+
+			const char* const next = ParseFloat(p, end, values[i]);
+			if (next == nullptr) {
+				for (; i < count; ++i) values[i] = 0.f;
+				break;
+			}
+
+			p = next;
+		}
+
+		return p;
+	}
+
+	// Converts a one-based (or negative, relative) OBJ index into a zero-based index within the chunk.
+	__forceinline BOOL ResolveIndex(INT raw, size_t localCount, UINT relativeFlag, INT& index, UINT& relative) {
+		if (raw > 0) {
+			index = raw - 1;
+		}
+		else if (raw < 0) {
+			index = static_cast<INT>(localCount) + raw;
+			relative |= relativeFlag;
+		}
+		else {
+			return FALSE;
+		}
+
+		return TRUE;
+	}
+
+	// Parses the corners of a face line and appends its fan triangulation.
+	BOOL ParseFace(const char* p, const char* end, Chunk& chunk) {
+		Corner first = {};
+		Corner prev = {};
+		UINT count = 0;
+
+		while (TRUE) {
+			p = SkipSpaces(p, end);
+			if (p >= end || *p == '\n' || *p == '#') break;
+
+			Corner corner;
+			corner.TexCoord = MissingIndex;
+			corner.Normal = MissingIndex;
+			corner.Relative = 0;
+
+			INT raw = 0;
+			p = ParseInt(p, end, raw);
+			if (p == nullptr) ReturnFalse(L"Invalid face definition");
+			if (!ResolveIndex(raw, chunk.Positions.size(), RelativePosition, corner.Position, corner.Relative)) ReturnFalse(L"Invalid vertex index");
+
+			if (p < end && *p == '/') {
+				++p;
+				if (!IsEndOfToken(p, end) && *p != '/') {
+					p = ParseInt(p, end, raw);
+					if (p == nullptr) ReturnFalse(L"Invalid face definition");
+					if (!ResolveIndex(raw, chunk.TexCoords.size(), RelativeTexCoord, corner.TexCoord, corner.Relative)) ReturnFalse(L"Invalid texcoord index");
+				}
+				if (p < end && *p == '/') {
+					++p;
+					p = ParseInt(p, end, raw);
+					if (p == nullptr) ReturnFalse(L"Invalid face definition");
+					if (!ResolveIndex(raw, chunk.Normals.size(), RelativeNormal, corner.Normal, corner.Relative)) ReturnFalse(L"Invalid normal index");
+				}
+			}
+
+			if (!IsEndOfToken(p, end)) ReturnFalse(L"Invalid face definition");
+
+			if (count == 0) {
+				first = corner;
+			}
+			else if (count >= 2) {
+				chunk.Corners.push_back(first);
+				chunk.Corners.push_back(prev);
+				chunk.Corners.push_back(corner);
+			}
+
+			prev = corner;
+			++count;
+		}
+
+		return TRUE;
+	}
+
+	BOOL ParseChunk(Chunk& chunk) {
+		const char* p = chunk.Begin;
+		const char* const end = chunk.End;
+
+		while (p < end) {
+			p = SkipSpaces(p, end);
+			if (p >= end) break;
+
+			if (p[0] == 'v' && p + 1 < end) {
+				if (IsSpace(p[1])) {
+					XMFLOAT3 position;
+					ParseFloats(p + 2, end, &position.x, 3);
+					chunk.Positions.push_back(position);
+				}
+				else if (p[1] == 'n' && p + 2 < end && IsSpace(p[2])) {
+					XMFLOAT3 normal;
+					ParseFloats(p + 3, end, &normal.x, 3);
+					chunk.Normals.push_back(normal);
+				}
+				else if (p[1] == 't' && p + 2 < end && IsSpace(p[2])) {
+					XMFLOAT2 texc;
+					ParseFloats(p + 3, end, &texc.x, 2);
+					chunk.TexCoords.push_back(texc);
+				}
+			}
+			else if (p[0] == 'f' && p + 1 < end && IsSpace(p[1])) {
+				CheckReturn(ParseFace(p + 2, end, chunk));
+			}
+			else if (StartsWithToken(p, end, "mtllib")) {
+				// Several libraries may be listed on one line.
+				for (p = SkipSpaces(p + 6, end); !IsEndOfToken(p, end); p = SkipSpaces(p, end)) {
+					const char* const begin = p;
+					while (!IsEndOfToken(p, end)) ++p;
+
+					chunk.MaterialLibs.emplace_back(begin, p);
+				}
+			}
+			else if (StartsWithToken(p, end, "usemtl")) {
+				chunk.MaterialSwitches.push_back({ chunk.Corners.size(), ReadRestOfLine(p + 6, end) });
+			}
+
+			p = SkipLine(p, end);
+		}
+
+		return TRUE;
+	}
+
+	// Appends the materials of the library with the defaults tinyobjloader assigns to a new material.
+	BOOL LoadMaterialLib(const std::string& path, std::vector<Material>& materials) {
+		MappedFile file;
+		if (!file.Open(path)) {
+			WLogln(L"Material library not found: ", std::wstring(path.begin(), path.end()));
+			return TRUE;
+		}
+
+		const char* p = reinterpret_cast<const char*>(file.Data());
+		const char* const end = p + file.Size();
+
+		Material ignored;
+
+		while (p < end) {
+			p = SkipSpaces(p, end);
+			if (p >= end) break;
+
+			// Statements before the first newmtl have no material to apply to.
+			Material& mat = materials.empty() ? ignored : materials.back();
+
+			if (StartsWithToken(p, end, "newmtl")) {
+				Material newMat;
+				newMat.Name = ReadRestOfLine(p + 6, end);
+				newMat.Albedo = XMFLOAT4(0.f, 0.f, 0.f, 1.f);
+				newMat.Roughness = 0.f;
+				newMat.Specular = 0.f;
+
+				materials.push_back(std::move(newMat));
+			}
+			else if (StartsWithToken(p, end, "Kd")) {
+				ParseFloats(p + 2, end, &mat.Albedo.x, 3);
+			}
+			else if (StartsWithToken(p, end, "Ks")) {
+				FLOAT specular[3];
+				ParseFloats(p + 2, end, specular, 3);
+				mat.Specular = specular[0];
+			}
+			else if (StartsWithToken(p, end, "Pr")) {
+				ParseFloats(p + 2, end, &mat.Roughness, 1);
+			}
+			else if (StartsWithToken(p, end, "map_Kd")) {
+				// Texture options may precede the file name, which is the last token.
+				const std::string rest = ReadRestOfLine(p + 6, end);
+				const size_t pos = rest.find_last_of(" \t");
+				mat.DiffuseMapFileName = pos == std::string::npos ? rest : rest.substr(pos + 1);
+			}
+			else if (StartsWithToken(p, end, "map_d")) {
+				const std::string rest = ReadRestOfLine(p + 5, end);
+				const size_t pos = rest.find_last_of(" \t");
+				mat.AlphaMapFileName = pos == std::string::npos ? rest : rest.substr(pos + 1);
+				mat.AlphaTested = TRUE;
+			}
+
+			p = SkipLine(p, end);
+		}
+
+		return TRUE;
+	}
+
+	__forceinline BOOL ResolveCorner(
+			INT index,
+			UINT relative,
+			UINT relativeFlag,
+			size_t offset,
+			size_t count,
+			size_t& resolved) {
+		const INT64 absolute = (relative & relativeFlag) ? static_cast<INT64>(offset) + index : index;
+		if (absolute < 0 || absolute >= static_cast<INT64>(count)) return FALSE;
+
+		resolved = static_cast<size_t>(absolute);
+
+		return TRUE;
+	}
+}
+
+BOOL ObjParser::Load(const std::string& file, const std::string& baseDir, Mesh& mesh, std::vector<Material>& materials, UINT64 numThreads, FLOAT weldEpsilon, std::vector<std::string>* materialLibs) {
+	const std::string path = baseDir + file;
+
+	MappedFile mapped;
+	CheckReturn(mapped.Open(path));
+
+	const char* const data = reinterpret_cast<const char*>(mapped.Data());
+	const UINT64 size = mapped.Size();
+
+	// Split the file at line boundaries.
+	const UINT64 numChunks = std::max<UINT64>(1, std::min<UINT64>(std::max<UINT64>(numThreads, 1) * ChunksPerThread, size / MinChunkSize));
+
+	std::vector<Chunk> chunks(numChunks);
+	{
+		const char* begin = data;
+		for (UINT64 i = 0; i < numChunks; ++i) {
+			const char* end = i + 1 == numChunks ? data + size : data + size * (i + 1) / numChunks;
+			if (end < begin) end = begin;
+			end = SkipLine(end, data + size);
+
+			chunks[i].Begin = begin;
+			chunks[i].End = end;
+			begin = end;
+		}
+	}
+
+	if (numChunks > 1 && numThreads > 1) {
+		TaskQueue taskQueue;
+		for (auto& chunk : chunks) {
+			taskQueue.AddTask([&chunk] {
+				return ParseChunk(chunk);
+			});
+		}
+
+		CheckReturn(taskQueue.Run(std::min<UINT64>(numThreads, numChunks)));
+	}
+	else {
+		for (auto& chunk : chunks) CheckReturn(ParseChunk(chunk));
+	}
+
+	// Merge the attribute streams; each chunk keeps its offsets to resolve relative indices.
+	std::vector<XMFLOAT3> positions;
+	std::vector<XMFLOAT3> normals;
+	std::vector<XMFLOAT2> texCoords;
+	std::vector<size_t> positionOffsets(numChunks);
+	std::vector<size_t> normalOffsets(numChunks);
+	std::vector<size_t> texCoordOffsets(numChunks);
+
+	size_t numPositions = 0;
+	size_t numNormals = 0;
+	size_t numTexCoords = 0;
+	size_t numCorners = 0;
+	for (UINT64 i = 0; i < numChunks; ++i) {
+		positionOffsets[i] = numPositions;
+		normalOffsets[i] = numNormals;
+		texCoordOffsets[i] = numTexCoords;
+
+		numPositions += chunks[i].Positions.size();
+		numNormals += chunks[i].Normals.size();
+		numTexCoords += chunks[i].TexCoords.size();
+		numCorners += chunks[i].Corners.size();
+	}
+
+	positions.reserve(numPositions);
+	normals.reserve(numNormals);
+	texCoords.reserve(numTexCoords);
+	for (auto& chunk : chunks) {
+		positions.insert(positions.end(), chunk.Positions.begin(), chunk.Positions.end());
+		normals.insert(normals.end(), chunk.Normals.begin(), chunk.Normals.end());
+		texCoords.insert(texCoords.end(), chunk.TexCoords.begin(), chunk.TexCoords.end());
+
+		std::vector<XMFLOAT3>().swap(chunk.Positions);
+		std::vector<XMFLOAT3>().swap(chunk.Normals);
+		std::vector<XMFLOAT2>().swap(chunk.TexCoords);
+	}
+
+	for (const auto& chunk : chunks) {
+		for (const auto& lib : chunk.MaterialLibs) {
+			CheckReturn(LoadMaterialLib(baseDir + lib, materials));
+			if (materialLibs != nullptr) materialLibs->push_back(lib);
+		}
+	}
+
+	// The first definition of a name wins, as in tinyobjloader.
+	std::unordered_map<std::string, UINT> materialIndices;
+	for (UINT i = 0, end = static_cast<UINT>(materials.size()); i < end; ++i)
+		materialIndices.emplace(materials[i].Name, i);
+
+	// Triangles before the first usemtl, or naming an unknown material, get the default material.
+	const UINT defaultMaterial = static_cast<UINT>(materials.size());
+	UINT currMaterial = defaultMaterial;
+
+	std::vector<UINT> triangleMaterials;
+	triangleMaterials.reserve(numCorners / 3);
+
+	mesh.Indices.reserve(mesh.Indices.size() + numCorners);
+
+	VertexWelder welder(weldEpsilon);
+	welder.Reserve(numCorners);
+
+	for (UINT64 i = 0; i < numChunks; ++i) {
+		const auto& corners = chunks[i].Corners;
+		const auto& switches = chunks[i].MaterialSwitches;
+		size_t nextSwitch = 0;
+
+		for (size_t c = 0, end = corners.size(); c < end; ++c) {
+			const auto& corner = corners[c];
+
+			if (c % 3 == 0) {
+				for (; nextSwitch < switches.size() && switches[nextSwitch].Corner <= c; ++nextSwitch) {
+					const auto iter = materialIndices.find(switches[nextSwitch].Name);
+					currMaterial = iter == materialIndices.end() ? defaultMaterial : iter->second;
+				}
+
+				triangleMaterials.push_back(currMaterial);
+			}
+			Vertex vertex = {};
+
+			size_t index = 0;
+			if (!ResolveCorner(corner.Position, corner.Relative, RelativePosition, positionOffsets[i], numPositions, index))
+				ReturnFalse(L"Vertex index out of range: " << path.c_str());
+			vertex.Position = positions[index];
+
+			if (corner.Normal != MissingIndex) {
+				if (!ResolveCorner(corner.Normal, corner.Relative, RelativeNormal, normalOffsets[i], numNormals, index))
+					ReturnFalse(L"Normal index out of range: " << path.c_str());
+				vertex.Normal = normals[index];
+			}
+
+			if (corner.TexCoord != MissingIndex) {
+				if (!ResolveCorner(corner.TexCoord, corner.Relative, RelativeTexCoord, texCoordOffsets[i], numTexCoords, index))
+					ReturnFalse(L"Texcoord index out of range: " << path.c_str());
+				vertex.TexCoord = texCoords[index];
+			}
+
+			mesh.Indices.push_back(welder.Weld(vertex, mesh.Vertices));
+		}
+
+		// A usemtl after the last face still selects the material for the next chunk.
+		for (; nextSwitch < switches.size(); ++nextSwitch) {
+			const auto iter = materialIndices.find(switches[nextSwitch].Name);
+			currMaterial = iter == materialIndices.end() ? defaultMaterial : iter->second;
+		}
+	}
+
+	MeshOptimizer::SortByMaterial(mesh, materials, triangleMaterials);
+
+	return TRUE;
+}
\ No newline at end of file
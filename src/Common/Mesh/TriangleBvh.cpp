@@ -0,0 +1,513 @@
+#include "Common/Mesh/TriangleBvh.h"
+#include "Common/Debug/Logger.h"
+
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <numeric>
+#include <ostream>
+
+#undef max
+#undef min
+
+using namespace DirectX;
+
+namespace {
+	const UINT FileMagic = 0x48564254; // "TBVH"
+	const UINT FileVersion = 1;
+
+	const FLOAT DeterminantEpsilon = 1e-12f;
+
+	struct FileHeader {
+		UINT Magic;
+		UINT Version;
+		UINT NodeCount;
+		UINT TriangleCount;
+	};
+
+	struct Bin {
+		XMFLOAT3 Min = { +MathHelper::Infinity, +MathHelper::Infinity, +MathHelper::Infinity };
+		XMFLOAT3 Max = { -MathHelper::Infinity, -MathHelper::Infinity, -MathHelper::Infinity };
+		UINT Count = 0;
+	};
+
+	__forceinline FLOAT Component(const XMFLOAT3& v, UINT axis) {
+		return (&v.x)[axis];
+	}
+
+	__forceinline void Grow(XMFLOAT3& min, XMFLOAT3& max, const XMFLOAT3& pMin, const XMFLOAT3& pMax) {
+		min = XMFLOAT3(std::min(min.x, pMin.x), std::min(min.y, pMin.y), std::min(min.z, pMin.z));
+		max = XMFLOAT3(std::max(max.x, pMax.x), std::max(max.y, pMax.y), std::max(max.z, pMax.z));
+	}
+
+	// Half of the surface area; the factor of two cancels out in the SAH comparison.
+	__forceinline FLOAT HalfArea(const XMFLOAT3& min, const XMFLOAT3& max) {
+		const FLOAT dx = max.x - min.x;
+		const FLOAT dy = max.y - min.y;
+		const FLOAT dz = max.z - min.z;
+		return dx * dy + dy * dz + dz * dx;
+	}
+}
+
+BoundingBox TriangleBvh::Bounds() const {
+	BoundingBox aabb;
+	if (mNodes.empty()) return aabb;
+
+	BoundingBox::CreateFromPoints(aabb, XMLoadFloat3(&mNodes[0].Min), XMLoadFloat3(&mNodes[0].Max));
+
+	return aabb;
+}
+
+BOOL TriangleBvh::Build(const std::vector<Vertex>& vertices, const std::vector<UINT>& indices) {
+	Clear();
+
+	if (indices.size() % 3 != 0) ReturnFalse(L"Index count must be a multiple of three");
+
+	const UINT triCount = static_cast<UINT>(indices.size() / 3);
+	if (triCount == 0) return TRUE;
+
+	std::vector<XMFLOAT3> triMins(triCount);
+	std::vector<XMFLOAT3> triMaxs(triCount);
+	std::vector<XMFLOAT3> centroids(triCount);
+
+	for (UINT i = 0; i < triCount; ++i) {
+		const UINT i0 = indices[i * 3 + 0];
+		const UINT i1 = indices[i * 3 + 1];
+		const UINT i2 = indices[i * 3 + 2];
+		if (i0 >= vertices.size() || i1 >= vertices.size() || i2 >= vertices.size()) ReturnFalse(L"Index out of range");
+
+		const XMVECTOR p0 = XMLoadFloat3(&vertices[i0].Position);
+		const XMVECTOR p1 = XMLoadFloat3(&vertices[i1].Position);
+		const XMVECTOR p2 = XMLoadFloat3(&vertices[i2].Position);
+
+		XMStoreFloat3(&triMins[i], XMVectorMin(p0, XMVectorMin(p1, p2)));
+		XMStoreFloat3(&triMaxs[i], XMVectorMax(p0, XMVectorMax(p1, p2)));
+		XMStoreFloat3(&centroids[i], (p0 + p1 + p2) / 3.f);
+	}
+
+	mTriangleIndices.resize(triCount);
+	std::iota(mTriangleIndices.begin(), mTriangleIndices.end(), 0);
+
+	// A binary tree with N leaves at most has 2N - 1 nodes, so the storage never reallocates.
+	mNodes.reserve(static_cast<size_t>(triCount) * 2 - 1);
+
+	Node root;
+	root.LeftFirst = 0;
+	root.TriangleCount = triCount;
+	UpdateBounds(root, triMins, triMaxs);
+	mNodes.push_back(root);
+
+	std::vector<UINT> stack;
+	stack.push_back(0);
+
+	while (!stack.empty()) {
+		const UINT nodeIndex = stack.back();
+		stack.pop_back();
+
+		const UINT first = mNodes[nodeIndex].LeftFirst;
+		const UINT count = mNodes[nodeIndex].TriangleCount;
+
+		// Leaves are kept at the SIMD width; splitting further would not reduce the number of triangle tests.
+		if (count <= MaxLeafTriangles) continue;
+
+		UINT axis = 0;
+		FLOAT position = 0.f;
+		const FLOAT cost = FindBestSplit(mNodes[nodeIndex], triMins, triMaxs, centroids, axis, position);
+
+		UINT mid = first;
+		if (cost < MathHelper::Infinity) {
+			const auto begin = mTriangleIndices.begin() + first;
+			const auto iter = std::partition(begin, begin + count, [&](UINT tri) {
+				return Component(centroids[tri], axis) < position;
+			});
+			mid = first + static_cast<UINT>(iter - begin);
+		}
+
+		// Coincident centroids cannot be separated by a plane; halve the range instead.
+		if (mid == first || mid == first + count) mid = first + count / 2;
+
+		const UINT leftIndex = static_cast<UINT>(mNodes.size());
+
+		Node left;
+		left.LeftFirst = first;
+		left.TriangleCount = mid - first;
+		UpdateBounds(left, triMins, triMaxs);
+
+		Node right;
+		right.LeftFirst = mid;
+		right.TriangleCount = first + count - mid;
+		UpdateBounds(right, triMins, triMaxs);
+
+		mNodes.push_back(left);
+		mNodes.push_back(right);
+
+		mNodes[nodeIndex].LeftFirst = leftIndex;
+		mNodes[nodeIndex].TriangleCount = 0;
+
+		stack.push_back(leftIndex);
+		stack.push_back(leftIndex + 1);
+	}
+
+	mTriangles.resize(triCount);
+	for (UINT i = 0; i < triCount; ++i) {
+		const UINT tri = mTriangleIndices[i];
+
+		const XMVECTOR p0 = XMLoadFloat3(&vertices[indices[tri * 3 + 0]].Position);
+		const XMVECTOR p1 = XMLoadFloat3(&vertices[indices[tri * 3 + 1]].Position);
+		const XMVECTOR p2 = XMLoadFloat3(&vertices[indices[tri * 3 + 2]].Position);
+
+		XMStoreFloat3(&mTriangles[i].V0, p0);
+		XMStoreFloat3(&mTriangles[i].Edge1, p1 - p0);
+		XMStoreFloat3(&mTriangles[i].Edge2, p2 - p0);
+	}
+
+	mNodes.shrink_to_fit();
+
+	return TRUE;
+}
+
+void TriangleBvh::Clear() {
+	mNodes.clear();
+	mTriangles.clear();
+	mTriangleIndices.clear();
+}
+
+BOOL TriangleBvh::RayCast(FXMVECTOR origin, FXMVECTOR dir, FLOAT maxT, Hit& hit) const {
+	if (mNodes.empty()) return FALSE;
+
+	BOOL found = FALSE;
+
+	const Node& root = mNodes[0];
+	if (root.IsLeaf()) {
+		IntersectLeaf(root, origin, dir, maxT, hit, found);
+		return found;
+	}
+
+	const XMVECTOR ox = XMVectorSplatX(origin);
+	const XMVECTOR oy = XMVectorSplatY(origin);
+	const XMVECTOR oz = XMVectorSplatZ(origin);
+
+	// Division by zero yields infinities, which the slab test below handles correctly.
+	const XMVECTOR invDir = XMVectorReciprocal(dir);
+	const XMVECTOR invDx = XMVectorSplatX(invDir);
+	const XMVECTOR invDy = XMVectorSplatY(invDir);
+	const XMVECTOR invDz = XMVectorSplatZ(invDir);
+
+	std::vector<UINT> stack;
+	stack.reserve(64);
+	stack.push_back(0);
+
+	while (!stack.empty()) {
+		const Node& node = mNodes[stack.back()];
+		stack.pop_back();
+
+		// Interior children are skipped in favour of their own children, so that up to four boxes
+		// are tested at once against the ray. Every popped node is an interior node.
+		UINT candidates[4];
+		UINT count = 0;
+		for (UINT c = node.LeftFirst; c <= node.LeftFirst + 1; ++c) {
+			const Node& child = mNodes[c];
+			if (child.IsLeaf()) {
+				candidates[count++] = c;
+			}
+			else {
+				candidates[count++] = child.LeftFirst;
+				candidates[count++] = child.LeftFirst + 1;
+			}
+		}
+
+		// Unused lanes repeat the first box and are ignored below.
+		const Node& n0 = mNodes[candidates[0]];
+		const Node& n1 = mNodes[candidates[1]];
+		const Node& n2 = mNodes[candidates[count > 2 ? 2 : 0]];
+		const Node& n3 = mNodes[candidates[count > 3 ? 3 : 0]];
+
+		const XMVECTOR tx0 = (XMVectorSet(n0.Min.x, n1.Min.x, n2.Min.x, n3.Min.x) - ox) * invDx;
+		const XMVECTOR tx1 = (XMVectorSet(n0.Max.x, n1.Max.x, n2.Max.x, n3.Max.x) - ox) * invDx;
+		const XMVECTOR ty0 = (XMVectorSet(n0.Min.y, n1.Min.y, n2.Min.y, n3.Min.y) - oy) * invDy;
+		const XMVECTOR ty1 = (XMVectorSet(n0.Max.y, n1.Max.y, n2.Max.y, n3.Max.y) - oy) * invDy;
+		const XMVECTOR tz0 = (XMVectorSet(n0.Min.z, n1.Min.z, n2.Min.z, n3.Min.z) - oz) * invDz;
+		const XMVECTOR tz1 = (XMVectorSet(n0.Max.z, n1.Max.z, n2.Max.z, n3.Max.z) - oz) * invDz;
+
+		const XMVECTOR tNear = XMVectorMax(
+			XMVectorMax(XMVectorMin(tx0, tx1), XMVectorMin(ty0, ty1)),
+			XMVectorMax(XMVectorMin(tz0, tz1), XMVectorZero()));
+		const XMVECTOR tFar = XMVectorMin(
+			XMVectorMin(XMVectorMax(tx0, tx1), XMVectorMax(ty0, ty1)),
+			XMVectorMin(XMVectorMax(tz0, tz1), XMVectorReplicate(maxT)));
+
+		XMFLOAT4 nearT;
+		XMStoreFloat4(&nearT, tNear);
+
+		XMUINT4 mask;
+		XMStoreUInt4(&mask, XMVectorLessOrEqual(tNear, tFar));
+
+		const FLOAT nears[4] = { nearT.x, nearT.y, nearT.z, nearT.w };
+		const UINT masks[4] = { mask.x, mask.y, mask.z, mask.w };
+
+		// Sort the hit boxes front to back.
+		UINT hits[4];
+		UINT hitCount = 0;
+		for (UINT i = 0; i < count; ++i) {
+			if (masks[i] == 0) continue;
+
+			UINT j = hitCount++;
+			for (; j > 0 && nears[hits[j - 1]] > nears[i]; --j) hits[j] = hits[j - 1];
+			hits[j] = i;
+		}
+
+		for (UINT i = 0; i < hitCount; ++i) {
+			const Node& candidate = mNodes[candidates[hits[i]]];
+			if (candidate.IsLeaf() && nears[hits[i]] < maxT) IntersectLeaf(candidate, origin, dir, maxT, hit, found);
+		}
+
+		// Push interior nodes far to near so the nearest one is visited next.
+		for (UINT i = hitCount; i > 0; --i) {
+			const UINT lane = hits[i - 1];
+			if (!mNodes[candidates[lane]].IsLeaf() && nears[lane] < maxT) stack.push_back(candidates[lane]);
+		}
+	}
+
+	return found;
+}
+
+BOOL TriangleBvh::Save(std::ostream& stream) const {
+	FileHeader header;
+	header.Magic = FileMagic;
+	header.Version = FileVersion;
+	header.NodeCount = static_cast<UINT>(mNodes.size());
+	header.TriangleCount = static_cast<UINT>(mTriangles.size());
+
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+	stream.write(reinterpret_cast<const char*>(mNodes.data()), sizeof(Node) * mNodes.size());
+	stream.write(reinterpret_cast<const char*>(mTriangles.data()), sizeof(Triangle) * mTriangles.size());
+	stream.write(reinterpret_cast<const char*>(mTriangleIndices.data()), sizeof(UINT) * mTriangleIndices.size());
+
+	if (!stream.good()) ReturnFalse(L"Failed to write triangle BVH");
+
+	return TRUE;
+}
+
+BOOL TriangleBvh::Load(std::istream& stream) {
+	Clear();
+
+	FileHeader header;
+	stream.read(reinterpret_cast<char*>(&header), sizeof(FileHeader));
+	if (!stream.good()) ReturnFalse(L"Failed to read triangle BVH header");
+
+	if (header.Magic != FileMagic) ReturnFalse(L"Invalid triangle BVH magic");
+	if (header.Version != FileVersion) ReturnFalse(L"Unsupported triangle BVH version: " << header.Version);
+
+	mNodes.resize(header.NodeCount);
+	mTriangles.resize(header.TriangleCount);
+	mTriangleIndices.resize(header.TriangleCount);
+
+	stream.read(reinterpret_cast<char*>(mNodes.data()), sizeof(Node) * mNodes.size());
+	stream.read(reinterpret_cast<char*>(mTriangles.data()), sizeof(Triangle) * mTriangles.size());
+	stream.read(reinterpret_cast<char*>(mTriangleIndices.data()), sizeof(UINT) * mTriangleIndices.size());
+
+	if (!stream.good()) {
+		Clear();
+		ReturnFalse(L"Failed to read triangle BVH");
+	}
+
+	return TRUE;
+}
+
+BOOL TriangleBvh::Load(const BYTE* data, UINT64 size) {
+	Clear();
+
+	if (size < sizeof(FileHeader)) ReturnFalse(L"Failed to read triangle BVH header");
+
+	FileHeader header;
+	std::memcpy(&header, data, sizeof(FileHeader));
+
+	if (header.Magic != FileMagic) ReturnFalse(L"Invalid triangle BVH magic");
+	if (header.Version != FileVersion) ReturnFalse(L"Unsupported triangle BVH version: " << header.Version);
+
+	const UINT64 nodesSize = sizeof(Node) * static_cast<UINT64>(header.NodeCount);
+	const UINT64 trianglesSize = sizeof(Triangle) * static_cast<UINT64>(header.TriangleCount);
+	const UINT64 indicesSize = sizeof(UINT) * static_cast<UINT64>(header.TriangleCount);
+	if (size < sizeof(FileHeader) + nodesSize + trianglesSize + indicesSize) ReturnFalse(L"Failed to read triangle BVH");
+
+	const BYTE* p = data + sizeof(FileHeader);
+
+	mNodes.resize(header.NodeCount);
+	std::memcpy(mNodes.data(), p, nodesSize);
+	p += nodesSize;
+
+	mTriangles.resize(header.TriangleCount);
+	std::memcpy(mTriangles.data(), p, trianglesSize);
+	p += trianglesSize;
+
+	mTriangleIndices.resize(header.TriangleCount);
+	std::memcpy(mTriangleIndices.data(), p, indicesSize);
+
+	return TRUE;
+}
+
+void TriangleBvh::UpdateBounds(Node& node, const std::vector<XMFLOAT3>& triMins, const std::vector<XMFLOAT3>& triMaxs) const {
+	node.Min = XMFLOAT3(+MathHelper::Infinity, +MathHelper::Infinity, +MathHelper::Infinity);
+	node.Max = XMFLOAT3(-MathHelper::Infinity, -MathHelper::Infinity, -MathHelper::Infinity);
+
+	for (UINT i = 0; i < node.TriangleCount; ++i) {
+		const UINT tri = mTriangleIndices[node.LeftFirst + i];
+		Grow(node.Min, node.Max, triMins[tri], triMaxs[tri]);
+	}
+}
+
+// Returns the SAH cost of the best split plane, or infinity if the centroids cannot be separated.
+FLOAT TriangleBvh::FindBestSplit(
+		const Node& node,
+		const std::vector<XMFLOAT3>& triMins,
+		const std::vector<XMFLOAT3>& triMaxs,
+		const std::vector<XMFLOAT3>& centroids,
+		UINT& axis,
+		FLOAT& position) const {
+	XMFLOAT3 centroidMin(+MathHelper::Infinity, +MathHelper::Infinity, +MathHelper::Infinity);
+	XMFLOAT3 centroidMax(-MathHelper::Infinity, -MathHelper::Infinity, -MathHelper::Infinity);
+	for (UINT i = 0; i < node.TriangleCount; ++i) {
+		const UINT tri = mTriangleIndices[node.LeftFirst + i];
+		Grow(centroidMin, centroidMax, centroids[tri], centroids[tri]);
+	}
+
+	FLOAT bestCost = MathHelper::Infinity;
+
+	for (UINT a = 0; a < 3; ++a) {
+		const FLOAT boundsMin = Component(centroidMin, a);
+		const FLOAT boundsMax = Component(centroidMax, a);
+		if (boundsMin == boundsMax) continue;
+
+		Bin bins[BinCount];
+		const FLOAT scale = BinCount / (boundsMax - boundsMin);
+
+		for (UINT i = 0; i < node.TriangleCount; ++i) {
+			const UINT tri = mTriangleIndices[node.LeftFirst + i];
+			const UINT b = std::min(BinCount - 1, static_cast<UINT>((Component(centroids[tri], a) - boundsMin) * scale));
+
+			++bins[b].Count;
+			Grow(bins[b].Min, bins[b].Max, triMins[tri], triMaxs[tri]);
+		}
+
+		// Sweep from both sides to get the area and count on each side of every bin boundary.
+		FLOAT leftArea[BinCount - 1];
+		FLOAT rightArea[BinCount - 1];
+		UINT leftCount[BinCount - 1];
+		UINT rightCount[BinCount - 1];
+
+		Bin leftBox;
+		Bin rightBox;
+		UINT leftSum = 0;
+		UINT rightSum = 0;
+
+		for (UINT i = 0; i < BinCount - 1; ++i) {
+			leftSum += bins[i].Count;
+			leftCount[i] = leftSum;
+			Grow(leftBox.Min, leftBox.Max, bins[i].Min, bins[i].Max);
+			leftArea[i] = leftSum > 0 ? HalfArea(leftBox.Min, leftBox.Max) : 0.f;
+
+			rightSum += bins[BinCount - 1 - i].Count;
+			rightCount[BinCount - 2 - i] = rightSum;
+			Grow(rightBox.Min, rightBox.Max, bins[BinCount - 1 - i].Min, bins[BinCount - 1 - i].Max);
+			rightArea[BinCount - 2 - i] = rightSum > 0 ? HalfArea(rightBox.Min, rightBox.Max) : 0.f;
+		}
+
+		const FLOAT binWidth = (boundsMax - boundsMin) / BinCount;
+		for (UINT i = 0; i < BinCount - 1; ++i) {
+			if (leftCount[i] == 0 || rightCount[i] == 0) continue;
+
+			const FLOAT cost = leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i];
+			if (cost < bestCost) {
+				bestCost = cost;
+				axis = a;
+				position = boundsMin + binWidth * (i + 1);
+			}
+		}
+	}
+
+	return bestCost;
+}
+
+// Tests the ray against all triangles of the leaf at once with a 4-wide Moller-Trumbore.
+void TriangleBvh::IntersectLeaf(const Node& node, FXMVECTOR origin, FXMVECTOR dir, FLOAT& maxT, Hit& hit, BOOL& found) const {
+	const UINT count = node.TriangleCount;
+	const Triangle* const tris = &mTriangles[node.LeftFirst];
+
+	// Unused lanes repeat the last triangle and are ignored below.
+	const Triangle& t0 = tris[0];
+	const Triangle& t1 = tris[std::min(1u, count - 1)];
+	const Triangle& t2 = tris[std::min(2u, count - 1)];
+	const Triangle& t3 = tris[std::min(3u, count - 1)];
+
+	const XMVECTOR v0x = XMVectorSet(t0.V0.x, t1.V0.x, t2.V0.x, t3.V0.x);
+	const XMVECTOR v0y = XMVectorSet(t0.V0.y, t1.V0.y, t2.V0.y, t3.V0.y);
+	const XMVECTOR v0z = XMVectorSet(t0.V0.z, t1.V0.z, t2.V0.z, t3.V0.z);
+	const XMVECTOR e1x = XMVectorSet(t0.Edge1.x, t1.Edge1.x, t2.Edge1.x, t3.Edge1.x);
+	const XMVECTOR e1y = XMVectorSet(t0.Edge1.y, t1.Edge1.y, t2.Edge1.y, t3.Edge1.y);
+	const XMVECTOR e1z = XMVectorSet(t0.Edge1.z, t1.Edge1.z, t2.Edge1.z, t3.Edge1.z);
+	const XMVECTOR e2x = XMVectorSet(t0.Edge2.x, t1.Edge2.x, t2.Edge2.x, t3.Edge2.x);
+	const XMVECTOR e2y = XMVectorSet(t0.Edge2.y, t1.Edge2.y, t2.Edge2.y, t3.Edge2.y);
+	const XMVECTOR e2z = XMVectorSet(t0.Edge2.z, t1.Edge2.z, t2.Edge2.z, t3.Edge2.z);
+
+	const XMVECTOR dx = XMVectorSplatX(dir);
+	const XMVECTOR dy = XMVectorSplatY(dir);
+	const XMVECTOR dz = XMVectorSplatZ(dir);
+
+	// p = d x e2
+	const XMVECTOR px = dy * e2z - dz * e2y;
+	const XMVECTOR py = dz * e2x - dx * e2z;
+	const XMVECTOR pz = dx * e2y - dy * e2x;
+
+	const XMVECTOR det = e1x * px + e1y * py + e1z * pz;
+	const XMVECTOR invDet = XMVectorReciprocal(det);
+
+	const XMVECTOR sx = XMVectorSplatX(origin) - v0x;
+	const XMVECTOR sy = XMVectorSplatY(origin) - v0y;
+	const XMVECTOR sz = XMVectorSplatZ(origin) - v0z;
+
+	const XMVECTOR u = (sx * px + sy * py + sz * pz) * invDet;
+
+	// q = s x e1
+	const XMVECTOR qx = sy * e1z - sz * e1y;
+	const XMVECTOR qy = sz * e1x - sx * e1z;
+	const XMVECTOR qz = sx * e1y - sy * e1x;
+
+	const XMVECTOR v = (dx * qx + dy * qy + dz * qz) * invDet;
+	const XMVECTOR t = (e2x * qx + e2y * qy + e2z * qz) * invDet;
+
+	const XMVECTOR zero = XMVectorZero();
+
+	XMVECTOR valid = XMVectorGreater(XMVectorAbs(det), XMVectorReplicate(DeterminantEpsilon));
+	valid = XMVectorAndInt(valid, XMVectorGreaterOrEqual(u, zero));
+	valid = XMVectorAndInt(valid, XMVectorGreaterOrEqual(v, zero));
+	valid = XMVectorAndInt(valid, XMVectorLessOrEqual(u + v, XMVectorSplatOne()));
+	valid = XMVectorAndInt(valid, XMVectorGreater(t, zero));
+	valid = XMVectorAndInt(valid, XMVectorLess(t, XMVectorReplicate(maxT)));
+
+	XMUINT4 mask;
+	XMStoreUInt4(&mask, valid);
+	if ((mask.x | mask.y | mask.z | mask.w) == 0) return;
+
+	XMFLOAT4 ts, us, vs;
+	XMStoreFloat4(&ts, t);
+	XMStoreFloat4(&us, u);
+	XMStoreFloat4(&vs, v);
+
+	const UINT masks[4] = { mask.x, mask.y, mask.z, mask.w };
+	const FLOAT tArray[4] = { ts.x, ts.y, ts.z, ts.w };
+	const FLOAT uArray[4] = { us.x, us.y, us.z, us.w };
+	const FLOAT vArray[4] = { vs.x, vs.y, vs.z, vs.w };
+
+	for (UINT i = 0; i < count; ++i) {
+		if (masks[i] == 0 || tArray[i] >= maxT) continue;
+
+		maxT = tArray[i];
+
+		hit.T = tArray[i];
+		hit.U = uArray[i];
+		hit.V = vArray[i];
+		hit.Triangle = mTriangleIndices[node.LeftFirst + i];
+
+		found = TRUE;
+	}
+}
\ No newline at end of file
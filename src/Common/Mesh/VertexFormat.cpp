@@ -0,0 +1,296 @@
+#include "Common/Mesh/VertexFormat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <DirectXPackedVector.h>
+
+#undef max
+#undef min
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace {
+	const FLOAT Unorm16Max = 65535.f;
+	const FLOAT Snorm16Max = 32767.f;
+
+	__forceinline USHORT EncodeUnorm16(FLOAT value) {
+		return static_cast<USHORT>(std::floor(std::min(std::max(value, 0.f), 1.f) * Unorm16Max + 0.5f));
+	}
+
+	__forceinline SHORT EncodeSnorm16(FLOAT value) {
+		return static_cast<SHORT>(std::floor(std::min(std::max(value, -1.f), 1.f) * Snorm16Max + 0.5f));
+	}
+
+	__forceinline FLOAT DecodeSnorm16(SHORT value) {
+		return std::max(value / Snorm16Max, -1.f);
+	}
+
+	__forceinline FLOAT SignNotZero(FLOAT value) {
+		return value >= 0.f ? 1.f : -1.f;
+	}
+
+	XMFLOAT3 DecodeOctahedron(FLOAT x, FLOAT y) {
+		XMFLOAT3 n(x, y, 1.f - std::abs(x) - std::abs(y));
+
+		const FLOAT t = std::max(-n.z, 0.f);
+		n.x += n.x >= 0.f ? -t : t;
+		n.y += n.y >= 0.f ? -t : t;
+
+		XMStoreFloat3(&n, XMVector3Normalize(XMLoadFloat3(&n)));
+		return n;
+	}
+
+	// Maps the normal onto the octahedron, then picks the rounding of the two components
+	// that decodes closest to the source instead of rounding each one independently.
+	void EncodeOctahedron(const XMFLOAT3& normal, SHORT& outX, SHORT& outY) {
+		const FLOAT l1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+		if (l1 <= 0.f) {
+			outX = outY = 0;
+			return;
+		}
+
+		FLOAT x = normal.x / l1;
+		FLOAT y = normal.y / l1;
+		if (normal.z < 0.f) {
+			const FLOAT wrappedX = (1.f - std::abs(y)) * SignNotZero(x);
+			const FLOAT wrappedY = (1.f - std::abs(x)) * SignNotZero(y);
+			x = wrappedX;
+			y = wrappedY;
+		}
+
+		const XMVECTOR source = XMVector3Normalize(XMLoadFloat3(&normal));
+		const FLOAT baseX = std::floor(std::min(std::max(x, -1.f), 1.f) * Snorm16Max);
+		const FLOAT baseY = std::floor(std::min(std::max(y, -1.f), 1.f) * Snorm16Max);
+
+		FLOAT bestDot = -2.f;
+		for (UINT i = 0; i < 4; ++i) {
+			const FLOAT qx = std::min(baseX + (i & 1), Snorm16Max);
+			const FLOAT qy = std::min(baseY + (i >> 1), Snorm16Max);
+
+			const XMFLOAT3 decoded = DecodeOctahedron(qx / Snorm16Max, qy / Snorm16Max);
+			const FLOAT dot = XMVectorGetX(XMVector3Dot(source, XMLoadFloat3(&decoded)));
+			if (dot > bestDot) {
+				bestDot = dot;
+				outX = static_cast<SHORT>(qx);
+				outY = static_cast<SHORT>(qy);
+			}
+		}
+	}
+
+	__forceinline FLOAT ComponentError(const XMFLOAT3& a, const XMFLOAT3& b) {
+		return std::max(std::max(std::abs(a.x - b.x), std::abs(a.y - b.y)), std::abs(a.z - b.z));
+	}
+}
+
+VertexQuantization VertexQuantization::FromBounds(const XMFLOAT3& min, const XMFLOAT3& max) {
+	VertexQuantization quant;
+	quant.Offset = min;
+
+	// Flat axes keep a unit scale so that encoding never divides by zero.
+	quant.Scale.x = max.x > min.x ? max.x - min.x : 1.f;
+	quant.Scale.y = max.y > min.y ? max.y - min.y : 1.f;
+	quant.Scale.z = max.z > min.z ? max.z - min.z : 1.f;
+
+	return quant;
+}
+
+VertexQuantization VertexQuantization::FromVertices(const Vertex* vertices, UINT count) {
+	if (count == 0) return FromBounds(XMFLOAT3(0.f, 0.f, 0.f), XMFLOAT3(0.f, 0.f, 0.f));
+
+	XMVECTOR vMin = XMVectorReplicate(+MathHelper::Infinity);
+	XMVECTOR vMax = XMVectorReplicate(-MathHelper::Infinity);
+
+	for (UINT i = 0; i < count; ++i) {
+		const XMVECTOR P = XMLoadFloat3(&vertices[i].Position);
+
+		vMin = XMVectorMin(vMin, P);
+		vMax = XMVectorMax(vMax, P);
+	}
+
+	XMFLOAT3 min, max;
+	XMStoreFloat3(&min, vMin);
+	XMStoreFloat3(&max, vMax);
+
+	return FromBounds(min, max);
+}
+
+XMMATRIX VertexQuantization::DequantizeMatrix() const {
+	return XMMatrixScaling(Scale.x, Scale.y, Scale.z) * XMMatrixTranslation(Offset.x, Offset.y, Offset.z);
+}
+
+VertexFormat::VertexFormat(PositionEncoding::Type position, NormalEncoding::Type normal, TexCoordEncoding::Type texCoord) {
+	mPosition = position;
+	mNormal = normal;
+	mTexCoord = texCoord;
+
+	BuildLayout();
+}
+
+VertexFormat VertexFormat::Full() {
+	return VertexFormat(PositionEncoding::E_Float3, NormalEncoding::E_Float3, TexCoordEncoding::E_Float2);
+}
+
+VertexFormat VertexFormat::PositionOnly() {
+	return VertexFormat(PositionEncoding::E_Unorm16x4, NormalEncoding::E_None, TexCoordEncoding::E_None);
+}
+
+VertexFormat VertexFormat::FromId(UINT id) {
+	return VertexFormat(
+		static_cast<PositionEncoding::Type>(id & 0xFF),
+		static_cast<NormalEncoding::Type>((id >> 8) & 0xFF),
+		static_cast<TexCoordEncoding::Type>((id >> 16) & 0xFF));
+}
+
+BOOL VertexFormat::operator==(const VertexFormat& other) const {
+	return mPosition == other.mPosition && mNormal == other.mNormal && mTexCoord == other.mTexCoord;
+}
+
+void VertexFormat::Encode(const Vertex* vertices, UINT count, const VertexQuantization& quant, BYTE* dst) const {
+	const XMFLOAT3 invScale(1.f / quant.Scale.x, 1.f / quant.Scale.y, 1.f / quant.Scale.z);
+
+	for (UINT i = 0; i < count; ++i, dst += mStride) {
+		const Vertex& vertex = vertices[i];
+
+		if (mPosition == PositionEncoding::E_Float3) {
+			std::memcpy(dst, &vertex.Position, sizeof(XMFLOAT3));
+		}
+		else {
+			const USHORT q[4] = {
+				EncodeUnorm16((vertex.Position.x - quant.Offset.x) * invScale.x),
+				EncodeUnorm16((vertex.Position.y - quant.Offset.y) * invScale.y),
+				EncodeUnorm16((vertex.Position.z - quant.Offset.z) * invScale.z),
+				static_cast<USHORT>(Unorm16Max)
+			};
+			std::memcpy(dst, q, sizeof(q));
+		}
+
+		if (mNormal == NormalEncoding::E_Float3) {
+			std::memcpy(dst + mNormalOffset, &vertex.Normal, sizeof(XMFLOAT3));
+		}
+		else if (mNormal == NormalEncoding::E_OctSnorm16x2) {
+			SHORT q[2];
+			EncodeOctahedron(vertex.Normal, q[0], q[1]);
+			std::memcpy(dst + mNormalOffset, q, sizeof(q));
+		}
+
+		if (mTexCoord == TexCoordEncoding::E_Float2) {
+			std::memcpy(dst + mTexCoordOffset, &vertex.TexCoord, sizeof(XMFLOAT2));
+		}
+		else if (mTexCoord == TexCoordEncoding::E_Half2) {
+			const HALF q[2] = { XMConvertFloatToHalf(vertex.TexCoord.x), XMConvertFloatToHalf(vertex.TexCoord.y) };
+			std::memcpy(dst + mTexCoordOffset, q, sizeof(q));
+		}
+	}
+}
+
+void VertexFormat::Decode(const BYTE* src, UINT count, const VertexQuantization& quant, Vertex* vertices) const {
+	for (UINT i = 0; i < count; ++i, src += mStride) {
+		Vertex& vertex = vertices[i];
+		vertex = {};
+
+		if (mPosition == PositionEncoding::E_Float3) {
+			std::memcpy(&vertex.Position, src, sizeof(XMFLOAT3));
+		}
+		else {
+			USHORT q[4];
+			std::memcpy(q, src, sizeof(q));
+
+			vertex.Position.x = quant.Offset.x + q[0] / Unorm16Max * quant.Scale.x;
+			vertex.Position.y = quant.Offset.y + q[1] / Unorm16Max * quant.Scale.y;
+			vertex.Position.z = quant.Offset.z + q[2] / Unorm16Max * quant.Scale.z;
+		}
+
+		if (mNormal == NormalEncoding::E_Float3) {
+			std::memcpy(&vertex.Normal, src + mNormalOffset, sizeof(XMFLOAT3));
+		}
+		else if (mNormal == NormalEncoding::E_OctSnorm16x2) {
+			SHORT q[2];
+			std::memcpy(q, src + mNormalOffset, sizeof(q));
+			vertex.Normal = DecodeOctahedron(DecodeSnorm16(q[0]), DecodeSnorm16(q[1]));
+		}
+
+		if (mTexCoord == TexCoordEncoding::E_Float2) {
+			std::memcpy(&vertex.TexCoord, src + mTexCoordOffset, sizeof(XMFLOAT2));
+		}
+		else if (mTexCoord == TexCoordEncoding::E_Half2) {
+			HALF q[2];
+			std::memcpy(q, src + mTexCoordOffset, sizeof(q));
+			vertex.TexCoord = XMFLOAT2(XMConvertHalfToFloat(q[0]), XMConvertHalfToFloat(q[1]));
+		}
+	}
+}
+
+VertexEncodingError VertexFormat::MeasureError(const Vertex* vertices, UINT count, const VertexQuantization& quant) const {
+	VertexEncodingError error;
+
+	std::vector<BYTE> encoded(mStride);
+	Vertex decoded;
+
+	FLOAT minNormalDot = 1.f;
+
+	for (UINT i = 0; i < count; ++i) {
+		const Vertex& vertex = vertices[i];
+
+		Encode(&vertex, 1, quant, encoded.data());
+		Decode(encoded.data(), 1, quant, &decoded);
+
+		error.Position = std::max(error.Position, ComponentError(vertex.Position, decoded.Position));
+
+		if (mNormal != NormalEncoding::E_None) {
+			const XMVECTOR source = XMLoadFloat3(&vertex.Normal);
+			// Degenerate source normals cannot be preserved by any encoding and are ignored.
+			if (XMVectorGetX(XMVector3LengthSq(source)) > 0.f) {
+				const FLOAT dot = XMVectorGetX(XMVector3Dot(XMVector3Normalize(source), XMLoadFloat3(&decoded.Normal)));
+				minNormalDot = std::min(minNormalDot, dot);
+			}
+		}
+
+		if (mTexCoord != TexCoordEncoding::E_None) {
+			error.TexCoord = std::max(error.TexCoord, std::max(
+				std::abs(vertex.TexCoord.x - decoded.TexCoord.x),
+				std::abs(vertex.TexCoord.y - decoded.TexCoord.y)));
+		}
+	}
+
+	error.NormalDegrees = std::acos(std::min(std::max(minNormalDot, -1.f), 1.f)) * MathHelper::RadToDeg;
+
+	return error;
+}
+
+void VertexFormat::BuildLayout() {
+	mInputLayout.clear();
+
+	UINT offset = 0;
+
+	if (mPosition == PositionEncoding::E_Float3) {
+		mInputLayout.push_back({ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offset, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 });
+		offset += sizeof(XMFLOAT3);
+	}
+	else {
+		mInputLayout.push_back({ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, offset, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 });
+		offset += sizeof(USHORT) * 4;
+	}
+
+	mNormalOffset = offset;
+	if (mNormal == NormalEncoding::E_Float3) {
+		mInputLayout.push_back({ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offset, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 });
+		offset += sizeof(XMFLOAT3);
+	}
+	else if (mNormal == NormalEncoding::E_OctSnorm16x2) {
+		mInputLayout.push_back({ "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, offset, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 });
+		offset += sizeof(SHORT) * 2;
+	}
+
+	mTexCoordOffset = offset;
+	if (mTexCoord == TexCoordEncoding::E_Float2) {
+		mInputLayout.push_back({ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, offset, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 });
+		offset += sizeof(XMFLOAT2);
+	}
+	else if (mTexCoord == TexCoordEncoding::E_Half2) {
+		mInputLayout.push_back({ "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, offset, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 });
+		offset += sizeof(HALF) * 2;
+	}
+
+	mStride = offset;
+}
\ No newline at end of file
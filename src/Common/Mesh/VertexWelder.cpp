@@ -0,0 +1,124 @@
+#include "Common/Mesh/VertexWelder.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace {
+	const UINT ComponentCount = 8;
+
+	__forceinline UINT RotateLeft(UINT x, UINT r) {
+		return (x << r) | (x >> (32 - r));
+	}
+
+	__forceinline UINT NextPowerOfTwo(size_t value) {
+		UINT result = VertexWelder::MinCapacity;
+		while (result < value) result <<= 1;
+		return result;
+	}
+}
+
+VertexWelder::VertexWelder(FLOAT epsilon) {
+	mEpsilon = epsilon;
+	mInvEpsilon = epsilon > 0.f ? 1.f / epsilon : 0.f;
+}
+
+void VertexWelder::Reserve(size_t vertexCount) {
+	// Keep the load factor at or below one half.
+	const UINT capacity = NextPowerOfTwo(vertexCount * 2);
+	if (capacity > mSlots.size()) Rehash(capacity);
+}
+
+void VertexWelder::Clear() {
+	mSlots.clear();
+	mCount = 0;
+}
+
+UINT VertexWelder::Weld(const Vertex& vertex, std::vector<Vertex>& vertices) {
+	if ((mCount + 1) * 2 > mSlots.size()) Rehash(mSlots.empty() ? MinCapacity : mSlots.size() * 2);
+
+	Key key;
+	MakeKey(vertex, key);
+
+	const UINT hash = Hash(key);
+	const UINT mask = static_cast<UINT>(mSlots.size()) - 1;
+
+	for (UINT i = hash & mask; ; i = (i + 1) & mask) {
+		Slot& slot = mSlots[i];
+
+		if (slot.Index == EmptySlot) {
+			slot.Hash = hash;
+			slot.Index = static_cast<UINT>(vertices.size());
+			vertices.push_back(vertex);
+			++mCount;
+
+			return slot.Index;
+		}
+
+		if (slot.Hash != hash) continue;
+
+		Key other;
+		MakeKey(vertices[slot.Index], other);
+		if (std::memcmp(key.Values, other.Values, sizeof(Key)) == 0) return slot.Index;
+	}
+}
+
+void VertexWelder::MakeKey(const Vertex& vertex, Key& key) const {
+	const FLOAT components[ComponentCount] = {
+		vertex.Position.x, vertex.Position.y, vertex.Position.z,
+		vertex.Normal.x, vertex.Normal.y, vertex.Normal.z,
+		vertex.TexCoord.x, vertex.TexCoord.y
+	};
+
+	if (mEpsilon > 0.f) {
+		for (UINT i = 0; i < ComponentCount; ++i)
+			key.Values[i] = static_cast<UINT>(static_cast<INT>(std::floor(components[i] * mInvEpsilon + 0.5f)));
+	}
+	else {
+		for (UINT i = 0; i < ComponentCount; ++i) {
+			// Adding zero turns -0 into +0 so both compare equal, as they do as floats.
+			const FLOAT value = components[i] + 0.f;
+			std::memcpy(&key.Values[i], &value, sizeof(UINT));
+		}
+	}
+}
+
+// MurmurHash3 (x86, 32-bit) over the eight key words.
+UINT VertexWelder::Hash(const Key& key) {
+	UINT h = 0;
+
+	for (UINT i = 0; i < ComponentCount; ++i) {
+		UINT k = key.Values[i];
+		k *= 0xcc9e2d51;
+		k = RotateLeft(k, 15);
+		k *= 0x1b873593;
+
+		h ^= k;
+		h = RotateLeft(h, 13);
+		h = h * 5 + 0xe6546b64;
+	}
+
+	h ^= ComponentCount * sizeof(UINT);
+	h ^= h >> 16;
+	h *= 0x85ebca6b;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35;
+	h ^= h >> 16;
+
+	return h;
+}
+
+void VertexWelder::Rehash(size_t capacity) {
+	std::vector<Slot> slots(capacity, Slot{ 0, EmptySlot });
+	const UINT mask = static_cast<UINT>(capacity) - 1;
+
+	for (const auto& slot : mSlots) {
+		if (slot.Index == EmptySlot) continue;
+
+		UINT i = slot.Hash & mask;
+		while (slots[i].Index != EmptySlot) i = (i + 1) & mask;
+
+		slots[i] = slot;
+	}
+
+	mSlots.swap(slots);
+}
\ No newline at end of file
@@ -0,0 +1,416 @@
+#include "Common/Render/Culling.h"
+#include "Common/Render/RenderItem.h"
+#include "Common/Light/Light.h"
+#include "Common/Mesh/MeshletBuilder.h"
+#include "Common/Debug/Logger.h"
+#include "Common/Util/WorkerPool.h"
+
+#include <algorithm>
+
+#undef max
+#undef min
+
+using namespace DirectX;
+
+namespace {
+	const FLOAT MinCropExtent = 0.001f;
+
+	// World-space oriented box: center and the three half-axes (local axes scaled by the extents).
+	struct WorldBox {
+		XMVECTOR Center;
+		XMVECTOR Axes[3];
+	};
+
+	__forceinline void BuildWorldBox(const RenderItem* const ri, WorldBox& box) {
+		const XMMATRIX W = XMLoadFloat4x4(&ri->World);
+		const XMVECTOR center = XMLoadFloat3(&ri->AABB.Center);
+		const XMVECTOR extents = XMLoadFloat3(&ri->AABB.Extents);
+
+		box.Center = XMVector3Transform(center, W);
+		box.Axes[0] = XMVectorScale(W.r[0], XMVectorGetX(extents));
+		box.Axes[1] = XMVectorScale(W.r[1], XMVectorGetY(extents));
+		box.Axes[2] = XMVectorScale(W.r[2], XMVectorGetZ(extents));
+	}
+
+	// Tests up to four boxes against every plane at once. Components are laid out
+	// structure-of-arrays so that each XMVECTOR lane holds one render item.
+	UINT TestBatch(const Culling::Frustum& frustum, const RenderItem* const* ritems, UINT count) {
+		WorldBox boxes[Culling::BatchSize];
+		for (UINT i = 0; i < count; ++i) BuildWorldBox(ritems[i], boxes[i]);
+		for (UINT i = count; i < Culling::BatchSize; ++i) boxes[i] = boxes[0];
+
+		const XMMATRIX C = XMMatrixTranspose(XMMATRIX(boxes[0].Center, boxes[1].Center, boxes[2].Center, boxes[3].Center));
+		XMMATRIX A[3];
+		for (UINT a = 0; a < 3; ++a)
+			A[a] = XMMatrixTranspose(XMMATRIX(boxes[0].Axes[a], boxes[1].Axes[a], boxes[2].Axes[a], boxes[3].Axes[a]));
+
+		XMVECTOR inside = XMVectorTrueInt();
+		for (UINT p = 0; p < frustum.PlaneCount; ++p) {
+			const auto& plane = frustum.Planes[p];
+			const XMVECTOR nx = XMVectorReplicate(plane.x);
+			const XMVECTOR ny = XMVectorReplicate(plane.y);
+			const XMVECTOR nz = XMVectorReplicate(plane.z);
+
+			// Signed distance of the box centers.
+			XMVECTOR dist = XMVectorMultiplyAdd(C.r[0], nx, XMVectorReplicate(plane.w));
+			dist = XMVectorMultiplyAdd(C.r[1], ny, dist);
+			dist = XMVectorMultiplyAdd(C.r[2], nz, dist);
+
+			// Projected radius of the oriented boxes onto the plane normal.
+			XMVECTOR radius = XMVectorZero();
+			for (UINT a = 0; a < 3; ++a) {
+				XMVECTOR proj = XMVectorMultiply(A[a].r[0], nx);
+				proj = XMVectorMultiplyAdd(A[a].r[1], ny, proj);
+				proj = XMVectorMultiplyAdd(A[a].r[2], nz, proj);
+				radius = XMVectorAdd(radius, XMVectorAbs(proj));
+			}
+
+			inside = XMVectorAndInt(inside, XMVectorGreaterOrEqual(XMVectorAdd(dist, radius), XMVectorZero()));
+		}
+
+		XMUINT4 mask;
+		XMStoreUInt4(&mask, inside);
+
+		return (mask.x ? 1u : 0u) | (mask.y ? 2u : 0u) | (mask.z ? 4u : 0u) | (mask.w ? 8u : 0u);
+	}
+
+	void CullRange(
+			const Culling::Frustum& frustum,
+			const std::vector<RenderItem*>& ritems,
+			size_t begin, size_t end,
+			std::vector<RenderItem*>& visibles) {
+		for (size_t i = begin; i < end; i += Culling::BatchSize) {
+			const UINT count = static_cast<UINT>(std::min<size_t>(Culling::BatchSize, end - i));
+			const UINT mask = TestBatch(frustum, &ritems[i], count);
+
+			for (UINT j = 0; j < count; ++j)
+				if (mask & (1u << j)) visibles.push_back(ritems[i + j]);
+		}
+	}
+
+	// Clip-space bounds of the receivers seen by a shadow view, clamped to the view volume.
+	void CalcReceiverBounds(
+			FXMMATRIX viewProj,
+			const std::vector<RenderItem*>& receivers,
+			XMVECTOR& boundsMin,
+			XMVECTOR& boundsMax) {
+		const XMVECTOR volumeMin = XMVectorSet(-1.f, -1.f, 0.f, 0.f);
+		const XMVECTOR volumeMax = XMVectorSet( 1.f,  1.f, 1.f, 0.f);
+
+		boundsMin = XMVectorReplicate(+MathHelper::Infinity);
+		boundsMax = XMVectorReplicate(-MathHelper::Infinity);
+
+		for (const auto ri : receivers) {
+			WorldBox box;
+			BuildWorldBox(ri, box);
+
+			for (UINT c = 0; c < 8; ++c) {
+				XMVECTOR corner = box.Center;
+				corner = XMVectorAdd(corner, (c & 1) ? box.Axes[0] : XMVectorNegate(box.Axes[0]));
+				corner = XMVectorAdd(corner, (c & 2) ? box.Axes[1] : XMVectorNegate(box.Axes[1]));
+				corner = XMVectorAdd(corner, (c & 4) ? box.Axes[2] : XMVectorNegate(box.Axes[2]));
+
+				const XMVECTOR clip = XMVector4Transform(XMVectorSetW(corner, 1.f), viewProj);
+				const FLOAT w = XMVectorGetW(clip);
+
+				// The box straddles the plane of a perspective light; nothing tighter than the whole view is safe.
+				if (w <= MathHelper::Epsilon) {
+					boundsMin = volumeMin;
+					boundsMax = volumeMax;
+					return;
+				}
+
+				const XMVECTOR ndc = XMVectorScale(clip, 1.f / w);
+				boundsMin = XMVectorMin(boundsMin, ndc);
+				boundsMax = XMVectorMax(boundsMax, ndc);
+			}
+		}
+
+		boundsMin = XMVectorClamp(boundsMin, volumeMin, volumeMax);
+		boundsMax = XMVectorClamp(boundsMax, volumeMin, volumeMax);
+	}
+
+	// Maps the clip-space sub-volume [min.x, max.x] x [min.y, max.y] x [0, max.z] onto the full view volume.
+	// The near plane stays at the light, which extends the volume towards it so off-screen casters are kept.
+	XMMATRIX CropMatrix(FXMVECTOR boundsMin, FXMVECTOR boundsMax) {
+		XMFLOAT3 lo, hi;
+		XMStoreFloat3(&lo, boundsMin);
+		XMStoreFloat3(&hi, boundsMax);
+
+		const FLOAT width	= std::max(hi.x - lo.x, MinCropExtent);
+		const FLOAT height	= std::max(hi.y - lo.y, MinCropExtent);
+		const FLOAT depth	= std::max(hi.z, MinCropExtent);
+
+		const FLOAT sx = 2.f / width;
+		const FLOAT sy = 2.f / height;
+		const FLOAT sz = 1.f / depth;
+		const FLOAT ox = -(hi.x + lo.x) / width;
+		const FLOAT oy = -(hi.y + lo.y) / height;
+
+		return XMMATRIX(
+			sx,  0.f, 0.f, 0.f,
+			0.f, sy,  0.f, 0.f,
+			0.f, 0.f, sz,  0.f,
+			ox,  oy,  0.f, 1.f
+		);
+	}
+
+	__forceinline FLOAT BoundingRadius(const WorldBox& box) {
+		return std::sqrt(
+			XMVectorGetX(XMVector3LengthSq(box.Axes[0])) +
+			XMVectorGetX(XMVector3LengthSq(box.Axes[1])) +
+			XMVectorGetX(XMVector3LengthSq(box.Axes[2])));
+	}
+
+	// Bounding sphere against an infinite cone clipped by the light range.
+	BOOL IntersectsCone(const RenderItem* const ri, FXMVECTOR apex, FXMVECTOR axis, FLOAT cosAngle, FLOAT sinAngle, FLOAT range) {
+		WorldBox box;
+		BuildWorldBox(ri, box);
+
+		const FLOAT radius = BoundingRadius(box);
+
+		const XMVECTOR V = XMVectorSubtract(box.Center, apex);
+		const FLOAT lenSq = XMVectorGetX(XMVector3LengthSq(V));
+		const FLOAT alongAxis = XMVectorGetX(XMVector3Dot(V, axis));
+		const FLOAT distToCone = cosAngle * std::sqrt(std::max(lenSq - alongAxis * alongAxis, 0.f)) - alongAxis * sinAngle;
+
+		if (distToCone > radius) return FALSE;
+		if (alongAxis > radius + range) return FALSE;
+		if (alongAxis < -radius) return FALSE;
+
+		return TRUE;
+	}
+
+	void FilterByCone(const Light& light, FLOAT range, std::vector<RenderItem*>& ritems) {
+		const XMVECTOR apex = XMLoadFloat3(&light.Position);
+		const XMVECTOR axis = XMVector3Normalize(XMLoadFloat3(&light.Direction));
+		const FLOAT angle = MathHelper::DegreesToRadians(light.OuterConeAngle);
+		const FLOAT cosAngle = std::cos(angle);
+		const FLOAT sinAngle = std::sin(angle);
+
+		ritems.erase(std::remove_if(ritems.begin(), ritems.end(), [&](RenderItem* ri) {
+			return !IntersectsCone(ri, apex, axis, cosAngle, sinAngle, range);
+		}), ritems.end());
+	}
+
+	// Bounding sphere against the capsule of the given radius around the segment [p0, p1].
+	BOOL IntersectsCapsule(const RenderItem* const ri, FXMVECTOR p0, FXMVECTOR p1, FLOAT radius) {
+		WorldBox box;
+		BuildWorldBox(ri, box);
+
+		const XMVECTOR segment = XMVectorSubtract(p1, p0);
+		const FLOAT lenSq = XMVectorGetX(XMVector3LengthSq(segment));
+
+		FLOAT t = 0.f;
+		if (lenSq > MathHelper::Epsilon) {
+			t = XMVectorGetX(XMVector3Dot(XMVectorSubtract(box.Center, p0), segment)) / lenSq;
+			t = std::min(std::max(t, 0.f), 1.f);
+		}
+
+		const XMVECTOR closest = XMVectorMultiplyAdd(segment, XMVectorReplicate(t), p0);
+		const FLOAT distSq = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(box.Center, closest)));
+		const FLOAT reach = radius + BoundingRadius(box);
+
+		return distSq <= reach * reach;
+	}
+
+	// Area lights have no shadow views, so their influence is bounded instead: a capsule around the
+	// segment of a tube light, and a sphere around the center of a rectangle light.
+	void FilterByAreaLight(const Light& light, FLOAT range, const std::vector<RenderItem*>& ritems, std::vector<RenderItem*>& inside) {
+		XMVECTOR p0, p1;
+		FLOAT radius;
+		if (light.Type == LightType::E_Tube) {
+			p0 = XMLoadFloat3(&light.Position);
+			p1 = XMLoadFloat3(&light.Position1);
+			radius = range + light.Radius;
+		}
+		else {
+			p0 = p1 = XMLoadFloat3(&light.Center);
+			radius = range + 0.5f * std::sqrt(light.Size.x * light.Size.x + light.Size.y * light.Size.y);
+		}
+
+		inside.clear();
+		for (const auto ri : ritems) {
+			if (IntersectsCapsule(ri, p0, p1, radius)) inside.push_back(ri);
+		}
+	}
+}
+
+void Culling::ExtractFrustum(Frustum& frustum, FXMMATRIX viewProj) {
+	// Gribb-Hartmann plane extraction from the columns of the row-vector matrix.
+	const XMMATRIX M = XMMatrixTranspose(viewProj);
+
+	XMVECTOR planes[Plane::Count];
+	planes[Plane::E_Left]	= XMVectorAdd(M.r[3], M.r[0]);
+	planes[Plane::E_Right]	= XMVectorSubtract(M.r[3], M.r[0]);
+	planes[Plane::E_Bottom]	= XMVectorAdd(M.r[3], M.r[1]);
+	planes[Plane::E_Top]	= XMVectorSubtract(M.r[3], M.r[1]);
+	planes[Plane::E_Near]	= M.r[2];
+	planes[Plane::E_Far]	= XMVectorSubtract(M.r[3], M.r[2]);
+
+	for (UINT i = 0; i < Plane::Count; ++i)
+		XMStoreFloat4(&frustum.Planes[i], XMPlaneNormalize(planes[i]));
+	frustum.PlaneCount = Plane::Count;
+}
+
+BOOL Culling::CullRenderItems(
+		const Frustum& frustum,
+		const std::vector<RenderItem*>& ritems,
+		std::vector<RenderItem*>& visibles,
+		WorkerPool* const pool) {
+	visibles.clear();
+
+	const size_t numItems = ritems.size();
+	if (numItems == 0) return TRUE;
+
+	const size_t maxTasks = (numItems + MinItemsPerTask - 1) / MinItemsPerTask;
+	const size_t numTasks = pool == nullptr ? 1 : std::min<size_t>(pool->ThreadCount(), maxTasks);
+
+	if (numTasks <= 1) {
+		visibles.reserve(numItems);
+		CullRange(frustum, ritems, 0, numItems, visibles);
+		return TRUE;
+	}
+
+	// Chunks are rounded up to a whole batch so that only the last one is partial.
+	size_t chunkSize = (numItems + numTasks - 1) / numTasks;
+	chunkSize = (chunkSize + BatchSize - 1) / BatchSize * BatchSize;
+
+	std::vector<std::vector<RenderItem*>> partials(numTasks);
+
+	CheckReturn(pool->Run(static_cast<UINT>(numTasks), [&](UINT t) {
+		const size_t begin = std::min(t * chunkSize, numItems);
+		const size_t end = std::min(begin + chunkSize, numItems);
+
+		partials[t].reserve(end - begin);
+		CullRange(frustum, ritems, begin, end, partials[t]);
+		return TRUE;
+	}));
+
+	size_t total = 0;
+	for (const auto& partial : partials) total += partial.size();
+
+	visibles.reserve(total);
+	for (const auto& partial : partials) visibles.insert(visibles.end(), partial.begin(), partial.end());
+
+	return TRUE;
+}
+
+void Culling::CullRenderItemsReference(
+		const Frustum& frustum,
+		const std::vector<RenderItem*>& ritems,
+		std::vector<RenderItem*>& visibles) {
+	visibles.clear();
+
+	for (const auto ri : ritems) {
+		XMFLOAT3 corners[BoundingBox::CORNER_COUNT];
+		ri->AABB.GetCorners(corners);
+
+		const XMMATRIX W = XMLoadFloat4x4(&ri->World);
+
+		BOOL inside = TRUE;
+		for (UINT p = 0; p < frustum.PlaneCount && inside; ++p) {
+			const XMVECTOR plane = XMLoadFloat4(&frustum.Planes[p]);
+
+			FLOAT maxDist = -MathHelper::Infinity;
+			for (UINT c = 0; c < BoundingBox::CORNER_COUNT; ++c) {
+				const XMVECTOR pos = XMVector3TransformCoord(XMLoadFloat3(&corners[c]), W);
+				maxDist = std::max(maxDist, XMVectorGetX(XMPlaneDotCoord(plane, pos)));
+			}
+
+			if (maxDist < 0.f) inside = FALSE;
+		}
+
+		if (inside) visibles.push_back(ri);
+	}
+}
+
+void Culling::CullMeshlets(
+		const Frustum& frustum,
+		FXMVECTOR viewPos,
+		const Meshlet* meshlets,
+		UINT count,
+		std::vector<UINT>& visibles) {
+	visibles.clear();
+
+	for (UINT i = 0; i < count; ++i) {
+		const auto& meshlet = meshlets[i];
+
+		if (MeshletBuilder::IsBackfacing(meshlet, viewPos)) continue;
+
+		const XMVECTOR center = XMLoadFloat3(&meshlet.Center);
+
+		BOOL inside = TRUE;
+		for (UINT p = 0; p < frustum.PlaneCount && inside; ++p) {
+			if (XMVectorGetX(XMPlaneDotCoord(XMLoadFloat4(&frustum.Planes[p]), center)) < -meshlet.Radius) inside = FALSE;
+		}
+
+		if (inside) visibles.push_back(i);
+	}
+}
+
+BOOL Culling::CullShadowCasters(
+		const Light& light,
+		FLOAT range,
+		const std::vector<RenderItem*>& receivers,
+		const std::vector<RenderItem*>& casters,
+		ShadowCasterLists& lists,
+		WorkerPool* const pool) {
+	for (UINT v = 0; v < MaxShadowViews; ++v) lists.Views[v].clear();
+
+	if (light.Type == LightType::E_Tube || light.Type == LightType::E_Rect) {
+		std::vector<RenderItem*> lit;
+		FilterByAreaLight(light, range, receivers, lit);
+		// No visible receiver within reach of the light, so none of its shadows can be seen.
+		if (!lit.empty()) FilterByAreaLight(light, range, casters, lists.Views[0]);
+
+		return TRUE;
+	}
+
+	UINT numViews = 0;
+	if (light.Type == LightType::E_Directional) numViews = 1;
+	else if (light.Type == LightType::E_Point || light.Type == LightType::E_Spot) numViews = MaxShadowViews;
+	else return TRUE;
+
+	const XMFLOAT4X4* const viewProjs[MaxShadowViews] = { 
+		&light.Mat0, &light.Mat1, &light.Mat2, &light.Mat3, &light.Mat4, &light.Mat5 
+	};
+
+	// Spot lights can only shadow what lies inside their outer cone.
+	const BOOL isSpot = light.Type == LightType::E_Spot;
+
+	std::vector<RenderItem*> coneReceivers;
+	std::vector<RenderItem*> coneCasters;
+	if (isSpot) {
+		coneReceivers = receivers;
+		coneCasters = casters;
+		FilterByCone(light, range, coneReceivers);
+		FilterByCone(light, range, coneCasters);
+	}
+
+	const auto& lit = isSpot ? coneReceivers : receivers;
+	const auto& candidates = isSpot ? coneCasters : casters;
+
+	std::vector<RenderItem*> seen;
+	for (UINT v = 0; v < numViews; ++v) {
+		// Light matrices are stored transposed for the shaders.
+		const XMMATRIX viewProj = XMMatrixTranspose(XMLoadFloat4x4(viewProjs[v]));
+
+		Frustum view;
+		ExtractFrustum(view, viewProj);
+
+		CheckReturn(CullRenderItems(view, lit, seen, pool));
+		// No visible receiver in this view, so nothing rendered into it can ever be sampled.
+		if (seen.empty()) continue;
+
+		XMVECTOR boundsMin, boundsMax;
+		CalcReceiverBounds(viewProj, seen, boundsMin, boundsMax);
+
+		Frustum casterVolume;
+		ExtractFrustum(casterVolume, XMMatrixMultiply(viewProj, CropMatrix(boundsMin, boundsMax)));
+
+		CheckReturn(CullRenderItems(casterVolume, candidates, lists.Views[v], pool));
+	}
+
+	return TRUE;
+}
\ No newline at end of file
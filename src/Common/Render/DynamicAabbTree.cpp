@@ -0,0 +1,375 @@
+#include "Common/Render/DynamicAabbTree.h"
+
+#include <algorithm>
+
+#undef max
+#undef min
+
+using namespace DirectX;
+
+DynamicAabbTree::DynamicAabbTree(FLOAT margin) {
+	mMargin = margin;
+}
+
+BoundingBox DynamicAabbTree::FatAABB(INT proxyId) const {
+	const Node& node = mNodes[proxyId];
+
+	BoundingBox aabb;
+	BoundingBox::CreateFromPoints(aabb, XMLoadFloat3(&node.Min), XMLoadFloat3(&node.Max));
+
+	return aabb;
+}
+
+INT DynamicAabbTree::CreateProxy(const BoundingBox& aabb, void* const userData) {
+	const INT proxyId = AllocateNode();
+
+	Node& node = mNodes[proxyId];
+	node.Min = XMFLOAT3(
+		aabb.Center.x - aabb.Extents.x - mMargin,
+		aabb.Center.y - aabb.Extents.y - mMargin,
+		aabb.Center.z - aabb.Extents.z - mMargin);
+	node.Max = XMFLOAT3(
+		aabb.Center.x + aabb.Extents.x + mMargin,
+		aabb.Center.y + aabb.Extents.y + mMargin,
+		aabb.Center.z + aabb.Extents.z + mMargin);
+	node.UserData = userData;
+	node.Height = 0;
+
+	InsertLeaf(proxyId);
+	++mProxyCount;
+
+	return proxyId;
+}
+
+void DynamicAabbTree::DestroyProxy(INT proxyId) {
+	RemoveLeaf(proxyId);
+	FreeNode(proxyId);
+	--mProxyCount;
+}
+
+BOOL DynamicAabbTree::MoveProxy(INT proxyId, const BoundingBox& aabb) {
+	Node& node = mNodes[proxyId];
+
+	const XMFLOAT3 bMin(aabb.Center.x - aabb.Extents.x, aabb.Center.y - aabb.Extents.y, aabb.Center.z - aabb.Extents.z);
+	const XMFLOAT3 bMax(aabb.Center.x + aabb.Extents.x, aabb.Center.y + aabb.Extents.y, aabb.Center.z + aabb.Extents.z);
+
+	// Still enclosed by the fat AABB; the tree does not need to change.
+	if (node.Min.x <= bMin.x && node.Min.y <= bMin.y && node.Min.z <= bMin.z &&
+		node.Max.x >= bMax.x && node.Max.y >= bMax.y && node.Max.z >= bMax.z) return FALSE;
+
+	RemoveLeaf(proxyId);
+
+	Node& moved = mNodes[proxyId];
+	moved.Min = XMFLOAT3(bMin.x - mMargin, bMin.y - mMargin, bMin.z - mMargin);
+	moved.Max = XMFLOAT3(bMax.x + mMargin, bMax.y + mMargin, bMax.z + mMargin);
+
+	InsertLeaf(proxyId);
+
+	return TRUE;
+}
+
+BOOL DynamicAabbTree::Validate() const {
+	if (mRoot == NullNode) return mProxyCount == 0;
+	if (mNodes[mRoot].Parent != NullNode) return FALSE;
+
+	return ValidateNode(mRoot);
+}
+
+INT DynamicAabbTree::AllocateNode() {
+	if (mFreeList == NullNode) {
+		const INT start = static_cast<INT>(mNodes.size());
+		const INT capacity = std::max(start * 2, 16);
+
+		mNodes.resize(capacity);
+		for (INT i = start; i < capacity; ++i) {
+			mNodes[i].Next = i + 1 < capacity ? i + 1 : NullNode;
+			mNodes[i].Height = -1;
+		}
+
+		mFreeList = start;
+	}
+
+	const INT nodeId = mFreeList;
+	mFreeList = mNodes[nodeId].Next;
+
+	Node& node = mNodes[nodeId];
+	node.UserData = nullptr;
+	node.Parent = NullNode;
+	node.Next = NullNode;
+	node.Child1 = NullNode;
+	node.Child2 = NullNode;
+	node.Height = 0;
+
+	return nodeId;
+}
+
+void DynamicAabbTree::FreeNode(INT nodeId) {
+	Node& node = mNodes[nodeId];
+	node.Next = mFreeList;
+	node.Height = -1;
+	node.UserData = nullptr;
+
+	mFreeList = nodeId;
+}
+
+void DynamicAabbTree::InsertLeaf(INT leaf) {
+	if (mRoot == NullNode) {
+		mRoot = leaf;
+		mNodes[mRoot].Parent = NullNode;
+		return;
+	}
+
+	// Find the best sibling by descending with the surface area heuristic.
+	INT index = mRoot;
+	while (!mNodes[index].IsLeaf()) {
+		const Node& node = mNodes[index];
+		const INT child1 = node.Child1;
+		const INT child2 = node.Child2;
+
+		Node combined;
+		Combine(combined, node, mNodes[leaf]);
+
+		const FLOAT area = SurfaceArea(node.Min, node.Max);
+		const FLOAT combinedArea = SurfaceArea(combined.Min, combined.Max);
+
+		// Cost of creating a new parent for this node and the new leaf.
+		const FLOAT cost = 2.f * combinedArea;
+		// Minimum cost of pushing the leaf further down the tree.
+		const FLOAT inheritanceCost = 2.f * (combinedArea - area);
+
+		auto descendCost = [&](INT child) {
+			const Node& c = mNodes[child];
+
+			Node merged;
+			Combine(merged, mNodes[leaf], c);
+
+			const FLOAT mergedArea = SurfaceArea(merged.Min, merged.Max);
+			if (c.IsLeaf()) return mergedArea + inheritanceCost;
+
+			return mergedArea - SurfaceArea(c.Min, c.Max) + inheritanceCost;
+		};
+
+		const FLOAT cost1 = descendCost(child1);
+		const FLOAT cost2 = descendCost(child2);
+
+		if (cost < cost1 && cost < cost2) break;
+
+		index = cost1 < cost2 ? child1 : child2;
+	}
+
+	const INT sibling = index;
+
+	// Allocating may grow the node pool, so nodes are addressed by index from here on.
+	const INT oldParent = mNodes[sibling].Parent;
+	const INT newParent = AllocateNode();
+
+	mNodes[newParent].Parent = oldParent;
+	mNodes[newParent].UserData = nullptr;
+	Combine(mNodes[newParent], mNodes[leaf], mNodes[sibling]);
+	mNodes[newParent].Height = mNodes[sibling].Height + 1;
+
+	if (oldParent != NullNode) {
+		if (mNodes[oldParent].Child1 == sibling) mNodes[oldParent].Child1 = newParent;
+		else mNodes[oldParent].Child2 = newParent;
+	}
+	else {
+		mRoot = newParent;
+	}
+
+	mNodes[newParent].Child1 = sibling;
+	mNodes[newParent].Child2 = leaf;
+	mNodes[sibling].Parent = newParent;
+	mNodes[leaf].Parent = newParent;
+
+	// Walk back up the tree fixing heights and bounds.
+	index = mNodes[leaf].Parent;
+	while (index != NullNode) {
+		index = Balance(index);
+
+		Node& node = mNodes[index];
+		const Node& child1 = mNodes[node.Child1];
+		const Node& child2 = mNodes[node.Child2];
+
+		node.Height = 1 + std::max(child1.Height, child2.Height);
+		Combine(node, child1, child2);
+
+		index = node.Parent;
+	}
+}
+
+void DynamicAabbTree::RemoveLeaf(INT leaf) {
+	if (leaf == mRoot) {
+		mRoot = NullNode;
+		return;
+	}
+
+	const INT parent = mNodes[leaf].Parent;
+	const INT grandParent = mNodes[parent].Parent;
+	const INT sibling = mNodes[parent].Child1 == leaf ? mNodes[parent].Child2 : mNodes[parent].Child1;
+
+	if (grandParent != NullNode) {
+		// Destroy the parent and connect the sibling to the grand parent.
+		if (mNodes[grandParent].Child1 == parent) mNodes[grandParent].Child1 = sibling;
+		else mNodes[grandParent].Child2 = sibling;
+		mNodes[sibling].Parent = grandParent;
+		FreeNode(parent);
+
+		INT index = grandParent;
+		while (index != NullNode) {
+			index = Balance(index);
+
+			Node& node = mNodes[index];
+			const Node& child1 = mNodes[node.Child1];
+			const Node& child2 = mNodes[node.Child2];
+
+			Combine(node, child1, child2);
+			node.Height = 1 + std::max(child1.Height, child2.Height);
+
+			index = node.Parent;
+		}
+	}
+	else {
+		mRoot = sibling;
+		mNodes[sibling].Parent = NullNode;
+		FreeNode(parent);
+	}
+}
+
+// Performs a left or right rotation if node A is imbalanced and returns the new subtree root.
+INT DynamicAabbTree::Balance(INT iA) {
+	Node& A = mNodes[iA];
+	if (A.IsLeaf() || A.Height < 2) return iA;
+
+	const INT iB = A.Child1;
+	const INT iC = A.Child2;
+
+	Node& B = mNodes[iB];
+	Node& C = mNodes[iC];
+
+	const INT balance = C.Height - B.Height;
+
+	// Rotate C up.
+	if (balance > 1) {
+		const INT iF = C.Child1;
+		const INT iG = C.Child2;
+
+		Node& F = mNodes[iF];
+		Node& G = mNodes[iG];
+
+		// Swap A and C.
+		C.Child1 = iA;
+		C.Parent = A.Parent;
+		A.Parent = iC;
+
+		// A's old parent should point to C.
+		if (C.Parent != NullNode) {
+			if (mNodes[C.Parent].Child1 == iA) mNodes[C.Parent].Child1 = iC;
+			else mNodes[C.Parent].Child2 = iC;
+		}
+		else {
+			mRoot = iC;
+		}
+
+		if (F.Height > G.Height) {
+			C.Child2 = iF;
+			A.Child2 = iG;
+			G.Parent = iA;
+
+			Combine(A, B, G);
+			Combine(C, A, F);
+
+			A.Height = 1 + std::max(B.Height, G.Height);
+			C.Height = 1 + std::max(A.Height, F.Height);
+		}
+		else {
+			C.Child2 = iG;
+			A.Child2 = iF;
+			F.Parent = iA;
+
+			Combine(A, B, F);
+			Combine(C, A, G);
+
+			A.Height = 1 + std::max(B.Height, F.Height);
+			C.Height = 1 + std::max(A.Height, G.Height);
+		}
+
+		return iC;
+	}
+
+	// Rotate B up.
+	if (balance < -1) {
+		const INT iD = B.Child1;
+		const INT iE = B.Child2;
+
+		Node& D = mNodes[iD];
+		Node& E = mNodes[iE];
+
+		// Swap A and B.
+		B.Child1 = iA;
+		B.Parent = A.Parent;
+		A.Parent = iB;
+
+		// A's old parent should point to B.
+		if (B.Parent != NullNode) {
+			if (mNodes[B.Parent].Child1 == iA) mNodes[B.Parent].Child1 = iB;
+			else mNodes[B.Parent].Child2 = iB;
+		}
+		else {
+			mRoot = iB;
+		}
+
+		if (D.Height > E.Height) {
+			B.Child2 = iD;
+			A.Child1 = iE;
+			E.Parent = iA;
+
+			Combine(A, C, E);
+			Combine(B, A, D);
+
+			A.Height = 1 + std::max(C.Height, E.Height);
+			B.Height = 1 + std::max(A.Height, D.Height);
+		}
+		else {
+			B.Child2 = iE;
+			A.Child1 = iD;
+			D.Parent = iA;
+
+			Combine(A, C, D);
+			Combine(B, A, E);
+
+			A.Height = 1 + std::max(C.Height, D.Height);
+			B.Height = 1 + std::max(A.Height, E.Height);
+		}
+
+		return iB;
+	}
+
+	return iA;
+}
+
+void DynamicAabbTree::Combine(Node& dst, const Node& a, const Node& b) const {
+	const XMFLOAT3 min(std::min(a.Min.x, b.Min.x), std::min(a.Min.y, b.Min.y), std::min(a.Min.z, b.Min.z));
+	const XMFLOAT3 max(std::max(a.Max.x, b.Max.x), std::max(a.Max.y, b.Max.y), std::max(a.Max.z, b.Max.z));
+
+	dst.Min = min;
+	dst.Max = max;
+}
+
+BOOL DynamicAabbTree::ValidateNode(INT index) const {
+	const Node& node = mNodes[index];
+
+	if (node.IsLeaf()) return node.Child2 == NullNode && node.Height == 0;
+
+	const Node& child1 = mNodes[node.Child1];
+	const Node& child2 = mNodes[node.Child2];
+
+	if (child1.Parent != index || child2.Parent != index) return FALSE;
+	if (node.Height != 1 + std::max(child1.Height, child2.Height)) return FALSE;
+
+	Node bound;
+	Combine(bound, child1, child2);
+	if (bound.Min.x != node.Min.x || bound.Min.y != node.Min.y || bound.Min.z != node.Min.z ||
+		bound.Max.x != node.Max.x || bound.Max.y != node.Max.y || bound.Max.z != node.Max.z) return FALSE;
+
+	return ValidateNode(node.Child1) && ValidateNode(node.Child2);
+}
\ No newline at end of file
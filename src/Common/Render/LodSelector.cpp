@@ -0,0 +1,40 @@
+#include "Common/Render/LodSelector.h"
+
+#include <algorithm>
+
+#undef max
+#undef min
+
+using namespace DirectX;
+
+FLOAT LodSelector::ProjectedScale(
+		const BoundingBox& localBounds,
+		FXMMATRIX world,
+		FXMVECTOR eyePos,
+		FLOAT projScaleY,
+		UINT screenHeight,
+		FLOAT nearZ) {
+	// Errors are measured in local units; a scaled item projects them by its largest axis scale.
+	const FLOAT worldScale = std::max(std::max(
+		XMVectorGetX(XMVector3Length(world.r[0])),
+		XMVectorGetX(XMVector3Length(world.r[1]))),
+		XMVectorGetX(XMVector3Length(world.r[2])));
+
+	const XMVECTOR center = XMVector3TransformCoord(XMLoadFloat3(&localBounds.Center), world);
+	const FLOAT radius = XMVectorGetX(XMVector3Length(XMLoadFloat3(&localBounds.Extents))) * worldScale;
+
+	const FLOAT distance = std::max(XMVectorGetX(XMVector3Length(XMVectorSubtract(center, eyePos))) - radius, nearZ);
+
+	return 0.5f * screenHeight * projScaleY / distance * worldScale;
+}
+
+UINT LodSelector::SelectLod(const MeshLod* lods, UINT lodCount, UINT currentLod, FLOAT projectedScale) {
+	if (lodCount == 0) return 0;
+
+	UINT lod = std::min(currentLod, lodCount - 1);
+
+	while (lod > 0 && lods[lod].Error * projectedScale > MaxPixelError) --lod;
+	while (lod + 1 < lodCount && lods[lod + 1].Error * projectedScale <= MaxPixelError * Hysteresis) ++lod;
+
+	return lod;
+}
\ No newline at end of file
@@ -0,0 +1,390 @@
+#include "Common/Render/OcclusionCuller.h"
+#include "Common/Render/RenderItem.h"
+#include "Common/Debug/Logger.h"
+#include "Common/Util/WorkerPool.h"
+
+#include <algorithm>
+#include <cstring>
+
+#undef max
+#undef min
+
+using namespace DirectX;
+
+namespace {
+	const FLOAT MinTriangleArea = 1e-6f;
+	const FLOAT MinClipW = 1e-6f;
+
+	// Levels below the one picked for a box that are visited when a texel is only partially covered.
+	const UINT RefineLevels = 2;
+	// A box is tested at the first level where its screen rectangle spans at most this many texels per axis.
+	const INT MaxTexelsPerAxis = 4;
+
+	__forceinline XMFLOAT4 LerpClip(const XMFLOAT4& a, const XMFLOAT4& b) {
+		// Intersection of the edge with the near plane (z = 0).
+		const FLOAT t = a.z / (a.z - b.z);
+		return XMFLOAT4(
+			a.x + (b.x - a.x) * t,
+			a.y + (b.y - a.y) * t,
+			0.f,
+			a.w + (b.w - a.w) * t);
+	}
+}
+
+OcclusionCuller::OcclusionCuller() {
+	mViewProj = MathHelper::Identity4x4();
+
+	for (UINT level = 0; level < LevelCount; ++level) {
+		const size_t size = static_cast<size_t>(Width >> level) * (Height >> level);
+
+		mMaxDepth[level].assign(size, 1.f);
+		if (level > 0) mMinDepth[level].assign(size, 1.f);
+	}
+}
+
+BOOL OcclusionCuller::AddMesh(
+		const void* const vertices,
+		UINT vertexCount,
+		UINT vertexStride,
+		const UINT* const indices,
+		UINT indexCount,
+		UINT& meshIndex) {
+	if (indexCount % 3 != 0) ReturnFalse(L"Index count must be a multiple of three");
+	if (indexCount / 3 > MaxOccluderTriangles) ReturnFalse(L"Too many triangles for an occluder: " << indexCount / 3);
+	if (vertexStride < sizeof(XMFLOAT3)) ReturnFalse(L"Vertex stride is smaller than a position");
+
+	OccluderMesh mesh;
+	mesh.Positions.resize(vertexCount);
+	mesh.Indices.assign(indices, indices + indexCount);
+
+	const BYTE* const src = reinterpret_cast<const BYTE*>(vertices);
+	for (UINT i = 0; i < vertexCount; ++i)
+		std::memcpy(&mesh.Positions[i], src + static_cast<size_t>(i) * vertexStride, sizeof(XMFLOAT3));
+
+	for (const auto index : mesh.Indices) {
+		if (index >= vertexCount) ReturnFalse(L"Index out of range");
+	}
+
+	meshIndex = static_cast<UINT>(mMeshes.size());
+	mMeshes.push_back(std::move(mesh));
+
+	return TRUE;
+}
+
+void OcclusionCuller::BeginFrame(FXMMATRIX viewProj) {
+	XMStoreFloat4x4(&mViewProj, viewProj);
+	mOccluders.clear();
+}
+
+void OcclusionCuller::AddOccluder(UINT meshIndex, FXMMATRIX world) {
+	Occluder occluder;
+	occluder.MeshIndex = meshIndex;
+	XMStoreFloat4x4(&occluder.World, world);
+
+	mOccluders.push_back(occluder);
+}
+
+BOOL OcclusionCuller::Rasterize(WorkerPool* const pool) {
+	std::fill(mMaxDepth[0].begin(), mMaxDepth[0].end(), 1.f);
+
+	mTriangles.clear();
+	for (auto& bin : mBandBins) bin.clear();
+
+	for (const auto& occluder : mOccluders) {
+		if (occluder.MeshIndex >= mMeshes.size()) ReturnFalse(L"Invalid occluder mesh index: " << occluder.MeshIndex);
+
+		SetupTriangles(occluder);
+	}
+
+	if (pool != nullptr && mTriangles.size() > 0) {
+		CheckReturn(pool->Run(BandCount, [this](UINT band) {
+			RasterizeBand(band);
+			return TRUE;
+		}));
+	}
+	else {
+		for (UINT band = 0; band < BandCount; ++band) RasterizeBand(band);
+	}
+
+	BuildHierarchy();
+
+	return TRUE;
+}
+
+BOOL OcclusionCuller::IsVisible(const BoundingBox& aabb, FXMMATRIX world) const {
+	const XMMATRIX M = XMMatrixMultiply(world, XMLoadFloat4x4(&mViewProj));
+
+	XMFLOAT3 corners[BoundingBox::CORNER_COUNT];
+	aabb.GetCorners(corners);
+
+	FLOAT minX = +MathHelper::Infinity;
+	FLOAT minY = +MathHelper::Infinity;
+	FLOAT maxX = -MathHelper::Infinity;
+	FLOAT maxY = -MathHelper::Infinity;
+	FLOAT minZ = +MathHelper::Infinity;
+
+	for (const auto& corner : corners) {
+		XMFLOAT4 clip;
+		XMStoreFloat4(&clip, XMVector4Transform(XMVectorSetW(XMLoadFloat3(&corner), 1.f), M));
+
+		// Boxes crossing the near plane cannot be bounded on screen.
+		if (clip.z < 0.f || clip.w < MinClipW) return TRUE;
+
+		const FLOAT invW = 1.f / clip.w;
+		const FLOAT sx = (clip.x * invW * 0.5f + 0.5f) * Width;
+		const FLOAT sy = (-clip.y * invW * 0.5f + 0.5f) * Height;
+
+		minX = std::min(minX, sx);
+		maxX = std::max(maxX, sx);
+		minY = std::min(minY, sy);
+		maxY = std::max(maxY, sy);
+		minZ = std::min(minZ, clip.z * invW);
+	}
+
+	// Off-screen boxes are left to the frustum test.
+	if (maxX < 0.f || maxY < 0.f || minX >= Width || minY >= Height) return TRUE;
+
+	const INT rect[4] = {
+		std::max(0, static_cast<INT>(std::floor(minX))),
+		std::max(0, static_cast<INT>(std::floor(minY))),
+		std::min(static_cast<INT>(Width) - 1, static_cast<INT>(std::floor(maxX))),
+		std::min(static_cast<INT>(Height) - 1, static_cast<INT>(std::floor(maxY)))
+	};
+
+	UINT level = 0;
+	while (level < LevelCount - 1 &&
+		((rect[2] >> level) - (rect[0] >> level) >= MaxTexelsPerAxis || (rect[3] >> level) - (rect[1] >> level) >= MaxTexelsPerAxis)) ++level;
+
+	for (INT y = rect[1] >> level; y <= rect[3] >> level; ++y) {
+		for (INT x = rect[0] >> level; x <= rect[2] >> level; ++x) {
+			if (TestTexel(level, x, y, rect, minZ, RefineLevels)) return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+void OcclusionCuller::CullRenderItems(const std::vector<RenderItem*>& ritems, std::vector<RenderItem*>& visibles) const {
+	visibles.clear();
+	visibles.reserve(ritems.size());
+
+	for (const auto ri : ritems) {
+		if (IsVisible(ri->AABB, XMLoadFloat4x4(&ri->World))) visibles.push_back(ri);
+	}
+}
+
+void OcclusionCuller::SetupTriangles(const Occluder& occluder) {
+	const auto& mesh = mMeshes[occluder.MeshIndex];
+	const XMMATRIX M = XMMatrixMultiply(XMLoadFloat4x4(&occluder.World), XMLoadFloat4x4(&mViewProj));
+
+	std::vector<XMFLOAT4> clips(mesh.Positions.size());
+	for (size_t i = 0, end = mesh.Positions.size(); i < end; ++i)
+		XMStoreFloat4(&clips[i], XMVector4Transform(XMVectorSetW(XMLoadFloat3(&mesh.Positions[i]), 1.f), M));
+
+	for (size_t i = 0, end = mesh.Indices.size(); i < end; i += 3) {
+		const XMFLOAT4& c0 = clips[mesh.Indices[i + 0]];
+		const XMFLOAT4& c1 = clips[mesh.Indices[i + 1]];
+		const XMFLOAT4& c2 = clips[mesh.Indices[i + 2]];
+
+		// Trivially reject triangles entirely outside one of the side or far planes.
+		if (c0.x > c0.w && c1.x > c1.w && c2.x > c2.w) continue;
+		if (c0.x < -c0.w && c1.x < -c1.w && c2.x < -c2.w) continue;
+		if (c0.y > c0.w && c1.y > c1.w && c2.y > c2.w) continue;
+		if (c0.y < -c0.w && c1.y < -c1.w && c2.y < -c2.w) continue;
+		if (c0.z > c0.w && c1.z > c1.w && c2.z > c2.w) continue;
+
+		const BOOL inside[3] = { c0.z >= 0.f, c1.z >= 0.f, c2.z >= 0.f };
+		const UINT insideCount = inside[0] + inside[1] + inside[2];
+
+		if (insideCount == 0) continue;
+		if (insideCount == 3) {
+			SetupTriangle(c0, c1, c2);
+			continue;
+		}
+
+		// Clip against the near plane; the result is a triangle or a quad.
+		const XMFLOAT4* const input[3] = { &c0, &c1, &c2 };
+		XMFLOAT4 polygon[4];
+		UINT count = 0;
+
+		for (UINT v = 0; v < 3; ++v) {
+			const UINT next = (v + 1) % 3;
+
+			if (inside[v]) polygon[count++] = *input[v];
+			if (inside[v] != inside[next]) polygon[count++] = LerpClip(*input[v], *input[next]);
+		}
+
+		for (UINT v = 2; v < count; ++v) SetupTriangle(polygon[0], polygon[v - 1], polygon[v]);
+	}
+}
+
+void OcclusionCuller::SetupTriangle(const XMFLOAT4& c0, const XMFLOAT4& c1, const XMFLOAT4& c2) {
+	if (c0.w < MinClipW || c1.w < MinClipW || c2.w < MinClipW) return;
+
+	XMFLOAT3 s[3];
+	const XMFLOAT4* const clips[3] = { &c0, &c1, &c2 };
+	for (UINT i = 0; i < 3; ++i) {
+		const FLOAT invW = 1.f / clips[i]->w;
+		s[i].x = (clips[i]->x * invW * 0.5f + 0.5f) * Width;
+		s[i].y = (-clips[i]->y * invW * 0.5f + 0.5f) * Height;
+		s[i].z = clips[i]->z * invW;
+	}
+
+	FLOAT area = (s[2].x - s[0].x) * (s[1].y - s[0].y) - (s[2].y - s[0].y) * (s[1].x - s[0].x);
+	if (std::abs(area) < MinTriangleArea) return;
+
+	// Both windings are rasterized; flip to make the edge functions positive inside.
+	if (area < 0.f) {
+		std::swap(s[1], s[2]);
+		area = -area;
+	}
+
+	ScreenTriangle tri;
+
+	const FLOAT minX = std::min(s[0].x, std::min(s[1].x, s[2].x));
+	const FLOAT maxX = std::max(s[0].x, std::max(s[1].x, s[2].x));
+	const FLOAT minY = std::min(s[0].y, std::min(s[1].y, s[2].y));
+	const FLOAT maxY = std::max(s[0].y, std::max(s[1].y, s[2].y));
+
+	// Pixels whose centers can lie inside the triangle.
+	tri.MinX = std::max(0, static_cast<INT>(std::ceil(minX - 0.5f)));
+	tri.MaxX = std::min(static_cast<INT>(Width) - 1, static_cast<INT>(std::floor(maxX - 0.5f)));
+	tri.MinY = std::max(0, static_cast<INT>(std::ceil(minY - 0.5f)));
+	tri.MaxY = std::min(static_cast<INT>(Height) - 1, static_cast<INT>(std::floor(maxY - 0.5f)));
+	if (tri.MinX > tri.MaxX || tri.MinY > tri.MaxY) return;
+
+	// Edge i is opposite to vertex i.
+	for (UINT i = 0; i < 3; ++i) {
+		const XMFLOAT3& a = s[(i + 1) % 3];
+		const XMFLOAT3& b = s[(i + 2) % 3];
+
+		tri.EdgeA[i] = b.y - a.y;
+		tri.EdgeB[i] = a.x - b.x;
+		tri.EdgeC[i] = a.y * (b.x - a.x) - a.x * (b.y - a.y);
+	}
+
+	// Depth is affine in screen space; the normalized edge functions are the barycentric coordinates.
+	const FLOAT invArea = 1.f / area;
+	tri.ZA = (tri.EdgeA[0] * s[0].z + tri.EdgeA[1] * s[1].z + tri.EdgeA[2] * s[2].z) * invArea;
+	tri.ZB = (tri.EdgeB[0] * s[0].z + tri.EdgeB[1] * s[1].z + tri.EdgeB[2] * s[2].z) * invArea;
+	tri.ZC = (tri.EdgeC[0] * s[0].z + tri.EdgeC[1] * s[1].z + tri.EdgeC[2] * s[2].z) * invArea;
+
+	// Coverage is tested inward: an edge function evaluated at a pixel center drops by at most
+	// (|A| + |B|) / 2 towards the corners, so shifting the edges by that much keeps only pixels the
+	// triangle covers entirely. Likewise the depth written is the farthest the plane reaches in the pixel.
+	for (UINT i = 0; i < 3; ++i)
+		tri.EdgeC[i] -= 0.5f * (std::abs(tri.EdgeA[i]) + std::abs(tri.EdgeB[i]));
+	tri.ZC += 0.5f * (std::abs(tri.ZA) + std::abs(tri.ZB));
+
+	const UINT index = static_cast<UINT>(mTriangles.size());
+	mTriangles.push_back(tri);
+
+	for (INT band = tri.MinY / BandHeight, end = tri.MaxY / BandHeight; band <= end; ++band)
+		mBandBins[band].push_back(index);
+}
+
+// Rasterizes four pixels of a row at a time; bands do not overlap, so they can run concurrently.
+void OcclusionCuller::RasterizeBand(UINT band) {
+	const INT bandMinY = static_cast<INT>(band * BandHeight);
+	const INT bandMaxY = bandMinY + static_cast<INT>(BandHeight) - 1;
+
+	const XMVECTOR offsets = XMVectorSet(0.5f, 1.5f, 2.5f, 3.5f);
+	const XMVECTOR zero = XMVectorZero();
+
+	FLOAT* const depth = mMaxDepth[0].data();
+
+	for (const auto index : mBandBins[band]) {
+		const ScreenTriangle& tri = mTriangles[index];
+
+		const XMVECTOR a0 = XMVectorReplicate(tri.EdgeA[0]);
+		const XMVECTOR a1 = XMVectorReplicate(tri.EdgeA[1]);
+		const XMVECTOR a2 = XMVectorReplicate(tri.EdgeA[2]);
+		const XMVECTOR za = XMVectorReplicate(tri.ZA);
+
+		const INT minY = std::max(tri.MinY, bandMinY);
+		const INT maxY = std::min(tri.MaxY, bandMaxY);
+		const INT minX = tri.MinX & ~3;
+
+		for (INT y = minY; y <= maxY; ++y) {
+			const FLOAT py = static_cast<FLOAT>(y) + 0.5f;
+
+			const XMVECTOR row0 = XMVectorReplicate(tri.EdgeB[0] * py + tri.EdgeC[0]);
+			const XMVECTOR row1 = XMVectorReplicate(tri.EdgeB[1] * py + tri.EdgeC[1]);
+			const XMVECTOR row2 = XMVectorReplicate(tri.EdgeB[2] * py + tri.EdgeC[2]);
+			const XMVECTOR rowZ = XMVectorReplicate(tri.ZB * py + tri.ZC);
+
+			FLOAT* const dstRow = depth + static_cast<size_t>(y) * Width;
+
+			for (INT x = minX; x <= tri.MaxX; x += 4) {
+				const XMVECTOR px = XMVectorAdd(XMVectorReplicate(static_cast<FLOAT>(x)), offsets);
+
+				const XMVECTOR e0 = XMVectorMultiplyAdd(a0, px, row0);
+				const XMVECTOR e1 = XMVectorMultiplyAdd(a1, px, row1);
+				const XMVECTOR e2 = XMVectorMultiplyAdd(a2, px, row2);
+
+				const XMVECTOR mask = XMVectorAndInt(
+					XMVectorAndInt(XMVectorGreaterOrEqual(e0, zero), XMVectorGreaterOrEqual(e1, zero)),
+					XMVectorGreaterOrEqual(e2, zero));
+				if (XMVector4EqualInt(mask, XMVectorFalseInt())) continue;
+
+				const XMVECTOR z = XMVectorMultiplyAdd(za, px, rowZ);
+
+				XMFLOAT4* const dst = reinterpret_cast<XMFLOAT4*>(dstRow + x);
+				const XMVECTOR d = XMLoadFloat4(dst);
+				XMStoreFloat4(dst, XMVectorSelect(d, XMVectorMin(d, z), mask));
+			}
+		}
+	}
+}
+
+void OcclusionCuller::BuildHierarchy() {
+	for (UINT level = 1; level < LevelCount; ++level) {
+		const UINT width = Width >> level;
+		const UINT height = Height >> level;
+		const UINT srcWidth = Width >> (level - 1);
+
+		const auto& srcMax = mMaxDepth[level - 1];
+		const auto& srcMin = level == 1 ? mMaxDepth[0] : mMinDepth[level - 1];
+
+		auto& dstMax = mMaxDepth[level];
+		auto& dstMin = mMinDepth[level];
+
+		for (UINT y = 0; y < height; ++y) {
+			for (UINT x = 0; x < width; ++x) {
+				const size_t i0 = static_cast<size_t>(y * 2) * srcWidth + x * 2;
+				const size_t i1 = i0 + srcWidth;
+
+				dstMax[y * width + x] = std::max(std::max(srcMax[i0], srcMax[i0 + 1]), std::max(srcMax[i1], srcMax[i1 + 1]));
+				dstMin[y * width + x] = std::min(std::min(srcMin[i0], srcMin[i0 + 1]), std::min(srcMin[i1], srcMin[i1 + 1]));
+			}
+		}
+	}
+}
+
+// Returns TRUE if the box may be visible somewhere inside the texel. The rectangle is in level 0 pixels.
+BOOL OcclusionCuller::TestTexel(UINT level, UINT x, UINT y, const INT rect[4], FLOAT minZ, UINT depth) const {
+	const UINT index = y * (Width >> level) + x;
+
+	// Every occluder in the texel is nearer than the box.
+	if (minZ > mMaxDepth[level][index]) return FALSE;
+	// The box is nearer than everything in the texel, or there is nothing finer to look at.
+	if (level == 0 || depth == 0 || minZ <= mMinDepth[level][index]) return TRUE;
+
+	// Partially covered; look at the children that overlap the rectangle.
+	const UINT childLevel = level - 1;
+	for (UINT cy = y * 2; cy <= y * 2 + 1; ++cy) {
+		const INT top = static_cast<INT>(cy << childLevel);
+		const INT bottom = static_cast<INT>(((cy + 1) << childLevel) - 1);
+		if (top > rect[3] || bottom < rect[1]) continue;
+
+		for (UINT cx = x * 2; cx <= x * 2 + 1; ++cx) {
+			const INT left = static_cast<INT>(cx << childLevel);
+			const INT right = static_cast<INT>(((cx + 1) << childLevel) - 1);
+			if (left > rect[2] || right < rect[0]) continue;
+
+			if (TestTexel(childLevel, cx, cy, rect, minZ, depth - 1)) return TRUE;
+		}
+	}
+
+	return FALSE;
+}
\ No newline at end of file
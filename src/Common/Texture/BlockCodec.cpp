@@ -0,0 +1,1853 @@
+#include "Common/Texture/BlockCodec.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+#undef max
+#undef min
+
+namespace {
+	const UINT Weights2[4] = { 0, 21, 43, 64 };
+	const UINT Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+	const UINT Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	// Two-subset partitions shared by BC6H (the first 32) and BC7, one bit per texel.
+	const USHORT Partitions2[64] = {
+		0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+		0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+		0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+		0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+		0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+		0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+		0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+		0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22
+	};
+
+	const BYTE Partitions3[64][16] = {
+		{ 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2 }, { 0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1 },
+		{ 0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1 }, { 0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 1, 0, 1, 1, 1 },
+		{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2 }, { 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 2, 2 },
+		{ 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1 }, { 0, 0, 1, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1 },
+		{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2 }, { 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2 },
+		{ 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2 }, { 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2 },
+		{ 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2 }, { 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2 },
+		{ 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2, 1, 2, 2, 2 }, { 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0, 2, 2, 2, 0 },
+		{ 0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2 }, { 0, 1, 1, 1, 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0 },
+		{ 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2 }, { 0, 0, 2, 2, 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1 },
+		{ 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2, 0, 2, 2, 2 }, { 0, 0, 0, 1, 0, 0, 0, 1, 2, 2, 2, 1, 2, 2, 2, 1 },
+		{ 0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2 }, { 0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 1, 0, 2, 2, 1, 0 },
+		{ 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 0 }, { 0, 0, 1, 2, 0, 0, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2 },
+		{ 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1, 0, 1, 1, 0 }, { 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1 },
+		{ 0, 0, 2, 2, 1, 1, 0, 2, 1, 1, 0, 2, 0, 0, 2, 2 }, { 0, 1, 1, 0, 0, 1, 1, 0, 2, 0, 0, 2, 2, 2, 2, 2 },
+		{ 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1 }, { 0, 0, 0, 0, 2, 0, 0, 0, 2, 2, 1, 1, 2, 2, 2, 1 },
+		{ 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 2, 2, 2 }, { 0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 2, 0, 0, 1, 1 },
+		{ 0, 0, 1, 1, 0, 0, 1, 2, 0, 0, 2, 2, 0, 2, 2, 2 }, { 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0 },
+		{ 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0 }, { 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0 },
+		{ 0, 1, 2, 0, 2, 0, 1, 2, 1, 2, 0, 1, 0, 1, 2, 0 }, { 0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0, 1, 1 },
+		{ 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1 }, { 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2 },
+		{ 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1 }, { 0, 0, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2, 1, 1, 2, 2 },
+		{ 0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1 }, { 0, 2, 2, 0, 1, 2, 2, 1, 0, 2, 2, 0, 1, 2, 2, 1 },
+		{ 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 0, 1 }, { 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1 },
+		{ 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2 }, { 0, 2, 2, 2, 0, 1, 1, 1, 0, 2, 2, 2, 0, 1, 1, 1 },
+		{ 0, 0, 0, 2, 1, 1, 1, 2, 0, 0, 0, 2, 1, 1, 1, 2 }, { 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2 },
+		{ 0, 2, 2, 2, 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2 }, { 0, 0, 0, 2, 1, 1, 1, 2, 1, 1, 1, 2, 0, 0, 0, 2 },
+		{ 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2 }, { 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2 },
+		{ 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2, 2, 2, 2, 2 }, { 0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2 },
+		{ 0, 0, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2 }, { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2 },
+		{ 0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1 }, { 0, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2, 1, 2, 2, 2 },
+		{ 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2 }, { 0, 1, 1, 1, 2, 0, 1, 1, 2, 2, 0, 1, 2, 2, 2, 0 }
+	};
+
+	// Texels whose index is stored with one bit less; the first subset is always anchored at texel 0.
+	const BYTE Anchors2[64] = {
+		15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+		15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+		15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+		 6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15
+	};
+
+	const BYTE Anchors3Second[64] = {
+		 3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+		 3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+		 8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+		 3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3
+	};
+
+	const BYTE Anchors3Third[64] = {
+		15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+		15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+		15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+		15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8
+	};
+
+	__forceinline const UINT* GetWeights(UINT bits) {
+		return bits == 2 ? Weights2 : bits == 3 ? Weights3 : Weights4;
+	}
+
+	__forceinline UINT SubsetOf(UINT subsets, UINT partition, UINT texel) {
+		if (subsets == 1) return 0;
+		if (subsets == 2) return (Partitions2[partition] >> texel) & 1;
+		return Partitions3[partition][texel];
+	}
+
+	__forceinline UINT AnchorOf(UINT subsets, UINT partition, UINT subset) {
+		if (subset == 0) return 0;
+		if (subsets == 2) return Anchors2[partition];
+		return subset == 1 ? Anchors3Second[partition] : Anchors3Third[partition];
+	}
+
+	__forceinline INT Interpolate(INT a, INT b, UINT weight) {
+		return ((64 - static_cast<INT>(weight)) * a + static_cast<INT>(weight) * b + 32) >> 6;
+	}
+
+	__forceinline INT Round(FLOAT value) {
+		return static_cast<INT>(std::floor(value + 0.5f));
+	}
+
+	__forceinline INT Clamp(INT value, INT low, INT high) {
+		return value < low ? low : value > high ? high : value;
+	}
+
+	class BitWriter {
+	public:
+		BitWriter(BYTE* block, UINT size) : mBlock(block) {
+			std::memset(block, 0, size);
+		}
+
+	public:
+		void Write(UINT value, UINT count) {
+			for (UINT i = 0; i < count; ++i, ++mPosition) {
+				if ((value >> i) & 1) mBlock[mPosition >> 3] |= static_cast<BYTE>(1 << (mPosition & 7));
+			}
+		}
+
+	private:
+		BYTE* mBlock;
+		UINT mPosition = 0;
+	};
+
+	class BitReader {
+	public:
+		BitReader(const BYTE* block) : mBlock(block) {}
+
+	public:
+		UINT Read(UINT count) {
+			UINT value = 0;
+			for (UINT i = 0; i < count; ++i, ++mPosition)
+				value |= ((mBlock[mPosition >> 3] >> (mPosition & 7)) & 1u) << i;
+			return value;
+		}
+
+	private:
+		const BYTE* mBlock;
+		UINT mPosition = 0;
+	};
+
+	// Mean and principal axis of the points, by power iteration on their covariance matrix. Returns
+	// the summed squared distance of the points from that line, which is zero when they all lie on it.
+	FLOAT FitLine(const XMVECTOR* points, UINT count, XMVECTOR& mean, XMVECTOR& axis) {
+		XMVECTOR sum = XMVectorZero();
+		for (UINT i = 0; i < count; ++i)
+			sum = XMVectorAdd(sum, points[i]);
+		mean = XMVectorScale(sum, 1.f / static_cast<FLOAT>(count));
+
+		XMVECTOR rows[4] = { XMVectorZero(), XMVectorZero(), XMVectorZero(), XMVectorZero() };
+		for (UINT i = 0; i < count; ++i) {
+			const XMVECTOR d = XMVectorSubtract(points[i], mean);
+			rows[0] = XMVectorMultiplyAdd(d, XMVectorSplatX(d), rows[0]);
+			rows[1] = XMVectorMultiplyAdd(d, XMVectorSplatY(d), rows[1]);
+			rows[2] = XMVectorMultiplyAdd(d, XMVectorSplatZ(d), rows[2]);
+			rows[3] = XMVectorMultiplyAdd(d, XMVectorSplatW(d), rows[3]);
+		}
+
+		const FLOAT trace = XMVectorGetX(rows[0]) + XMVectorGetY(rows[1]) + XMVectorGetZ(rows[2]) + XMVectorGetW(rows[3]);
+
+		// Starting from the longest row keeps the iteration away from vectors orthogonal to the axis.
+		axis = rows[0];
+		FLOAT longest = XMVectorGetX(XMVector4LengthSq(rows[0]));
+		for (UINT i = 1; i < 4; ++i) {
+			const FLOAT length = XMVectorGetX(XMVector4LengthSq(rows[i]));
+			if (length > longest) {
+				longest = length;
+				axis = rows[i];
+			}
+		}
+
+		if (longest <= FLT_MIN) {
+			axis = XMVectorZero();
+			return 0.f;
+		}
+
+		for (UINT i = 0; i < 8; ++i) {
+			XMVECTOR next = XMVectorMultiply(rows[0], XMVectorSplatX(axis));
+			next = XMVectorMultiplyAdd(rows[1], XMVectorSplatY(axis), next);
+			next = XMVectorMultiplyAdd(rows[2], XMVectorSplatZ(axis), next);
+			next = XMVectorMultiplyAdd(rows[3], XMVectorSplatW(axis), next);
+
+			const FLOAT length = XMVectorGetX(XMVector4Length(next));
+			if (length <= FLT_MIN) break;
+			axis = XMVectorScale(next, 1.f / length);
+		}
+
+		axis = XMVector4Normalize(axis);
+
+		XMVECTOR projected = XMVectorMultiply(rows[0], XMVectorSplatX(axis));
+		projected = XMVectorMultiplyAdd(rows[1], XMVectorSplatY(axis), projected);
+		projected = XMVectorMultiplyAdd(rows[2], XMVectorSplatZ(axis), projected);
+		projected = XMVectorMultiplyAdd(rows[3], XMVectorSplatW(axis), projected);
+
+		return std::max(trace - XMVectorGetX(XMVector4Dot(axis, projected)), 0.f);
+	}
+
+	// Ends of the segment of the line through mean along axis that covers the projected points.
+	void FitEndpoints(const XMVECTOR* points, UINT count, XMVECTOR& e0, XMVECTOR& e1) {
+		XMVECTOR mean, axis;
+		FitLine(points, count, mean, axis);
+
+		FLOAT tMin = FLT_MAX;
+		FLOAT tMax = -FLT_MAX;
+		for (UINT i = 0; i < count; ++i) {
+			const FLOAT t = XMVectorGetX(XMVector4Dot(XMVectorSubtract(points[i], mean), axis));
+			tMin = std::min(tMin, t);
+			tMax = std::max(tMax, t);
+		}
+
+		e0 = XMVectorMultiplyAdd(axis, XMVectorReplicate(tMin), mean);
+		e1 = XMVectorMultiplyAdd(axis, XMVectorReplicate(tMax), mean);
+	}
+
+	// Endpoints minimizing the squared error of the points for fixed interpolation weights, where
+	// point i is approximated by (1 - t[i]) * e0 + t[i] * e1. Fails when the weights are degenerate.
+	BOOL SolveEndpoints(const XMVECTOR* points, const FLOAT* t, UINT count, XMVECTOR& e0, XMVECTOR& e1) {
+		FLOAT aa = 0.f, bb = 0.f, ab = 0.f;
+		XMVECTOR ax = XMVectorZero();
+		XMVECTOR bx = XMVectorZero();
+
+		for (UINT i = 0; i < count; ++i) {
+			const FLOAT b = t[i];
+			const FLOAT a = 1.f - b;
+			aa += a * a;
+			bb += b * b;
+			ab += a * b;
+			ax = XMVectorMultiplyAdd(points[i], XMVectorReplicate(a), ax);
+			bx = XMVectorMultiplyAdd(points[i], XMVectorReplicate(b), bx);
+		}
+
+		const FLOAT det = aa * bb - ab * ab;
+		if (std::fabs(det) < 1e-6f) return FALSE;
+
+		const FLOAT invDet = 1.f / det;
+		e0 = XMVectorScale(XMVectorSubtract(XMVectorScale(ax, bb), XMVectorScale(bx, ab)), invDet);
+		e1 = XMVectorScale(XMVectorSubtract(XMVectorScale(bx, aa), XMVectorScale(ax, ab)), invDet);
+
+		return TRUE;
+	}
+
+	__forceinline XMVECTOR LoadTexel(const BYTE* texel) {
+		return XMVectorSet(texel[0], texel[1], texel[2], texel[3]);
+	}
+
+	//
+	// BC1 to BC5
+	//
+
+	__forceinline INT Expand5(INT value) { return (value << 3) | (value >> 2); }
+	__forceinline INT Expand6(INT value) { return (value << 2) | (value >> 4); }
+
+	USHORT Quantize565(FXMVECTOR color) {
+		XMFLOAT4 c;
+		XMStoreFloat4(&c, XMVectorClamp(color, XMVectorZero(), XMVectorReplicate(255.f)));
+
+		const INT r = Clamp(Round(c.x * 31.f / 255.f), 0, 31);
+		const INT g = Clamp(Round(c.y * 63.f / 255.f), 0, 63);
+		const INT b = Clamp(Round(c.z * 31.f / 255.f), 0, 31);
+
+		return static_cast<USHORT>((r << 11) | (g << 5) | b);
+	}
+
+	void Unpack565(USHORT color, INT* rgb) {
+		rgb[0] = Expand5((color >> 11) & 31);
+		rgb[1] = Expand6((color >> 5) & 63);
+		rgb[2] = Expand5(color & 31);
+	}
+
+	// Palette of a BC1 color block; the fourth entry of the three-color mode is transparent black.
+	void BuildColorPalette(USHORT c0, USHORT c1, BOOL fourColors, INT palette[4][4]) {
+		Unpack565(c0, palette[0]);
+		Unpack565(c1, palette[1]);
+		palette[0][3] = palette[1][3] = 255;
+
+		for (UINT c = 0; c < 3; ++c) {
+			if (fourColors) {
+				palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+			}
+			else {
+				palette[2][c] = (palette[0][c] + palette[1][c] + 1) / 2;
+				palette[3][c] = 0;
+			}
+		}
+
+		palette[2][3] = 255;
+		palette[3][3] = fourColors ? 255 : 0;
+	}
+
+	// Interpolation weights of the entries of the color palette towards c1.
+	const FLOAT ColorWeights4[4] = { 0.f, 1.f, 1.f / 3.f, 2.f / 3.f };
+	const FLOAT ColorWeights3[4] = { 0.f, 1.f, 0.5f, 0.f };
+
+	struct ColorCandidate {
+		USHORT C0;
+		USHORT C1;
+		UINT Indices[16];
+		UINT Error;
+	};
+
+	// Picks the nearest palette entry for each texel. Transparent texels take the transparent entry
+	// of the three-color mode, which opaque texels never use.
+	void AssignColorIndices(const BYTE* texels, const BOOL* transparent, BOOL fourColors, ColorCandidate& candidate) {
+		INT palette[4][4];
+		BuildColorPalette(candidate.C0, candidate.C1, fourColors, palette);
+
+		const UINT entries = fourColors ? 4 : 3;
+
+		candidate.Error = 0;
+		for (UINT i = 0; i < 16; ++i) {
+			if (transparent[i]) {
+				candidate.Indices[i] = 3;
+				continue;
+			}
+
+			const BYTE* texel = texels + i * 4;
+
+			UINT bestIndex = 0;
+			UINT bestError = UINT_MAX;
+			for (UINT p = 0; p < entries; ++p) {
+				const INT dr = palette[p][0] - texel[0];
+				const INT dg = palette[p][1] - texel[1];
+				const INT db = palette[p][2] - texel[2];
+				const UINT error = static_cast<UINT>(dr * dr + dg * dg + db * db);
+				if (error < bestError) {
+					bestError = error;
+					bestIndex = p;
+				}
+			}
+
+			candidate.Indices[i] = bestIndex;
+			candidate.Error += bestError;
+		}
+	}
+
+	// Quantizes the endpoints and orders them for the requested mode: c0 > c1 selects four colors.
+	void MakeColorCandidate(
+			const BYTE* texels,
+			const BOOL* transparent,
+			FXMVECTOR e0,
+			FXMVECTOR e1,
+			BOOL fourColors,
+			ColorCandidate& candidate) {
+		USHORT c0 = Quantize565(e0);
+		USHORT c1 = Quantize565(e1);
+
+		if ((fourColors && c0 < c1) || (!fourColors && c0 > c1)) std::swap(c0, c1);
+
+		candidate.C0 = c0;
+		candidate.C1 = c1;
+
+		// Equal endpoints always decode in three-color mode, where index 0 is still exact.
+		AssignColorIndices(texels, transparent, fourColors && c0 != c1, candidate);
+	}
+
+	void RefineColorCandidate(
+			const BYTE* texels,
+			const BOOL* transparent,
+			BOOL fourColors,
+			ColorCandidate& candidate) {
+		XMVECTOR points[16];
+		FLOAT t[16];
+		UINT count = 0;
+
+		const FLOAT* weights = fourColors && candidate.C0 != candidate.C1 ? ColorWeights4 : ColorWeights3;
+		for (UINT i = 0; i < 16; ++i) {
+			if (transparent[i]) continue;
+			points[count] = LoadTexel(texels + i * 4);
+			t[count] = weights[candidate.Indices[i]];
+			++count;
+		}
+
+		XMVECTOR e0, e1;
+		if (count == 0 || !SolveEndpoints(points, t, count, e0, e1)) return;
+
+		ColorCandidate refined;
+		MakeColorCandidate(texels, transparent, e0, e1, fourColors, refined);
+		if (refined.Error < candidate.Error) candidate = refined;
+	}
+
+	// Endpoints whose 2/3 : 1/3 mix reproduces each 8-bit value as closely as possible, for blocks
+	// of a single color, which the fitted endpoints would otherwise round away from.
+	struct SingleColorTable {
+		BYTE Table5[256][2];
+		BYTE Table6[256][2];
+
+		SingleColorTable() {
+			Build(Table5, 31, 5);
+			Build(Table6, 63, 6);
+		}
+
+		static void Build(BYTE table[256][2], INT maxValue, UINT bits) {
+			for (INT value = 0; value < 256; ++value) {
+				INT bestError = INT_MAX;
+				for (INT a = 0; a <= maxValue; ++a) {
+					for (INT b = 0; b <= maxValue; ++b) {
+						const INT ea = bits == 5 ? Expand5(a) : Expand6(a);
+						const INT eb = bits == 5 ? Expand5(b) : Expand6(b);
+						const INT error = std::abs((2 * ea + eb + 1) / 3 - value);
+						if (error < bestError) {
+							bestError = error;
+							table[value][0] = static_cast<BYTE>(a);
+							table[value][1] = static_cast<BYTE>(b);
+						}
+					}
+				}
+			}
+		}
+	};
+
+	const SingleColorTable& GetSingleColorTable() {
+		static const SingleColorTable table;
+		return table;
+	}
+
+	void WriteColorBlock(const ColorCandidate& candidate, BYTE* block) {
+		block[0] = static_cast<BYTE>(candidate.C0 & 0xFF);
+		block[1] = static_cast<BYTE>(candidate.C0 >> 8);
+		block[2] = static_cast<BYTE>(candidate.C1 & 0xFF);
+		block[3] = static_cast<BYTE>(candidate.C1 >> 8);
+
+		UINT indices = 0;
+		for (UINT i = 0; i < 16; ++i)
+			indices |= candidate.Indices[i] << (i * 2);
+
+		std::memcpy(block + 4, &indices, sizeof(UINT));
+	}
+
+	// Color part of BC1, BC2 and BC3. allowAlpha enables the transparent entry of BC1's three-color mode.
+	void EncodeColorBlock(const BYTE* texels, CompressionQuality::Type quality, BOOL allowAlpha, BYTE* block) {
+		BOOL transparent[16];
+		BOOL anyTransparent = FALSE;
+		for (UINT i = 0; i < 16; ++i) {
+			transparent[i] = allowAlpha && texels[i * 4 + 3] < 128;
+			anyTransparent |= transparent[i];
+		}
+
+		XMVECTOR points[16];
+		UINT count = 0;
+		BOOL singleColor = TRUE;
+		const BYTE* first = nullptr;
+
+		for (UINT i = 0; i < 16; ++i) {
+			if (transparent[i]) continue;
+
+			const BYTE* texel = texels + i * 4;
+			if (first == nullptr) first = texel;
+			else singleColor &= texel[0] == first[0] && texel[1] == first[1] && texel[2] == first[2];
+
+			points[count++] = LoadTexel(texel);
+		}
+
+		ColorCandidate best = {};
+
+		if (count == 0) {
+			best.C0 = best.C1 = 0;
+			for (UINT i = 0; i < 16; ++i)
+				best.Indices[i] = 3;
+			WriteColorBlock(best, block);
+			return;
+		}
+
+		if (singleColor && !anyTransparent) {
+			const auto& table = GetSingleColorTable();
+			best.C0 = static_cast<USHORT>((table.Table5[first[0]][0] << 11) | (table.Table6[first[1]][0] << 5) | table.Table5[first[2]][0]);
+			best.C1 = static_cast<USHORT>((table.Table5[first[0]][1] << 11) | (table.Table6[first[1]][1] << 5) | table.Table5[first[2]][1]);
+
+			if (best.C0 > best.C1) {
+				for (UINT i = 0; i < 16; ++i)
+					best.Indices[i] = 2;
+			}
+			else if (best.C0 < best.C1) {
+				std::swap(best.C0, best.C1);
+				for (UINT i = 0; i < 16; ++i)
+					best.Indices[i] = 3;
+			}
+			else {
+				for (UINT i = 0; i < 16; ++i)
+					best.Indices[i] = 0;
+			}
+
+			WriteColorBlock(best, block);
+			return;
+		}
+
+		XMVECTOR e0, e1;
+		FitEndpoints(points, count, e0, e1);
+
+		const UINT passes = quality == CompressionQuality::E_Fast ? 1 : quality == CompressionQuality::E_Normal ? 2 : 4;
+
+		best.Error = UINT_MAX;
+		for (UINT mode = 0; mode < 2; ++mode) {
+			// The transparent entry only exists in the three-color mode, which is otherwise tried at high quality.
+			const BOOL fourColors = mode == 0;
+			if (fourColors && anyTransparent) continue;
+			if (!fourColors && !anyTransparent && quality != CompressionQuality::E_High) continue;
+
+			// Insetting the ends by half a palette step centers the palette on the fitted range.
+			const XMVECTOR inset = XMVectorScale(XMVectorSubtract(e1, e0), fourColors ? 1.f / 16.f : 1.f / 8.f);
+
+			ColorCandidate candidate;
+			MakeColorCandidate(texels, transparent, XMVectorAdd(e0, inset), XMVectorSubtract(e1, inset), fourColors, candidate);
+			for (UINT pass = 0; pass < passes; ++pass)
+				RefineColorCandidate(texels, transparent, fourColors, candidate);
+
+			if (candidate.Error < best.Error) best = candidate;
+		}
+
+		WriteColorBlock(best, block);
+	}
+
+	void BuildAlphaPalette(INT a0, INT a1, INT palette[8]) {
+		palette[0] = a0;
+		palette[1] = a1;
+
+		if (a0 > a1) {
+			for (INT i = 2; i < 8; ++i)
+				palette[i] = ((8 - i) * a0 + (i - 1) * a1 + 3) / 7;
+		}
+		else {
+			for (INT i = 2; i < 6; ++i)
+				palette[i] = ((6 - i) * a0 + (i - 1) * a1 + 2) / 5;
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	struct AlphaCandidate {
+		INT A0;
+		INT A1;
+		UINT Indices[16];
+		UINT Error;
+	};
+
+	void AssignAlphaIndices(const INT* values, AlphaCandidate& candidate) {
+		INT palette[8];
+		BuildAlphaPalette(candidate.A0, candidate.A1, palette);
+
+		candidate.Error = 0;
+		for (UINT i = 0; i < 16; ++i) {
+			UINT bestIndex = 0;
+			UINT bestError = UINT_MAX;
+			for (UINT p = 0; p < 8; ++p) {
+				const INT d = palette[p] - values[i];
+				const UINT error = static_cast<UINT>(d * d);
+				if (error < bestError) {
+					bestError = error;
+					bestIndex = p;
+				}
+			}
+
+			candidate.Indices[i] = bestIndex;
+			candidate.Error += bestError;
+		}
+	}
+
+	// Least-squares endpoints for the current indices of the eight-value mode.
+	void RefineAlphaCandidate(const INT* values, AlphaCandidate& candidate) {
+		FLOAT aa = 0.f, bb = 0.f, ab = 0.f, ax = 0.f, bx = 0.f;
+		for (UINT i = 0; i < 16; ++i) {
+			const UINT index = candidate.Indices[i];
+			const FLOAT b = index == 0 ? 0.f : index == 1 ? 1.f : static_cast<FLOAT>(index - 1) / 7.f;
+			const FLOAT a = 1.f - b;
+			aa += a * a;
+			bb += b * b;
+			ab += a * b;
+			ax += a * values[i];
+			bx += b * values[i];
+		}
+
+		const FLOAT det = aa * bb - ab * ab;
+		if (std::fabs(det) < 1e-6f) return;
+
+		AlphaCandidate refined;
+		refined.A0 = Clamp(Round((ax * bb - bx * ab) / det), 0, 255);
+		refined.A1 = Clamp(Round((bx * aa - ax * ab) / det), 0, 255);
+		if (refined.A0 < refined.A1) std::swap(refined.A0, refined.A1);
+		if (refined.A0 == refined.A1) return;
+
+		AssignAlphaIndices(values, refined);
+		if (refined.Error < candidate.Error) candidate = refined;
+	}
+
+	void EncodeAlphaBlock(const INT* values, CompressionQuality::Type quality, BYTE* block) {
+		INT minValue = 255, maxValue = 0;
+		INT innerMin = 255, innerMax = 0;
+		for (UINT i = 0; i < 16; ++i) {
+			minValue = std::min(minValue, values[i]);
+			maxValue = std::max(maxValue, values[i]);
+			if (values[i] != 0 && values[i] != 255) {
+				innerMin = std::min(innerMin, values[i]);
+				innerMax = std::max(innerMax, values[i]);
+			}
+		}
+
+		AlphaCandidate best;
+
+		if (minValue == maxValue) {
+			best.A0 = best.A1 = minValue;
+			std::memset(best.Indices, 0, sizeof(best.Indices));
+		}
+		else {
+			best.A0 = maxValue;
+			best.A1 = minValue;
+			AssignAlphaIndices(values, best);
+
+			const UINT passes = quality == CompressionQuality::E_Fast ? 0 : quality == CompressionQuality::E_Normal ? 1 : 3;
+			for (UINT pass = 0; pass < passes; ++pass)
+				RefineAlphaCandidate(values, best);
+
+			// The six-value mode keeps exact 0 and 255 and spends the rest on the values in between.
+			if (best.Error > 0 && (minValue == 0 || maxValue == 255)) {
+				AlphaCandidate inner;
+				inner.A0 = innerMin <= innerMax ? innerMin : minValue;
+				inner.A1 = innerMin <= innerMax ? innerMax : minValue;
+				AssignAlphaIndices(values, inner);
+				if (inner.Error < best.Error) best = inner;
+			}
+		}
+
+		block[0] = static_cast<BYTE>(best.A0);
+		block[1] = static_cast<BYTE>(best.A1);
+
+		UINT64 indices = 0;
+		for (UINT i = 0; i < 16; ++i)
+			indices |= static_cast<UINT64>(best.Indices[i]) << (i * 3);
+
+		for (UINT i = 0; i < 6; ++i)
+			block[2 + i] = static_cast<BYTE>(indices >> (i * 8));
+	}
+
+	void DecodeColorBlock(const BYTE* block, BOOL allowThreeColors, BYTE* texels) {
+		const USHORT c0 = static_cast<USHORT>(block[0] | (block[1] << 8));
+		const USHORT c1 = static_cast<USHORT>(block[2] | (block[3] << 8));
+
+		INT palette[4][4];
+		BuildColorPalette(c0, c1, !allowThreeColors || c0 > c1, palette);
+
+		UINT indices;
+		std::memcpy(&indices, block + 4, sizeof(UINT));
+
+		for (UINT i = 0; i < 16; ++i) {
+			const INT* entry = palette[(indices >> (i * 2)) & 3];
+			for (UINT c = 0; c < 4; ++c)
+				texels[i * 4 + c] = static_cast<BYTE>(entry[c]);
+		}
+	}
+
+	void DecodeAlphaBlock(const BYTE* block, UINT channel, BYTE* texels) {
+		INT palette[8];
+		BuildAlphaPalette(block[0], block[1], palette);
+
+		UINT64 indices = 0;
+		for (UINT i = 0; i < 6; ++i)
+			indices |= static_cast<UINT64>(block[2 + i]) << (i * 8);
+
+		for (UINT i = 0; i < 16; ++i)
+			texels[i * 4 + channel] = static_cast<BYTE>(palette[(indices >> (i * 3)) & 7]);
+	}
+
+	//
+	// BC7
+	//
+
+	struct Bc7Mode {
+		UINT Subsets;
+		UINT PartitionBits;
+		UINT RotationBits;
+		UINT IndexSelectionBits;
+		UINT ColorBits;
+		UINT AlphaBits;
+		UINT EndpointPBits;
+		UINT SharedPBits;
+		UINT IndexBits;
+		UINT SecondaryIndexBits;
+	};
+
+	const Bc7Mode Bc7Modes[8] = {
+		{ 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+		{ 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+		{ 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+		{ 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+		{ 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+		{ 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+		{ 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+		{ 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 }
+	};
+
+	// Replicates the high bits of an n-bit value into the low bits of an 8-bit one.
+	__forceinline INT Expand(INT value, UINT bits) {
+		value <<= 8 - bits;
+		return value | (value >> bits);
+	}
+
+	// Stored value of bits bits whose expansion, with the p-bit appended when pBit is not negative,
+	// is closest to value.
+	INT QuantizeChannel(FLOAT value, UINT bits, INT pBit) {
+		const UINT total = bits + (pBit >= 0 ? 1 : 0);
+		const INT maxStored = (1 << bits) - 1;
+
+		const FLOAT scaled = value * static_cast<FLOAT>((1 << total) - 1) / 255.f;
+		const INT guess = pBit >= 0 ? Round((scaled - pBit) * 0.5f) : Round(scaled);
+
+		INT best = 0;
+		FLOAT bestError = FLT_MAX;
+		for (INT stored = guess - 1; stored <= guess + 1; ++stored) {
+			const INT clamped = Clamp(stored, 0, maxStored);
+			const INT expanded = Expand(pBit >= 0 ? (clamped << 1) | pBit : clamped, total);
+			const FLOAT error = std::fabs(static_cast<FLOAT>(expanded) - value);
+			if (error < bestError) {
+				bestError = error;
+				best = clamped;
+			}
+		}
+
+		return best;
+	}
+
+	struct Bc7Block {
+		UINT Mode;
+		UINT Partition;
+		UINT Rotation;
+		UINT IndexSelection;
+		// Stored endpoint values per subset, endpoint and channel.
+		INT Endpoints[3][2][4];
+		INT PBits[3][2];
+		UINT Indices[16];
+		UINT SecondaryIndices[16];
+		UINT Error;
+	};
+
+	// Decoded 8-bit endpoints of a subset of the block.
+	void DecodeBc7Endpoints(const Bc7Block& block, UINT subset, INT decoded[2][4]) {
+		const Bc7Mode& mode = Bc7Modes[block.Mode];
+		const BOOL hasPBits = mode.EndpointPBits || mode.SharedPBits;
+
+		for (UINT e = 0; e < 2; ++e) {
+			for (UINT c = 0; c < 4; ++c) {
+				const UINT bits = c < 3 ? mode.ColorBits : mode.AlphaBits;
+				if (bits == 0) {
+					decoded[e][c] = 255;
+					continue;
+				}
+
+				INT value = block.Endpoints[subset][e][c];
+				if (hasPBits) value = (value << 1) | block.PBits[subset][e];
+
+				decoded[e][c] = Expand(value, bits + (hasPBits ? 1 : 0));
+			}
+		}
+	}
+
+	// Squared error of the texel against the palette entry between the endpoints at the weight,
+	// over the channels in [first, last).
+	__forceinline UINT TexelError(const BYTE* texel, const INT endpoints[2][4], UINT weight, UINT first, UINT last) {
+		UINT error = 0;
+		for (UINT c = first; c < last; ++c) {
+			const INT d = Interpolate(endpoints[0][c], endpoints[1][c], weight) - texel[c];
+			error += static_cast<UINT>(d * d);
+		}
+		return error;
+	}
+
+	// Nearest palette entries over the channels in [first, last) for the texels of a subset.
+	UINT AssignBc7Indices(
+			const BYTE* texels,
+			const BYTE* subsets,
+			UINT subset,
+			const INT endpoints[2][4],
+			UINT indexBits,
+			UINT first,
+			UINT last,
+			UINT* indices) {
+		const UINT* weights = GetWeights(indexBits);
+		const UINT count = 1u << indexBits;
+
+		UINT total = 0;
+		for (UINT i = 0; i < 16; ++i) {
+			if (subsets[i] != subset) continue;
+
+			UINT bestIndex = 0;
+			UINT bestError = UINT_MAX;
+			for (UINT p = 0; p < count; ++p) {
+				const UINT error = TexelError(texels + i * 4, endpoints, weights[p], first, last);
+				if (error < bestError) {
+					bestError = error;
+					bestIndex = p;
+				}
+			}
+
+			indices[i] = bestIndex;
+			total += bestError;
+		}
+
+		return total;
+	}
+
+	// Quantizes the subset endpoints of a mode without rotation under every p-bit choice and keeps
+	// the one whose indices give the least error.
+	UINT QuantizeBc7Subset(const BYTE* texels, const BYTE* subsets, UINT subset, FXMVECTOR e0, FXMVECTOR e1, Bc7Block& block) {
+		const Bc7Mode& mode = Bc7Modes[block.Mode];
+		const UINT pBitChoices = mode.EndpointPBits ? 4 : mode.SharedPBits ? 2 : 1;
+
+		XMFLOAT4 ends[2];
+		XMStoreFloat4(&ends[0], XMVectorClamp(e0, XMVectorZero(), XMVectorReplicate(255.f)));
+		XMStoreFloat4(&ends[1], XMVectorClamp(e1, XMVectorZero(), XMVectorReplicate(255.f)));
+
+		UINT bestError = UINT_MAX;
+		INT bestEndpoints[2][4] = {};
+		INT bestPBits[2] = {};
+		UINT bestIndices[16] = {};
+
+		for (UINT choice = 0; choice < pBitChoices; ++choice) {
+			INT pBits[2] = { -1, -1 };
+			if (mode.EndpointPBits) {
+				pBits[0] = choice & 1;
+				pBits[1] = choice >> 1;
+			}
+			else if (mode.SharedPBits) {
+				pBits[0] = pBits[1] = choice;
+			}
+
+			for (UINT e = 0; e < 2; ++e) {
+				const FLOAT* values = &ends[e].x;
+				for (UINT c = 0; c < 4; ++c) {
+					const UINT bits = c < 3 ? mode.ColorBits : mode.AlphaBits;
+					block.Endpoints[subset][e][c] = bits > 0 ? QuantizeChannel(values[c], bits, pBits[e]) : 0;
+				}
+				block.PBits[subset][e] = std::max(pBits[e], 0);
+			}
+
+			INT decoded[2][4];
+			DecodeBc7Endpoints(block, subset, decoded);
+
+			UINT indices[16];
+			const UINT error = AssignBc7Indices(texels, subsets, subset, decoded, mode.IndexBits, 0, 4, indices);
+			if (error < bestError) {
+				bestError = error;
+				std::memcpy(bestEndpoints, block.Endpoints[subset], sizeof(bestEndpoints));
+				bestPBits[0] = block.PBits[subset][0];
+				bestPBits[1] = block.PBits[subset][1];
+				for (UINT i = 0; i < 16; ++i) {
+					if (subsets[i] == subset) bestIndices[i] = indices[i];
+				}
+			}
+		}
+
+		std::memcpy(block.Endpoints[subset], bestEndpoints, sizeof(bestEndpoints));
+		block.PBits[subset][0] = bestPBits[0];
+		block.PBits[subset][1] = bestPBits[1];
+		for (UINT i = 0; i < 16; ++i) {
+			if (subsets[i] == subset) block.Indices[i] = bestIndices[i];
+		}
+
+		return bestError;
+	}
+
+	// Encodes the block with a mode without rotation (0, 1, 2, 3, 6 or 7) and the given partition.
+	void EncodeBc7Partitioned(const BYTE* texels, UINT modeIndex, UINT partition, UINT passes, Bc7Block& block) {
+		const Bc7Mode& mode = Bc7Modes[modeIndex];
+
+		block.Mode = modeIndex;
+		block.Partition = partition;
+		block.Rotation = 0;
+		block.IndexSelection = 0;
+		block.Error = 0;
+		std::memset(block.Endpoints, 0, sizeof(block.Endpoints));
+		std::memset(block.PBits, 0, sizeof(block.PBits));
+
+		BYTE subsets[16];
+		for (UINT i = 0; i < 16; ++i)
+			subsets[i] = static_cast<BYTE>(SubsetOf(mode.Subsets, partition, i));
+
+		const UINT* weights = GetWeights(mode.IndexBits);
+		const UINT maxIndex = (1u << mode.IndexBits) - 1;
+
+		for (UINT s = 0; s < mode.Subsets; ++s) {
+			XMVECTOR points[16];
+			UINT count = 0;
+			for (UINT i = 0; i < 16; ++i) {
+				if (subsets[i] == s) points[count++] = LoadTexel(texels + i * 4);
+			}
+
+			XMVECTOR e0, e1;
+			FitEndpoints(points, count, e0, e1);
+
+			UINT error = QuantizeBc7Subset(texels, subsets, s, e0, e1, block);
+
+			for (UINT pass = 0; pass < passes && error > 0; ++pass) {
+				FLOAT t[16];
+				UINT n = 0;
+				for (UINT i = 0; i < 16; ++i) {
+					if (subsets[i] == s) t[n++] = weights[block.Indices[i]] / 64.f;
+				}
+				if (!SolveEndpoints(points, t, count, e0, e1)) break;
+
+				Bc7Block trial = block;
+				const UINT trialError = QuantizeBc7Subset(texels, subsets, s, e0, e1, trial);
+				if (trialError >= error) break;
+
+				block = trial;
+				error = trialError;
+			}
+
+			// The anchor index is stored without its high bit, so it must be in the lower half.
+			const UINT anchor = AnchorOf(mode.Subsets, partition, s);
+			if (block.Indices[anchor] > maxIndex / 2) {
+				std::swap(block.Endpoints[s][0], block.Endpoints[s][1]);
+				std::swap(block.PBits[s][0], block.PBits[s][1]);
+				for (UINT i = 0; i < 16; ++i) {
+					if (subsets[i] == s) block.Indices[i] = maxIndex - block.Indices[i];
+				}
+			}
+
+			block.Error += error;
+		}
+	}
+
+	// Encodes the block with mode 4 or 5, which code color and alpha with separate indices after
+	// swapping alpha with the channel the rotation selects.
+	void EncodeBc7Rotated(const BYTE* texels, UINT modeIndex, UINT rotation, UINT indexSelection, UINT passes, Bc7Block& block) {
+		const Bc7Mode& mode = Bc7Modes[modeIndex];
+
+		block.Mode = modeIndex;
+		block.Partition = 0;
+		block.Rotation = rotation;
+		block.IndexSelection = indexSelection;
+		std::memset(block.Endpoints, 0, sizeof(block.Endpoints));
+		std::memset(block.PBits, 0, sizeof(block.PBits));
+
+		BYTE rotated[64];
+		std::memcpy(rotated, texels, sizeof(rotated));
+		if (rotation > 0) {
+			for (UINT i = 0; i < 16; ++i)
+				std::swap(rotated[i * 4 + rotation - 1], rotated[i * 4 + 3]);
+		}
+
+		const UINT colorIndexBits = indexSelection ? mode.SecondaryIndexBits : mode.IndexBits;
+		const UINT alphaIndexBits = indexSelection ? mode.IndexBits : mode.SecondaryIndexBits;
+
+		UINT* colorIndices = indexSelection ? block.SecondaryIndices : block.Indices;
+		UINT* alphaIndices = indexSelection ? block.Indices : block.SecondaryIndices;
+
+		const BYTE subsets[16] = {};
+
+		XMVECTOR points[16];
+		for (UINT i = 0; i < 16; ++i)
+			points[i] = XMVectorSetW(LoadTexel(rotated + i * 4), 0.f);
+
+		// Color endpoints.
+		XMVECTOR e0, e1;
+		FitEndpoints(points, 16, e0, e1);
+
+		auto quantizeColor = [&](FXMVECTOR a, FXMVECTOR b, INT endpoints[2][4], UINT* indices) {
+			XMFLOAT4 ends[2];
+			XMStoreFloat4(&ends[0], XMVectorClamp(a, XMVectorZero(), XMVectorReplicate(255.f)));
+			XMStoreFloat4(&ends[1], XMVectorClamp(b, XMVectorZero(), XMVectorReplicate(255.f)));
+
+			INT decoded[2][4] = {};
+			for (UINT e = 0; e < 2; ++e) {
+				const FLOAT* values = &ends[e].x;
+				for (UINT c = 0; c < 3; ++c) {
+					endpoints[e][c] = QuantizeChannel(values[c], mode.ColorBits, -1);
+					decoded[e][c] = Expand(endpoints[e][c], mode.ColorBits);
+				}
+			}
+			return AssignBc7Indices(rotated, subsets, 0, decoded, colorIndexBits, 0, 3, indices);
+		};
+
+		UINT colorError = quantizeColor(e0, e1, block.Endpoints[0], colorIndices);
+		const UINT* colorWeights = GetWeights(colorIndexBits);
+
+		for (UINT pass = 0; pass < passes && colorError > 0; ++pass) {
+			FLOAT t[16];
+			for (UINT i = 0; i < 16; ++i)
+				t[i] = colorWeights[colorIndices[i]] / 64.f;
+			if (!SolveEndpoints(points, t, 16, e0, e1)) break;
+
+			INT endpoints[2][4];
+			UINT indices[16];
+			const UINT error = quantizeColor(e0, e1, endpoints, indices);
+			if (error >= colorError) break;
+
+			colorError = error;
+			for (UINT e = 0; e < 2; ++e) {
+				for (UINT c = 0; c < 3; ++c)
+					block.Endpoints[0][e][c] = endpoints[e][c];
+			}
+			std::memcpy(colorIndices, indices, sizeof(indices));
+		}
+
+		// Alpha endpoints, fitted along the one remaining channel.
+		INT alphaMin = 255, alphaMax = 0;
+		for (UINT i = 0; i < 16; ++i) {
+			alphaMin = std::min<INT>(alphaMin, rotated[i * 4 + 3]);
+			alphaMax = std::max<INT>(alphaMax, rotated[i * 4 + 3]);
+		}
+
+		auto quantizeAlpha = [&](FLOAT a, FLOAT b, INT endpoints[2], UINT* indices) {
+			INT decoded[2][4] = {};
+			endpoints[0] = QuantizeChannel(std::min(std::max(a, 0.f), 255.f), mode.AlphaBits, -1);
+			endpoints[1] = QuantizeChannel(std::min(std::max(b, 0.f), 255.f), mode.AlphaBits, -1);
+			decoded[0][3] = Expand(endpoints[0], mode.AlphaBits);
+			decoded[1][3] = Expand(endpoints[1], mode.AlphaBits);
+			return AssignBc7Indices(rotated, subsets, 0, decoded, alphaIndexBits, 3, 4, indices);
+		};
+
+		INT alphaEndpoints[2];
+		UINT alphaError = quantizeAlpha(static_cast<FLOAT>(alphaMin), static_cast<FLOAT>(alphaMax), alphaEndpoints, alphaIndices);
+		const UINT* alphaWeights = GetWeights(alphaIndexBits);
+
+		for (UINT pass = 0; pass < passes && alphaError > 0; ++pass) {
+			FLOAT aa = 0.f, bb = 0.f, ab = 0.f, ax = 0.f, bx = 0.f;
+			for (UINT i = 0; i < 16; ++i) {
+				const FLOAT b = alphaWeights[alphaIndices[i]] / 64.f;
+				const FLOAT a = 1.f - b;
+				const FLOAT x = rotated[i * 4 + 3];
+				aa += a * a;
+				bb += b * b;
+				ab += a * b;
+				ax += a * x;
+				bx += b * x;
+			}
+
+			const FLOAT det = aa * bb - ab * ab;
+			if (std::fabs(det) < 1e-6f) break;
+
+			INT endpoints[2];
+			UINT indices[16];
+			const UINT error = quantizeAlpha((ax * bb - bx * ab) / det, (bx * aa - ax * ab) / det, endpoints, indices);
+			if (error >= alphaError) break;
+
+			alphaError = error;
+			alphaEndpoints[0] = endpoints[0];
+			alphaEndpoints[1] = endpoints[1];
+			std::memcpy(alphaIndices, indices, sizeof(indices));
+		}
+
+		block.Endpoints[0][0][3] = alphaEndpoints[0];
+		block.Endpoints[0][1][3] = alphaEndpoints[1];
+
+		// Both index sets are anchored at texel 0.
+		const UINT maxColorIndex = (1u << colorIndexBits) - 1;
+		if (colorIndices[0] > maxColorIndex / 2) {
+			for (UINT c = 0; c < 3; ++c)
+				std::swap(block.Endpoints[0][0][c], block.Endpoints[0][1][c]);
+			for (UINT i = 0; i < 16; ++i)
+				colorIndices[i] = maxColorIndex - colorIndices[i];
+		}
+
+		const UINT maxAlphaIndex = (1u << alphaIndexBits) - 1;
+		if (alphaIndices[0] > maxAlphaIndex / 2) {
+			std::swap(block.Endpoints[0][0][3], block.Endpoints[0][1][3]);
+			for (UINT i = 0; i < 16; ++i)
+				alphaIndices[i] = maxAlphaIndex - alphaIndices[i];
+		}
+
+		block.Error = colorError + alphaError;
+	}
+
+	void WriteBc7Block(const Bc7Block& block, BYTE* output) {
+		const Bc7Mode& mode = Bc7Modes[block.Mode];
+
+		BitWriter writer(output, 16);
+		writer.Write(1u << block.Mode, block.Mode + 1);
+		writer.Write(block.Partition, mode.PartitionBits);
+		writer.Write(block.Rotation, mode.RotationBits);
+		writer.Write(block.IndexSelection, mode.IndexSelectionBits);
+
+		for (UINT c = 0; c < 3; ++c) {
+			for (UINT s = 0; s < mode.Subsets; ++s) {
+				writer.Write(block.Endpoints[s][0][c], mode.ColorBits);
+				writer.Write(block.Endpoints[s][1][c], mode.ColorBits);
+			}
+		}
+		if (mode.AlphaBits > 0) {
+			for (UINT s = 0; s < mode.Subsets; ++s) {
+				writer.Write(block.Endpoints[s][0][3], mode.AlphaBits);
+				writer.Write(block.Endpoints[s][1][3], mode.AlphaBits);
+			}
+		}
+
+		for (UINT s = 0; s < mode.Subsets; ++s) {
+			if (mode.EndpointPBits) {
+				writer.Write(block.PBits[s][0], 1);
+				writer.Write(block.PBits[s][1], 1);
+			}
+			else if (mode.SharedPBits) {
+				writer.Write(block.PBits[s][0], 1);
+			}
+		}
+
+		for (UINT i = 0; i < 16; ++i) {
+			const UINT subset = SubsetOf(mode.Subsets, block.Partition, i);
+			const BOOL anchor = AnchorOf(mode.Subsets, block.Partition, subset) == i;
+			writer.Write(block.Indices[i], mode.IndexBits - (anchor ? 1 : 0));
+		}
+		if (mode.SecondaryIndexBits > 0) {
+			for (UINT i = 0; i < 16; ++i)
+				writer.Write(block.SecondaryIndices[i], mode.SecondaryIndexBits - (i == 0 ? 1 : 0));
+		}
+	}
+
+	// Partitions sorted by how well their subsets fit a line each, which approximates the error
+	// the subsets will have once encoded.
+	void RankPartitions(const BYTE* texels, UINT subsets, UINT partitionCount, BOOL withAlpha, UINT* ranked) {
+		XMVECTOR all[16];
+		for (UINT i = 0; i < 16; ++i) {
+			all[i] = LoadTexel(texels + i * 4);
+			if (!withAlpha) all[i] = XMVectorSetW(all[i], 0.f);
+		}
+
+		FLOAT residuals[64];
+		for (UINT p = 0; p < partitionCount; ++p) {
+			residuals[p] = 0.f;
+			for (UINT s = 0; s < subsets; ++s) {
+				XMVECTOR points[16];
+				UINT count = 0;
+				for (UINT i = 0; i < 16; ++i) {
+					if (SubsetOf(subsets, p, i) == s) points[count++] = all[i];
+				}
+
+				XMVECTOR mean, axis;
+				residuals[p] += FitLine(points, count, mean, axis);
+			}
+			ranked[p] = p;
+		}
+
+		std::stable_sort(ranked, ranked + partitionCount, [&](UINT a, UINT b) { return residuals[a] < residuals[b]; });
+	}
+
+	//
+	// BC6H
+	//
+
+	namespace Bc6h {
+		// Endpoint fields: W and X are the ends of the first region, Y and Z those of the second. D is the partition.
+		enum Field {
+			RW = 0, GW, BW,
+			RX, GX, BX,
+			RY, GY, BY,
+			RZ, GZ, BZ,
+			D
+		};
+
+		// Bits High down to Low of a field in the notation of the format specification. They are
+		// stored starting with bit Low, so a range such as rw[10:11] is stored in reverse.
+		struct Bits {
+			BYTE Field;
+			BYTE High;
+			BYTE Low;
+		};
+
+		const Bits Layout1[] = {
+			{ GY, 4, 4 }, { BY, 4, 4 }, { BZ, 4, 4 }, { RW, 9, 0 }, { GW, 9, 0 }, { BW, 9, 0 }, { RX, 4, 0 }, { GZ, 4, 4 },
+			{ GY, 3, 0 }, { GX, 4, 0 }, { BZ, 0, 0 }, { GZ, 3, 0 }, { BX, 4, 0 }, { BZ, 1, 1 }, { BY, 3, 0 }, { RY, 4, 0 },
+			{ BZ, 2, 2 }, { RZ, 4, 0 }, { BZ, 3, 3 }, { D, 4, 0 }
+		};
+		const Bits Layout2[] = {
+			{ GY, 5, 5 }, { GZ, 4, 4 }, { GZ, 5, 5 }, { RW, 6, 0 }, { BZ, 0, 0 }, { BZ, 1, 1 }, { BY, 4, 4 }, { GW, 6, 0 },
+			{ BY, 5, 5 }, { BZ, 2, 2 }, { GY, 4, 4 }, { BW, 6, 0 }, { BZ, 3, 3 }, { BZ, 5, 5 }, { BZ, 4, 4 }, { RX, 5, 0 },
+			{ GY, 3, 0 }, { GX, 5, 0 }, { GZ, 3, 0 }, { BX, 5, 0 }, { BY, 3, 0 }, { RY, 5, 0 }, { RZ, 5, 0 }, { D, 4, 0 }
+		};
+		const Bits Layout3[] = {
+			{ RW, 9, 0 }, { GW, 9, 0 }, { BW, 9, 0 }, { RX, 4, 0 }, { RW, 10, 10 }, { GY, 3, 0 }, { GX, 3, 0 }, { GW, 10, 10 },
+			{ BZ, 0, 0 }, { GZ, 3, 0 }, { BX, 3, 0 }, { BW, 10, 10 }, { BZ, 1, 1 }, { BY, 3, 0 }, { RY, 4, 0 }, { BZ, 2, 2 },
+			{ RZ, 4, 0 }, { BZ, 3, 3 }, { D, 4, 0 }
+		};
+		const Bits Layout4[] = {
+			{ RW, 9, 0 }, { GW, 9, 0 }, { BW, 9, 0 }, { RX, 3, 0 }, { RW, 10, 10 }, { GZ, 4, 4 }, { GY, 3, 0 }, { GX, 4, 0 },
+			{ GW, 10, 10 }, { GZ, 3, 0 }, { BX, 3, 0 }, { BW, 10, 10 }, { BZ, 1, 1 }, { BY, 3, 0 }, { RY, 3, 0 }, { BZ, 0, 0 },
+			{ BZ, 2, 2 }, { RZ, 3, 0 }, { GY, 4, 4 }, { BZ, 3, 3 }, { D, 4, 0 }
+		};
+		const Bits Layout5[] = {
+			{ RW, 9, 0 }, { GW, 9, 0 }, { BW, 9, 0 }, { RX, 3, 0 }, { RW, 10, 10 }, { BY, 4, 4 }, { GY, 3, 0 }, { GX, 3, 0 },
+			{ GW, 10, 10 }, { BZ, 0, 0 }, { GZ, 3, 0 }, { BX, 4, 0 }, { BW, 10, 10 }, { BY, 3, 0 }, { RY, 3, 0 }, { BZ, 1, 1 },
+			{ BZ, 2, 2 }, { RZ, 3, 0 }, { BZ, 4, 4 }, { BZ, 3, 3 }, { D, 4, 0 }
+		};
+		const Bits Layout6[] = {
+			{ RW, 8, 0 }, { BY, 4, 4 }, { GW, 8, 0 }, { GY, 4, 4 }, { BW, 8, 0 }, { BZ, 4, 4 }, { RX, 4, 0 }, { GZ, 4, 4 },
+			{ GY, 3, 0 }, { GX, 4, 0 }, { BZ, 0, 0 }, { GZ, 3, 0 }, { BX, 4, 0 }, { BZ, 1, 1 }, { BY, 3, 0 }, { RY, 4, 0 },
+			{ BZ, 2, 2 }, { RZ, 4, 0 }, { BZ, 3, 3 }, { D, 4, 0 }
+		};
+		const Bits Layout7[] = {
+			{ RW, 7, 0 }, { GZ, 4, 4 }, { BY, 4, 4 }, { GW, 7, 0 }, { BZ, 2, 2 }, { GY, 4, 4 }, { BW, 7, 0 }, { BZ, 3, 3 },
+			{ BZ, 4, 4 }, { RX, 5, 0 }, { GY, 3, 0 }, { GX, 4, 0 }, { BZ, 0, 0 }, { GZ, 3, 0 }, { BX, 4, 0 }, { BZ, 1, 1 },
+			{ BY, 3, 0 }, { RY, 5, 0 }, { RZ, 5, 0 }, { D, 4, 0 }
+		};
+		const Bits Layout8[] = {
+			{ RW, 7, 0 }, { BZ, 0, 0 }, { BY, 4, 4 }, { GW, 7, 0 }, { GY, 5, 5 }, { GY, 4, 4 }, { BW, 7, 0 }, { GZ, 5, 5 },
+			{ BZ, 4, 4 }, { RX, 4, 0 }, { GZ, 4, 4 }, { GY, 3, 0 }, { GX, 5, 0 }, { GZ, 3, 0 }, { BX, 4, 0 }, { BZ, 1, 1 },
+			{ BY, 3, 0 }, { RY, 4, 0 }, { BZ, 2, 2 }, { RZ, 4, 0 }, { BZ, 3, 3 }, { D, 4, 0 }
+		};
+		const Bits Layout9[] = {
+			{ RW, 7, 0 }, { BZ, 1, 1 }, { BY, 4, 4 }, { GW, 7, 0 }, { BY, 5, 5 }, { GY, 4, 4 }, { BW, 7, 0 }, { BZ, 5, 5 },
+			{ BZ, 4, 4 }, { RX, 4, 0 }, { GZ, 4, 4 }, { GY, 3, 0 }, { GX, 4, 0 }, { BZ, 0, 0 }, { GZ, 3, 0 }, { BX, 5, 0 },
+			{ BY, 3, 0 }, { RY, 4, 0 }, { BZ, 2, 2 }, { RZ, 4, 0 }, { BZ, 3, 3 }, { D, 4, 0 }
+		};
+		const Bits Layout10[] = {
+			{ RW, 5, 0 }, { GZ, 4, 4 }, { BZ, 0, 0 }, { BZ, 1, 1 }, { BY, 4, 4 }, { GW, 5, 0 }, { GY, 5, 5 }, { BY, 5, 5 },
+			{ BZ, 2, 2 }, { GY, 4, 4 }, { BW, 5, 0 }, { GZ, 5, 5 }, { BZ, 3, 3 }, { BZ, 5, 5 }, { BZ, 4, 4 }, { RX, 5, 0 },
+			{ GY, 3, 0 }, { GX, 5, 0 }, { GZ, 3, 0 }, { BX, 5, 0 }, { BY, 3, 0 }, { RY, 5, 0 }, { RZ, 5, 0 }, { D, 4, 0 }
+		};
+		const Bits Layout11[] = {
+			{ RW, 9, 0 }, { GW, 9, 0 }, { BW, 9, 0 }, { RX, 9, 0 }, { GX, 9, 0 }, { BX, 9, 0 }
+		};
+		const Bits Layout12[] = {
+			{ RW, 9, 0 }, { GW, 9, 0 }, { BW, 9, 0 }, { RX, 8, 0 }, { RW, 10, 10 }, { GX, 8, 0 }, { GW, 10, 10 }, { BX, 8, 0 },
+			{ BW, 10, 10 }
+		};
+		const Bits Layout13[] = {
+			{ RW, 9, 0 }, { GW, 9, 0 }, { BW, 9, 0 }, { RX, 7, 0 }, { RW, 10, 11 }, { GX, 7, 0 }, { GW, 10, 11 }, { BX, 7, 0 },
+			{ BW, 10, 11 }
+		};
+		const Bits Layout14[] = {
+			{ RW, 9, 0 }, { GW, 9, 0 }, { BW, 9, 0 }, { RX, 3, 0 }, { RW, 10, 15 }, { GX, 3, 0 }, { GW, 10, 15 }, { BX, 3, 0 },
+			{ BW, 10, 15 }
+		};
+
+		struct Mode {
+			UINT Code;
+			UINT CodeBits;
+			BOOL TwoRegions;
+			BOOL Transformed;
+			UINT EndpointBits;
+			UINT DeltaBits[3];
+			const Bits* Layout;
+			UINT LayoutCount;
+		};
+
+#define BC6H_LAYOUT(layout) layout, static_cast<UINT>(sizeof(layout) / sizeof(layout[0]))
+		const Mode Modes[14] = {
+			{ 0x00, 2, TRUE,  TRUE,  10, { 5, 5, 5 },    BC6H_LAYOUT(Layout1) },
+			{ 0x01, 2, TRUE,  TRUE,   7, { 6, 6, 6 },    BC6H_LAYOUT(Layout2) },
+			{ 0x02, 5, TRUE,  TRUE,  11, { 5, 4, 4 },    BC6H_LAYOUT(Layout3) },
+			{ 0x06, 5, TRUE,  TRUE,  11, { 4, 5, 4 },    BC6H_LAYOUT(Layout4) },
+			{ 0x0A, 5, TRUE,  TRUE,  11, { 4, 4, 5 },    BC6H_LAYOUT(Layout5) },
+			{ 0x0E, 5, TRUE,  TRUE,   9, { 5, 5, 5 },    BC6H_LAYOUT(Layout6) },
+			{ 0x12, 5, TRUE,  TRUE,   8, { 6, 5, 5 },    BC6H_LAYOUT(Layout7) },
+			{ 0x16, 5, TRUE,  TRUE,   8, { 5, 6, 5 },    BC6H_LAYOUT(Layout8) },
+			{ 0x1A, 5, TRUE,  TRUE,   8, { 5, 5, 6 },    BC6H_LAYOUT(Layout9) },
+			{ 0x1E, 5, TRUE,  FALSE,  6, { 6, 6, 6 },    BC6H_LAYOUT(Layout10) },
+			{ 0x03, 5, FALSE, FALSE, 10, { 10, 10, 10 }, BC6H_LAYOUT(Layout11) },
+			{ 0x07, 5, FALSE, TRUE,  11, { 9, 9, 9 },    BC6H_LAYOUT(Layout12) },
+			{ 0x0B, 5, FALSE, TRUE,  12, { 8, 8, 8 },    BC6H_LAYOUT(Layout13) },
+			{ 0x0F, 5, FALSE, TRUE,  16, { 4, 4, 4 },    BC6H_LAYOUT(Layout14) }
+		};
+#undef BC6H_LAYOUT
+
+		const UINT FirstOneRegionMode = 10;
+		const UINT PartitionCount = 32;
+
+		__forceinline INT SignExtend(INT value, UINT bits) {
+			const INT shift = 32 - static_cast<INT>(bits);
+			return static_cast<INT>(static_cast<UINT>(value) << shift) >> shift;
+		}
+
+		INT Unquantize(INT value, UINT bits, BOOL isSigned) {
+			if (!isSigned) {
+				if (bits >= 15 || value == 0) return value;
+				if (value == (1 << bits) - 1) return 0xFFFF;
+				return ((value << 15) + 0x4000) >> (bits - 1);
+			}
+
+			if (bits >= 16) return value;
+
+			const BOOL negative = value < 0;
+			if (negative) value = -value;
+
+			INT result;
+			if (value == 0) result = 0;
+			else if (value >= (1 << (bits - 1)) - 1) result = 0x7FFF;
+			else result = ((value << 15) + 0x4000) >> (bits - 1);
+
+			return negative ? -result : result;
+		}
+
+		// Maps an interpolated value to the bits of the half float it stands for.
+		USHORT Finalize(INT value, BOOL isSigned) {
+			if (!isSigned) return static_cast<USHORT>((value * 31) >> 6);
+			if (value < 0) return static_cast<USHORT>(0x8000 | (((-value) * 31) >> 5));
+			return static_cast<USHORT>((value * 31) >> 5);
+		}
+
+		// Unquantized endpoints from the stored fields: applies the delta transform and sign extension.
+		void ReconstructEndpoints(const Mode& mode, const INT stored[4][3], BOOL isSigned, INT endpoints[4][3]) {
+			const UINT count = mode.TwoRegions ? 4 : 2;
+			const INT mask = (1 << mode.EndpointBits) - 1;
+
+			for (UINT c = 0; c < 3; ++c) {
+				const INT base = isSigned ? SignExtend(stored[0][c], mode.EndpointBits) : stored[0][c];
+				endpoints[0][c] = Unquantize(base, mode.EndpointBits, isSigned);
+
+				for (UINT e = 1; e < count; ++e) {
+					INT value = stored[e][c];
+					if (mode.Transformed) {
+						value = (stored[0][c] + SignExtend(value, mode.DeltaBits[c])) & mask;
+						if (isSigned) value = SignExtend(value, mode.EndpointBits);
+					}
+					else if (isSigned) {
+						value = SignExtend(value, mode.EndpointBits);
+					}
+
+					endpoints[e][c] = Unquantize(value, mode.EndpointBits, isSigned);
+				}
+			}
+		}
+
+		// Quantized value of an unsigned unquantized endpoint channel.
+		INT Quantize(FLOAT value, UINT bits) {
+			const INT maxValue = (1 << bits) - 1;
+			const INT guess = static_cast<INT>(value * static_cast<FLOAT>(1 << bits) / 65536.f);
+
+			INT best = 0;
+			FLOAT bestError = FLT_MAX;
+			for (INT q = guess - 1; q <= guess + 1; ++q) {
+				const INT clamped = Clamp(q, 0, maxValue);
+				const FLOAT error = std::fabs(static_cast<FLOAT>(Unquantize(clamped, bits, FALSE)) - value);
+				if (error < bestError) {
+					bestError = error;
+					best = clamped;
+				}
+			}
+
+			return best;
+		}
+
+		struct Block {
+			UINT Mode;
+			UINT Partition;
+			INT Stored[4][3];
+			UINT Indices[16];
+			FLOAT Error;
+		};
+
+		// Picks the indices of the texels of a region against its unquantized endpoints. The anchor
+		// texel is limited to the lower half of the palette since its high bit is not stored.
+		FLOAT AssignIndices(
+				const FLOAT* values,
+				UINT partition,
+				BOOL twoRegions,
+				UINT region,
+				const INT endpoints[2][3],
+				UINT* indices) {
+			const UINT indexBits = twoRegions ? 3 : 4;
+			const UINT* weights = GetWeights(indexBits);
+			const UINT count = 1u << indexBits;
+			const UINT anchor = twoRegions ? AnchorOf(2, partition, region) : 0;
+
+			FLOAT palette[16][3];
+			for (UINT p = 0; p < count; ++p) {
+				for (UINT c = 0; c < 3; ++c)
+					palette[p][c] = static_cast<FLOAT>(Interpolate(endpoints[0][c], endpoints[1][c], weights[p]));
+			}
+
+			FLOAT total = 0.f;
+			for (UINT i = 0; i < 16; ++i) {
+				if (twoRegions && SubsetOf(2, partition, i) != region) continue;
+
+				const FLOAT* texel = values + i * 3;
+				const UINT limit = i == anchor ? count / 2 : count;
+
+				UINT bestIndex = 0;
+				FLOAT bestError = FLT_MAX;
+				for (UINT p = 0; p < limit; ++p) {
+					const FLOAT dr = palette[p][0] - texel[0];
+					const FLOAT dg = palette[p][1] - texel[1];
+					const FLOAT db = palette[p][2] - texel[2];
+					const FLOAT error = dr * dr + dg * dg + db * db;
+					if (error < bestError) {
+						bestError = error;
+						bestIndex = p;
+					}
+				}
+
+				indices[i] = bestIndex;
+				total += bestError;
+			}
+
+			return total;
+		}
+
+		// Encodes fitted unquantized endpoints (two per region) with the mode. Deltas that do not fit
+		// are clamped, which the index search then accounts for.
+		void EncodeWithMode(const FLOAT* values, UINT modeIndex, UINT partition, const FLOAT ends[4][3], Block& block) {
+			const Mode& mode = Modes[modeIndex];
+			const UINT count = mode.TwoRegions ? 4 : 2;
+
+			block.Mode = modeIndex;
+			block.Partition = mode.TwoRegions ? partition : 0;
+
+			INT quantized[4][3];
+			for (UINT e = 0; e < count; ++e) {
+				for (UINT c = 0; c < 3; ++c)
+					quantized[e][c] = Quantize(ends[e][c], mode.EndpointBits);
+			}
+
+			std::memset(block.Stored, 0, sizeof(block.Stored));
+			for (UINT c = 0; c < 3; ++c) {
+				block.Stored[0][c] = quantized[0][c];
+
+				for (UINT e = 1; e < count; ++e) {
+					if (!mode.Transformed) {
+						block.Stored[e][c] = quantized[e][c];
+						continue;
+					}
+
+					const INT limit = 1 << (mode.DeltaBits[c] - 1);
+					const INT delta = Clamp(quantized[e][c] - quantized[0][c], -limit, limit - 1);
+					block.Stored[e][c] = delta & ((1 << mode.DeltaBits[c]) - 1);
+				}
+			}
+
+			INT endpoints[4][3];
+			ReconstructEndpoints(mode, block.Stored, FALSE, endpoints);
+
+			block.Error = AssignIndices(values, block.Partition, mode.TwoRegions, 0, endpoints, block.Indices);
+			if (mode.TwoRegions) block.Error += AssignIndices(values, block.Partition, TRUE, 1, endpoints + 2, block.Indices);
+		}
+
+		void Write(const Block& block, BYTE* output) {
+			const Mode& mode = Modes[block.Mode];
+
+			BitWriter writer(output, 16);
+			writer.Write(mode.Code, mode.CodeBits);
+
+			for (UINT i = 0; i < mode.LayoutCount; ++i) {
+				const Bits& bits = mode.Layout[i];
+				const UINT value = bits.Field == D ? block.Partition : static_cast<UINT>(block.Stored[bits.Field / 3][bits.Field % 3]);
+
+				if (bits.High >= bits.Low) {
+					for (INT b = bits.Low; b <= bits.High; ++b)
+						writer.Write(value >> b, 1);
+				}
+				else {
+					for (INT b = bits.Low; b >= bits.High; --b)
+						writer.Write(value >> b, 1);
+				}
+			}
+
+			for (UINT i = 0; i < 16; ++i) {
+				const UINT indexBits = mode.TwoRegions ? 3 : 4;
+				const BOOL anchor = i == 0 || (mode.TwoRegions && i == Anchors2[block.Partition]);
+				writer.Write(block.Indices[i], indexBits - (anchor ? 1 : 0));
+			}
+		}
+
+		// Fits a region along its principal axis, oriented so that the anchor texel is nearer the first end.
+		void FitRegion(const FLOAT* values, UINT partition, BOOL twoRegions, UINT region, FLOAT e0[3], FLOAT e1[3]) {
+			XMVECTOR points[16];
+			UINT count = 0;
+			for (UINT i = 0; i < 16; ++i) {
+				if (twoRegions && SubsetOf(2, partition, i) != region) continue;
+				points[count++] = XMVectorSet(values[i * 3], values[i * 3 + 1], values[i * 3 + 2], 0.f);
+			}
+
+			XMVECTOR a, b;
+			FitEndpoints(points, count, a, b);
+
+			const UINT anchor = twoRegions ? AnchorOf(2, partition, region) : 0;
+			const XMVECTOR texel = XMVectorSet(values[anchor * 3], values[anchor * 3 + 1], values[anchor * 3 + 2], 0.f);
+			if (XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(texel, a))) > XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(texel, b))))
+				std::swap(a, b);
+
+			const XMVECTOR low = XMVectorZero();
+			const XMVECTOR high = XMVectorReplicate(65535.f);
+
+			XMFLOAT4 ends[2];
+			XMStoreFloat4(&ends[0], XMVectorClamp(a, low, high));
+			XMStoreFloat4(&ends[1], XMVectorClamp(b, low, high));
+
+			e0[0] = ends[0].x; e0[1] = ends[0].y; e0[2] = ends[0].z;
+			e1[0] = ends[1].x; e1[1] = ends[1].y; e1[2] = ends[1].z;
+		}
+
+		// Least-squares ends of a region for the weights its current indices select.
+		BOOL RefineRegion(const FLOAT* values, const Block& block, UINT region, FLOAT e0[3], FLOAT e1[3]) {
+			const Mode& mode = Modes[block.Mode];
+			const UINT* weights = GetWeights(mode.TwoRegions ? 3 : 4);
+
+			XMVECTOR points[16];
+			FLOAT t[16];
+			UINT count = 0;
+			for (UINT i = 0; i < 16; ++i) {
+				if (mode.TwoRegions && SubsetOf(2, block.Partition, i) != region) continue;
+				points[count] = XMVectorSet(values[i * 3], values[i * 3 + 1], values[i * 3 + 2], 0.f);
+				t[count] = weights[block.Indices[i]] / 64.f;
+				++count;
+			}
+
+			XMVECTOR a, b;
+			if (!SolveEndpoints(points, t, count, a, b)) return FALSE;
+
+			const XMVECTOR low = XMVectorZero();
+			const XMVECTOR high = XMVectorReplicate(65535.f);
+
+			XMFLOAT4 ends[2];
+			XMStoreFloat4(&ends[0], XMVectorClamp(a, low, high));
+			XMStoreFloat4(&ends[1], XMVectorClamp(b, low, high));
+
+			e0[0] = ends[0].x; e0[1] = ends[0].y; e0[2] = ends[0].z;
+			e1[0] = ends[1].x; e1[1] = ends[1].y; e1[2] = ends[1].z;
+
+			return TRUE;
+		}
+
+		// Tries the modes in [firstMode, lastMode) for the partition, refining the best fit.
+		void EncodePartition(const FLOAT* values, UINT partition, UINT firstMode, UINT lastMode, UINT passes, Block& best) {
+			const BOOL twoRegions = Modes[firstMode].TwoRegions;
+
+			FLOAT ends[4][3];
+			FitRegion(values, partition, twoRegions, 0, ends[0], ends[1]);
+			if (twoRegions) FitRegion(values, partition, TRUE, 1, ends[2], ends[3]);
+
+			for (UINT pass = 0; pass <= passes; ++pass) {
+				Block candidate;
+				Block passBest;
+				passBest.Error = FLT_MAX;
+
+				for (UINT m = firstMode; m < lastMode; ++m) {
+					EncodeWithMode(values, m, partition, ends, candidate);
+					if (candidate.Error < passBest.Error) passBest = candidate;
+				}
+
+				if (passBest.Error < best.Error) best = passBest;
+				if (pass == passes || passBest.Error <= 0.f) break;
+
+				BOOL refined = RefineRegion(values, passBest, 0, ends[0], ends[1]);
+				if (twoRegions) refined &= RefineRegion(values, passBest, 1, ends[2], ends[3]);
+				if (!refined) break;
+			}
+		}
+	}
+}
+
+void BlockCodec::EncodeBC1(const BYTE* texels, CompressionQuality::Type quality, BYTE* block) {
+	EncodeColorBlock(texels, quality, TRUE, block);
+}
+
+void BlockCodec::EncodeBC3(const BYTE* texels, CompressionQuality::Type quality, BYTE* block) {
+	EncodeBC4(texels, 3, quality, block);
+	EncodeColorBlock(texels, quality, FALSE, block + 8);
+}
+
+void BlockCodec::EncodeBC4(const BYTE* texels, UINT channel, CompressionQuality::Type quality, BYTE* block) {
+	INT values[16];
+	for (UINT i = 0; i < 16; ++i)
+		values[i] = texels[i * 4 + channel];
+
+	EncodeAlphaBlock(values, quality, block);
+}
+
+void BlockCodec::EncodeBC5(const BYTE* texels, CompressionQuality::Type quality, BYTE* block) {
+	EncodeBC4(texels, 0, quality, block);
+	EncodeBC4(texels, 1, quality, block + 8);
+}
+
+void BlockCodec::EncodeBC7(const BYTE* texels, CompressionQuality::Type quality, BYTE* block) {
+	BOOL opaque = TRUE;
+	for (UINT i = 0; i < 16; ++i)
+		opaque &= texels[i * 4 + 3] == 255;
+
+	const UINT passes = quality == CompressionQuality::E_Fast ? 1 : quality == CompressionQuality::E_Normal ? 2 : 3;
+
+	Bc7Block best;
+	EncodeBc7Partitioned(texels, 6, 0, passes, best);
+
+	auto tryBlock = [&](const Bc7Block& candidate) {
+		if (candidate.Error < best.Error) best = candidate;
+	};
+
+	if (quality != CompressionQuality::E_Fast && best.Error > 0) {
+		const BOOL high = quality == CompressionQuality::E_High;
+		Bc7Block candidate;
+
+		UINT ranked2[64];
+		RankPartitions(texels, 2, 64, !opaque, ranked2);
+
+		if (opaque) {
+			// Modes without alpha bits decode alpha as opaque.
+			for (UINT i = 0, end = high ? 6 : 2; i < end; ++i) {
+				EncodeBc7Partitioned(texels, 1, ranked2[i], passes, candidate);
+				tryBlock(candidate);
+			}
+			for (UINT i = 0, end = high ? 4 : 1; i < end; ++i) {
+				EncodeBc7Partitioned(texels, 3, ranked2[i], passes, candidate);
+				tryBlock(candidate);
+			}
+
+			if (high) {
+				UINT ranked3[64];
+				RankPartitions(texels, 3, 64, FALSE, ranked3);
+
+				for (UINT i = 0; i < 2; ++i) {
+					EncodeBc7Partitioned(texels, 2, ranked3[i], passes, candidate);
+					tryBlock(candidate);
+				}
+
+				// Mode 0 only addresses the first 16 three-subset partitions.
+				for (UINT i = 0, tried = 0; i < 64 && tried < 2; ++i) {
+					if (ranked3[i] >= 16) continue;
+					EncodeBc7Partitioned(texels, 0, ranked3[i], passes, candidate);
+					tryBlock(candidate);
+					++tried;
+				}
+
+				EncodeBc7Rotated(texels, 5, 0, 0, passes, candidate);
+				tryBlock(candidate);
+			}
+		}
+		else {
+			for (UINT rotation = 0, end = high ? 4 : 1; rotation < end; ++rotation) {
+				EncodeBc7Rotated(texels, 5, rotation, 0, passes, candidate);
+				tryBlock(candidate);
+
+				if (high) {
+					for (UINT selection = 0; selection < 2; ++selection) {
+						EncodeBc7Rotated(texels, 4, rotation, selection, passes, candidate);
+						tryBlock(candidate);
+					}
+				}
+			}
+			for (UINT i = 0, end = high ? 4 : 1; i < end; ++i) {
+				EncodeBc7Partitioned(texels, 7, ranked2[i], passes, candidate);
+				tryBlock(candidate);
+			}
+		}
+	}
+
+	WriteBc7Block(best, block);
+}
+
+void BlockCodec::EncodeBC6H(const FLOAT* texels, CompressionQuality::Type quality, BYTE* block) {
+	// Endpoints are fitted in the unquantized 16-bit domain the decoder interpolates in, in which
+	// the half float bits of a value are (x * 31) >> 6.
+	FLOAT values[48];
+	for (UINT i = 0; i < 16; ++i) {
+		for (UINT c = 0; c < 3; ++c) {
+			const FLOAT value = std::min(std::max(texels[i * 4 + c], 0.f), 65504.f);
+			values[i * 3 + c] = static_cast<FLOAT>(XMConvertFloatToHalf(value)) * 64.f / 31.f;
+		}
+	}
+
+	const UINT passes = quality == CompressionQuality::E_Fast ? 1 : quality == CompressionQuality::E_Normal ? 2 : 3;
+
+	Bc6h::Block best;
+	best.Error = FLT_MAX;
+	Bc6h::EncodePartition(values, 0, Bc6h::FirstOneRegionMode, 14, passes, best);
+
+	if (quality != CompressionQuality::E_Fast && best.Error > 0.f) {
+		XMVECTOR all[16];
+		for (UINT i = 0; i < 16; ++i)
+			all[i] = XMVectorSet(values[i * 3], values[i * 3 + 1], values[i * 3 + 2], 0.f);
+
+		FLOAT residuals[Bc6h::PartitionCount];
+		UINT ranked[Bc6h::PartitionCount];
+		for (UINT p = 0; p < Bc6h::PartitionCount; ++p) {
+			residuals[p] = 0.f;
+			for (UINT s = 0; s < 2; ++s) {
+				XMVECTOR points[16];
+				UINT count = 0;
+				for (UINT i = 0; i < 16; ++i) {
+					if (SubsetOf(2, p, i) == s) points[count++] = all[i];
+				}
+
+				XMVECTOR mean, axis;
+				residuals[p] += FitLine(points, count, mean, axis);
+			}
+			ranked[p] = p;
+		}
+		std::stable_sort(ranked, ranked + Bc6h::PartitionCount, [&](UINT a, UINT b) { return residuals[a] < residuals[b]; });
+
+		for (UINT i = 0, end = quality == CompressionQuality::E_High ? 8 : 2; i < end; ++i)
+			Bc6h::EncodePartition(values, ranked[i], 0, Bc6h::FirstOneRegionMode, passes, best);
+	}
+
+	Bc6h::Write(best, block);
+}
+
+void BlockCodec::DecodeBC1(const BYTE* block, BYTE* texels) {
+	DecodeColorBlock(block, TRUE, texels);
+}
+
+void BlockCodec::DecodeBC3(const BYTE* block, BYTE* texels) {
+	DecodeColorBlock(block + 8, FALSE, texels);
+	DecodeAlphaBlock(block, 3, texels);
+}
+
+void BlockCodec::DecodeBC4(const BYTE* block, UINT channel, BYTE* texels) {
+	DecodeAlphaBlock(block, channel, texels);
+}
+
+void BlockCodec::DecodeBC5(const BYTE* block, BYTE* texels) {
+	for (UINT i = 0; i < 16; ++i) {
+		texels[i * 4 + 2] = 0;
+		texels[i * 4 + 3] = 255;
+	}
+
+	DecodeAlphaBlock(block, 0, texels);
+	DecodeAlphaBlock(block + 8, 1, texels);
+}
+
+void BlockCodec::DecodeBC7(const BYTE* block, BYTE* texels) {
+	BitReader reader(block);
+
+	UINT modeIndex = 0;
+	while (modeIndex < 8 && reader.Read(1) == 0)
+		++modeIndex;
+
+	// Reserved modes decode to transparent black.
+	if (modeIndex == 8) {
+		std::memset(texels, 0, 64);
+		return;
+	}
+
+	const Bc7Mode& mode = Bc7Modes[modeIndex];
+
+	Bc7Block decoded = {};
+	decoded.Mode = modeIndex;
+	decoded.Partition = reader.Read(mode.PartitionBits);
+	decoded.Rotation = reader.Read(mode.RotationBits);
+	decoded.IndexSelection = reader.Read(mode.IndexSelectionBits);
+
+	for (UINT c = 0; c < 3; ++c) {
+		for (UINT s = 0; s < mode.Subsets; ++s) {
+			decoded.Endpoints[s][0][c] = static_cast<INT>(reader.Read(mode.ColorBits));
+			decoded.Endpoints[s][1][c] = static_cast<INT>(reader.Read(mode.ColorBits));
+		}
+	}
+	if (mode.AlphaBits > 0) {
+		for (UINT s = 0; s < mode.Subsets; ++s) {
+			decoded.Endpoints[s][0][3] = static_cast<INT>(reader.Read(mode.AlphaBits));
+			decoded.Endpoints[s][1][3] = static_cast<INT>(reader.Read(mode.AlphaBits));
+		}
+	}
+
+	for (UINT s = 0; s < mode.Subsets; ++s) {
+		if (mode.EndpointPBits) {
+			decoded.PBits[s][0] = static_cast<INT>(reader.Read(1));
+			decoded.PBits[s][1] = static_cast<INT>(reader.Read(1));
+		}
+		else if (mode.SharedPBits) {
+			decoded.PBits[s][0] = decoded.PBits[s][1] = static_cast<INT>(reader.Read(1));
+		}
+	}
+
+	for (UINT i = 0; i < 16; ++i) {
+		const UINT subset = SubsetOf(mode.Subsets, decoded.Partition, i);
+		const BOOL anchor = AnchorOf(mode.Subsets, decoded.Partition, subset) == i;
+		decoded.Indices[i] = reader.Read(mode.IndexBits - (anchor ? 1 : 0));
+	}
+	if (mode.SecondaryIndexBits > 0) {
+		for (UINT i = 0; i < 16; ++i)
+			decoded.SecondaryIndices[i] = reader.Read(mode.SecondaryIndexBits - (i == 0 ? 1 : 0));
+	}
+
+	INT endpoints[3][2][4];
+	for (UINT s = 0; s < mode.Subsets; ++s)
+		DecodeBc7Endpoints(decoded, s, endpoints[s]);
+
+	const UINT* colorWeights = GetWeights(decoded.IndexSelection ? mode.SecondaryIndexBits : mode.IndexBits);
+	const UINT* alphaWeights = GetWeights(mode.SecondaryIndexBits == 0 || decoded.IndexSelection ? mode.IndexBits : mode.SecondaryIndexBits);
+
+	for (UINT i = 0; i < 16; ++i) {
+		const UINT subset = SubsetOf(mode.Subsets, decoded.Partition, i);
+
+		UINT colorIndex = decoded.Indices[i];
+		UINT alphaIndex = decoded.Indices[i];
+		if (mode.SecondaryIndexBits > 0) {
+			if (decoded.IndexSelection) colorIndex = decoded.SecondaryIndices[i];
+			else alphaIndex = decoded.SecondaryIndices[i];
+		}
+
+		BYTE* texel = texels + i * 4;
+		for (UINT c = 0; c < 3; ++c)
+			texel[c] = static_cast<BYTE>(Interpolate(endpoints[subset][0][c], endpoints[subset][1][c], colorWeights[colorIndex]));
+		texel[3] = static_cast<BYTE>(Interpolate(endpoints[subset][0][3], endpoints[subset][1][3], alphaWeights[alphaIndex]));
+
+		if (decoded.Rotation > 0) std::swap(texel[decoded.Rotation - 1], texel[3]);
+	}
+}
+
+void BlockCodec::DecodeBC6H(const BYTE* block, BOOL isSigned, FLOAT* texels) {
+	BitReader reader(block);
+
+	UINT code = reader.Read(2);
+	if (code > 1) code |= reader.Read(3) << 2;
+
+	UINT modeIndex = 0;
+	while (modeIndex < 14 && Bc6h::Modes[modeIndex].Code != code)
+		++modeIndex;
+
+	if (modeIndex == 14) {
+		for (UINT i = 0; i < 16; ++i) {
+			texels[i * 4] = texels[i * 4 + 1] = texels[i * 4 + 2] = 0.f;
+			texels[i * 4 + 3] = 1.f;
+		}
+		return;
+	}
+
+	const Bc6h::Mode& mode = Bc6h::Modes[modeIndex];
+
+	INT stored[4][3] = {};
+	UINT partition = 0;
+
+	for (UINT i = 0; i < mode.LayoutCount; ++i) {
+		const Bc6h::Bits& bits = mode.Layout[i];
+		UINT value = 0;
+
+		if (bits.High >= bits.Low) {
+			for (INT b = bits.Low; b <= bits.High; ++b)
+				value |= reader.Read(1) << b;
+		}
+		else {
+			for (INT b = bits.Low; b >= bits.High; --b)
+				value |= reader.Read(1) << b;
+		}
+
+		if (bits.Field == Bc6h::D) partition |= value;
+		else stored[bits.Field / 3][bits.Field % 3] |= static_cast<INT>(value);
+	}
+
+	INT endpoints[4][3];
+	Bc6h::ReconstructEndpoints(mode, stored, isSigned, endpoints);
+
+	const UINT indexBits = mode.TwoRegions ? 3 : 4;
+	const UINT* weights = GetWeights(indexBits);
+
+	for (UINT i = 0; i < 16; ++i) {
+		const BOOL anchor = i == 0 || (mode.TwoRegions && i == Anchors2[partition]);
+		const UINT index = reader.Read(indexBits - (anchor ? 1 : 0));
+		const UINT region = mode.TwoRegions ? SubsetOf(2, partition, i) : 0;
+
+		for (UINT c = 0; c < 3; ++c) {
+			const INT value = Interpolate(endpoints[region * 2][c], endpoints[region * 2 + 1][c], weights[index]);
+			texels[i * 4 + c] = XMConvertHalfToFloat(Bc6h::Finalize(value, isSigned));
+		}
+		texels[i * 4 + 3] = 1.f;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,345 @@
+#include "Common/Texture/BlockCompressor.h"
+#include "Common/Debug/Logger.h"
+#include "Common/Util/TaskQueue.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <DirectXPackedVector.h>
+
+using namespace DirectX::PackedVector;
+
+#undef max
+#undef min
+
+namespace {
+	struct ErrorSums {
+		DOUBLE SquaredError = 0.0;
+		UINT64 Count = 0;
+		DOUBLE Peak = 0.0;
+	};
+
+	UINT BlockSize(DXGI_FORMAT format) {
+		switch (format) {
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+		case DXGI_FORMAT_BC4_UNORM:
+			return 8;
+		default:
+			return 16;
+		}
+	}
+
+	// Channels the format stores, which are the ones the error is measured over.
+	UINT StoredChannels(DXGI_FORMAT format) {
+		switch (format) {
+		case DXGI_FORMAT_BC4_UNORM:
+			return 1;
+		case DXGI_FORMAT_BC5_UNORM:
+			return 2;
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+		case DXGI_FORMAT_BC6H_UF16:
+			return 3;
+		default:
+			return 4;
+		}
+	}
+
+	void LoadTexel(const BYTE* texel, DXGI_FORMAT format, FLOAT* rgba) {
+		switch (format) {
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+			for (UINT c = 0; c < 4; ++c)
+				rgba[c] = texel[c] / 255.f;
+			break;
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+		case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+			rgba[0] = texel[2] / 255.f;
+			rgba[1] = texel[1] / 255.f;
+			rgba[2] = texel[0] / 255.f;
+			rgba[3] = texel[3] / 255.f;
+			break;
+		case DXGI_FORMAT_R16G16B16A16_FLOAT: {
+			const HALF* values = reinterpret_cast<const HALF*>(texel);
+			for (UINT c = 0; c < 4; ++c)
+				rgba[c] = XMConvertHalfToFloat(values[c]);
+			break;
+		}
+		case DXGI_FORMAT_R32G32B32A32_FLOAT:
+			std::memcpy(rgba, texel, sizeof(FLOAT) * 4);
+			break;
+		case DXGI_FORMAT_R32G32B32_FLOAT:
+			std::memcpy(rgba, texel, sizeof(FLOAT) * 3);
+			rgba[3] = 1.f;
+			break;
+		default:
+			rgba[0] = rgba[1] = rgba[2] = rgba[3] = 0.f;
+			break;
+		}
+	}
+
+	__forceinline BYTE ToUnorm8(FLOAT value) {
+		return static_cast<BYTE>(std::min(std::max(value, 0.f), 1.f) * 255.f + 0.5f);
+	}
+
+	void EncodeBlock(const FLOAT* texels, DXGI_FORMAT format, CompressionQuality::Type quality, BYTE* block) {
+		if (format == DXGI_FORMAT_BC6H_UF16) {
+			BlockCodec::EncodeBC6H(texels, quality, block);
+			return;
+		}
+
+		BYTE bytes[BlockCodec::BlockTexels * 4];
+		for (UINT i = 0; i < BlockCodec::BlockTexels * 4; ++i)
+			bytes[i] = ToUnorm8(texels[i]);
+
+		switch (format) {
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+			BlockCodec::EncodeBC1(bytes, quality, block);
+			break;
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+			BlockCodec::EncodeBC3(bytes, quality, block);
+			break;
+		case DXGI_FORMAT_BC4_UNORM:
+			BlockCodec::EncodeBC4(bytes, 0, quality, block);
+			break;
+		case DXGI_FORMAT_BC5_UNORM:
+			BlockCodec::EncodeBC5(bytes, quality, block);
+			break;
+		default:
+			BlockCodec::EncodeBC7(bytes, quality, block);
+			break;
+		}
+	}
+
+	// Squared error of the decoded block against the source over the stored channels of the
+	// texels inside the texture.
+	DOUBLE MeasureBlock(const FLOAT* texels, const BYTE* block, DXGI_FORMAT format, UINT columns, UINT rows) {
+		const UINT channels = StoredChannels(format);
+		DOUBLE error = 0.0;
+
+		if (format == DXGI_FORMAT_BC6H_UF16) {
+			FLOAT decoded[BlockCodec::BlockTexels * 4];
+			BlockCodec::DecodeBC6H(block, FALSE, decoded);
+
+			for (UINT y = 0; y < rows; ++y) {
+				for (UINT x = 0; x < columns; ++x) {
+					const UINT i = (y * 4 + x) * 4;
+					for (UINT c = 0; c < channels; ++c) {
+						const DOUBLE d = static_cast<DOUBLE>(decoded[i + c]) - std::max(texels[i + c], 0.f);
+						error += d * d;
+					}
+				}
+			}
+			return error;
+		}
+
+		BYTE decoded[BlockCodec::BlockTexels * 4];
+		switch (format) {
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+			BlockCodec::DecodeBC1(block, decoded);
+			break;
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+			BlockCodec::DecodeBC3(block, decoded);
+			break;
+		case DXGI_FORMAT_BC4_UNORM:
+			BlockCodec::DecodeBC4(block, 0, decoded);
+			break;
+		case DXGI_FORMAT_BC5_UNORM:
+			BlockCodec::DecodeBC5(block, decoded);
+			break;
+		default:
+			BlockCodec::DecodeBC7(block, decoded);
+			break;
+		}
+
+		for (UINT y = 0; y < rows; ++y) {
+			for (UINT x = 0; x < columns; ++x) {
+				const UINT i = (y * 4 + x) * 4;
+				for (UINT c = 0; c < channels; ++c) {
+					const DOUBLE d = static_cast<DOUBLE>(decoded[i + c]) - ToUnorm8(texels[i + c]);
+					error += d * d;
+				}
+			}
+		}
+		return error;
+	}
+
+	BOOL CompressSurface(
+			const DdsFile::Subresource& source,
+			DXGI_FORMAT sourceFormat,
+			DXGI_FORMAT format,
+			CompressionQuality::Type quality,
+			UINT64 numThreads,
+			std::vector<BYTE>& blocks,
+			ErrorSums& sums) {
+		if (!BlockCompressor::IsSupported(format)) ReturnFalse(L"Unsupported block-compressed format: " << format);
+		if (!BlockCompressor::IsSupportedSource(sourceFormat)) ReturnFalse(L"Unsupported source format for block compression: " << sourceFormat);
+		if (source.Data == nullptr || source.Width == 0 || source.Height == 0 || source.Depth == 0)
+			ReturnFalse(L"Empty surface");
+
+		const UINT texelSize = TextureFormat::BitsPerPixel(sourceFormat) / 8;
+		const UINT blockSize = BlockSize(format);
+		const UINT blocksWide = (source.Width + 3) / 4;
+		const UINT blocksHigh = (source.Height + 3) / 4;
+		const UINT64 rowSize = static_cast<UINT64>(blocksWide) * blockSize;
+
+		blocks.resize(rowSize * blocksHigh * source.Depth);
+
+		const UINT rowCount = blocksHigh * source.Depth;
+		std::vector<DOUBLE> rowErrors(rowCount, 0.0);
+		std::vector<DOUBLE> rowPeaks(rowCount, 0.0);
+
+		auto compressRow = [&](UINT row) {
+			const UINT z = row / blocksHigh;
+			const UINT by = row % blocksHigh;
+			const BYTE* slice = source.Data + source.SlicePitch * z;
+			BYTE* output = blocks.data() + rowSize * row;
+
+			FLOAT texels[BlockCodec::BlockTexels * 4];
+			for (UINT bx = 0; bx < blocksWide; ++bx) {
+				for (UINT y = 0; y < 4; ++y) {
+					const UINT sy = std::min(by * 4 + y, source.Height - 1);
+					const BYTE* sourceRow = slice + source.RowPitch * sy;
+					for (UINT x = 0; x < 4; ++x) {
+						const UINT sx = std::min(bx * 4 + x, source.Width - 1);
+						LoadTexel(sourceRow + static_cast<UINT64>(sx) * texelSize, sourceFormat, texels + (y * 4 + x) * 4);
+					}
+				}
+
+				BYTE* block = output + static_cast<UINT64>(bx) * blockSize;
+				EncodeBlock(texels, format, quality, block);
+
+				const UINT columns = std::min(4u, source.Width - bx * 4);
+				const UINT rows = std::min(4u, source.Height - by * 4);
+				rowErrors[row] += MeasureBlock(texels, block, format, columns, rows);
+
+				for (UINT i = 0; i < BlockCodec::BlockTexels; ++i) {
+					for (UINT c = 0; c < 3; ++c)
+						rowPeaks[row] = std::max(rowPeaks[row], static_cast<DOUBLE>(texels[i * 4 + c]));
+				}
+			}
+			return true;
+		};
+
+		if (numThreads > 1 && rowCount > 1) {
+			TaskQueue taskQueue;
+			for (UINT row = 0; row < rowCount; ++row) {
+				taskQueue.AddTask([&compressRow, row] {
+					return compressRow(row);
+				});
+			}
+
+			CheckReturn(taskQueue.Run(std::min<UINT64>(numThreads, rowCount)));
+		}
+		else {
+			for (UINT row = 0; row < rowCount; ++row) compressRow(row);
+		}
+
+		for (UINT row = 0; row < rowCount; ++row) {
+			sums.SquaredError += rowErrors[row];
+			sums.Peak = std::max(sums.Peak, rowPeaks[row]);
+		}
+		sums.Count += static_cast<UINT64>(source.Width) * source.Height * source.Depth * StoredChannels(format);
+
+		return TRUE;
+	}
+
+	void MakeReport(const ErrorSums& sums, DXGI_FORMAT format, BlockCompressor::Report& report) {
+		report.Mse = sums.Count > 0 ? sums.SquaredError / static_cast<DOUBLE>(sums.Count) : 0.0;
+
+		const DOUBLE peak = format == DXGI_FORMAT_BC6H_UF16 ? sums.Peak : 255.0;
+		report.Psnr = report.Mse > 0.0 && peak > 0.0 ?
+			10.0 * std::log10(peak * peak / report.Mse) : std::numeric_limits<DOUBLE>::infinity();
+	}
+}
+
+BOOL BlockCompressor::IsSupported(DXGI_FORMAT format) {
+	switch (format) {
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+	case DXGI_FORMAT_BC4_UNORM:
+	case DXGI_FORMAT_BC5_UNORM:
+	case DXGI_FORMAT_BC6H_UF16:
+	case DXGI_FORMAT_BC7_UNORM:
+	case DXGI_FORMAT_BC7_UNORM_SRGB:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+BOOL BlockCompressor::IsSupportedSource(DXGI_FORMAT format) {
+	switch (format) {
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+	case DXGI_FORMAT_B8G8R8A8_UNORM:
+	case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+	case DXGI_FORMAT_R32G32B32A32_FLOAT:
+	case DXGI_FORMAT_R32G32B32_FLOAT:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+BOOL BlockCompressor::Compress(
+		const DdsFile::Subresource& source,
+		DXGI_FORMAT sourceFormat,
+		DXGI_FORMAT format,
+		CompressionQuality::Type quality,
+		UINT64 numThreads,
+		std::vector<BYTE>& blocks,
+		Report* report) {
+	ErrorSums sums;
+	CheckReturn(CompressSurface(source, sourceFormat, format, quality, numThreads, blocks, sums));
+
+	if (report != nullptr) MakeReport(sums, format, *report);
+
+	return TRUE;
+}
+
+BOOL BlockCompressor::CompressTexture(
+		const DdsFile& source,
+		DXGI_FORMAT format,
+		CompressionQuality::Type quality,
+		UINT64 numThreads,
+		const std::string& path,
+		Report* report) {
+	DdsFile::Description desc = source.Desc();
+	const DXGI_FORMAT sourceFormat = desc.Format;
+	desc.Format = format;
+
+	std::vector<DdsFile::Subresource> layout;
+	UINT64 totalSize = 0;
+	CheckReturn(DdsFile::ComputeLayout(desc, layout, totalSize));
+
+	const auto& subresources = source.Subresources();
+	if (layout.size() != subresources.size()) ReturnFalse(L"Subresource count mismatch");
+
+	std::vector<std::vector<BYTE>> blocks(subresources.size());
+	ErrorSums sums;
+	for (size_t i = 0, end = subresources.size(); i < end; ++i) {
+		CheckReturn(CompressSurface(subresources[i], sourceFormat, format, quality, numThreads, blocks[i], sums));
+		layout[i].Data = blocks[i].data();
+	}
+
+	CheckReturn(DdsFile::Save(path, desc, layout));
+
+	Report result;
+	MakeReport(sums, format, result);
+	if (report != nullptr) *report = result;
+
+	WLogln(L"Block compression: ", std::wstring(path.begin(), path.end()), L" PSNR ", std::to_wstring(result.Psnr),
+		L" dB (MSE ", std::to_wstring(result.Mse), L")");
+
+	return TRUE;
+}
\ No newline at end of file
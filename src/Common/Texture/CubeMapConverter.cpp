@@ -0,0 +1,387 @@
+#include "Common/Texture/CubeMapConverter.h"
+#include "Common/Debug/Logger.h"
+#include "Common/Texture/MipGenerator.h"
+#include "Common/Texture/TexelDecoder.h"
+#include "Common/Util/TexelUtil.h"
+
+#include <algorithm>
+#include <cmath>
+#include <DirectXPackedVector.h>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+#undef max
+#undef min
+
+namespace {
+	const UINT FaceCount = 6;
+
+	// Rows per task; narrow destinations put several rows in one task.
+	const UINT64 TexelsPerTask = 1 << 12;
+
+	// Weights of the taps at floor(f) - 1 through floor(f) + 2; bilinear leaves the outer two at zero.
+	void FilterWeights(ResampleFilter::Type filter, FLOAT t, FLOAT weights[4]) {
+		if (filter == ResampleFilter::E_Cubic) {
+			const FLOAT t2 = t * t;
+			const FLOAT t3 = t2 * t;
+			weights[0] = 0.5f * (-t3 + 2.f * t2 - t);
+			weights[1] = 0.5f * (3.f * t3 - 5.f * t2 + 2.f);
+			weights[2] = 0.5f * (-3.f * t3 + 4.f * t2 + t);
+			weights[3] = 0.5f * (t3 - t2);
+		}
+		else {
+			weights[0] = 0.f;
+			weights[1] = 1.f - t;
+			weights[2] = t;
+			weights[3] = 0.f;
+		}
+	}
+
+	// Filters around texel coordinates (fx, fy), with fetch resolving any integer texel, in range or not.
+	template <typename Fetch>
+	XMVECTOR Filter(ResampleFilter::Type filter, FLOAT fx, FLOAT fy, const Fetch& fetch) {
+		const FLOAT x0f = std::floor(fx);
+		const FLOAT y0f = std::floor(fy);
+		const INT x0 = static_cast<INT>(x0f);
+		const INT y0 = static_cast<INT>(y0f);
+
+		FLOAT wx[4], wy[4];
+		FilterWeights(filter, fx - x0f, wx);
+		FilterWeights(filter, fy - y0f, wy);
+
+		XMVECTOR sum = XMVectorZero();
+		for (INT j = 0; j < 4; ++j) {
+			if (wy[j] == 0.f) continue;
+
+			XMVECTOR row = XMVectorZero();
+			for (INT i = 0; i < 4; ++i) {
+				if (wx[i] == 0.f) continue;
+				row = XMVectorMultiplyAdd(XMVectorReplicate(wx[i]), fetch(x0 + i - 1, y0 + j - 1), row);
+			}
+
+			sum = XMVectorMultiplyAdd(XMVectorReplicate(wy[j]), row, sum);
+		}
+
+		return filter == ResampleFilter::E_Cubic ? XMVectorMax(sum, XMVectorZero()) : sum;
+	}
+
+	// Rows past a pole continue down the meridian half a turn away.
+	XMVECTOR FetchEquirectangular(const TexelUtil::Level& level, INT x, INT y) {
+		const INT width = static_cast<INT>(level.Width);
+		const INT height = static_cast<INT>(level.Height);
+
+		if (y < 0) {
+			y = std::min(-1 - y, height - 1);
+			x += width / 2;
+		}
+		else if (y >= height) {
+			y = std::max(2 * height - 1 - y, 0);
+			x += width / 2;
+		}
+		x = ((x % width) + width) % width;
+
+		return XMLoadFloat4(&level.Texels[static_cast<size_t>(y) * level.Width + x]);
+	}
+
+	// Texels off a face are looked up where their direction lands on the neighboring face.
+	XMVECTOR FetchCube(const TexelUtil::Level& level, UINT face, INT x, INT y) {
+		const INT size = static_cast<INT>(level.Width);
+		const size_t faceTexels = static_cast<size_t>(level.Width) * level.Width;
+
+		if (x < 0 || y < 0 || x >= size || y >= size) {
+			const FLOAT s = 2.f * (x + 0.5f) / size - 1.f;
+			const FLOAT t = 2.f * (y + 0.5f) / size - 1.f;
+
+			FLOAT s1, t1;
+			CubeMapConverter::CubeFace(CubeMapConverter::CubeDirection(face, s, t), face, s1, t1);
+
+			x = std::min(std::max(static_cast<INT>(std::floor((s1 + 1.f) * 0.5f * size)), 0), size - 1);
+			y = std::min(std::max(static_cast<INT>(std::floor((t1 + 1.f) * 0.5f * size)), 0), size - 1);
+		}
+
+		return XMLoadFloat4(&level.Texels[face * faceTexels + static_cast<size_t>(y) * level.Width + x]);
+	}
+
+	// Box-filtered chain of a float surface, with mip 0 first.
+	BOOL BuildChain(
+			const XMFLOAT4* texels,
+			UINT width, UINT height,
+			UINT64 numThreads,
+			std::vector<BYTE>& chainTexels,
+			std::vector<TexelUtil::Level>& levels) {
+		DdsFile::Subresource top = {};
+		top.Data = reinterpret_cast<const BYTE*>(texels);
+		top.Width = width;
+		top.Height = height;
+		top.Depth = 1;
+		top.RowCount = height;
+		top.RowPitch = static_cast<UINT64>(width) * sizeof(XMFLOAT4);
+		top.SlicePitch = top.RowPitch * height;
+
+		MipGenerator::Settings settings;
+		settings.Filter = MipFilter::E_Box;
+
+		std::vector<DdsFile::Subresource> chain;
+		CheckReturn(MipGenerator::Generate(top, DXGI_FORMAT_R32G32B32A32_FLOAT, settings, numThreads, chainTexels, chain));
+
+		levels.clear();
+		levels.push_back({ width, height, texels });
+		for (const auto& mip : chain)
+			levels.push_back({ mip.Width, mip.Height, reinterpret_cast<const XMFLOAT4*>(mip.Data) });
+
+		return TRUE;
+	}
+
+	// Coarsest level whose texels are still no wider than sourceTexelsPerTexel source texels of mip 0.
+	UINT SelectLevel(FLOAT sourceTexelsPerTexel, UINT levelCount) {
+		if (!(sourceTexelsPerTexel > 1.f)) return 0;
+		return std::min(static_cast<UINT>(std::log2(sourceTexelsPerTexel)), levelCount - 1);
+	}
+
+	// Saves float surfaces as R16G16B16A16_FLOAT, in the subresource order of desc.
+	BOOL SaveHalf(const std::string& path, DdsFile::Description desc, const std::vector<TexelUtil::Level>& surfaces) {
+		desc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+
+		size_t total = 0;
+		for (const auto& surface : surfaces)
+			total += static_cast<size_t>(surface.Width) * surface.Height * 4;
+
+		std::vector<HALF> halves(total);
+		std::vector<DdsFile::Subresource> subresources;
+
+		size_t offset = 0;
+		for (const auto& surface : surfaces) {
+			const size_t count = static_cast<size_t>(surface.Width) * surface.Height * 4;
+			XMConvertFloatToHalfStream(halves.data() + offset, sizeof(HALF), reinterpret_cast<const FLOAT*>(surface.Texels), sizeof(FLOAT), count);
+
+			DdsFile::Subresource subresource = {};
+			subresource.Data = reinterpret_cast<const BYTE*>(halves.data() + offset);
+			subresource.Width = surface.Width;
+			subresource.Height = surface.Height;
+			subresource.Depth = 1;
+			subresource.RowCount = surface.Height;
+			subresource.RowPitch = static_cast<UINT64>(surface.Width) * 4 * sizeof(HALF);
+			subresource.SlicePitch = subresource.RowPitch * surface.Height;
+			subresources.push_back(subresource);
+
+			offset += count;
+		}
+
+		return DdsFile::Save(path, desc, subresources);
+	}
+}
+
+XMFLOAT3 CubeMapConverter::CubeDirection(UINT face, FLOAT s, FLOAT t) {
+	switch (face) {
+	case 0: return XMFLOAT3(1.f, -t, -s);
+	case 1: return XMFLOAT3(-1.f, -t, s);
+	case 2: return XMFLOAT3(s, 1.f, t);
+	case 3: return XMFLOAT3(s, -1.f, -t);
+	case 4: return XMFLOAT3(s, -t, 1.f);
+	default: return XMFLOAT3(-s, -t, -1.f);
+	}
+}
+
+void CubeMapConverter::CubeFace(const XMFLOAT3& dir, UINT& face, FLOAT& s, FLOAT& t) {
+	const FLOAT ax = std::abs(dir.x);
+	const FLOAT ay = std::abs(dir.y);
+	const FLOAT az = std::abs(dir.z);
+
+	if (ax >= ay && ax >= az) {
+		face = dir.x > 0.f ? 0 : 1;
+		s = (dir.x > 0.f ? -dir.z : dir.z) / ax;
+		t = -dir.y / ax;
+	}
+	else if (ay >= az) {
+		face = dir.y > 0.f ? 2 : 3;
+		s = dir.x / ay;
+		t = (dir.y > 0.f ? dir.z : -dir.z) / ay;
+	}
+	else {
+		face = dir.z > 0.f ? 4 : 5;
+		s = (dir.z > 0.f ? dir.x : -dir.x) / az;
+		t = -dir.y / az;
+	}
+}
+
+BOOL CubeMapConverter::EquirectangularToCube(
+		const std::vector<XMFLOAT4>& equirectangular,
+		UINT width, UINT height,
+		UINT faceSize,
+		ResampleFilter::Type filter,
+		UINT64 numThreads,
+		std::vector<XMFLOAT4>& faces) {
+	if (width == 0 || height == 0 || faceSize == 0) ReturnFalse(L"Empty environment");
+	if (equirectangular.size() != static_cast<size_t>(width) * height) ReturnFalse(L"Equirectangular map does not match its extent");
+
+	std::vector<BYTE> chainTexels;
+	std::vector<TexelUtil::Level> levels;
+	CheckReturn(BuildChain(equirectangular.data(), width, height, numThreads, chainTexels, levels));
+
+	// A face spans a quarter turn, as many radians as a quarter of the source width.
+	const TexelUtil::Level& level = levels[SelectLevel(static_cast<FLOAT>(width) / (4.f * faceSize), static_cast<UINT>(levels.size()))];
+
+	faces.resize(static_cast<size_t>(FaceCount) * faceSize * faceSize);
+
+	return TexelUtil::ForEachBand(FaceCount * faceSize, faceSize, TexelsPerTask, numThreads, [&](UINT begin, UINT end) {
+		for (UINT row = begin; row < end; ++row) {
+			const UINT face = row / faceSize;
+			const FLOAT t = 2.f * (row % faceSize + 0.5f) / faceSize - 1.f;
+
+			for (UINT x = 0; x < faceSize; ++x) {
+				const FLOAT s = 2.f * (x + 0.5f) / faceSize - 1.f;
+				const XMFLOAT3 d = CubeDirection(face, s, t);
+
+				const FLOAT length = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+				const FLOAT u = std::atan2(d.z, d.x) / (2.f * XM_PI) + 0.5f;
+				const FLOAT v = 0.5f - std::asin(std::min(std::max(d.y / length, -1.f), 1.f)) / XM_PI;
+
+				const XMVECTOR color = Filter(filter, u * level.Width - 0.5f, v * level.Height - 0.5f, [&level](INT i, INT j) {
+					return FetchEquirectangular(level, i, j);
+				});
+				XMStoreFloat4(&faces[static_cast<size_t>(row) * faceSize + x], color);
+			}
+		}
+
+		return TRUE;
+	});
+}
+
+BOOL CubeMapConverter::CubeToEquirectangular(
+		const std::vector<XMFLOAT4>& faces,
+		UINT faceSize,
+		UINT width, UINT height,
+		ResampleFilter::Type filter,
+		UINT64 numThreads,
+		std::vector<XMFLOAT4>& equirectangular) {
+	if (width == 0 || height == 0 || faceSize == 0) ReturnFalse(L"Empty environment");
+
+	const size_t faceTexels = static_cast<size_t>(faceSize) * faceSize;
+	if (faces.size() != FaceCount * faceTexels) ReturnFalse(L"Cube map does not match its extent");
+
+	// Every face gets its own chain; the fetches across edges keep the seams.
+	std::vector<std::vector<BYTE>> chainTexels(FaceCount);
+	std::vector<std::vector<TexelUtil::Level>> faceLevels(FaceCount);
+	for (UINT face = 0; face < FaceCount; ++face)
+		CheckReturn(BuildChain(faces.data() + face * faceTexels, faceSize, faceSize, numThreads, chainTexels[face], faceLevels[face]));
+
+	const UINT index = SelectLevel(4.f * faceSize / width, static_cast<UINT>(faceLevels[0].size()));
+	const UINT size = faceLevels[0][index].Width;
+
+	// Gathers the faces of the selected level into one array for FetchCube.
+	std::vector<XMFLOAT4> levelTexels(FaceCount * static_cast<size_t>(size) * size);
+	for (UINT face = 0; face < FaceCount; ++face) {
+		const XMFLOAT4* src = faceLevels[face][index].Texels;
+		std::copy(src, src + static_cast<size_t>(size) * size, levelTexels.begin() + face * static_cast<size_t>(size) * size);
+	}
+	const TexelUtil::Level level = { size, size, levelTexels.data() };
+
+	equirectangular.resize(static_cast<size_t>(width) * height);
+
+	return TexelUtil::ForEachBand(height, width, TexelsPerTask, numThreads, [&](UINT begin, UINT end) {
+		for (UINT y = begin; y < end; ++y) {
+			const FLOAT lat = (0.5f - (y + 0.5f) / height) * XM_PI;
+			const FLOAT cosLat = std::cos(lat);
+			const FLOAT sinLat = std::sin(lat);
+
+			for (UINT x = 0; x < width; ++x) {
+				const FLOAT phi = ((x + 0.5f) / width - 0.5f) * 2.f * XM_PI;
+
+				UINT face;
+				FLOAT s, t;
+				CubeFace(XMFLOAT3(std::cos(phi) * cosLat, sinLat, std::sin(phi) * cosLat), face, s, t);
+
+				const XMVECTOR color = Filter(filter, (s + 1.f) * 0.5f * size - 0.5f, (t + 1.f) * 0.5f * size - 0.5f, [&level, face](INT i, INT j) {
+					return FetchCube(level, face, i, j);
+				});
+				XMStoreFloat4(&equirectangular[static_cast<size_t>(y) * width + x], color);
+			}
+		}
+
+		return TRUE;
+	});
+}
+
+BOOL CubeMapConverter::CookCubeMap(
+		const DdsFile& equirectangular,
+		UINT faceSize,
+		ResampleFilter::Type filter,
+		BOOL generateMips,
+		UINT64 numThreads,
+		const std::string& path) {
+	const auto& srcDesc = equirectangular.Desc();
+	if (srcDesc.IsCube) ReturnFalse(L"Expected an equirectangular map");
+
+	std::vector<XMFLOAT4> source;
+	CheckReturn(TexelDecoder::Decode(equirectangular.GetSubresource(0, 0), srcDesc.Format, source));
+
+	std::vector<XMFLOAT4> faces;
+	CheckReturn(EquirectangularToCube(source, srcDesc.Width, srcDesc.Height, faceSize, filter, numThreads, faces));
+
+	DdsFile::Description desc = {};
+	desc.Dimension = TextureDimension::E_Texture2D;
+	desc.Width = faceSize;
+	desc.Height = faceSize;
+	desc.Depth = 1;
+	desc.ArraySize = FaceCount;
+	desc.MipLevels = generateMips ? TextureFormat::MipCount(faceSize) : 1;
+	desc.IsCube = TRUE;
+
+	const size_t faceTexels = static_cast<size_t>(faceSize) * faceSize;
+
+	// Subresources go face after face, with the mips of each face together.
+	std::vector<std::vector<BYTE>> chainTexels(FaceCount);
+	std::vector<TexelUtil::Level> surfaces;
+	for (UINT face = 0; face < FaceCount; ++face) {
+		const XMFLOAT4* texels = faces.data() + face * faceTexels;
+		if (!generateMips) {
+			surfaces.push_back({ faceSize, faceSize, texels });
+			continue;
+		}
+
+		std::vector<TexelUtil::Level> levels;
+		CheckReturn(BuildChain(texels, faceSize, faceSize, numThreads, chainTexels[face], levels));
+		surfaces.insert(surfaces.end(), levels.begin(), levels.end());
+	}
+
+	CheckReturn(SaveHalf(path, desc, surfaces));
+
+	WLogln(L"Cooked cube map: ", std::wstring(path.begin(), path.end()));
+
+	return TRUE;
+}
+
+BOOL CubeMapConverter::CookEquirectangular(
+		const DdsFile& cubeMap,
+		UINT width, UINT height,
+		ResampleFilter::Type filter,
+		UINT64 numThreads,
+		const std::string& path) {
+	const auto& srcDesc = cubeMap.Desc();
+	if (!srcDesc.IsCube || srcDesc.ArraySize < FaceCount) ReturnFalse(L"Expected a cube map");
+
+	std::vector<XMFLOAT4> faces;
+	for (UINT face = 0; face < FaceCount; ++face) {
+		std::vector<XMFLOAT4> texels;
+		CheckReturn(TexelDecoder::Decode(cubeMap.GetSubresource(0, face), srcDesc.Format, texels));
+		faces.insert(faces.end(), texels.begin(), texels.end());
+	}
+
+	std::vector<XMFLOAT4> equirectangular;
+	CheckReturn(CubeToEquirectangular(faces, srcDesc.Width, width, height, filter, numThreads, equirectangular));
+
+	DdsFile::Description desc = {};
+	desc.Dimension = TextureDimension::E_Texture2D;
+	desc.Width = width;
+	desc.Height = height;
+	desc.Depth = 1;
+	desc.ArraySize = 1;
+	desc.MipLevels = 1;
+
+	CheckReturn(SaveHalf(path, desc, { { width, height, equirectangular.data() } }));
+
+	WLogln(L"Cooked equirectangular map: ", std::wstring(path.begin(), path.end()));
+
+	return TRUE;
+}
\ No newline at end of file
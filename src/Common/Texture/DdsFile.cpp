@@ -0,0 +1,360 @@
+#include "Common/Texture/DdsFile.h"
+#include "Common/Debug/Logger.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <DirectX/DDS.h>
+
+using namespace DirectX;
+
+namespace {
+	const UINT64 HeaderSize = sizeof(UINT) + sizeof(DDS_HEADER);
+	const UINT64 Dx10HeaderSize = HeaderSize + sizeof(DDS_HEADER_DXT10);
+
+	// Numeric D3DFMT codes some exporters store in the FourCC field.
+	const UINT D3DFmt_A16B16G16R16 = 36;
+	const UINT D3DFmt_Q16W16V16U16 = 110;
+	const UINT D3DFmt_R16F = 111;
+	const UINT D3DFmt_G16R16F = 112;
+	const UINT D3DFmt_A16B16G16R16F = 113;
+	const UINT D3DFmt_R32F = 114;
+	const UINT D3DFmt_G32R32F = 115;
+	const UINT D3DFmt_A32B32G32R32F = 116;
+
+	__forceinline BOOL HasMasks(const DDS_PIXELFORMAT& pf, UINT r, UINT g, UINT b, UINT a) {
+		return pf.RBitMask == r && pf.GBitMask == g && pf.BBitMask == b && pf.ABitMask == a;
+	}
+
+	// Maps a legacy pixel format to DXGI. Formats that would need their channels swizzled or
+	// expanded, such as 24-bit RGB or X8B8G8R8, are rejected.
+	DXGI_FORMAT GetDxgiFormat(const DDS_PIXELFORMAT& pf, UINT& alphaMode) {
+		alphaMode = DDS_ALPHA_MODE_UNKNOWN;
+
+		if (pf.flags & DDS_FOURCC) {
+			switch (pf.fourCC) {
+			case MAKEFOURCC('D', 'X', 'T', '1'): return DXGI_FORMAT_BC1_UNORM;
+			case MAKEFOURCC('D', 'X', 'T', '2'): alphaMode = DDS_ALPHA_MODE_PREMULTIPLIED; return DXGI_FORMAT_BC2_UNORM;
+			case MAKEFOURCC('D', 'X', 'T', '3'): return DXGI_FORMAT_BC2_UNORM;
+			case MAKEFOURCC('D', 'X', 'T', '4'): alphaMode = DDS_ALPHA_MODE_PREMULTIPLIED; return DXGI_FORMAT_BC3_UNORM;
+			case MAKEFOURCC('D', 'X', 'T', '5'): return DXGI_FORMAT_BC3_UNORM;
+			case MAKEFOURCC('A', 'T', 'I', '1'):
+			case MAKEFOURCC('B', 'C', '4', 'U'): return DXGI_FORMAT_BC4_UNORM;
+			case MAKEFOURCC('B', 'C', '4', 'S'): return DXGI_FORMAT_BC4_SNORM;
+			case MAKEFOURCC('A', 'T', 'I', '2'):
+			case MAKEFOURCC('B', 'C', '5', 'U'): return DXGI_FORMAT_BC5_UNORM;
+			case MAKEFOURCC('B', 'C', '5', 'S'): return DXGI_FORMAT_BC5_SNORM;
+			case D3DFmt_A16B16G16R16: return DXGI_FORMAT_R16G16B16A16_UNORM;
+			case D3DFmt_Q16W16V16U16: return DXGI_FORMAT_R16G16B16A16_SNORM;
+			case D3DFmt_R16F: return DXGI_FORMAT_R16_FLOAT;
+			case D3DFmt_G16R16F: return DXGI_FORMAT_R16G16_FLOAT;
+			case D3DFmt_A16B16G16R16F: return DXGI_FORMAT_R16G16B16A16_FLOAT;
+			case D3DFmt_R32F: return DXGI_FORMAT_R32_FLOAT;
+			case D3DFmt_G32R32F: return DXGI_FORMAT_R32G32_FLOAT;
+			case D3DFmt_A32B32G32R32F: return DXGI_FORMAT_R32G32B32A32_FLOAT;
+			default: return DXGI_FORMAT_UNKNOWN;
+			}
+		}
+
+		if (pf.flags & DDS_RGB) {
+			switch (pf.RGBBitCount) {
+			case 32:
+				if (HasMasks(pf, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000)) return DXGI_FORMAT_R8G8B8A8_UNORM;
+				if (HasMasks(pf, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000)) return DXGI_FORMAT_B8G8R8A8_UNORM;
+				if (HasMasks(pf, 0x00ff0000, 0x0000ff00, 0x000000ff, 0)) return DXGI_FORMAT_B8G8R8X8_UNORM;
+				// D3DX writes R10G10B10A2 with the red and blue masks swapped.
+				if (HasMasks(pf, 0x3ff00000, 0x000ffc00, 0x000003ff, 0xc0000000)) return DXGI_FORMAT_R10G10B10A2_UNORM;
+				if (HasMasks(pf, 0x0000ffff, 0xffff0000, 0, 0)) return DXGI_FORMAT_R16G16_UNORM;
+				if (HasMasks(pf, 0xffffffff, 0, 0, 0)) return DXGI_FORMAT_R32_FLOAT;
+				break;
+			case 16:
+				if (HasMasks(pf, 0x7c00, 0x03e0, 0x001f, 0x8000)) return DXGI_FORMAT_B5G5R5A1_UNORM;
+				if (HasMasks(pf, 0xf800, 0x07e0, 0x001f, 0)) return DXGI_FORMAT_B5G6R5_UNORM;
+				if (HasMasks(pf, 0x0f00, 0x00f0, 0x000f, 0xf000)) return DXGI_FORMAT_B4G4R4A4_UNORM;
+				if (HasMasks(pf, 0xffff, 0, 0, 0)) return DXGI_FORMAT_R16_UNORM;
+				if (HasMasks(pf, 0x00ff, 0, 0, 0xff00)) return DXGI_FORMAT_R8G8_UNORM;
+				break;
+			case 8:
+				if (HasMasks(pf, 0xff, 0, 0, 0)) return DXGI_FORMAT_R8_UNORM;
+				break;
+			}
+		}
+		else if (pf.flags & DDS_LUMINANCE) {
+			if (pf.RGBBitCount == 8 && HasMasks(pf, 0xff, 0, 0, 0)) return DXGI_FORMAT_R8_UNORM;
+			if (pf.RGBBitCount == 16 && HasMasks(pf, 0xffff, 0, 0, 0)) return DXGI_FORMAT_R16_UNORM;
+			if (pf.RGBBitCount == 16 && HasMasks(pf, 0x00ff, 0, 0, 0xff00)) return DXGI_FORMAT_R8G8_UNORM;
+		}
+		else if (pf.flags & DDS_ALPHA) {
+			if (pf.RGBBitCount == 8) return DXGI_FORMAT_A8_UNORM;
+		}
+		else if (pf.flags & DDS_BUMPDUDV) {
+			if (pf.RGBBitCount == 16 && HasMasks(pf, 0x00ff, 0xff00, 0, 0)) return DXGI_FORMAT_R8G8_SNORM;
+			if (pf.RGBBitCount == 32 && HasMasks(pf, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000)) return DXGI_FORMAT_R8G8B8A8_SNORM;
+			if (pf.RGBBitCount == 32 && HasMasks(pf, 0x0000ffff, 0xffff0000, 0, 0)) return DXGI_FORMAT_R16G16_SNORM;
+		}
+
+		return DXGI_FORMAT_UNKNOWN;
+	}
+}
+
+BOOL DdsFile::Open(const std::string& path) {
+	Close();
+
+	CheckReturn(mFile.Open(path));
+
+	if (!Parse(mFile.Data(), mFile.Size())) {
+		Close();
+		ReturnFalse(L"Invalid DDS file: " << path.c_str());
+	}
+
+	return TRUE;
+}
+
+BOOL DdsFile::Parse(const BYTE* data, UINT64 size) {
+	mDesc = {};
+	mSubresources.clear();
+
+	if (data == nullptr || size < HeaderSize) ReturnFalse(L"DDS image is too small");
+
+	UINT magic;
+	std::memcpy(&magic, data, sizeof(UINT));
+	if (magic != DDS_MAGIC) ReturnFalse(L"Missing DDS magic");
+
+	DDS_HEADER header;
+	std::memcpy(&header, data + sizeof(UINT), sizeof(DDS_HEADER));
+	if (header.size != sizeof(DDS_HEADER) || header.ddspf.size != sizeof(DDS_PIXELFORMAT))
+		ReturnFalse(L"Malformed DDS header");
+
+	Description desc = {};
+	desc.Width = header.width;
+	desc.Height = header.height;
+	desc.Depth = 1;
+	desc.ArraySize = 1;
+	desc.MipLevels = header.mipMapCount > 0 ? header.mipMapCount : 1;
+
+	UINT64 offset = HeaderSize;
+
+	if ((header.ddspf.flags & DDS_FOURCC) && header.ddspf.fourCC == MAKEFOURCC('D', 'X', '1', '0')) {
+		if (size < Dx10HeaderSize) ReturnFalse(L"DDS image is too small for its DX10 header");
+
+		DDS_HEADER_DXT10 dx10;
+		std::memcpy(&dx10, data + HeaderSize, sizeof(DDS_HEADER_DXT10));
+		offset = Dx10HeaderSize;
+
+		desc.Format = dx10.dxgiFormat;
+		desc.AlphaMode = dx10.miscFlags2 & DDS_MISC_FLAGS2_ALPHA_MODE_MASK;
+
+		if (dx10.arraySize == 0 || dx10.arraySize > MaxArraySize) ReturnFalse(L"Unsupported DDS array size: " << dx10.arraySize);
+		desc.ArraySize = dx10.arraySize;
+
+		switch (dx10.resourceDimension) {
+		case DDS_DIMENSION_TEXTURE1D:
+			// Some writers leave the height unset for 1D textures.
+			if (header.flags & DDS_HEIGHT) {
+				if (desc.Height != 1) ReturnFalse(L"1D DDS texture with a height of " << desc.Height);
+			}
+			desc.Dimension = TextureDimension::E_Texture1D;
+			desc.Height = 1;
+			break;
+		case DDS_DIMENSION_TEXTURE2D:
+			desc.Dimension = TextureDimension::E_Texture2D;
+			if (dx10.miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE) {
+				desc.IsCube = TRUE;
+				desc.ArraySize *= 6;
+			}
+			break;
+		case DDS_DIMENSION_TEXTURE3D:
+			if (!(header.flags & DDS_HEADER_FLAGS_VOLUME)) ReturnFalse(L"3D DDS texture without a depth");
+			desc.Dimension = TextureDimension::E_Texture3D;
+			desc.Depth = header.depth;
+			break;
+		default:
+			ReturnFalse(L"Unsupported DDS resource dimension: " << dx10.resourceDimension);
+		}
+	}
+	else {
+		desc.Format = GetDxgiFormat(header.ddspf, desc.AlphaMode);
+		if (desc.Format == DXGI_FORMAT_UNKNOWN) ReturnFalse(L"Unsupported legacy DDS pixel format");
+
+		if (header.flags & DDS_HEADER_FLAGS_VOLUME) {
+			desc.Dimension = TextureDimension::E_Texture3D;
+			desc.Depth = header.depth;
+		}
+		else {
+			desc.Dimension = TextureDimension::E_Texture2D;
+			if (header.caps2 & DDS_CUBEMAP) {
+				// Direct3D 10 and later only know complete cube maps.
+				if ((header.caps2 & DDS_CUBEMAP_ALLFACES) != DDS_CUBEMAP_ALLFACES) ReturnFalse(L"DDS cube map without all six faces");
+				desc.IsCube = TRUE;
+				desc.ArraySize = 6;
+			}
+		}
+	}
+
+	std::vector<Subresource> layout;
+	UINT64 totalSize;
+	CheckReturn(ComputeLayout(desc, layout, totalSize));
+
+	if (totalSize > size - offset) ReturnFalse(L"DDS image is truncated: " << size - offset << L" of " << totalSize << L" bytes of texels");
+
+	for (auto& subresource : layout) {
+		subresource.Data = data + offset;
+		offset += subresource.SlicePitch * subresource.Depth;
+	}
+
+	mDesc = desc;
+	mSubresources.swap(layout);
+
+	return TRUE;
+}
+
+void DdsFile::Close() {
+	mFile.Close();
+
+	mDesc = {};
+	std::vector<Subresource>().swap(mSubresources);
+}
+
+BOOL DdsFile::ComputeLayout(const Description& desc, std::vector<Subresource>& layout, UINT64& totalSize) {
+	if (TextureFormat::BitsPerPixel(desc.Format) == 0) ReturnFalse(L"Unsupported DDS format: " << static_cast<UINT>(desc.Format));
+
+	if (desc.Width == 0 || desc.Height == 0 || desc.Depth == 0 ||
+			desc.Width > MaxDimension || desc.Height > MaxDimension || desc.Depth > MaxDimension)
+		ReturnFalse(L"Unsupported DDS extent: " << desc.Width << L'x' << desc.Height << L'x' << desc.Depth);
+	if (desc.ArraySize == 0 || desc.ArraySize > MaxArraySize * 6) ReturnFalse(L"Unsupported DDS array size: " << desc.ArraySize);
+
+	switch (desc.Dimension) {
+	case TextureDimension::E_Texture1D:
+		if (desc.Height != 1 || desc.Depth != 1 || desc.IsCube) ReturnFalse(L"Malformed 1D DDS description");
+		break;
+	case TextureDimension::E_Texture2D:
+		if (desc.Depth != 1) ReturnFalse(L"Malformed 2D DDS description");
+		if (desc.IsCube && (desc.ArraySize % 6 != 0 || desc.Width != desc.Height)) ReturnFalse(L"Malformed DDS cube map description");
+		break;
+	case TextureDimension::E_Texture3D:
+		if (desc.ArraySize != 1 || desc.IsCube) ReturnFalse(L"Malformed 3D DDS description");
+		break;
+	default:
+		ReturnFalse(L"Unknown texture dimension: " << static_cast<UINT>(desc.Dimension));
+	}
+
+	UINT largest = desc.Width > desc.Height ? desc.Width : desc.Height;
+	if (desc.Dimension == TextureDimension::E_Texture3D && desc.Depth > largest) largest = desc.Depth;
+	if (desc.MipLevels == 0 || desc.MipLevels > TextureFormat::MipCount(largest)) ReturnFalse(L"Unsupported DDS mip count: " << desc.MipLevels);
+
+	layout.clear();
+	layout.reserve(static_cast<size_t>(desc.ArraySize) * desc.MipLevels);
+
+	totalSize = 0;
+
+	for (UINT slice = 0; slice < desc.ArraySize; ++slice) {
+		for (UINT mip = 0; mip < desc.MipLevels; ++mip) {
+			Subresource subresource = {};
+			subresource.Width = TextureFormat::MipExtent(desc.Width, mip);
+			subresource.Height = TextureFormat::MipExtent(desc.Height, mip);
+			subresource.Depth = TextureFormat::MipExtent(desc.Depth, mip);
+
+			TextureFormat::ComputePitch(desc.Format, subresource.Width, subresource.Height, subresource.RowPitch, subresource.RowCount);
+			subresource.SlicePitch = subresource.RowPitch * subresource.RowCount;
+
+			totalSize += subresource.SlicePitch * subresource.Depth;
+			layout.push_back(subresource);
+		}
+	}
+
+	return TRUE;
+}
+
+BOOL DdsFile::Write(const Description& desc, const std::vector<Subresource>& subresources, std::vector<BYTE>& image) {
+	std::vector<Subresource> layout;
+	UINT64 totalSize;
+	CheckReturn(ComputeLayout(desc, layout, totalSize));
+
+	if (subresources.size() != layout.size())
+		ReturnFalse(L"Expected " << layout.size() << L" subresources to write but got " << subresources.size());
+
+	const BOOL compressed = TextureFormat::IsBlockCompressed(desc.Format);
+
+	DDS_HEADER header = {};
+	header.size = sizeof(DDS_HEADER);
+	header.flags = DDS_HEADER_FLAGS_TEXTURE | (compressed ? DDS_HEADER_FLAGS_LINEARSIZE : DDS_HEADER_FLAGS_PITCH);
+	header.height = desc.Height;
+	header.width = desc.Width;
+	header.pitchOrLinearSize = static_cast<UINT>(compressed ? layout[0].SlicePitch : layout[0].RowPitch);
+	header.mipMapCount = desc.MipLevels;
+	header.ddspf = DDSPF_DX10;
+	header.caps = DDS_SURFACE_FLAGS_TEXTURE;
+
+	if (desc.MipLevels > 1) {
+		header.flags |= DDS_HEADER_FLAGS_MIPMAP;
+		header.caps |= DDS_SURFACE_FLAGS_MIPMAP;
+	}
+	if (desc.Dimension == TextureDimension::E_Texture3D) {
+		header.flags |= DDS_HEADER_FLAGS_VOLUME;
+		header.depth = desc.Depth;
+		header.caps2 = DDS_FLAGS_VOLUME;
+	}
+	if (desc.IsCube) {
+		header.caps |= DDS_SURFACE_FLAGS_CUBEMAP;
+		header.caps2 = DDS_CUBEMAP_ALLFACES;
+	}
+
+	DDS_HEADER_DXT10 dx10 = {};
+	dx10.dxgiFormat = desc.Format;
+	dx10.resourceDimension = DDS_DIMENSION_TEXTURE1D + static_cast<UINT>(desc.Dimension);
+	dx10.miscFlag = desc.IsCube ? DDS_RESOURCE_MISC_TEXTURECUBE : 0;
+	dx10.arraySize = desc.IsCube ? desc.ArraySize / 6 : desc.ArraySize;
+	dx10.miscFlags2 = desc.AlphaMode & DDS_MISC_FLAGS2_ALPHA_MODE_MASK;
+
+	image.resize(static_cast<size_t>(Dx10HeaderSize + totalSize));
+
+	BYTE* dst = image.data();
+
+	const UINT magic = DDS_MAGIC;
+	std::memcpy(dst, &magic, sizeof(UINT));
+	std::memcpy(dst + sizeof(UINT), &header, sizeof(DDS_HEADER));
+	std::memcpy(dst + HeaderSize, &dx10, sizeof(DDS_HEADER_DXT10));
+	dst += Dx10HeaderSize;
+
+	for (size_t i = 0, end = layout.size(); i < end; ++i) {
+		const Subresource& packed = layout[i];
+		const Subresource& src = subresources[i];
+
+		if (src.Data == nullptr || src.RowPitch < packed.RowPitch || src.SlicePitch < src.RowPitch * packed.RowCount)
+			ReturnFalse(L"Subresource " << i << L" is smaller than its " << packed.Width << L'x' << packed.Height << L" surface");
+
+		for (UINT z = 0; z < packed.Depth; ++z) {
+			const BYTE* srcSlice = src.Data + z * src.SlicePitch;
+
+			if (src.RowPitch == packed.RowPitch) {
+				std::memcpy(dst, srcSlice, static_cast<size_t>(packed.SlicePitch));
+				dst += packed.SlicePitch;
+				continue;
+			}
+
+			for (UINT row = 0; row < packed.RowCount; ++row) {
+				std::memcpy(dst, srcSlice + row * src.RowPitch, static_cast<size_t>(packed.RowPitch));
+				dst += packed.RowPitch;
+			}
+		}
+	}
+
+	return TRUE;
+}
+
+BOOL DdsFile::Save(const std::string& path, const Description& desc, const std::vector<Subresource>& subresources) {
+	std::vector<BYTE> image;
+	CheckReturn(Write(desc, subresources, image));
+
+	std::error_code error;
+	const std::filesystem::path parent = std::filesystem::path(path).parent_path();
+	if (!parent.empty()) std::filesystem::create_directories(parent, error);
+
+	std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+	if (!stream.is_open()) ReturnFalse(L"Failed to create the DDS file: " << path.c_str());
+
+	stream.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+	if (!stream.good()) ReturnFalse(L"Failed to write the DDS file: " << path.c_str());
+
+	return TRUE;
+}
\ No newline at end of file
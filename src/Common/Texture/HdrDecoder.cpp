@@ -0,0 +1,1066 @@
+#include "Common/Texture/HdrDecoder.h"
+#include "Common/Debug/Logger.h"
+#include "Common/HashUtil.h"
+#include "Common/Texture/BlockCompressor.h"
+#include "Common/Texture/MipGenerator.h"
+#include "Common/Util/Inflate.h"
+#include "Common/Util/MappedFile.h"
+#include "Common/Util/TexelUtil.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <DirectXPackedVector.h>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+#undef max
+#undef min
+
+namespace {
+	// Rows per task; EXR chunks of several rows are never split.
+	const UINT64 TexelsPerTask = 1 << 14;
+
+	const UINT TexelBytes = 4 * sizeof(HALF);
+	const HALF HalfOne = 0x3C00;
+
+	const BYTE ExrMagic[] = { 0x76, 0x2F, 0x31, 0x01 };
+
+	BOOL AllocateImage(UINT width, UINT height, std::vector<BYTE>& texels, DdsFile::Subresource& surface) {
+		if (width == 0 || height == 0 || width > DdsFile::MaxDimension || height > DdsFile::MaxDimension)
+			ReturnFalse(L"Unsupported HDR image extent: " << width << L'x' << height);
+
+		surface = {};
+		surface.Width = width;
+		surface.Height = height;
+		surface.Depth = 1;
+		surface.RowCount = height;
+		surface.RowPitch = static_cast<UINT64>(width) * TexelBytes;
+		surface.SlicePitch = surface.RowPitch * height;
+
+		texels.assign(static_cast<size_t>(surface.SlicePitch), 0);
+		surface.Data = texels.data();
+
+		return TRUE;
+	}
+
+	//
+	// Radiance
+	//
+
+	BOOL ReadLine(const BYTE*& p, const BYTE* end, std::string& line) {
+		line.clear();
+		while (p < end && *p != '\n')
+			line.push_back(static_cast<CHAR>(*p++));
+		if (p == end) return FALSE;
+
+		++p;
+		return TRUE;
+	}
+
+	// Decodes one row into width RGBE texels, or only walks past it when rgbe is null. Rows of 8 to
+	// 32767 texels may be run-length encoded channel by channel; the others are flat, where the old
+	// encoding repeats the previous texel.
+	BOOL DecodeRadianceRow(const BYTE*& p, const BYTE* end, UINT width, BYTE* rgbe) {
+		if (width >= 8 && width < 32768 && end - p >= 4 && p[0] == 2 && p[1] == 2 && (p[2] & 0x80) == 0) {
+			if (((static_cast<UINT>(p[2]) << 8) | p[3]) != width) ReturnFalse(L"Radiance scanline width mismatch");
+			p += 4;
+
+			for (UINT channel = 0; channel < 4; ++channel) {
+				for (UINT x = 0; x < width;) {
+					if (p >= end) ReturnFalse(L"Radiance scanline is truncated");
+
+					UINT count = *p++;
+					if (count > 128) {
+						count -= 128;
+						if (count > width - x || p >= end) ReturnFalse(L"Corrupt Radiance run");
+
+						const BYTE value = *p++;
+						if (rgbe != nullptr) {
+							for (UINT i = 0; i < count; ++i)
+								rgbe[(x + i) * 4 + channel] = value;
+						}
+					}
+					else {
+						if (count == 0 || count > width - x || end - p < count) ReturnFalse(L"Corrupt Radiance run");
+
+						if (rgbe != nullptr) {
+							for (UINT i = 0; i < count; ++i)
+								rgbe[(x + i) * 4 + channel] = p[i];
+						}
+						p += count;
+					}
+					x += count;
+				}
+			}
+
+			return TRUE;
+		}
+
+		UINT shift = 0;
+		for (UINT x = 0; x < width;) {
+			if (end - p < 4) ReturnFalse(L"Radiance scanline is truncated");
+
+			if (p[0] == 1 && p[1] == 1 && p[2] == 1) {
+				if (x == 0 || shift > 24) ReturnFalse(L"Corrupt Radiance run");
+
+				const UINT count = static_cast<UINT>(p[3]) << shift;
+				if (count > width - x) ReturnFalse(L"Corrupt Radiance run");
+
+				if (rgbe != nullptr) {
+					for (UINT i = 0; i < count; ++i)
+						std::memcpy(rgbe + (x + i) * 4, rgbe + (x - 1) * 4, 4);
+				}
+				x += count;
+				shift += 8;
+			}
+			else {
+				if (rgbe != nullptr) std::memcpy(rgbe + x * 4, p, 4);
+				++x;
+				shift = 0;
+			}
+			p += 4;
+		}
+
+		return TRUE;
+	}
+
+	BOOL DecodeRadiance(const BYTE* data, UINT64 size, UINT64 numThreads, std::vector<BYTE>& texels, DdsFile::Subresource& surface) {
+		const BYTE* p = data;
+		const BYTE* const end = data + size;
+
+		std::string line;
+		if (!ReadLine(p, end, line) || line.compare(0, 2, "#?") != 0) ReturnFalse(L"Missing Radiance signature");
+
+		for (;;) {
+			if (!ReadLine(p, end, line)) ReturnFalse(L"Radiance header is truncated");
+			if (line.empty()) break;
+
+			if (line.compare(0, 7, "FORMAT=") == 0 && line != "FORMAT=32-bit_rle_rgbe")
+				ReturnFalse(L"Unsupported Radiance pixel format: " << line.c_str());
+		}
+
+		if (!ReadLine(p, end, line)) ReturnFalse(L"Missing Radiance resolution");
+
+		std::istringstream resolution(line);
+		std::string yAxis, xAxis;
+		INT height = 0;
+		INT width = 0;
+		resolution >> yAxis >> height >> xAxis >> width;
+		if (resolution.fail() || (yAxis != "-Y" && yAxis != "+Y") || xAxis != "+X" || width <= 0 || height <= 0)
+			ReturnFalse(L"Unsupported Radiance resolution: " << line.c_str());
+
+		CheckReturn(AllocateImage(static_cast<UINT>(width), static_cast<UINT>(height), texels, surface));
+
+		// Run lengths hide where rows start; one pass over the runs finds them and validates every row.
+		std::vector<UINT64> offsets(height);
+		for (INT row = 0; row < height; ++row) {
+			offsets[row] = static_cast<UINT64>(p - data);
+			CheckReturn(DecodeRadianceRow(p, end, static_cast<UINT>(width), nullptr));
+		}
+
+		// Rows are stored bottom to top when Y increases.
+		const BOOL flip = yAxis == "+Y";
+		BYTE* const image = texels.data();
+
+		return TexelUtil::ForEachBand(static_cast<UINT>(height), static_cast<UINT>(width), TexelsPerTask, numThreads, [&](UINT begin, UINT last) {
+			std::vector<BYTE> rgbe(static_cast<size_t>(width) * 4);
+			std::vector<FLOAT> floats(static_cast<size_t>(width) * 4);
+
+			for (UINT row = begin; row < last; ++row) {
+				const BYTE* q = data + offsets[row];
+				CheckReturn(DecodeRadianceRow(q, end, static_cast<UINT>(width), rgbe.data()));
+
+				for (INT x = 0; x < width; ++x) {
+					const BYTE* texel = &rgbe[static_cast<size_t>(x) * 4];
+					FLOAT* color = &floats[static_cast<size_t>(x) * 4];
+
+					if (texel[3] == 0) {
+						color[0] = color[1] = color[2] = 0.f;
+					}
+					else {
+						// Mantissas are the lower bounds of their intervals; the middle is unbiased.
+						const FLOAT scale = std::ldexp(1.f, static_cast<INT>(texel[3]) - 136);
+						color[0] = (texel[0] + 0.5f) * scale;
+						color[1] = (texel[1] + 0.5f) * scale;
+						color[2] = (texel[2] + 0.5f) * scale;
+					}
+					color[3] = 1.f;
+				}
+
+				const UINT dstRow = flip ? static_cast<UINT>(height) - 1 - row : row;
+				HALF* const dst = reinterpret_cast<HALF*>(image + static_cast<size_t>(dstRow) * surface.RowPitch);
+				XMConvertFloatToHalfStream(dst, sizeof(HALF), floats.data(), sizeof(FLOAT), floats.size());
+			}
+
+			return TRUE;
+		});
+	}
+
+	//
+	// OpenEXR
+	//
+
+	namespace ExrCompression {
+		enum Type {
+			E_None = 0,
+			E_Rle,
+			E_Zips,
+			E_Zip,
+			E_Piz,
+			Count
+		};
+	}
+
+	namespace ExrPixelType {
+		enum Type {
+			E_Uint = 0,
+			E_Half,
+			E_Float
+		};
+	}
+
+	struct ExrChannel {
+		ExrPixelType::Type Type;
+		UINT Bytes;
+		// First RGBA component filled, and how many; grey fills three.
+		UINT Target;
+		UINT TargetCount;
+	};
+
+	struct ExrHeader {
+		std::vector<ExrChannel> Channels;
+		ExrCompression::Type Compression;
+		INT MinY;
+		UINT Width;
+		UINT Height;
+		UINT LinesPerBlock;
+		UINT64 BytesPerLine;
+	};
+
+	__forceinline UINT ReadUInt(const BYTE* p) {
+		return static_cast<UINT>(p[0]) | (static_cast<UINT>(p[1]) << 8) | (static_cast<UINT>(p[2]) << 16) | (static_cast<UINT>(p[3]) << 24);
+	}
+
+	__forceinline INT ReadInt(const BYTE* p) {
+		return static_cast<INT>(ReadUInt(p));
+	}
+
+	__forceinline USHORT ReadUShort(const BYTE* p) {
+		return static_cast<USHORT>(p[0] | (p[1] << 8));
+	}
+
+	BOOL ReadString(const BYTE*& p, const BYTE* end, std::string& str) {
+		const BYTE* terminator = std::find(p, end, static_cast<BYTE>(0));
+		if (terminator == end) return FALSE;
+
+		str.assign(reinterpret_cast<const CHAR*>(p), reinterpret_cast<const CHAR*>(terminator));
+		p = terminator + 1;
+		return TRUE;
+	}
+
+	BOOL ReadChannels(const BYTE* p, const BYTE* end, ExrHeader& header) {
+		BOOL hasColor = FALSE;
+		BOOL hasGrey = FALSE;
+
+		for (;;) {
+			std::string name;
+			if (!ReadString(p, end, name)) ReturnFalse(L"Malformed EXR channel list");
+			if (name.empty()) break;
+			if (end - p < 16) ReturnFalse(L"Malformed EXR channel list");
+
+			const INT type = ReadInt(p);
+			const INT xSampling = ReadInt(p + 8);
+			const INT ySampling = ReadInt(p + 12);
+			p += 16;
+
+			if (type < ExrPixelType::E_Uint || type > ExrPixelType::E_Float) ReturnFalse(L"Unknown EXR pixel type: " << type);
+			if (xSampling != 1 || ySampling != 1) ReturnFalse(L"Subsampled EXR channels are not supported: " << name.c_str());
+
+			ExrChannel channel;
+			channel.Type = static_cast<ExrPixelType::Type>(type);
+			channel.Bytes = channel.Type == ExrPixelType::E_Half ? 2 : 4;
+			channel.Target = 0;
+			channel.TargetCount = 1;
+
+			if (name == "R") channel.Target = 0;
+			else if (name == "G") channel.Target = 1;
+			else if (name == "B") channel.Target = 2;
+			else if (name == "A") channel.Target = 3;
+			else if (name == "Y") channel.TargetCount = 3;
+			else channel.TargetCount = 0;
+
+			if (name == "R" || name == "G" || name == "B") hasColor = TRUE;
+			if (name == "Y") hasGrey = TRUE;
+
+			header.Channels.push_back(channel);
+		}
+
+		// Luminance only stands in for missing color; with chroma channels present it is skipped.
+		if (hasGrey && hasColor) {
+			for (auto& channel : header.Channels) {
+				if (channel.TargetCount == 3) channel.TargetCount = 0;
+			}
+		}
+
+		if (header.Channels.empty()) ReturnFalse(L"EXR image has no channels");
+
+		return TRUE;
+	}
+
+	BOOL ReadExrHeader(const BYTE* data, UINT64 size, ExrHeader& header, const BYTE*& p) {
+		const BYTE* const end = data + size;
+		if (size < 8 || std::memcmp(data, ExrMagic, sizeof(ExrMagic)) != 0) ReturnFalse(L"Missing OpenEXR signature");
+
+		const UINT version = ReadUInt(data + 4);
+		if ((version & 0xFF) != 2) ReturnFalse(L"Unsupported OpenEXR version: " << (version & 0xFF));
+		if (version & 0x200) ReturnFalse(L"Tiled OpenEXR images are not supported");
+		if (version & 0x1800) ReturnFalse(L"Deep and multi-part OpenEXR images are not supported");
+
+		p = data + 8;
+
+		BOOL hasChannels = FALSE;
+		BOOL hasDataWindow = FALSE;
+		INT compression = ExrCompression::E_None;
+		INT minX = 0, minY = 0, maxX = 0, maxY = 0;
+
+		for (;;) {
+			std::string name, type;
+			if (!ReadString(p, end, name)) ReturnFalse(L"OpenEXR header is truncated");
+			if (name.empty()) break;
+			if (!ReadString(p, end, type) || end - p < 4) ReturnFalse(L"OpenEXR header is truncated");
+
+			const INT attributeSize = ReadInt(p);
+			p += 4;
+			if (attributeSize < 0 || end - p < attributeSize) ReturnFalse(L"OpenEXR header is truncated");
+
+			const BYTE* value = p;
+			p += attributeSize;
+
+			if (name == "channels" && type == "chlist") {
+				CheckReturn(ReadChannels(value, value + attributeSize, header));
+				hasChannels = TRUE;
+			}
+			else if (name == "compression" && type == "compression" && attributeSize == 1) {
+				compression = value[0];
+			}
+			else if (name == "dataWindow" && type == "box2i" && attributeSize == 16) {
+				minX = ReadInt(value);
+				minY = ReadInt(value + 4);
+				maxX = ReadInt(value + 8);
+				maxY = ReadInt(value + 12);
+				hasDataWindow = TRUE;
+			}
+		}
+
+		if (!hasChannels || !hasDataWindow) ReturnFalse(L"OpenEXR header lacks channels or a data window");
+		if (compression >= ExrCompression::Count) ReturnFalse(L"Unsupported OpenEXR compression: " << compression);
+		if (maxX < minX || maxY < minY) ReturnFalse(L"Empty OpenEXR data window");
+
+		const INT64 width = static_cast<INT64>(maxX) - minX + 1;
+		const INT64 height = static_cast<INT64>(maxY) - minY + 1;
+		if (width > DdsFile::MaxDimension || height > DdsFile::MaxDimension)
+			ReturnFalse(L"Unsupported OpenEXR extent: " << width << L'x' << height);
+
+		header.Compression = static_cast<ExrCompression::Type>(compression);
+		header.MinY = minY;
+		header.Width = static_cast<UINT>(width);
+		header.Height = static_cast<UINT>(height);
+		header.LinesPerBlock = header.Compression == ExrCompression::E_Zip ? 16 : header.Compression == ExrCompression::E_Piz ? 32 : 1;
+
+		header.BytesPerLine = 0;
+		for (const auto& channel : header.Channels)
+			header.BytesPerLine += static_cast<UINT64>(channel.Bytes) * header.Width;
+
+		return TRUE;
+	}
+
+	BOOL DecodeExrRle(const BYTE* src, UINT64 srcSize, BYTE* dst, UINT64 dstSize) {
+		UINT64 in = 0;
+		UINT64 out = 0;
+
+		while (in < srcSize) {
+			const INT count = static_cast<INT8>(src[in++]);
+
+			if (count < 0) {
+				const UINT64 length = static_cast<UINT64>(-count);
+				if (srcSize - in < length || dstSize - out < length) ReturnFalse(L"Corrupt EXR RLE chunk");
+
+				std::memcpy(dst + out, src + in, static_cast<size_t>(length));
+				in += length;
+				out += length;
+			}
+			else {
+				const UINT64 length = static_cast<UINT64>(count) + 1;
+				if (in >= srcSize || dstSize - out < length) ReturnFalse(L"Corrupt EXR RLE chunk");
+
+				std::memset(dst + out, src[in++], static_cast<size_t>(length));
+				out += length;
+			}
+		}
+
+		if (out != dstSize) ReturnFalse(L"EXR RLE chunk is truncated");
+
+		return TRUE;
+	}
+
+	// RLE and ZIP store the bytes as deltas, with the even bytes in the first half and the odd in the second.
+	void Unpredict(BYTE* bytes, UINT64 size, BYTE* dst) {
+		for (UINT64 i = 1; i < size; ++i)
+			bytes[i] = static_cast<BYTE>(bytes[i - 1] + bytes[i] - 128);
+
+		const BYTE* even = bytes;
+		const BYTE* odd = bytes + (size + 1) / 2;
+		for (UINT64 i = 0; i < size; ++i)
+			dst[i] = (i & 1) ? *odd++ : *even++;
+	}
+
+	//
+	// PIZ: a Huffman coded, wavelet transformed and range compacted image
+	//
+
+	const UINT HufDecBits = 14;
+	const UINT HufEncSize = (1 << 16) + 1;
+	const UINT HufDecSize = 1 << HufDecBits;
+	const UINT HufDecMask = HufDecSize - 1;
+
+	const UINT ShortZeroCodeRun = 59;
+	const UINT LongZeroCodeRun = 63;
+	const UINT ShortestLongRun = 2 + LongZeroCodeRun - ShortZeroCodeRun;
+
+	const UINT BitmapSize = (1 << 16) / 8;
+
+	// Codes up to HufDecBits long fill every slot they prefix; longer codes are listed under the slot
+	// of their leading bits and matched one by one.
+	struct HufDec {
+		UINT Length;
+		UINT Literal;
+		UINT LongBegin;
+		UINT LongCount;
+	};
+
+	struct HuffmanDecoder {
+		std::vector<UINT64> Codes;
+		std::vector<HufDec> Table;
+		std::vector<UINT> Longs;
+	};
+
+	__forceinline BOOL GetBits(UINT count, UINT64& c, UINT& lc, const BYTE*& p, const BYTE* end, UINT& value) {
+		while (lc < count) {
+			if (p >= end) return FALSE;
+			c = (c << 8) | *p++;
+			lc += 8;
+		}
+		lc -= count;
+		value = static_cast<UINT>((c >> lc) & ((1ull << count) - 1));
+		return TRUE;
+	}
+
+	// Code lengths are stored in 6 bits, with zero runs folded in; codes are assigned canonically,
+	// longest first, and packed as length | code << 6.
+	BOOL UnpackEncodingTable(const BYTE*& p, const BYTE* end, UINT im, UINT iM, std::vector<UINT64>& codes) {
+		codes.assign(HufEncSize, 0);
+
+		UINT64 c = 0;
+		UINT lc = 0;
+		for (; im <= iM; ++im) {
+			UINT length;
+			if (!GetBits(6, c, lc, p, end, length)) ReturnFalse(L"PIZ Huffman table is truncated");
+			codes[im] = length;
+
+			if (length >= ShortZeroCodeRun) {
+				UINT run;
+				if (length == LongZeroCodeRun) {
+					if (!GetBits(8, c, lc, p, end, run)) ReturnFalse(L"PIZ Huffman table is truncated");
+					run += ShortestLongRun;
+				}
+				else {
+					run = length - ShortZeroCodeRun + 2;
+				}
+
+				if (im + run > iM + 1) ReturnFalse(L"PIZ Huffman table is too long");
+				std::fill(codes.begin() + im, codes.begin() + im + run, 0);
+				im += run - 1;
+			}
+		}
+
+		UINT64 counts[59] = {};
+		for (const auto code : codes)
+			++counts[code];
+
+		UINT64 next = 0;
+		for (INT length = 58; length > 0; --length) {
+			const UINT64 first = (next + counts[length]) >> 1;
+			counts[length] = next;
+			next = first;
+		}
+
+		for (auto& code : codes) {
+			if (code > 0) code = code | (counts[code]++ << 6);
+		}
+
+		return TRUE;
+	}
+
+	BOOL BuildDecodingTable(UINT im, UINT iM, HuffmanDecoder& decoder) {
+		decoder.Table.assign(HufDecSize, { 0, 0, 0, 0 });
+		decoder.Longs.clear();
+
+		for (UINT pass = 0; pass < 2; ++pass) {
+			for (UINT symbol = im; symbol <= iM; ++symbol) {
+				const UINT64 code = decoder.Codes[symbol] >> 6;
+				const UINT length = static_cast<UINT>(decoder.Codes[symbol] & 63);
+				if (length == 0) continue;
+				if (code >> length) ReturnFalse(L"Invalid PIZ Huffman code");
+
+				if (length > HufDecBits) {
+					HufDec& entry = decoder.Table[static_cast<size_t>(code >> (length - HufDecBits))];
+					if (entry.Length != 0) ReturnFalse(L"Invalid PIZ Huffman code");
+
+					if (pass == 0) ++entry.LongCount;
+					else decoder.Longs[entry.LongBegin + entry.LongCount++] = symbol;
+				}
+				else if (pass == 0) {
+					const UINT64 first = code << (HufDecBits - length);
+					for (UINT64 slot = first, last = first + (1ull << (HufDecBits - length)); slot < last; ++slot) {
+						HufDec& entry = decoder.Table[static_cast<size_t>(slot)];
+						if (entry.Length != 0 || entry.LongCount != 0) ReturnFalse(L"Invalid PIZ Huffman code");
+
+						entry.Length = length;
+						entry.Literal = symbol;
+					}
+				}
+			}
+
+			if (pass == 0) {
+				UINT begin = 0;
+				for (auto& entry : decoder.Table) {
+					entry.LongBegin = begin;
+					begin += entry.LongCount;
+					entry.LongCount = 0;
+				}
+				decoder.Longs.resize(begin);
+			}
+		}
+
+		return TRUE;
+	}
+
+	// The largest symbol stands for a run of the previous one, with the length in the next 8 bits.
+	__forceinline BOOL EmitSymbol(UINT symbol, UINT runSymbol, UINT64& c, UINT& lc, const BYTE*& p, const BYTE* end, USHORT*& out, USHORT* begin, USHORT* outEnd) {
+		if (symbol == runSymbol) {
+			if (lc < 8) {
+				if (p >= end) ReturnFalse(L"PIZ Huffman data is truncated");
+				c = (c << 8) | *p++;
+				lc += 8;
+			}
+			lc -= 8;
+
+			const UINT count = static_cast<BYTE>(c >> lc);
+			if (count > static_cast<UINT64>(outEnd - out)) ReturnFalse(L"PIZ Huffman data overflows the chunk");
+			if (out == begin) ReturnFalse(L"PIZ Huffman run without a previous symbol");
+
+			std::fill(out, out + count, out[-1]);
+			out += count;
+		}
+		else {
+			if (out >= outEnd) ReturnFalse(L"PIZ Huffman data overflows the chunk");
+			*out++ = static_cast<USHORT>(symbol);
+		}
+
+		return TRUE;
+	}
+
+	BOOL DecodeHuffman(const BYTE* src, UINT64 srcSize, HuffmanDecoder& decoder, USHORT* out, UINT64 outCount) {
+		if (srcSize == 0) {
+			if (outCount != 0) ReturnFalse(L"PIZ chunk is missing its Huffman data");
+			return TRUE;
+		}
+		if (srcSize < 20) ReturnFalse(L"PIZ Huffman header is truncated");
+
+		const UINT im = ReadUInt(src);
+		const UINT iM = ReadUInt(src + 4);
+		const UINT64 bitCount = ReadUInt(src + 12);
+		if (im >= HufEncSize || iM >= HufEncSize) ReturnFalse(L"Invalid PIZ Huffman table size");
+
+		const BYTE* p = src + 20;
+		const BYTE* const end = src + srcSize;
+
+		CheckReturn(UnpackEncodingTable(p, end, im, iM, decoder.Codes));
+		if (bitCount > 8 * static_cast<UINT64>(end - p)) ReturnFalse(L"PIZ Huffman data is truncated");
+
+		CheckReturn(BuildDecodingTable(im, iM, decoder));
+
+		const BYTE* const dataEnd = p + (bitCount + 7) / 8;
+		USHORT* o = out;
+		USHORT* const oe = out + outCount;
+
+		UINT64 c = 0;
+		UINT lc = 0;
+		while (p < dataEnd) {
+			c = (c << 8) | *p++;
+			lc += 8;
+
+			while (lc >= HufDecBits) {
+				const HufDec& entry = decoder.Table[(c >> (lc - HufDecBits)) & HufDecMask];
+
+				if (entry.Length != 0) {
+					lc -= entry.Length;
+					CheckReturn(EmitSymbol(entry.Literal, iM, c, lc, p, end, o, out, oe));
+					continue;
+				}
+
+				if (entry.LongCount == 0) ReturnFalse(L"Invalid PIZ Huffman code");
+
+				UINT j = 0;
+				for (; j < entry.LongCount; ++j) {
+					const UINT symbol = decoder.Longs[entry.LongBegin + j];
+					const UINT length = static_cast<UINT>(decoder.Codes[symbol] & 63);
+
+					while (lc < length && p < dataEnd) {
+						c = (c << 8) | *p++;
+						lc += 8;
+					}
+
+					if (lc >= length && (decoder.Codes[symbol] >> 6) == ((c >> (lc - length)) & ((1ull << length) - 1))) {
+						lc -= length;
+						CheckReturn(EmitSymbol(symbol, iM, c, lc, p, end, o, out, oe));
+						break;
+					}
+				}
+
+				if (j == entry.LongCount) ReturnFalse(L"Invalid PIZ Huffman code");
+			}
+		}
+
+		// The padding of the last byte is dropped before the remaining short codes.
+		const UINT padding = static_cast<UINT>((8 - bitCount) & 7);
+		c >>= padding;
+		lc -= std::min(lc, padding);
+
+		while (lc > 0) {
+			const HufDec& entry = decoder.Table[(c << (HufDecBits - lc)) & HufDecMask];
+			if (entry.Length == 0 || entry.Length > lc) ReturnFalse(L"Invalid PIZ Huffman code");
+
+			lc -= entry.Length;
+			CheckReturn(EmitSymbol(entry.Literal, iM, c, lc, p, end, o, out, oe));
+		}
+
+		if (o != oe) ReturnFalse(L"PIZ Huffman data is truncated");
+
+		return TRUE;
+	}
+
+	// Inverse of the 14-bit wavelet step, for data whose range fits without wrapping.
+	__forceinline void Wdec14(USHORT l, USHORT h, USHORT& a, USHORT& b) {
+		const INT hi = static_cast<SHORT>(h);
+		const INT ai = static_cast<SHORT>(l) + (hi & 1) + (hi >> 1);
+
+		a = static_cast<USHORT>(ai);
+		b = static_cast<USHORT>(ai - hi);
+	}
+
+	// Inverse of the 16-bit wavelet step, which works modulo 2^16.
+	__forceinline void Wdec16(USHORT l, USHORT h, USHORT& a, USHORT& b) {
+		const INT m = l;
+		const INT d = h;
+		const INT bb = (m - (d >> 1)) & 0xFFFF;
+		const INT aa = (d + bb - 0x8000) & 0xFFFF;
+
+		a = static_cast<USHORT>(aa);
+		b = static_cast<USHORT>(bb);
+	}
+
+	// Inverse 2D Haar-like wavelet over nx by ny values ox apart in a row and oy apart between rows,
+	// from the coarsest level to the finest.
+	void Wav2Decode(USHORT* in, INT nx, INT ox, INT ny, INT oy, USHORT maxValue) {
+		const BOOL w14 = maxValue < (1 << 14);
+		const auto decode = [w14](USHORT l, USHORT h, USHORT& a, USHORT& b) {
+			if (w14) Wdec14(l, h, a, b);
+			else Wdec16(l, h, a, b);
+		};
+
+		const INT n = std::min(nx, ny);
+		INT p = 1;
+		while (p <= n) p <<= 1;
+		p >>= 1;
+
+		INT p2 = p;
+		p >>= 1;
+
+		while (p >= 1) {
+			const INT64 oy1 = static_cast<INT64>(oy) * p;
+			const INT64 oy2 = static_cast<INT64>(oy) * p2;
+			const INT64 ox1 = static_cast<INT64>(ox) * p;
+			const INT64 ox2 = static_cast<INT64>(ox) * p2;
+			const INT64 ey = static_cast<INT64>(oy) * (ny - p2);
+
+			USHORT i00, i01, i10, i11;
+
+			INT64 py = 0;
+			for (; py <= ey; py += oy2) {
+				const INT64 ex = py + static_cast<INT64>(ox) * (nx - p2);
+
+				INT64 px = py;
+				for (; px <= ex; px += ox2) {
+					USHORT& p00 = in[px];
+					USHORT& p01 = in[px + ox1];
+					USHORT& p10 = in[px + oy1];
+					USHORT& p11 = in[px + oy1 + ox1];
+
+					decode(p00, p10, i00, i10);
+					decode(p01, p11, i01, i11);
+					decode(i00, i01, p00, p01);
+					decode(i10, i11, p10, p11);
+				}
+
+				// Odd column.
+				if (nx & p) {
+					USHORT& p10 = in[px + oy1];
+					decode(in[px], p10, i00, p10);
+					in[px] = i00;
+				}
+			}
+
+			// Odd row.
+			if (ny & p) {
+				const INT64 ex = py + static_cast<INT64>(ox) * (nx - p2);
+				for (INT64 px = py; px <= ex; px += ox2) {
+					USHORT& p01 = in[px + ox1];
+					decode(in[px], p01, i00, p01);
+					in[px] = i00;
+				}
+			}
+
+			p2 = p;
+			p >>= 1;
+		}
+	}
+
+	BOOL DecodePiz(const ExrHeader& header, UINT lines, const BYTE* src, UINT64 srcSize, HuffmanDecoder& decoder, std::vector<USHORT>& work, BYTE* dst) {
+		const UINT64 count = lines * header.BytesPerLine / 2;
+		work.resize(static_cast<size_t>(count));
+
+		const BYTE* p = src;
+		const BYTE* const end = src + srcSize;
+		if (end - p < 4) ReturnFalse(L"PIZ chunk is truncated");
+
+		const UINT minNonZero = ReadUShort(p);
+		const UINT maxNonZero = ReadUShort(p + 2);
+		p += 4;
+		if (maxNonZero >= BitmapSize) ReturnFalse(L"Invalid PIZ bitmap range");
+
+		// Values present in the chunk, zero always among them; the LUT maps the compacted range back.
+		BYTE bitmap[BitmapSize] = {};
+		if (minNonZero <= maxNonZero) {
+			const UINT bytes = maxNonZero - minNonZero + 1;
+			if (static_cast<UINT64>(end - p) < bytes) ReturnFalse(L"PIZ chunk is truncated");
+
+			std::memcpy(bitmap + minNonZero, p, bytes);
+			p += bytes;
+		}
+
+		std::vector<USHORT> lut(1 << 16, 0);
+		UINT k = 0;
+		for (UINT value = 0; value < (1u << 16); ++value) {
+			if (value == 0 || (bitmap[value >> 3] & (1 << (value & 7)))) lut[k++] = static_cast<USHORT>(value);
+		}
+		const USHORT maxValue = static_cast<USHORT>(k - 1);
+
+		if (end - p < 4) ReturnFalse(L"PIZ chunk is truncated");
+		const INT length = ReadInt(p);
+		p += 4;
+		if (length < 0 || end - p < length) ReturnFalse(L"PIZ chunk is truncated");
+
+		CheckReturn(DecodeHuffman(p, static_cast<UINT64>(length), decoder, work.data(), count));
+
+		// Channels are transformed one after another, each value of a 32-bit type as two planes.
+		UINT64 start = 0;
+		for (const auto& channel : header.Channels) {
+			const INT components = static_cast<INT>(channel.Bytes / 2);
+			const INT nx = static_cast<INT>(header.Width);
+			const INT ny = static_cast<INT>(lines);
+
+			for (INT j = 0; j < components; ++j)
+				Wav2Decode(work.data() + start + j, nx, components, ny, nx * components, maxValue);
+
+			start += static_cast<UINT64>(nx) * ny * components;
+		}
+
+		for (auto& value : work)
+			value = lut[value];
+
+		// Back from channel after channel to line after line.
+		std::vector<const USHORT*> cursors;
+		start = 0;
+		for (const auto& channel : header.Channels) {
+			cursors.push_back(work.data() + start);
+			start += static_cast<UINT64>(header.Width) * lines * (channel.Bytes / 2);
+		}
+
+		BYTE* out = dst;
+		for (UINT line = 0; line < lines; ++line) {
+			for (size_t i = 0; i < header.Channels.size(); ++i) {
+				const size_t values = static_cast<size_t>(header.Width) * (header.Channels[i].Bytes / 2);
+				for (size_t v = 0; v < values; ++v) {
+					out[0] = static_cast<BYTE>(cursors[i][v]);
+					out[1] = static_cast<BYTE>(cursors[i][v] >> 8);
+					out += 2;
+				}
+				cursors[i] += values;
+			}
+		}
+
+		return TRUE;
+	}
+
+	struct ExrScratch {
+		std::vector<BYTE> Packed;
+		std::vector<BYTE> Block;
+		std::vector<USHORT> Work;
+		std::vector<FLOAT> Floats;
+		HuffmanDecoder Huffman;
+	};
+
+	// Converts the channels of one uncompressed line into a row of RGBA halves.
+	void ConvertExrLine(const ExrHeader& header, const BYTE* src, HALF* dst, std::vector<FLOAT>& floats) {
+		const UINT width = header.Width;
+
+		for (UINT x = 0; x < width; ++x) {
+			dst[x * 4 + 0] = 0;
+			dst[x * 4 + 1] = 0;
+			dst[x * 4 + 2] = 0;
+			dst[x * 4 + 3] = HalfOne;
+		}
+
+		for (const auto& channel : header.Channels) {
+			const BYTE* values = src;
+			src += static_cast<UINT64>(channel.Bytes) * width;
+			if (channel.TargetCount == 0) continue;
+
+			HALF* const target = dst + channel.Target;
+
+			switch (channel.Type) {
+			case ExrPixelType::E_Half:
+				for (UINT x = 0; x < width; ++x)
+					target[x * 4] = ReadUShort(values + x * 2);
+				break;
+			case ExrPixelType::E_Float:
+				floats.resize(width);
+				std::memcpy(floats.data(), values, static_cast<size_t>(width) * sizeof(FLOAT));
+				XMConvertFloatToHalfStream(target, TexelBytes, floats.data(), sizeof(FLOAT), width);
+				break;
+			default:
+				floats.resize(width);
+				for (UINT x = 0; x < width; ++x)
+					floats[x] = static_cast<FLOAT>(ReadUInt(values + x * 4));
+				XMConvertFloatToHalfStream(target, TexelBytes, floats.data(), sizeof(FLOAT), width);
+				break;
+			}
+
+			for (UINT i = 1; i < channel.TargetCount; ++i) {
+				for (UINT x = 0; x < width; ++x)
+					target[x * 4 + i] = target[x * 4];
+			}
+		}
+	}
+
+	BOOL DecodeExrChunk(const ExrHeader& header, const BYTE* data, UINT64 size, UINT64 offset, UINT chunk, ExrScratch& scratch, BYTE* image) {
+		if (offset > size || size - offset < 8) ReturnFalse(L"OpenEXR chunk " << chunk << L" lies outside the file");
+
+		const INT y = ReadInt(data + offset);
+		const INT dataSize = ReadInt(data + offset + 4);
+		if (dataSize < 0 || size - offset - 8 < static_cast<UINT64>(dataSize)) ReturnFalse(L"OpenEXR chunk " << chunk << L" is truncated");
+
+		const UINT row = chunk * header.LinesPerBlock;
+		if (static_cast<INT64>(y) - header.MinY != row) ReturnFalse(L"OpenEXR chunk " << chunk << L" starts at the wrong line");
+
+		const UINT lines = std::min(header.LinesPerBlock, header.Height - row);
+		const UINT64 expected = lines * header.BytesPerLine;
+
+		const BYTE* src = data + offset + 8;
+		const BYTE* block = src;
+
+		// Chunks that would not shrink are stored as they are.
+		if (static_cast<UINT64>(dataSize) != expected) {
+			scratch.Block.resize(static_cast<size_t>(expected));
+
+			switch (header.Compression) {
+			case ExrCompression::E_Rle:
+				scratch.Packed.resize(static_cast<size_t>(expected));
+				CheckReturn(DecodeExrRle(src, dataSize, scratch.Packed.data(), expected));
+				Unpredict(scratch.Packed.data(), expected, scratch.Block.data());
+				break;
+			case ExrCompression::E_Zips:
+			case ExrCompression::E_Zip: {
+				scratch.Packed.resize(static_cast<size_t>(expected));
+
+				UINT64 written = 0;
+				CheckReturn(Inflate::Decompress(src, dataSize, scratch.Packed.data(), expected, written));
+				if (written != expected) ReturnFalse(L"OpenEXR chunk " << chunk << L" inflates to " << written << L" of " << expected << L" bytes");
+
+				Unpredict(scratch.Packed.data(), expected, scratch.Block.data());
+				break;
+			}
+			case ExrCompression::E_Piz:
+				CheckReturn(DecodePiz(header, lines, src, dataSize, scratch.Huffman, scratch.Work, scratch.Block.data()));
+				break;
+			default:
+				ReturnFalse(L"OpenEXR chunk " << chunk << L" has " << dataSize << L" of " << expected << L" bytes");
+			}
+
+			block = scratch.Block.data();
+		}
+
+		const UINT64 rowPitch = static_cast<UINT64>(header.Width) * TexelBytes;
+		for (UINT line = 0; line < lines; ++line) {
+			HALF* const dst = reinterpret_cast<HALF*>(image + (row + line) * rowPitch);
+			ConvertExrLine(header, block + line * header.BytesPerLine, dst, scratch.Floats);
+		}
+
+		return TRUE;
+	}
+
+	BOOL DecodeOpenExr(const BYTE* data, UINT64 size, UINT64 numThreads, std::vector<BYTE>& texels, DdsFile::Subresource& surface) {
+		ExrHeader header;
+		const BYTE* p = nullptr;
+		CheckReturn(ReadExrHeader(data, size, header, p));
+
+		const UINT chunkCount = (header.Height + header.LinesPerBlock - 1) / header.LinesPerBlock;
+		if (static_cast<UINT64>(data + size - p) / sizeof(UINT64) < chunkCount) ReturnFalse(L"OpenEXR offset table is truncated");
+
+		std::vector<UINT64> offsets(chunkCount);
+		for (UINT chunk = 0; chunk < chunkCount; ++chunk)
+			offsets[chunk] = static_cast<UINT64>(ReadUInt(p + chunk * 8)) | (static_cast<UINT64>(ReadUInt(p + chunk * 8 + 4)) << 32);
+
+		CheckReturn(AllocateImage(header.Width, header.Height, texels, surface));
+		BYTE* const image = texels.data();
+
+		return TexelUtil::ForEachBand(chunkCount, static_cast<UINT64>(header.LinesPerBlock) * header.Width, TexelsPerTask, numThreads, [&](UINT begin, UINT end) {
+			ExrScratch scratch;
+			for (UINT chunk = begin; chunk < end; ++chunk)
+				CheckReturn(DecodeExrChunk(header, data, size, offsets[chunk], chunk, scratch, image));
+
+			return TRUE;
+		});
+	}
+}
+
+HdrFormat::Type HdrDecoder::Identify(const BYTE* data, UINT64 size) {
+	if (size >= 2 && data[0] == '#' && data[1] == '?') return HdrFormat::E_Radiance;
+	if (size >= sizeof(ExrMagic) && std::memcmp(data, ExrMagic, sizeof(ExrMagic)) == 0) return HdrFormat::E_OpenExr;
+	return HdrFormat::E_Unknown;
+}
+
+BOOL HdrDecoder::IsHdrSource(const std::string& path) {
+	const auto index = path.rfind('.');
+	if (index == std::string::npos) return FALSE;
+
+	std::string extension = path.substr(index);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) {
+		return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+	});
+
+	return extension == ".hdr" || extension == ".exr";
+}
+
+BOOL HdrDecoder::Decode(
+		const BYTE* data,
+		UINT64 size,
+		UINT64 numThreads,
+		std::vector<BYTE>& texels,
+		DdsFile::Subresource& surface) {
+	switch (Identify(data, size)) {
+	case HdrFormat::E_Radiance:
+		return DecodeRadiance(data, size, numThreads, texels, surface);
+	case HdrFormat::E_OpenExr:
+		return DecodeOpenExr(data, size, numThreads, texels, surface);
+	default:
+		ReturnFalse(L"Unknown HDR image format");
+	}
+}
+
+void HdrDecoder::DescribeBake(UINT64 sourceHash, const Settings& settings, BakeManifest& manifest) {
+	manifest.Set("Baker", std::string("HdrDecoder"));
+	manifest.Set("Version", static_cast<UINT64>(Version));
+	manifest.SetHash("SourceHash", sourceHash);
+	manifest.Set("Format", static_cast<UINT64>(settings.Format));
+	manifest.Set("Quality", static_cast<UINT64>(settings.Quality));
+	manifest.Set("GenerateMips", static_cast<UINT64>(settings.GenerateMips ? 1 : 0));
+}
+
+BOOL HdrDecoder::Cook(
+		const std::string& sourcePath,
+		const std::string& path,
+		const std::string& manifestPath,
+		const Settings& settings,
+		UINT64 numThreads) {
+	if (settings.Format != DXGI_FORMAT_R16G16B16A16_FLOAT && settings.Format != DXGI_FORMAT_BC6H_UF16)
+		ReturnFalse(L"Unsupported format for cooked HDR images: " << static_cast<UINT>(settings.Format));
+
+	MappedFile file;
+	CheckReturn(file.Open(sourcePath));
+
+	std::vector<BYTE> texels;
+	DdsFile::Subresource surface;
+	if (!Decode(file.Data(), file.Size(), numThreads, texels, surface)) ReturnFalse(L"Failed to decode HDR image: " << sourcePath.c_str());
+
+	std::vector<DdsFile::Subresource> subresources = { surface };
+
+	std::vector<BYTE> mipTexels;
+	std::vector<DdsFile::Subresource> mips;
+	if (settings.GenerateMips) {
+		MipGenerator::Settings mipSettings;
+		mipSettings.Filter = MipFilter::E_Box;
+
+		CheckReturn(MipGenerator::Generate(surface, DXGI_FORMAT_R16G16B16A16_FLOAT, mipSettings, numThreads, mipTexels, mips));
+		subresources.insert(subresources.end(), mips.begin(), mips.end());
+	}
+
+	DdsFile::Description desc = {};
+	desc.Dimension = TextureDimension::E_Texture2D;
+	desc.Format = settings.Format;
+	desc.Width = surface.Width;
+	desc.Height = surface.Height;
+	desc.Depth = 1;
+	desc.ArraySize = 1;
+	desc.MipLevels = static_cast<UINT>(subresources.size());
+
+	std::vector<std::vector<BYTE>> blocks;
+	if (settings.Format == DXGI_FORMAT_BC6H_UF16) {
+		std::vector<DdsFile::Subresource> layout;
+		UINT64 totalSize = 0;
+		CheckReturn(DdsFile::ComputeLayout(desc, layout, totalSize));
+
+		blocks.resize(subresources.size());
+		for (size_t i = 0, end = subresources.size(); i < end; ++i) {
+			CheckReturn(BlockCompressor::Compress(subresources[i], DXGI_FORMAT_R16G16B16A16_FLOAT, settings.Format, settings.Quality, numThreads, blocks[i]));
+			layout[i].Data = blocks[i].data();
+		}
+
+		subresources.swap(layout);
+	}
+
+	CheckReturn(DdsFile::Save(path, desc, subresources));
+
+	BakeManifest manifest;
+	DescribeBake(hu::hash_bytes(file.Data(), static_cast<size_t>(file.Size())), settings, manifest);
+	CheckReturn(manifest.Save(manifestPath));
+
+	WLogln(L"Cooked HDR image: ", std::wstring(sourcePath.begin(), sourcePath.end()), L" -> ", std::wstring(path.begin(), path.end()));
+
+	return TRUE;
+}
+
+BOOL HdrDecoder::IsCookCurrent(const std::string& sourcePath, const std::string& manifestPath, const Settings& settings) {
+	MappedFile file;
+	if (!file.Open(sourcePath)) return FALSE;
+
+	BakeManifest expected;
+	DescribeBake(hu::hash_bytes(file.Data(), static_cast<size_t>(file.Size())), settings, expected);
+
+	return expected.Matches(manifestPath);
+}
\ No newline at end of file
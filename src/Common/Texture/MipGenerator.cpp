@@ -0,0 +1,444 @@
+#include "Common/Texture/MipGenerator.h"
+#include "Common/Debug/Logger.h"
+#include "Common/Util/TaskQueue.h"
+#include "Common/Util/TexelUtil.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+#undef max
+#undef min
+
+namespace {
+	// Radius of the Kaiser filter in destination texels and the shape of its window.
+	const FLOAT KaiserWidth = 3.f;
+	const FLOAT KaiserAlpha = 4.f;
+
+	// Texels each task filters; rows are grouped into bands of about this size.
+	const UINT64 TexelsPerTask = 1 << 14;
+
+	const UINT CoverageIterations = 16;
+
+	// Taps of every destination texel along one axis, with the source indices already clamped or wrapped.
+	struct AxisWeights {
+		std::vector<UINT> Offsets;
+		std::vector<UINT> Indices;
+		std::vector<FLOAT> Weights;
+	};
+
+	// Level of the chain in linear float RGBA.
+	struct Image {
+		UINT Width = 0;
+		UINT Height = 0;
+		std::vector<XMFLOAT4> Texels;
+	};
+
+	FLOAT SrgbToLinear(FLOAT value) {
+		return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	FLOAT LinearToSrgb(FLOAT value) {
+		return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.f / 2.4f) - 0.055f;
+	}
+
+	const FLOAT* SrgbTable() {
+		static const std::vector<FLOAT> table = [] {
+			std::vector<FLOAT> values(256);
+			for (UINT i = 0; i < 256; ++i)
+				values[i] = SrgbToLinear(i / 255.f);
+			return values;
+		}();
+		return table.data();
+	}
+
+	__forceinline BYTE ToUnorm8(FLOAT value) {
+		return static_cast<BYTE>(std::min(std::max(value, 0.f), 1.f) * 255.f + 0.5f);
+	}
+
+	void LoadTexel(const BYTE* texel, DXGI_FORMAT format, XMFLOAT4& rgba) {
+		switch (format) {
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+			rgba = XMFLOAT4(texel[0] / 255.f, texel[1] / 255.f, texel[2] / 255.f, texel[3] / 255.f);
+			break;
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB: {
+			const FLOAT* table = SrgbTable();
+			rgba = XMFLOAT4(table[texel[0]], table[texel[1]], table[texel[2]], texel[3] / 255.f);
+			break;
+		}
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+			rgba = XMFLOAT4(texel[2] / 255.f, texel[1] / 255.f, texel[0] / 255.f, texel[3] / 255.f);
+			break;
+		case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB: {
+			const FLOAT* table = SrgbTable();
+			rgba = XMFLOAT4(table[texel[2]], table[texel[1]], table[texel[0]], texel[3] / 255.f);
+			break;
+		}
+		case DXGI_FORMAT_R16G16B16A16_FLOAT: {
+			const HALF* values = reinterpret_cast<const HALF*>(texel);
+			rgba = XMFLOAT4(
+				XMConvertHalfToFloat(values[0]),
+				XMConvertHalfToFloat(values[1]),
+				XMConvertHalfToFloat(values[2]),
+				XMConvertHalfToFloat(values[3]));
+			break;
+		}
+		default:
+			std::memcpy(&rgba, texel, sizeof(XMFLOAT4));
+			break;
+		}
+	}
+
+	void StoreTexel(const XMFLOAT4& rgba, DXGI_FORMAT format, BYTE* texel) {
+		switch (format) {
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+			texel[0] = ToUnorm8(rgba.x);
+			texel[1] = ToUnorm8(rgba.y);
+			texel[2] = ToUnorm8(rgba.z);
+			texel[3] = ToUnorm8(rgba.w);
+			break;
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+			texel[0] = ToUnorm8(LinearToSrgb(std::max(rgba.x, 0.f)));
+			texel[1] = ToUnorm8(LinearToSrgb(std::max(rgba.y, 0.f)));
+			texel[2] = ToUnorm8(LinearToSrgb(std::max(rgba.z, 0.f)));
+			texel[3] = ToUnorm8(rgba.w);
+			break;
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+			texel[0] = ToUnorm8(rgba.z);
+			texel[1] = ToUnorm8(rgba.y);
+			texel[2] = ToUnorm8(rgba.x);
+			texel[3] = ToUnorm8(rgba.w);
+			break;
+		case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+			texel[0] = ToUnorm8(LinearToSrgb(std::max(rgba.z, 0.f)));
+			texel[1] = ToUnorm8(LinearToSrgb(std::max(rgba.y, 0.f)));
+			texel[2] = ToUnorm8(LinearToSrgb(std::max(rgba.x, 0.f)));
+			texel[3] = ToUnorm8(rgba.w);
+			break;
+		case DXGI_FORMAT_R16G16B16A16_FLOAT: {
+			HALF* values = reinterpret_cast<HALF*>(texel);
+			values[0] = XMConvertFloatToHalf(rgba.x);
+			values[1] = XMConvertFloatToHalf(rgba.y);
+			values[2] = XMConvertFloatToHalf(rgba.z);
+			values[3] = XMConvertFloatToHalf(rgba.w);
+			break;
+		}
+		default:
+			std::memcpy(texel, &rgba, sizeof(XMFLOAT4));
+			break;
+		}
+	}
+
+	FLOAT Sinc(FLOAT x) {
+		if (std::abs(x) < 1e-6f) return 1.f;
+		const FLOAT px = XM_PI * x;
+		return std::sin(px) / px;
+	}
+
+	// Zeroth-order modified Bessel function of the first kind, by its power series.
+	FLOAT BesselI0(FLOAT x) {
+		const FLOAT quarterSq = x * x * 0.25f;
+		FLOAT sum = 1.f;
+		FLOAT term = 1.f;
+		for (UINT k = 1; k < 32; ++k) {
+			term *= quarterSq / static_cast<FLOAT>(k * k);
+			sum += term;
+			if (term < sum * 1e-7f) break;
+		}
+		return sum;
+	}
+
+	FLOAT Kaiser(FLOAT x) {
+		const FLOAT t = x / KaiserWidth;
+		if (std::abs(t) >= 1.f) return 0.f;
+		return Sinc(x) * BesselI0(KaiserAlpha * std::sqrt(1.f - t * t)) / BesselI0(KaiserAlpha);
+	}
+
+	UINT AddressTexel(INT index, UINT extent, BOOL wrap) {
+		const INT size = static_cast<INT>(extent);
+		if (wrap) return static_cast<UINT>(((index % size) + size) % size);
+		return static_cast<UINT>(std::min(std::max(index, 0), size - 1));
+	}
+
+	void BuildAxis(UINT sourceExtent, UINT destExtent, const MipGenerator::Settings& settings, AxisWeights& axis) {
+		const FLOAT scale = static_cast<FLOAT>(sourceExtent) / static_cast<FLOAT>(destExtent);
+
+		axis.Offsets.assign(1, 0);
+		axis.Indices.clear();
+		axis.Weights.clear();
+
+		for (UINT d = 0; d < destExtent; ++d) {
+			const size_t first = axis.Weights.size();
+
+			if (settings.Filter == MipFilter::E_Box) {
+				// Overlap of each source texel with the footprint [d, d + 1) * scale.
+				const FLOAT lo = d * scale;
+				const FLOAT hi = (d + 1) * scale;
+				for (INT s = static_cast<INT>(std::floor(lo)); static_cast<FLOAT>(s) < hi; ++s) {
+					const FLOAT weight = std::min(hi, static_cast<FLOAT>(s + 1)) - std::max(lo, static_cast<FLOAT>(s));
+					if (weight <= 0.f) continue;
+
+					axis.Indices.push_back(AddressTexel(s, sourceExtent, settings.Wrap));
+					axis.Weights.push_back(weight);
+				}
+			}
+			else {
+				// Sampled at the source texel centers, in destination texel units.
+				const FLOAT center = (d + 0.5f) * scale;
+				const FLOAT radius = KaiserWidth * scale;
+				const INT begin = static_cast<INT>(std::floor(center - radius));
+				const INT end = static_cast<INT>(std::ceil(center + radius));
+				for (INT s = begin; s <= end; ++s) {
+					const FLOAT weight = Kaiser((s + 0.5f - center) / scale);
+					if (weight == 0.f) continue;
+
+					axis.Indices.push_back(AddressTexel(s, sourceExtent, settings.Wrap));
+					axis.Weights.push_back(weight);
+				}
+			}
+
+			FLOAT sum = 0.f;
+			for (size_t i = first, end = axis.Weights.size(); i < end; ++i)
+				sum += axis.Weights[i];
+			for (size_t i = first, end = axis.Weights.size(); i < end; ++i)
+				axis.Weights[i] /= sum;
+
+			axis.Offsets.push_back(static_cast<UINT>(axis.Weights.size()));
+		}
+	}
+
+	// Filters rows horizontally into a source-height intermediate, then columns vertically.
+	BOOL Downsample(const Image& source, Image& dest, const MipGenerator::Settings& settings, UINT64 numThreads) {
+		AxisWeights horizontal;
+		AxisWeights vertical;
+		BuildAxis(source.Width, dest.Width, settings, horizontal);
+		BuildAxis(source.Height, dest.Height, settings, vertical);
+
+		std::vector<XMFLOAT4> rows(static_cast<size_t>(source.Height) * dest.Width);
+		dest.Texels.resize(static_cast<size_t>(dest.Width) * dest.Height);
+
+		CheckReturn(TexelUtil::ForEachBand(source.Height, dest.Width, TexelsPerTask, numThreads, [&](UINT begin, UINT end) {
+			for (UINT y = begin; y < end; ++y) {
+				const XMFLOAT4* input = source.Texels.data() + static_cast<size_t>(y) * source.Width;
+				XMFLOAT4* output = rows.data() + static_cast<size_t>(y) * dest.Width;
+
+				for (UINT x = 0; x < dest.Width; ++x) {
+					XMVECTOR sum = XMVectorZero();
+					for (UINT i = horizontal.Offsets[x], last = horizontal.Offsets[x + 1]; i < last; ++i)
+						sum = XMVectorMultiplyAdd(XMVectorReplicate(horizontal.Weights[i]), XMLoadFloat4(&input[horizontal.Indices[i]]), sum);
+					XMStoreFloat4(&output[x], sum);
+				}
+			}
+
+			return TRUE;
+		}));
+
+		CheckReturn(TexelUtil::ForEachBand(dest.Height, dest.Width, TexelsPerTask, numThreads, [&](UINT begin, UINT end) {
+			for (UINT y = begin; y < end; ++y) {
+				XMFLOAT4* output = dest.Texels.data() + static_cast<size_t>(y) * dest.Width;
+
+				for (UINT x = 0; x < dest.Width; ++x) {
+					XMVECTOR sum = XMVectorZero();
+					for (UINT i = vertical.Offsets[y], last = vertical.Offsets[y + 1]; i < last; ++i) {
+						const XMFLOAT4& texel = rows[static_cast<size_t>(vertical.Indices[i]) * dest.Width + x];
+						sum = XMVectorMultiplyAdd(XMVectorReplicate(vertical.Weights[i]), XMLoadFloat4(&texel), sum);
+					}
+					XMStoreFloat4(&output[x], sum);
+				}
+			}
+
+			return TRUE;
+		}));
+
+		return TRUE;
+	}
+
+	FLOAT Coverage(const Image& image, FLOAT reference) {
+		UINT64 passed = 0;
+		for (const auto& texel : image.Texels) {
+			if (texel.w > reference) ++passed;
+		}
+		return static_cast<FLOAT>(passed) / static_cast<FLOAT>(image.Texels.size());
+	}
+
+	// Scale that brings the coverage of the image closest to the target, found by bisecting the
+	// threshold the unscaled alpha would have to pass.
+	FLOAT CoverageScale(const Image& image, FLOAT reference, FLOAT target) {
+		FLOAT lo = 0.f;
+		FLOAT hi = 1.f;
+		for (UINT i = 0; i < CoverageIterations; ++i) {
+			const FLOAT mid = (lo + hi) * 0.5f;
+			if (Coverage(image, mid) > target) lo = mid;
+			else hi = mid;
+		}
+
+		const FLOAT threshold = (lo + hi) * 0.5f;
+		return threshold > 0.f ? reference / threshold : 1.f;
+	}
+
+	BOOL LoadLevel(const DdsFile::Subresource& source, DXGI_FORMAT format, Image& image) {
+		if (!MipGenerator::IsSupported(format)) ReturnFalse(L"Unsupported format for mip generation: " << format);
+		if (source.Data == nullptr || source.Width == 0 || source.Height == 0) ReturnFalse(L"Empty surface");
+		if (source.Depth != 1) ReturnFalse(L"Mip generation expects 2D surfaces");
+
+		const UINT texelSize = TextureFormat::BitsPerPixel(format) / 8;
+
+		image.Width = source.Width;
+		image.Height = source.Height;
+		image.Texels.resize(static_cast<size_t>(source.Width) * source.Height);
+
+		for (UINT y = 0; y < source.Height; ++y) {
+			const BYTE* row = source.Data + source.RowPitch * y;
+			for (UINT x = 0; x < source.Width; ++x)
+				LoadTexel(row + static_cast<UINT64>(x) * texelSize, format, image.Texels[static_cast<size_t>(y) * source.Width + x]);
+		}
+
+		return TRUE;
+	}
+}
+
+BOOL MipGenerator::IsSupported(DXGI_FORMAT format) {
+	switch (format) {
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+	case DXGI_FORMAT_B8G8R8A8_UNORM:
+	case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+	case DXGI_FORMAT_R32G32B32A32_FLOAT:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+BOOL MipGenerator::Generate(
+		const DdsFile::Subresource& source,
+		DXGI_FORMAT format,
+		const Settings& settings,
+		UINT64 numThreads,
+		std::vector<BYTE>& texels,
+		std::vector<DdsFile::Subresource>& mips) {
+	Image current;
+	CheckReturn(LoadLevel(source, format, current));
+
+	const UINT mipLevels = TextureFormat::MipCount(std::max(source.Width, source.Height));
+	const UINT texelSize = TextureFormat::BitsPerPixel(format) / 8;
+
+	mips.clear();
+	UINT64 totalSize = 0;
+	for (UINT mip = 1; mip < mipLevels; ++mip) {
+		DdsFile::Subresource subresource = {};
+		subresource.Width = TextureFormat::MipExtent(source.Width, mip);
+		subresource.Height = TextureFormat::MipExtent(source.Height, mip);
+		subresource.Depth = 1;
+		subresource.RowCount = subresource.Height;
+		subresource.RowPitch = static_cast<UINT64>(subresource.Width) * texelSize;
+		subresource.SlicePitch = subresource.RowPitch * subresource.Height;
+
+		mips.push_back(subresource);
+		totalSize += subresource.SlicePitch;
+	}
+
+	texels.resize(static_cast<size_t>(totalSize));
+
+	const BOOL preserveCoverage = settings.AlphaReference > 0.f;
+	const FLOAT targetCoverage = preserveCoverage ? Coverage(current, settings.AlphaReference) : 0.f;
+
+	UINT64 offset = 0;
+	for (auto& mip : mips) {
+		Image next;
+		next.Width = mip.Width;
+		next.Height = mip.Height;
+		CheckReturn(Downsample(current, next, settings, numThreads));
+
+		// The chain continues from the unscaled alpha, so the scales do not compound.
+		const FLOAT alphaScale = preserveCoverage ? CoverageScale(next, settings.AlphaReference, targetCoverage) : 1.f;
+
+		BYTE* const output = texels.data() + offset;
+		CheckReturn(TexelUtil::ForEachBand(mip.Height, mip.Width, TexelsPerTask, numThreads, [&](UINT begin, UINT end) {
+			for (UINT y = begin; y < end; ++y) {
+				for (UINT x = 0; x < mip.Width; ++x) {
+					XMFLOAT4 texel = next.Texels[static_cast<size_t>(y) * mip.Width + x];
+					if (preserveCoverage) texel.w = std::min(texel.w * alphaScale, 1.f);
+					StoreTexel(texel, format, output + mip.RowPitch * y + static_cast<UINT64>(x) * texelSize);
+				}
+			}
+
+			return TRUE;
+		}));
+
+		mip.Data = output;
+		offset += mip.SlicePitch;
+
+		current = std::move(next);
+	}
+
+	return TRUE;
+}
+
+BOOL MipGenerator::GenerateTexture(const DdsFile& source, const Settings& settings, UINT64 numThreads, const std::string& path) {
+	DdsFile::Description desc = source.Desc();
+	if (desc.Dimension != TextureDimension::E_Texture2D) ReturnFalse(L"Mip generation expects 2D textures");
+
+	const UINT sourceLevels = desc.MipLevels;
+	desc.MipLevels = TextureFormat::MipCount(std::max(desc.Width, desc.Height));
+
+	std::vector<DdsFile::Subresource> layout;
+	UINT64 totalSize = 0;
+	CheckReturn(DdsFile::ComputeLayout(desc, layout, totalSize));
+
+	std::vector<std::vector<BYTE>> texels(desc.ArraySize);
+	for (UINT slice = 0; slice < desc.ArraySize; ++slice) {
+		const auto& top = source.Subresources()[static_cast<size_t>(slice) * sourceLevels];
+
+		std::vector<DdsFile::Subresource> mips;
+		CheckReturn(Generate(top, desc.Format, settings, numThreads, texels[slice], mips));
+
+		const size_t first = static_cast<size_t>(slice) * desc.MipLevels;
+		layout[first].Data = top.Data;
+		layout[first].RowPitch = top.RowPitch;
+		layout[first].SlicePitch = top.SlicePitch;
+		for (size_t mip = 0, end = mips.size(); mip < end; ++mip)
+			layout[first + mip + 1].Data = mips[mip].Data;
+	}
+
+	CheckReturn(DdsFile::Save(path, desc, layout));
+
+	return TRUE;
+}
+
+BOOL MipGenerator::GenerateTextures(
+		const std::vector<std::pair<std::string, std::string>>& files,
+		const Settings& settings,
+		UINT64 numThreads) {
+	auto generate = [&settings](const std::pair<std::string, std::string>& file) {
+		DdsFile source;
+		if (!source.Open(file.first)) return false;
+		if (!GenerateTexture(source, settings, 1, file.second)) {
+			WLogln(L"Failed to generate mips: ", std::wstring(file.first.begin(), file.first.end()));
+			return false;
+		}
+		return true;
+	};
+
+	if (numThreads > 1 && files.size() > 1) {
+		TaskQueue taskQueue;
+		for (const auto& file : files) {
+			taskQueue.AddTask([&generate, &file] {
+				return generate(file);
+			});
+		}
+
+		CheckReturn(taskQueue.Run(std::min<UINT64>(numThreads, files.size())));
+	}
+	else {
+		for (const auto& file : files) CheckReturn(generate(file));
+	}
+
+	return TRUE;
+}
\ No newline at end of file
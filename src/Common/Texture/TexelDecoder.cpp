@@ -0,0 +1,104 @@
+#include "Common/Texture/TexelDecoder.h"
+#include "Common/Debug/Logger.h"
+#include "Common/Texture/BlockCodec.h"
+
+#include <cmath>
+#include <cstring>
+#include <DirectXPackedVector.h>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+#undef max
+#undef min
+
+namespace {
+	FLOAT SrgbToLinear(BYTE value) {
+		const FLOAT v = value / 255.f;
+		return v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+	}
+
+	void DecodeTexel(const BYTE* texel, DXGI_FORMAT format, XMFLOAT4& rgba) {
+		switch (format) {
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+			rgba = XMFLOAT4(texel[0] / 255.f, texel[1] / 255.f, texel[2] / 255.f, texel[3] / 255.f);
+			break;
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+			rgba = XMFLOAT4(SrgbToLinear(texel[0]), SrgbToLinear(texel[1]), SrgbToLinear(texel[2]), texel[3] / 255.f);
+			break;
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+			rgba = XMFLOAT4(texel[2] / 255.f, texel[1] / 255.f, texel[0] / 255.f, texel[3] / 255.f);
+			break;
+		case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+			rgba = XMFLOAT4(SrgbToLinear(texel[2]), SrgbToLinear(texel[1]), SrgbToLinear(texel[0]), texel[3] / 255.f);
+			break;
+		case DXGI_FORMAT_R16G16B16A16_FLOAT: {
+			const HALF* values = reinterpret_cast<const HALF*>(texel);
+			rgba = XMFLOAT4(
+				XMConvertHalfToFloat(values[0]),
+				XMConvertHalfToFloat(values[1]),
+				XMConvertHalfToFloat(values[2]),
+				XMConvertHalfToFloat(values[3]));
+			break;
+		}
+		case DXGI_FORMAT_R32G32B32_FLOAT:
+			std::memcpy(&rgba, texel, sizeof(XMFLOAT3));
+			rgba.w = 1.f;
+			break;
+		default:
+			std::memcpy(&rgba, texel, sizeof(XMFLOAT4));
+			break;
+		}
+	}
+}
+
+BOOL TexelDecoder::IsSupported(DXGI_FORMAT format) {
+	switch (format) {
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+	case DXGI_FORMAT_B8G8R8A8_UNORM:
+	case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+	case DXGI_FORMAT_R32G32B32A32_FLOAT:
+	case DXGI_FORMAT_R32G32B32_FLOAT:
+	case DXGI_FORMAT_BC6H_UF16:
+	case DXGI_FORMAT_BC6H_SF16:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+BOOL TexelDecoder::Decode(const DdsFile::Subresource& surface, DXGI_FORMAT format, std::vector<XMFLOAT4>& texels) {
+	if (!IsSupported(format)) ReturnFalse(L"Unsupported format for decoding: " << format);
+	if (surface.Data == nullptr || surface.Width == 0 || surface.Height == 0) ReturnFalse(L"Empty surface");
+
+	const UINT width = surface.Width;
+	const UINT height = surface.Height;
+	texels.resize(static_cast<size_t>(width) * height);
+
+	if (format == DXGI_FORMAT_BC6H_UF16 || format == DXGI_FORMAT_BC6H_SF16) {
+		FLOAT block[BlockCodec::BlockTexels * 4];
+		for (UINT by = 0; by < (height + 3) / 4; ++by) {
+			const BYTE* row = surface.Data + surface.RowPitch * by;
+			for (UINT bx = 0; bx < (width + 3) / 4; ++bx) {
+				BlockCodec::DecodeBC6H(row + bx * 16, format == DXGI_FORMAT_BC6H_SF16, block);
+
+				for (UINT y = 0; y < 4 && by * 4 + y < height; ++y) {
+					for (UINT x = 0; x < 4 && bx * 4 + x < width; ++x)
+						std::memcpy(&texels[static_cast<size_t>(by * 4 + y) * width + bx * 4 + x], block + (y * 4 + x) * 4, sizeof(XMFLOAT4));
+				}
+			}
+		}
+		return TRUE;
+	}
+
+	const UINT texelSize = TextureFormat::BitsPerPixel(format) / 8;
+	for (UINT y = 0; y < height; ++y) {
+		const BYTE* row = surface.Data + surface.RowPitch * y;
+		for (UINT x = 0; x < width; ++x)
+			DecodeTexel(row + static_cast<UINT64>(x) * texelSize, format, texels[static_cast<size_t>(y) * width + x]);
+	}
+
+	return TRUE;
+}
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "Common/Texture/TextureRegistry.h"
+#include "Common/Debug/Logger.h"
+#include "Common/HashUtil.h"
+#include "Common/Util/BakeManifest.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+
+#undef max
+#undef min
+
+BOOL TextureRegistry::Acquire(const std::string& path, UINT newTexture, UINT& texture, BOOL& created) {
+	const std::string key = NormalizePath(path);
+
+	const auto pathIter = mPaths.find(key);
+	if (pathIter != mPaths.end()) {
+		Entry& entry = mEntries[pathIter->second];
+		++entry.References;
+
+		++mStats.References;
+		++mStats.PathHits;
+		mStats.SavedBytes += entry.Bytes;
+
+		texture = pathIter->second;
+		created = FALSE;
+
+		return TRUE;
+	}
+
+	DdsFile file;
+	CheckReturn(file.Open(path));
+
+	UINT64 bytes = 0;
+	for (const auto& subresource : file.Subresources())
+		bytes += subresource.SlicePitch * subresource.Depth;
+
+	const UINT64 hash = CachedContentHash(path, file);
+
+	const auto hashIter = mHashes.find(hash);
+	if (hashIter != mHashes.end()) {
+		Entry& entry = mEntries[hashIter->second];
+		if (entry.Bytes != bytes) ReturnFalse(L"Content hash collision for texture " << hashIter->second);
+
+		++entry.References;
+		entry.Paths.push_back(key);
+		mPaths.emplace(key, hashIter->second);
+
+		++mStats.References;
+		++mStats.ContentHits;
+		mStats.SavedBytes += bytes;
+
+		texture = hashIter->second;
+		created = FALSE;
+
+		return TRUE;
+	}
+
+	if (mEntries.count(newTexture) != 0) ReturnFalse(L"Texture " << newTexture << L" is already registered");
+
+	Entry& entry = mEntries[newTexture];
+	entry.Hash = hash;
+	entry.Bytes = bytes;
+	entry.References = 1;
+	entry.Paths.push_back(key);
+
+	mHashes.emplace(hash, newTexture);
+	mPaths.emplace(key, newTexture);
+
+	++mStats.Textures;
+	++mStats.References;
+	mStats.UniqueBytes += bytes;
+
+	texture = newTexture;
+	created = TRUE;
+
+	return TRUE;
+}
+
+BOOL TextureRegistry::Release(UINT texture) {
+	const auto iter = mEntries.find(texture);
+	if (iter == mEntries.end()) return FALSE;
+
+	Entry& entry = iter->second;
+	--mStats.References;
+	if (--entry.References > 0) return FALSE;
+
+	for (const auto& path : entry.Paths)
+		mPaths.erase(path);
+	mHashes.erase(entry.Hash);
+
+	--mStats.Textures;
+	mStats.UniqueBytes -= entry.Bytes;
+
+	mEntries.erase(iter);
+
+	return TRUE;
+}
+
+void TextureRegistry::Clear() {
+	mEntries.clear();
+	mHashes.clear();
+	mPaths.clear();
+	mStats = Statistics();
+}
+
+UINT64 TextureRegistry::ContentHash(const DdsFile& file) {
+	// The description is hashed as well, so the same bytes under another format or shape differ.
+	UINT64 hash = hu::hash_bytes(&file.Desc(), sizeof(DdsFile::Description));
+
+	for (const auto& subresource : file.Subresources())
+		hash = hu::hash_bytes(subresource.Data, static_cast<size_t>(subresource.SlicePitch * subresource.Depth), hash);
+
+	return hash;
+}
+
+UINT64 TextureRegistry::CachedContentHash(const std::string& path, const DdsFile& file) {
+	std::error_code error;
+	const UINT64 size = std::filesystem::file_size(path, error);
+	if (error) return ContentHash(file);
+
+	const auto writeTime = std::filesystem::last_write_time(path, error);
+	if (error) return ContentHash(file);
+
+	const std::string manifestPath = path + ".hash";
+
+	BakeManifest expected;
+	expected.Set("Size", size);
+	expected.Set("WriteTime", static_cast<UINT64>(writeTime.time_since_epoch().count()));
+
+	BakeManifest stored;
+	UINT64 hash = 0;
+	if (stored.Load(manifestPath) && stored.GetHash("ContentHash", hash)) {
+		expected.SetHash("ContentHash", hash);
+		if (expected.Matches(manifestPath)) return hash;
+	}
+
+	hash = ContentHash(file);
+	expected.SetHash("ContentHash", hash);
+
+	// A manifest that cannot be written only costs hashing the file again next time.
+	expected.Save(manifestPath);
+
+	return hash;
+}
+
+std::string TextureRegistry::NormalizePath(const std::string& path) {
+	std::string normalized = std::filesystem::path(path).lexically_normal().generic_string();
+	std::transform(normalized.begin(), normalized.end(), normalized.begin(), [](char c) {
+		return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+	});
+
+	return normalized;
+}
\ No newline at end of file
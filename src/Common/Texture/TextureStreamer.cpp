@@ -0,0 +1,213 @@
+#include "Common/Texture/TextureStreamer.h"
+#include "Common/Debug/Logger.h"
+
+#include <algorithm>
+#include <cmath>
+
+#undef max
+#undef min
+
+struct TextureStreamer::Entry {
+	DdsFile File;
+	// Bytes of mips [mip, MipLevels) of every slice, for each mip and one past the last.
+	std::vector<UINT64> Sizes;
+
+	UINT TailMip;
+	UINT ResidentMip;
+
+	// Finest mip and largest priority requested since the last update.
+	UINT RequestedMip;
+	FLOAT Priority;
+
+	// Finest mip requested within the last EvictionDelay frames and the frame it was last requested.
+	UINT WantedMip;
+	UINT64 WantedFrame;
+
+	// Wanted mip once the memory budget is applied.
+	UINT TargetMip;
+};
+
+TextureStreamer::TextureStreamer(TextureStreamingDevice* device) : mDevice(device) {}
+
+// Textures still registered keep their GPU copies; the device releases them with its own resources.
+TextureStreamer::~TextureStreamer() = default;
+
+BOOL TextureStreamer::AddTexture(UINT texture, const std::string& path) {
+	if (mEntries.count(texture) != 0) ReturnFalse(L"Texture " << texture << L" is already streamed");
+
+	auto entry = std::make_unique<Entry>();
+	CheckReturn(entry->File.Open(path));
+
+	const auto& desc = entry->File.Desc();
+
+	entry->Sizes.assign(desc.MipLevels + 1, 0);
+	for (UINT mip = desc.MipLevels; mip-- > 0;) {
+		UINT64 bytes = 0;
+		for (UINT slice = 0; slice < desc.ArraySize; ++slice) {
+			const auto& subresource = entry->File.GetSubresource(mip, slice);
+			bytes += subresource.SlicePitch * subresource.Depth;
+		}
+		entry->Sizes[mip] = entry->Sizes[mip + 1] + bytes;
+	}
+
+	UINT tail = 0;
+	while (tail + 1 < desc.MipLevels &&
+		std::max(TextureFormat::MipExtent(desc.Width, tail), TextureFormat::MipExtent(desc.Height, tail)) > TailExtent) ++tail;
+
+	entry->TailMip = tail;
+	entry->ResidentMip = desc.MipLevels;
+	entry->RequestedMip = tail;
+	entry->Priority = 0.f;
+	entry->WantedMip = tail;
+	entry->WantedFrame = mFrame;
+	entry->TargetMip = tail;
+
+	CheckReturn(SetResidentMip(texture, *entry, tail));
+
+	mEntries.emplace(texture, std::move(entry));
+
+	return TRUE;
+}
+
+void TextureStreamer::RemoveTexture(UINT texture) {
+	const auto iter = mEntries.find(texture);
+	if (iter == mEntries.end()) return;
+
+	mDevice->ReleaseTexture(texture);
+	mResidentBytes -= iter->second->Sizes[iter->second->ResidentMip];
+
+	mEntries.erase(iter);
+}
+
+void TextureStreamer::Clear() {
+	for (const auto& pair : mEntries)
+		mDevice->ReleaseTexture(pair.first);
+
+	mEntries.clear();
+	mResidentBytes = 0;
+	mStats = Statistics();
+}
+
+void TextureStreamer::Request(UINT texture, FLOAT uvPerUnit, FLOAT pixelsPerUnit) {
+	const auto iter = mEntries.find(texture);
+	if (iter == mEntries.end() || !(uvPerUnit > 0.f) || !(pixelsPerUnit > 0.f)) return;
+
+	Entry& entry = *iter->second;
+	const auto& desc = entry.File.Desc();
+
+	// Rounding the level down keeps at least one texel per pixel.
+	const FLOAT texelsPerPixel = std::max(desc.Width, desc.Height) * uvPerUnit / pixelsPerUnit;
+	const UINT mip = texelsPerPixel > 1.f ? static_cast<UINT>(std::log2(texelsPerPixel)) : 0;
+
+	entry.RequestedMip = std::min(entry.RequestedMip, mip);
+	entry.Priority = std::max(entry.Priority, pixelsPerUnit / uvPerUnit);
+}
+
+BOOL TextureStreamer::Update() {
+	++mFrame;
+	mStats = Statistics();
+
+	std::vector<std::pair<UINT, Entry*>> entries;
+	entries.reserve(mEntries.size());
+
+	for (const auto& pair : mEntries) {
+		Entry& entry = *pair.second;
+
+		if (entry.RequestedMip <= entry.WantedMip || mFrame - entry.WantedFrame >= EvictionDelay) {
+			entry.WantedMip = entry.RequestedMip;
+			entry.WantedFrame = mFrame;
+		}
+
+		entry.TargetMip = entry.WantedMip;
+		mStats.RequestedBytes += entry.Sizes[entry.TargetMip];
+
+		entries.emplace_back(pair.first, &entry);
+	}
+
+	ApplyBudget(entries);
+
+	// Evictions go first to make room for the uploads.
+	for (const auto& pair : entries) {
+		Entry& entry = *pair.second;
+		if (entry.ResidentMip >= entry.TargetMip || mDevice->IsReplacing(pair.first)) continue;
+
+		CheckReturn(SetResidentMip(pair.first, entry, entry.TargetMip));
+		++mStats.Downgrades;
+	}
+
+	// Uploads by priority; equal priorities favor the textures furthest from their targets.
+	std::sort(entries.begin(), entries.end(), [](const std::pair<UINT, Entry*>& a, const std::pair<UINT, Entry*>& b) {
+		if (a.second->Priority != b.second->Priority) return a.second->Priority > b.second->Priority;
+
+		const INT distanceA = static_cast<INT>(a.second->ResidentMip) - static_cast<INT>(a.second->TargetMip);
+		const INT distanceB = static_cast<INT>(b.second->ResidentMip) - static_cast<INT>(b.second->TargetMip);
+		if (distanceA != distanceB) return distanceA > distanceB;
+
+		return a.first < b.first;
+	});
+
+	for (const auto& pair : entries) {
+		Entry& entry = *pair.second;
+		if (entry.ResidentMip <= entry.TargetMip || mDevice->IsReplacing(pair.first)) continue;
+
+		const UINT mip = entry.ResidentMip - 1;
+		const UINT64 bytes = entry.Sizes[mip] - entry.Sizes[entry.ResidentMip];
+
+		if (mStats.UploadedBytes > 0 && mStats.UploadedBytes + bytes > mSettings.UploadBudget) break;
+		if (mResidentBytes + bytes > mSettings.MemoryBudget) continue;
+
+		CheckReturn(SetResidentMip(pair.first, entry, mip));
+		mStats.UploadedBytes += bytes;
+		++mStats.Upgrades;
+	}
+
+	for (const auto& pair : entries) {
+		pair.second->RequestedMip = pair.second->TailMip;
+		pair.second->Priority = 0.f;
+	}
+
+	mStats.ResidentBytes = mResidentBytes;
+
+	return TRUE;
+}
+
+BOOL TextureStreamer::SetResidentMip(UINT texture, Entry& entry, UINT mip) {
+	CheckReturn(mDevice->SetResidentMips(texture, entry.File, mip));
+
+	mResidentBytes = mResidentBytes - entry.Sizes[entry.ResidentMip] + entry.Sizes[mip];
+	entry.ResidentMip = mip;
+
+	return TRUE;
+}
+
+// Coarsens the targets one mip per texture and round, lowest priority first, until they fit. The
+// mip tails are always kept, so the budget may still be exceeded when it cannot even hold those.
+void TextureStreamer::ApplyBudget(std::vector<std::pair<UINT, Entry*>>& entries) {
+	UINT64 total = mStats.RequestedBytes;
+	if (total <= mSettings.MemoryBudget) return;
+
+	std::sort(entries.begin(), entries.end(), [](const std::pair<UINT, Entry*>& a, const std::pair<UINT, Entry*>& b) {
+		if (a.second->Priority != b.second->Priority) return a.second->Priority < b.second->Priority;
+		return a.first < b.first;
+	});
+
+	BOOL progress = TRUE;
+	while (total > mSettings.MemoryBudget && progress) {
+		progress = FALSE;
+
+		for (const auto& pair : entries) {
+			Entry& entry = *pair.second;
+			if (entry.TargetMip >= entry.TailMip) continue;
+
+			total -= entry.Sizes[entry.TargetMip] - entry.Sizes[entry.TargetMip + 1];
+			++entry.TargetMip;
+			progress = TRUE;
+
+			if (total <= mSettings.MemoryBudget) break;
+		}
+	}
+
+	for (const auto& pair : entries) {
+		if (pair.second->TargetMip > pair.second->WantedMip) ++mStats.BudgetLimited;
+	}
+}
\ No newline at end of file
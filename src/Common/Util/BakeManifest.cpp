@@ -0,0 +1,76 @@
+#include "Common/Util/BakeManifest.h"
+#include "Common/Debug/Logger.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+void BakeManifest::Set(const std::string& key, const std::string& value) {
+	mEntries[key] = value;
+}
+
+void BakeManifest::Set(const std::string& key, UINT64 value) {
+	mEntries[key] = std::to_string(value);
+}
+
+// Nine significant digits round trip every float exactly.
+void BakeManifest::Set(const std::string& key, FLOAT value) {
+	std::ostringstream stream;
+	stream << std::setprecision(9) << value;
+	mEntries[key] = stream.str();
+}
+
+void BakeManifest::SetHash(const std::string& key, UINT64 hash) {
+	std::ostringstream stream;
+	stream << std::hex << std::setw(16) << std::setfill('0') << hash;
+	mEntries[key] = stream.str();
+}
+
+BOOL BakeManifest::GetHash(const std::string& key, UINT64& hash) const {
+	const auto iter = mEntries.find(key);
+	if (iter == mEntries.end() || iter->second.size() != 16) return FALSE;
+
+	std::istringstream stream(iter->second);
+	stream >> std::hex >> hash;
+
+	return !stream.fail();
+}
+
+BOOL BakeManifest::Load(const std::string& path) {
+	std::ifstream file(path);
+	if (!file.is_open()) return FALSE;
+
+	mEntries.clear();
+
+	std::string line;
+	while (std::getline(file, line)) {
+		if (line.empty()) continue;
+
+		const auto separator = line.find('=');
+		if (separator == std::string::npos) ReturnFalse(L"Malformed bake manifest line: " << path.c_str());
+
+		mEntries[line.substr(0, separator)] = line.substr(separator + 1);
+	}
+
+	return TRUE;
+}
+
+BOOL BakeManifest::Save(const std::string& path) const {
+	std::ofstream file(path, std::ios::trunc);
+	if (!file.is_open()) ReturnFalse(L"Failed to write the bake manifest: " << path.c_str());
+
+	for (const auto& entry : mEntries)
+		file << entry.first << '=' << entry.second << '\n';
+
+	file.close();
+	if (file.fail()) ReturnFalse(L"Failed to write the bake manifest: " << path.c_str());
+
+	return TRUE;
+}
+
+BOOL BakeManifest::Matches(const std::string& path) const {
+	BakeManifest stored;
+	if (!stored.Load(path)) return FALSE;
+
+	return stored.mEntries == mEntries;
+}
\ No newline at end of file
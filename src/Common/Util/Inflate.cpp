@@ -0,0 +1,361 @@
+#include "Common/Util/Inflate.h"
+#include "Common/Debug/Logger.h"
+
+#include <cstring>
+
+#undef max
+#undef min
+
+namespace {
+	const UINT MaxCodeLength = 15;
+	const UINT LiteralCodeCount = 288;
+	const UINT DistanceCodeCount = 32;
+
+	const USHORT LengthBase[] = {
+		3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	const BYTE LengthExtra[] = {
+		0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	const USHORT DistanceBase[] = {
+		1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073,
+		4097, 6145, 8193, 12289, 16385, 24577 };
+	const BYTE DistanceExtra[] = {
+		0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+	// Order the code length code lengths are stored in.
+	const BYTE CodeLengthOrder[] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	// DEFLATE packs bits from the least significant end of each byte.
+	class BitReader {
+	public:
+		BitReader(const BYTE* data, UINT64 size) : mData(data), mSize(size) {}
+
+	public:
+		__forceinline void Refill() {
+			while (mCount <= 56) {
+				if (mPos < mSize) mBits |= static_cast<UINT64>(mData[mPos]) << mCount;
+				++mPos;
+				mCount += 8;
+			}
+		}
+
+		__forceinline UINT Peek() const { return static_cast<UINT>(mBits); }
+
+		__forceinline void Consume(UINT count) {
+			mBits >>= count;
+			mCount -= count;
+		}
+
+		__forceinline UINT Bits(UINT count) {
+			if (count == 0) return 0;
+			if (mCount < count) Refill();
+			const UINT value = static_cast<UINT>(mBits & ((1ull << count) - 1));
+			Consume(count);
+			return value;
+		}
+
+		// Drops the partial byte and hands the buffered whole bytes back to the stream.
+		void AlignToByte() {
+			Consume(mCount & 7);
+			mPos -= mCount / 8;
+			mBits = 0;
+			mCount = 0;
+		}
+
+		// Reading past the end fills zeros; the stream is broken once any of them are consumed.
+		__forceinline BOOL Overrun() const { return mPos * 8 - mCount > mSize * 8; }
+
+		__forceinline UINT64 Position() const { return mPos; }
+		__forceinline void Skip(UINT64 bytes) { mPos += bytes; }
+		__forceinline const BYTE* Data() const { return mData; }
+		__forceinline UINT64 Size() const { return mSize; }
+
+	private:
+		const BYTE* mData;
+		UINT64 mSize;
+		UINT64 mPos = 0;
+		UINT64 mBits = 0;
+		UINT mCount = 0;
+	};
+
+	// Canonical Huffman code; the fast table holds the symbol and length of every code up to
+	// FastBits long under all of its bit-reversed prefixes, and zero lengths for longer codes.
+	struct Huffman {
+		USHORT Counts[MaxCodeLength + 1];
+		USHORT Symbols[LiteralCodeCount];
+		USHORT FastSymbols[1 << Inflate::FastBits];
+		BYTE FastLengths[1 << Inflate::FastBits];
+
+		BOOL Build(const BYTE* lengths, UINT count) {
+			std::memset(Counts, 0, sizeof(Counts));
+			std::memset(FastLengths, 0, sizeof(FastLengths));
+
+			for (UINT i = 0; i < count; ++i)
+				++Counts[lengths[i]];
+			Counts[0] = 0;
+
+			// Over-subscribed codes are malformed; incomplete ones are allowed for single codes.
+			INT left = 1;
+			for (UINT len = 1; len <= MaxCodeLength; ++len) {
+				left <<= 1;
+				left -= Counts[len];
+				if (left < 0) return FALSE;
+			}
+
+			USHORT offsets[MaxCodeLength + 2];
+			offsets[1] = 0;
+			for (UINT len = 1; len <= MaxCodeLength; ++len)
+				offsets[len + 1] = offsets[len] + Counts[len];
+
+			UINT code = 0;
+			USHORT next[MaxCodeLength + 1];
+			for (UINT len = 1; len <= MaxCodeLength; ++len) {
+				next[len] = static_cast<USHORT>(code);
+				code = (code + Counts[len]) << 1;
+			}
+
+			for (UINT symbol = 0; symbol < count; ++symbol) {
+				const UINT len = lengths[symbol];
+				if (len == 0) continue;
+
+				Symbols[offsets[len]++] = static_cast<USHORT>(symbol);
+
+				const UINT canonical = next[len]++;
+				if (len > Inflate::FastBits) continue;
+
+				UINT reversed = 0;
+				for (UINT bit = 0; bit < len; ++bit)
+					reversed |= ((canonical >> bit) & 1) << (len - 1 - bit);
+
+				for (UINT index = reversed; index < (1u << Inflate::FastBits); index += 1u << len) {
+					FastSymbols[index] = static_cast<USHORT>(symbol);
+					FastLengths[index] = static_cast<BYTE>(len);
+				}
+			}
+
+			return TRUE;
+		}
+
+		// Returns the symbol, or -1 for a code the table does not hold.
+		__forceinline INT Decode(BitReader& reader) const {
+			reader.Refill();
+
+			const UINT bits = reader.Peek();
+			const UINT fast = bits & ((1u << Inflate::FastBits) - 1);
+			if (FastLengths[fast] != 0) {
+				reader.Consume(FastLengths[fast]);
+				return FastSymbols[fast];
+			}
+
+			INT code = 0;
+			INT first = 0;
+			INT index = 0;
+			for (UINT len = 1; len <= MaxCodeLength; ++len) {
+				code |= (bits >> (len - 1)) & 1;
+				const INT count = Counts[len];
+				if (code - count < first) {
+					reader.Consume(len);
+					return Symbols[index + (code - first)];
+				}
+				index += count;
+				first += count;
+				first <<= 1;
+				code <<= 1;
+			}
+
+			return -1;
+		}
+	};
+
+	BOOL InflateCodes(BitReader& reader, const Huffman& literals, const Huffman& distances, BYTE* dst, UINT64 dstSize, UINT64& pos) {
+		for (;;) {
+			const INT symbol = literals.Decode(reader);
+			if (symbol < 0) ReturnFalse(L"Invalid literal/length code");
+
+			if (symbol < 256) {
+				if (pos >= dstSize) ReturnFalse(L"Inflated data exceeds " << dstSize << L" bytes");
+				dst[pos++] = static_cast<BYTE>(symbol);
+				continue;
+			}
+			if (symbol == 256) break;
+
+			const UINT lengthCode = static_cast<UINT>(symbol) - 257;
+			if (lengthCode >= 29) ReturnFalse(L"Invalid length code: " << symbol);
+			const UINT length = LengthBase[lengthCode] + reader.Bits(LengthExtra[lengthCode]);
+
+			const INT distanceCode = distances.Decode(reader);
+			if (distanceCode < 0 || distanceCode >= 30) ReturnFalse(L"Invalid distance code: " << distanceCode);
+			const UINT distance = DistanceBase[distanceCode] + reader.Bits(DistanceExtra[distanceCode]);
+
+			if (distance > pos) ReturnFalse(L"Distance " << distance << L" reaches before the output");
+			if (length > dstSize - pos) ReturnFalse(L"Inflated data exceeds " << dstSize << L" bytes");
+
+			// Overlapping copies repeat the last distance bytes, so they go byte by byte.
+			const BYTE* from = dst + pos - distance;
+			BYTE* to = dst + pos;
+			if (distance >= length) {
+				std::memcpy(to, from, length);
+			}
+			else {
+				for (UINT i = 0; i < length; ++i)
+					to[i] = from[i];
+			}
+			pos += length;
+		}
+
+		if (reader.Overrun()) ReturnFalse(L"DEFLATE stream is truncated");
+
+		return TRUE;
+	}
+
+	BOOL InflateStored(BitReader& reader, BYTE* dst, UINT64 dstSize, UINT64& pos) {
+		reader.AlignToByte();
+
+		const UINT64 start = reader.Position();
+		if (start > reader.Size() || reader.Size() - start < 4) ReturnFalse(L"DEFLATE stream is truncated");
+
+		const BYTE* header = reader.Data() + start;
+		const UINT length = header[0] | (header[1] << 8);
+		const UINT complement = header[2] | (header[3] << 8);
+		if ((length ^ 0xFFFFu) != complement) ReturnFalse(L"Corrupt stored block length");
+
+		if (reader.Size() - start - 4 < length) ReturnFalse(L"DEFLATE stream is truncated");
+		if (length > dstSize - pos) ReturnFalse(L"Inflated data exceeds " << dstSize << L" bytes");
+
+		std::memcpy(dst + pos, header + 4, length);
+		pos += length;
+		reader.Skip(4 + static_cast<UINT64>(length));
+
+		return TRUE;
+	}
+
+	BOOL ReadDynamicCodes(BitReader& reader, Huffman& literals, Huffman& distances) {
+		const UINT literalCount = reader.Bits(5) + 257;
+		const UINT distanceCount = reader.Bits(5) + 1;
+		const UINT codeLengthCount = reader.Bits(4) + 4;
+		if (literalCount > 286 || distanceCount > 30) ReturnFalse(L"Too many DEFLATE codes");
+
+		BYTE lengths[LiteralCodeCount + DistanceCodeCount] = {};
+		for (UINT i = 0; i < codeLengthCount; ++i)
+			lengths[CodeLengthOrder[i]] = static_cast<BYTE>(reader.Bits(3));
+
+		Huffman codeLengths;
+		if (!codeLengths.Build(lengths, 19)) ReturnFalse(L"Invalid code length code");
+
+		const UINT total = literalCount + distanceCount;
+		std::memset(lengths, 0, sizeof(lengths));
+
+		for (UINT i = 0; i < total;) {
+			const INT symbol = codeLengths.Decode(reader);
+			if (symbol < 0) ReturnFalse(L"Invalid code length symbol");
+
+			if (symbol < 16) {
+				lengths[i++] = static_cast<BYTE>(symbol);
+				continue;
+			}
+
+			BYTE value = 0;
+			UINT repeat = 0;
+			if (symbol == 16) {
+				if (i == 0) ReturnFalse(L"Code length repeat without a previous length");
+				value = lengths[i - 1];
+				repeat = 3 + reader.Bits(2);
+			}
+			else if (symbol == 17) {
+				repeat = 3 + reader.Bits(3);
+			}
+			else {
+				repeat = 11 + reader.Bits(7);
+			}
+
+			if (i + repeat > total) ReturnFalse(L"Code lengths overflow");
+			while (repeat-- > 0)
+				lengths[i++] = value;
+		}
+
+		if (lengths[256] == 0) ReturnFalse(L"Missing end-of-block code");
+
+		if (!literals.Build(lengths, literalCount)) ReturnFalse(L"Invalid literal/length code lengths");
+		if (!distances.Build(lengths + literalCount, distanceCount)) ReturnFalse(L"Invalid distance code lengths");
+
+		return TRUE;
+	}
+
+	UINT Adler32(const BYTE* data, UINT64 size) {
+		UINT a = 1;
+		UINT b = 0;
+		while (size > 0) {
+			// The largest run that cannot overflow before the modulo.
+			const UINT64 run = size < 5552 ? size : 5552;
+			for (UINT64 i = 0; i < run; ++i) {
+				a += data[i];
+				b += a;
+			}
+			a %= 65521;
+			b %= 65521;
+			data += run;
+			size -= run;
+		}
+		return (b << 16) | a;
+	}
+}
+
+BOOL Inflate::DecompressRaw(const BYTE* src, UINT64 srcSize, BYTE* dst, UINT64 dstSize, UINT64& written) {
+	BitReader reader(src, srcSize);
+
+	Huffman literals;
+	Huffman distances;
+
+	UINT64 pos = 0;
+	BOOL last = FALSE;
+	while (!last) {
+		last = reader.Bits(1);
+		const UINT type = reader.Bits(2);
+
+		switch (type) {
+		case 0:
+			CheckReturn(InflateStored(reader, dst, dstSize, pos));
+			break;
+		case 1: {
+			BYTE lengths[LiteralCodeCount + DistanceCodeCount];
+			std::memset(lengths, 8, 144);
+			std::memset(lengths + 144, 9, 112);
+			std::memset(lengths + 256, 7, 24);
+			std::memset(lengths + 280, 8, 8);
+			std::memset(lengths + LiteralCodeCount, 5, DistanceCodeCount);
+
+			literals.Build(lengths, LiteralCodeCount);
+			distances.Build(lengths + LiteralCodeCount, DistanceCodeCount);
+			CheckReturn(InflateCodes(reader, literals, distances, dst, dstSize, pos));
+			break;
+		}
+		case 2:
+			CheckReturn(ReadDynamicCodes(reader, literals, distances));
+			CheckReturn(InflateCodes(reader, literals, distances, dst, dstSize, pos));
+			break;
+		default:
+			ReturnFalse(L"Invalid DEFLATE block type");
+		}
+
+		if (reader.Overrun()) ReturnFalse(L"DEFLATE stream is truncated");
+	}
+
+	written = pos;
+
+	return TRUE;
+}
+
+BOOL Inflate::Decompress(const BYTE* src, UINT64 srcSize, BYTE* dst, UINT64 dstSize, UINT64& written) {
+	if (srcSize < 6) ReturnFalse(L"zlib stream is truncated");
+
+	const UINT cmf = src[0];
+	const UINT flg = src[1];
+	if ((cmf & 0x0F) != 8 || (cmf >> 4) > 7 || ((cmf << 8) | flg) % 31 != 0) ReturnFalse(L"Invalid zlib header");
+	if (flg & 0x20) ReturnFalse(L"zlib preset dictionaries are not supported");
+
+	CheckReturn(DecompressRaw(src + 2, srcSize - 6, dst, dstSize, written));
+
+	const BYTE* trailer = src + srcSize - 4;
+	const UINT expected = (static_cast<UINT>(trailer[0]) << 24) | (trailer[1] << 16) | (trailer[2] << 8) | trailer[3];
+	if (Adler32(dst, written) != expected) ReturnFalse(L"zlib checksum mismatch");
+
+	return TRUE;
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "Common/Util/MappedFile.h"
+#include "Common/Debug/Logger.h"
+
+MappedFile::~MappedFile() {
+	Close();
+}
+
+BOOL MappedFile::Open(const std::string& path) {
+	Close();
+
+	mFile = CreateFileA(
+		path.c_str(),
+		GENERIC_READ,
+		FILE_SHARE_READ,
+		NULL,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+		NULL);
+	if (mFile == INVALID_HANDLE_VALUE) ReturnFalse(L"Failed to open the file: " << path.c_str());
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(mFile, &size)) {
+		Close();
+		ReturnFalse(L"Failed to get the file size: " << path.c_str());
+	}
+
+	mSize = static_cast<UINT64>(size.QuadPart);
+
+	// Empty files cannot be mapped; they are exposed as a null view of size zero.
+	if (mSize == 0) return TRUE;
+
+	mMapping = CreateFileMappingA(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mMapping == NULL) {
+		Close();
+		ReturnFalse(L"Failed to create the file mapping: " << path.c_str());
+	}
+
+	mData = reinterpret_cast<const BYTE*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+	if (mData == nullptr) {
+		Close();
+		ReturnFalse(L"Failed to map the file: " << path.c_str());
+	}
+
+	return TRUE;
+}
+
+void MappedFile::Close() {
+	if (mData != nullptr) {
+		UnmapViewOfFile(mData);
+		mData = nullptr;
+	}
+	if (mMapping != NULL) {
+		CloseHandle(mMapping);
+		mMapping = NULL;
+	}
+	if (mFile != INVALID_HANDLE_VALUE) {
+		CloseHandle(mFile);
+		mFile = INVALID_HANDLE_VALUE;
+	}
+
+	mSize = 0;
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include "Common/Util/TexelUtil.h"
+#include "Common/Debug/Logger.h"
+#include "Common/Util/TaskQueue.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+#undef max
+#undef min
+
+BOOL TexelUtil::ForEachBand(
+		UINT rows,
+		UINT64 rowTexels,
+		UINT64 texelsPerTask,
+		UINT64 numThreads,
+		const std::function<BOOL(UINT, UINT)>& body) {
+	const UINT bandRows = static_cast<UINT>(std::max<UINT64>(texelsPerTask / std::max<UINT64>(rowTexels, 1), 1));
+	const UINT bandCount = (rows + bandRows - 1) / bandRows;
+
+	if (numThreads > 1 && bandCount > 1) {
+		TaskQueue taskQueue;
+		for (UINT band = 0; band < bandCount; ++band) {
+			taskQueue.AddTask([&body, band, bandRows, rows] {
+				return body(band * bandRows, std::min((band + 1) * bandRows, rows)) != FALSE;
+			});
+		}
+
+		CheckReturn(taskQueue.Run(std::min<UINT64>(numThreads, bandCount)));
+	}
+	else {
+		CheckReturn(body(0, rows));
+	}
+
+	return TRUE;
+}
+
+FLOAT TexelUtil::RadicalInverse(UINT bits) {
+	bits = (bits << 16u) | (bits >> 16u);
+	bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+	bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+	bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+	bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+	return static_cast<FLOAT>(bits) * 2.3283064365386963e-10f;
+}
+
+XMVECTOR TexelUtil::Bilinear(const Level& level, FLOAT u, FLOAT v) {
+	const FLOAT fx = u * level.Width - 0.5f;
+	const FLOAT fy = std::min(std::max(v * level.Height - 0.5f, 0.f), static_cast<FLOAT>(level.Height - 1));
+
+	const FLOAT x0f = std::floor(fx);
+	const FLOAT y0f = std::floor(fy);
+	const FLOAT tx = fx - x0f;
+	const FLOAT ty = fy - y0f;
+
+	const INT width = static_cast<INT>(level.Width);
+	const UINT x0 = static_cast<UINT>(((static_cast<INT>(x0f) % width) + width) % width);
+	const UINT x1 = (x0 + 1) % level.Width;
+	const UINT y0 = static_cast<UINT>(y0f);
+	const UINT y1 = std::min(y0 + 1, level.Height - 1);
+
+	const XMFLOAT4* row0 = level.Texels + static_cast<size_t>(y0) * level.Width;
+	const XMFLOAT4* row1 = level.Texels + static_cast<size_t>(y1) * level.Width;
+
+	const XMVECTOR top = XMVectorLerp(XMLoadFloat4(&row0[x0]), XMLoadFloat4(&row0[x1]), tx);
+	const XMVECTOR bottom = XMVectorLerp(XMLoadFloat4(&row1[x0]), XMLoadFloat4(&row1[x1]), tx);
+	return XMVectorLerp(top, bottom, ty);
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "Common/Util/WorkerPool.h"
+#include "Common/Debug/Logger.h"
+
+WorkerPool::~WorkerPool() {
+	CleanUp();
+}
+
+BOOL WorkerPool::Initialize(UINT numWorkers) {
+	if (!mWorkers.empty()) ReturnFalse(L"Worker pool is already initialized");
+
+	bStopping = FALSE;
+	for (UINT i = 0; i < numWorkers; ++i)
+		mWorkers.emplace_back(&WorkerPool::WorkerLoop, this);
+
+	return TRUE;
+}
+
+void WorkerPool::CleanUp() {
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		bStopping = TRUE;
+	}
+	mWakeUp.notify_all();
+
+	for (auto& worker : mWorkers) worker.join();
+	mWorkers.clear();
+}
+
+BOOL WorkerPool::Run(UINT taskCount, const std::function<BOOL(UINT)>& task) {
+	if (mWorkers.empty() || taskCount < 2) {
+		for (UINT i = 0; i < taskCount; ++i) CheckReturn(task(i));
+		return TRUE;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mTask = &task;
+		mTaskCount = taskCount;
+		mNextTask = 0;
+		mStatus = TRUE;
+		mBusyWorkers = static_cast<UINT>(mWorkers.size());
+		++mGeneration;
+	}
+	mWakeUp.notify_all();
+
+	ExecuteTasks();
+
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mDone.wait(lock, [this] { return mBusyWorkers == 0; });
+		mTask = nullptr;
+	}
+
+	return mStatus;
+}
+
+void WorkerPool::WorkerLoop() {
+	UINT64 generation = 0;
+
+	while (TRUE) {
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWakeUp.wait(lock, [&] { return bStopping || mGeneration != generation; });
+			if (bStopping) return;
+
+			generation = mGeneration;
+		}
+
+		ExecuteTasks();
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (--mBusyWorkers == 0) mDone.notify_one();
+		}
+	}
+}
+
+void WorkerPool::ExecuteTasks() {
+	while (TRUE) {
+		const UINT index = mNextTask.fetch_add(1);
+		if (index >= mTaskCount) break;
+
+		if (!(*mTask)(index)) mStatus = FALSE;
+	}
+}
\ No newline at end of file
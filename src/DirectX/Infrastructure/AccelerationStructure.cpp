@@ -19,8 +19,11 @@ BOOL AccelerationStructureBuffer::BuildBLAS(
 	geometryDesc.Triangles.VertexCount = static_cast<UINT>(geo->VertexBufferCPU->GetBufferSize() / sizeof(Vertex));
 	geometryDesc.Triangles.VertexBuffer.StartAddress = geo->VertexBufferGPU->GetGPUVirtualAddress();
 	geometryDesc.Triangles.VertexBuffer.StrideInBytes = sizeof(Vertex);
-	geometryDesc.Triangles.IndexFormat = DXGI_FORMAT_R32_UINT;
-	geometryDesc.Triangles.IndexCount = static_cast<UINT>(geo->IndexBufferCPU->GetBufferSize() / sizeof(UINT));
+	geometryDesc.Triangles.IndexFormat = geo->IndexFormat;
+	// Only the full-detail level goes into the BLAS; the hit shaders index triangles from the start of the buffer.
+	geometryDesc.Triangles.IndexCount = geo->Lods.empty() ?
+		static_cast<UINT>(geo->IndexBufferCPU->GetBufferSize() / (geo->IndexFormat == DXGI_FORMAT_R16_UINT ? sizeof(USHORT) : sizeof(UINT))) :
+		geo->Lods.front().IndexCount;
 	geometryDesc.Triangles.IndexBuffer = geo->IndexBufferGPU->GetGPUVirtualAddress();
 	geometryDesc.Triangles.Transform3x4 = 0;
 	// Mark the geometry as opaque. 
@@ -1,10 +1,13 @@
 #include "DirectX/Render/DxRenderer.h"
 #include "Common/Debug/Logger.h"
 #include "Common/Helper/MathHelper.h"
+#include "Common/Mesh/CookedMesh.h"
 #include "Common/Mesh/MeshImporter.h"
+#include "Common/Render/LodSelector.h"
 #include "Common/Util/HWInfo.h"
 #include "Common/Util/TaskQueue.h"
 #include "Common/Shading/ShaderArgument.h"
+#include "Common/Texture/DdsFile.h"
 #include "DirectX/Debug/Debug.h"
 #include "DirectX/Debug/ImGuiManager.h"
 #include "DirectX/Infrastructure/FrameResource.h"
@@ -52,12 +55,28 @@ namespace {
 	const std::wstring ShaderFilePath = L".\\..\\..\\assets\\shaders\\hlsl\\";
 
 	HWInfo::Processor ProcessorInfo;
+
+	const FLOAT ShadowCubeNearZ = 1.f;
+	const FLOAT ShadowCubeFarZ = 50.f;
+
+	// Every material a model subset draws with takes a constant buffer entry.
+	const UINT MaxMaterials = 128;
+
+	// Key of a material of a cooked mesh in the material map.
+	std::string MaterialName(const std::string& file, UINT index) {
+		return file + '#' + std::to_string(index);
+	}
 }
 
 DxRenderer::DxRenderer() {
 	mLocker = std::make_unique<Locker<ID3D12Device5>>();
 
 	mMainPassCB = std::make_unique<ConstantBuffer_Pass>();
+	mSceneTree = std::make_unique<DynamicAabbTree>();
+	mOcclusionCuller = std::make_unique<OcclusionCuller>();
+	mWorkerPool = std::make_unique<WorkerPool>();
+	mTextureRegistry = std::make_unique<TextureRegistry>();
+	mTextureStreamer = std::make_unique<TextureStreamer>(this);
 	mShaderManager = std::make_unique<ShaderManager>();
 	mImGui = std::make_unique<ImGuiManager>();
 	mBRDF = std::make_unique<BRDF::BRDFClass>();
@@ -122,6 +141,8 @@ BOOL DxRenderer::Initialize(HWND hwnd, void* const glfwWnd, UINT width, UINT hei
 
 	CheckReturn(LowInitialize(hwnd, width, height));
 	CheckReturn(HWInfo::GetProcessorInfo(ProcessorInfo));
+	// The calling thread is one of the pool's threads.
+	CheckReturn(mWorkerPool->Initialize(static_cast<UINT>(std::max<UINT64>(ProcessorInfo.Logical, 1) - 1)));
 
 	auto device = md3dDevice.Get();
 	mGraphicsMemory = std::make_unique<GraphicsMemory>(device);
@@ -234,10 +255,12 @@ BOOL DxRenderer::Initialize(HWND hwnd, void* const glfwWnd, UINT width, UINT hei
 void DxRenderer::CleanUp() {
 	if (!bInitialized) return;
 
+	SubmitStreamingUploads();
 	FlushCommandQueue();
 	
 	mImGui->CleanUp();
 	mShaderManager->CleanUp();
+	mWorkerPool->CleanUp();
 	LowCleanUp();
 
 	bIsCleanedUp = TRUE;
@@ -274,6 +297,9 @@ BOOL DxRenderer::Update(FLOAT delta) {
 	}
 
 	CheckReturn(UpdateCB_Main(delta));
+	CheckReturn(CullRenderItems());
+	SelectLods();
+	CheckReturn(StreamTextures());
 	CheckReturn(UpdateCB_Blur(delta));
 	CheckReturn(UpdateCB_DoF(delta));
 	CheckReturn(UpdateCB_Objects(delta));
@@ -387,6 +413,12 @@ void DxRenderer::UpdateModel(void* const model, const Transform& trans) {
 		)
 	);
 	ptr->NumFramesDirty = gNumFrameResources << 1;
+
+	if (ptr->ProxyId != DynamicAabbTree::NullNode) {
+		BoundingBox worldBox;
+		ptr->AABB.Transform(worldBox, XMLoadFloat4x4(&ptr->World));
+		mSceneTree->MoveProxy(ptr->ProxyId, worldBox);
+	}
 }
 
 void DxRenderer::SetModelVisibility(void* const model, BOOL visible) {
@@ -402,6 +434,69 @@ void DxRenderer::SetModelPickable(void* const model, BOOL pickable) {
 	if (iter != end) iter->get()->Pickable = pickable;
 }
 
+void DxRenderer::SetModelOccluder(void* const model, BOOL occluder) {
+	auto begin = mRitems.begin();
+	auto end = mRitems.end();
+	const auto& iter = std::find_if(begin, end, [&](std::unique_ptr<RenderItem>& p) {
+		return p.get() == model;
+	});
+	if (iter == end) return;
+
+	auto ritem = iter->get();
+	auto geo = ritem->Geometry;
+
+	if (occluder && geo->OccluderMeshIndex == -1) {
+		const UINT indexStride = geo->IndexFormat == DXGI_FORMAT_R16_UINT ? sizeof(USHORT) : sizeof(UINT);
+
+		// The finest level of detail within the triangle budget of the culler.
+		MeshLod lod = { 0, geo->IndexBufferByteSize / indexStride, 0.f };
+		for (const auto& level : geo->Lods) {
+			lod = level;
+			if (level.IndexCount / 3 <= OcclusionCuller::MaxOccluderTriangles) break;
+		}
+		if (lod.IndexCount / 3 > OcclusionCuller::MaxOccluderTriangles) {
+			WLogln(L"No level of detail of ", std::wstring(geo->Name.begin(), geo->Name.end()), L" is simple enough to be an occluder");
+			return;
+		}
+
+		// The culler takes 32-bit indices.
+		std::vector<UINT> indices;
+		const BYTE* const indexBytes = reinterpret_cast<const BYTE*>(geo->IndexBufferCPU->GetBufferPointer()) +
+			static_cast<size_t>(lod.StartIndexLocation) * indexStride;
+		const UINT* indexData = reinterpret_cast<const UINT*>(indexBytes);
+		if (indexStride == sizeof(USHORT)) {
+			const USHORT* const shortIndices = reinterpret_cast<const USHORT*>(indexBytes);
+			indices.assign(shortIndices, shortIndices + lod.IndexCount);
+			indexData = indices.data();
+		}
+
+		// A simplified level strays from the surface by up to its error. Pulling every vertex that far
+		// inwards along its normal keeps the occluder inside the mesh, so it never hides what the full
+		// detail would show.
+		const UINT vertexCount = geo->VertexBufferByteSize / geo->VertexByteStride;
+		const Vertex* const vertices = reinterpret_cast<const Vertex*>(geo->VertexBufferCPU->GetBufferPointer());
+
+		std::vector<XMFLOAT3> positions(vertexCount);
+		for (UINT i = 0; i < vertexCount; ++i) {
+			const XMVECTOR normal = XMVector3Normalize(XMLoadFloat3(&vertices[i].Normal));
+			XMStoreFloat3(&positions[i], XMVectorNegativeMultiplySubtract(normal, XMVectorReplicate(lod.Error), XMLoadFloat3(&vertices[i].Position)));
+		}
+
+		UINT meshIndex = 0;
+		if (!mOcclusionCuller->AddMesh(
+			positions.data(),
+			vertexCount,
+			sizeof(XMFLOAT3),
+			indexData,
+			lod.IndexCount,
+			meshIndex)) return;
+
+		geo->OccluderMeshIndex = static_cast<INT>(meshIndex);
+	}
+
+	ritem->Occluder = occluder;
+}
+
 BOOL DxRenderer::SetCubeMap(const std::string& file) {
 
 	return TRUE;
@@ -427,27 +522,40 @@ void DxRenderer::Pick(FLOAT x, FLOAT y) {
 	const auto V = XMLoadFloat4x4(&mCamera->View());
 	const auto InvView = XMMatrixInverse(&XMMatrixDeterminant(V), V);
 
-	FLOAT closestT = std::numeric_limits<FLOAT>().max();
-	for (auto ri : mRitemRefs[RenderType::E_Opaque]) {
-		if (!ri->Pickable) continue;
+	// Ray definition in world space for the scene tree traversal.
+	const auto originW = XMVector3TransformCoord(origin, InvView);
+	const auto dirW = XMVector3Normalize(XMVector3TransformNormal(dir, InvView));
+
+	mSceneTree->RayCast(originW, dirW, std::numeric_limits<FLOAT>().max(), [&](INT proxyId, FLOAT maxT) {
+		auto ri = reinterpret_cast<RenderItem*>(mSceneTree->UserData(proxyId));
+		if (!ri->Pickable) return maxT;
 
 		const auto W = XMLoadFloat4x4(&ri->World);
 		const auto InvWorld = XMMatrixInverse(&XMMatrixDeterminant(W), W);
 
-		// Transform ray to vi space of the mesh.
-		const auto ToLocal = XMMatrixMultiply(InvView, InvWorld);
-
-		const auto originL = XMVector3TransformCoord(origin, ToLocal);
-		auto dirL = XMVector3TransformNormal(dir, ToLocal);
+		// Transform ray to the local space of the mesh.
+		const auto originL = XMVector3TransformCoord(originW, InvWorld);
+		const auto dirL = XMVector3TransformNormal(dirW, InvWorld);
+		const FLOAT lengthL = XMVectorGetX(XMVector3Length(dirL));
 
 		// Make the ray direction unit length for the intersection tests.
-		dirL = XMVector3Normalize(dirL);
 		FLOAT tmin = 0.f;
-		if (ri->AABB.Intersects(originL, dirL, tmin) && tmin < closestT) {
-			closestT = tmin;
-			mPickedRitem = ri;
+		if (ri->Geometry->Bvh != nullptr && !ri->Geometry->Bvh->IsEmpty()) {
+			TriangleBvh::Hit hit;
+			if (!ri->Geometry->Bvh->RayCast(originL, dirL / lengthL, maxT * lengthL, hit)) return maxT;
+			tmin = hit.T;
 		}
-	}
+		else if (!ri->AABB.Intersects(originL, dirL / lengthL, tmin)) {
+			return maxT;
+		}
+
+		// Back to world-space distance so hits of differently scaled meshes are comparable.
+		const FLOAT t = tmin / lengthL;
+		if (t >= maxT) return maxT;
+
+		mPickedRitem = ri;
+		return t;
+	});
 }
 
 BOOL DxRenderer::CreateRtvAndDsvDescriptorHeaps() {
@@ -651,7 +759,7 @@ BOOL DxRenderer::BuildFrameResources() {
 			1, 
 			MaxLights,	// Shadows
 			32,			// Objects
-			32));		// Materials
+			MaxMaterials));
 		CheckReturn(mFrameResources.back()->Initialize());
 	}
 
@@ -829,51 +937,40 @@ void DxRenderer::BuildRenderItems() {
 }
 
 BOOL DxRenderer::AddGeometry(const std::string& file) {
-	Mesh mesh;
-	Material mat;
-	CheckReturn(MeshImporter::LoadObj(file, mesh, mat));
+	// The vertex stream is read from the mapped cooked file and the indices from their decoded copy. Both
+	// still pass through an upload heap, and the CPU copies kept for occluders and BLAS builds duplicate them.
+	CookedMesh cooked;
+	CheckReturn(MeshImporter::LoadCooked(file, cooked, ProcessorInfo.Logical));
+
+	std::vector<Material> materials;
+	CheckReturn(cooked.LoadMaterials(materials));
 
 	auto geo = std::make_unique<MeshGeometry>();
 	geo->Name = file;
 
-	const auto& vertices = mesh.Vertices;
-	const auto& indices = mesh.Indices;
+	const Vertex* const vertices = cooked.Vertices();
+	const BYTE* const indices = cooked.IndexData();
 
 	const size_t vertexSize = sizeof(Vertex);
 
-	const UINT vbByteSize = static_cast<UINT>(vertices.size() * vertexSize);
-	const UINT ibByteSize = static_cast<UINT>(indices.size() * sizeof(UINT));
-
-	const XMFLOAT3 vMinf3(+MathHelper::Infinity, +MathHelper::Infinity, +MathHelper::Infinity);
-	const XMFLOAT3 vMaxf3(-MathHelper::Infinity, -MathHelper::Infinity, -MathHelper::Infinity);
-
-	XMVECTOR vMin = XMLoadFloat3(&vMinf3);
-	XMVECTOR vMax = XMLoadFloat3(&vMaxf3);
-
-	for (size_t i = 0, end = vertices.size(); i < end; ++i) {
-		const XMVECTOR P = XMLoadFloat3(&vertices[i].Position);
+	const UINT vbByteSize = cooked.VertexBufferByteSize();
+	const UINT ibByteSize = cooked.IndexBufferByteSize();
 
-		vMin = XMVectorMin(vMin, P);
-		vMax = XMVectorMax(vMax, P);
-	}
-
-	BoundingBox bound;
-	XMStoreFloat3(&bound.Center, 0.5f * (vMax + vMin));
-	XMStoreFloat3(&bound.Extents, 0.5f * (vMax - vMin));
+	const BoundingBox bound = cooked.Bounds();
 
 	const auto cmdList = mCommandList.Get();
 	CheckHRESULT(cmdList->Reset(mDirectCmdListAlloc.Get(), nullptr));
 
 	CheckHRESULT(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
+	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices, vbByteSize);
 
 	CheckHRESULT(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);	
+	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices, ibByteSize);	
 
 	CheckReturn(D3D12Util::CreateDefaultBuffer(
 		md3dDevice.Get(),
 		cmdList,
-		vertices.data(),
+		vertices,
 		vbByteSize,
 		geo->VertexBufferUploader,
 		geo->VertexBufferGPU)
@@ -882,40 +979,85 @@ BOOL DxRenderer::AddGeometry(const std::string& file) {
 	CheckReturn(D3D12Util::CreateDefaultBuffer(
 		md3dDevice.Get(),
 		cmdList,
-		indices.data(),
+		indices,
 		ibByteSize,
 		geo->IndexBufferUploader,
 		geo->IndexBufferGPU)
 	);
 
+	// Depth-only passes read the quantized positions when the mesh was cooked with them.
+	if (cooked.PositionBufferByteSize() > 0) {
+		CheckReturn(D3D12Util::CreateDefaultBuffer(
+			md3dDevice.Get(),
+			cmdList,
+			cooked.Positions(),
+			cooked.PositionBufferByteSize(),
+			geo->PositionBufferUploader,
+			geo->PositionBufferGPU)
+		);
+
+		geo->PositionByteStride = VertexFormat::PositionOnly().Stride();
+		geo->PositionBufferByteSize = cooked.PositionBufferByteSize();
+		XMStoreFloat4x4(&geo->Dequantize, cooked.Quantization().DequantizeMatrix());
+	}
+
 	geo->VertexByteStride = static_cast<UINT>(vertexSize);
 	geo->VertexBufferByteSize = vbByteSize;
-	geo->IndexFormat = DXGI_FORMAT_R32_UINT;
+	geo->IndexFormat = cooked.IndexStride() == sizeof(USHORT) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
 	geo->IndexBufferByteSize = ibByteSize;
 	
+	geo->Lods.assign(cooked.Lods(), cooked.Lods() + cooked.LodCount());
+
 	SubmeshGeometry submesh;
-	submesh.IndexCount = static_cast<UINT>(indices.size());
+	submesh.IndexCount = geo->Lods.front().IndexCount;
 	submesh.StartIndexLocation = 0;
 	submesh.BaseVertexLocation = 0;
 	submesh.AABB = bound;
 
 	geo->DrawArgs["mesh"] = submesh;
 
+	const UINT subsetCount = cooked.SubmeshCount();
+	for (UINT l = 0, levels = cooked.LodCount(); l < levels; ++l) {
+		const auto submeshes = cooked.Submeshes(l);
+
+		for (UINT i = 0; i < subsetCount; ++i) {
+			SubmeshGeometry subset;
+			subset.IndexCount = submeshes[i].IndexCount;
+			subset.StartIndexLocation = submeshes[i].StartIndexLocation;
+			subset.BaseVertexLocation = submeshes[i].BaseVertexLocation;
+			subset.MaterialIndex = submeshes[i].MaterialIndex;
+			BoundingBox::CreateFromPoints(subset.AABB, XMLoadFloat3(&submeshes[i].BoundsMin), XMLoadFloat3(&submeshes[i].BoundsMax));
+
+			geo->Subsets.push_back(subset);
+		}
+	}
+	geo->SubsetCount = subsetCount;
+
+	geo->Bvh = std::make_unique<TriangleBvh>();
+	CheckReturn(cooked.LoadBvh(*geo->Bvh));
+
 	CheckReturn(AddBLAS(cmdList, geo.get()));
 
 	CheckHRESULT(cmdList->Close());
 	mCommandQueue->ExecuteCommandLists(1, reinterpret_cast<ID3D12CommandList* const*>(&cmdList));
 	CheckReturn(FlushCommandQueue());
 
-	mGeometries[file] = std::move(geo);
+	// Only the materials the subsets draw with get constant buffers and textures.
+	for (UINT i = 0; i < subsetCount; ++i) {
+		const UINT index = geo->Subsets[i].MaterialIndex;
+		const std::string name = MaterialName(file, index);
+		if (mMaterials.count(name) == 0) CheckReturn(AddMaterial(name, materials[index]));
+	}
 
-	if (mMaterials.count(file) == 0) CheckReturn(AddMaterial(file, mat));
+	mGeometries[file] = std::move(geo);
 
 	return TRUE;
 }
 
-BOOL DxRenderer::AddMaterial(const std::string& file, const Material& material) {
-	const UINT index = AddTexture(file, material);
+BOOL DxRenderer::AddMaterial(const std::string& name, const Material& material) {
+	if (mMaterials.size() >= MaxMaterials) ReturnFalse(L"Too many materials: " << name.c_str());
+
+	const UINT index = AddTexture(material);
 	if (index == -1) ReturnFalse("Failed to create texture");
 
 	auto matData = std::make_unique<MaterialData>();
@@ -925,8 +1067,9 @@ BOOL DxRenderer::AddMaterial(const std::string& file, const Material& material)
 	matData->Albedo = material.Albedo;
 	matData->Specular = material.Specular;
 	matData->Roughness = material.Roughness;
+	matData->AlphaTested = material.AlphaTested;
 
-	mMaterials[file] = std::move(matData);
+	mMaterials[name] = std::move(matData);
 
 	return TRUE;
 }
@@ -936,8 +1079,12 @@ void* DxRenderer::AddRenderItem(const std::string& file, const Transform& trans,
 
 	auto ritem = std::make_unique<RenderItem>();
 	ritem->ObjCBIndex = static_cast<INT>(mRitems.size());
-	ritem->Material = mMaterials[file].get();
 	ritem->Geometry = mGeometries[file].get();
+	for (UINT i = 0; i < ritem->Geometry->SubsetCount; ++i) {
+		const auto& subset = ritem->Geometry->Subsets[i];
+		ritem->Subsets.push_back({ subset.IndexCount, subset.StartIndexLocation, mMaterials[MaterialName(file, subset.MaterialIndex)].get() });
+	}
+	ritem->Material = ritem->Subsets.front().Material;
 	ritem->PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 	ritem->IndexCount = ritem->Geometry->DrawArgs["mesh"].IndexCount;
 	ritem->StartIndexLocation = ritem->Geometry->DrawArgs["mesh"].StartIndexLocation;
@@ -953,47 +1100,87 @@ void* DxRenderer::AddRenderItem(const std::string& file, const Transform& trans,
 		)
 	);
 
+	if (type == RenderType::E_Opaque) {
+		BoundingBox worldBox;
+		ritem->AABB.Transform(worldBox, XMLoadFloat4x4(&ritem->World));
+		ritem->ProxyId = mSceneTree->CreateProxy(worldBox, ritem.get());
+	}
+
 	mRitemRefs[type].push_back(ritem.get());
 	mRitems.push_back(std::move(ritem));
 
 	return mRitems.back().get();
 }
 
-UINT DxRenderer::AddTexture(const std::string& file, const Material& material) {
-	ID3D12GraphicsCommandList* cmdList = mCommandList.Get();
-	CheckHRESULT(cmdList->Reset(mDirectCmdListAlloc.Get(), nullptr));
+UINT DxRenderer::AddTexture(const Material& material) {
+	std::string filename = material.DiffuseMapFileName;
+
+	const auto index = filename.rfind('.');
+	filename = filename.replace(filename.begin() + index, filename.end(), ".dds");
+
+	UINT texture;
+	BOOL created;
+	if (!mTextureRegistry->Acquire(filename, mCurrDescriptorIndex, texture, created)) {
+		WLogln(L"Failed to create texture: ", std::wstring(filename.begin(), filename.end()));
+		return -1;
+	}
+
+	if (!created) {
+		WLogln(L"Sharing texture ", std::to_wstring(texture), L" for ", std::wstring(filename.begin(), filename.end()),
+			L" (", std::to_wstring(mTextureRegistry->Stats().SavedBytes >> 10), L" KB saved by deduplication)");
+		return texture;
+	}
 
 	auto texMap = std::make_unique<Texture>();
-	texMap->DescriptorIndex = mCurrDescriptorIndex;
+	texMap->DescriptorIndex = texture;
 
-	std::wstring filename;
-	filename.assign(material.DiffuseMapFileName.begin(), material.DiffuseMapFileName.end());
+	mTextures[texture] = std::move(texMap);
 
-	const auto index = filename.rfind(L'.');
-	filename = filename.replace(filename.begin() + index, filename.end(), L".dds");
+	// Only the mip tail is loaded here, uploaded with the next streaming batch; StreamTextures brings in
+	// the finer mips once the texture is seen.
+	if (!mTextureStreamer->AddTexture(texture, filename)) {
+		mTextures.erase(texture);
+		mTextureRegistry->Release(texture);
+		WLogln(L"Failed to create texture: ", std::wstring(filename.begin(), filename.end()));
+		return -1;
+	}
 
-	ResourceUploadBatch resourceUpload(md3dDevice.Get());
+	// A second descriptor lets streaming replace the texture while frames in flight still read the first.
+	mCurrDescriptorIndex += 2;
 
-	resourceUpload.Begin();
+	return texture;
+}
 
-	HRESULT status = DirectX::CreateDDSTextureFromFile(
-		md3dDevice.Get(),
-		resourceUpload,
-		filename.c_str(),
-		texMap->Resource.ReleaseAndGetAddressOf()
-	);
+BOOL DxRenderer::SetResidentMips(UINT texture, const DdsFile& source, UINT firstMip) {
+	const auto iter = mTextures.find(texture);
+	if (iter == mTextures.end()) ReturnFalse(L"Unknown streamed texture: " << texture);
 
-	auto finished = resourceUpload.End(mCommandQueue.Get());
-	finished.wait();
+	Texture* const texMap = iter->second.get();
+	if (texMap->Retired != nullptr) ReturnFalse(L"Texture " << texture << L" is still being replaced");
 
-	if (FAILED(status)) {
-		std::wstringstream wsstream;
-		wsstream << "Returned " << std::hex << status << "; when creating texture:  " << filename;
-		WLogln(wsstream.str());
-		return -1;
+	if (mStreamingUpload == nullptr) mStreamingUpload = std::make_unique<ResourceUploadBatch>(md3dDevice.Get());
+	if (!bStreamingUploadOpen) {
+		mStreamingUpload->Begin();
+		bStreamingUploadOpen = TRUE;
 	}
 
-	const auto& resource = texMap->Resource;
+	ComPtr<ID3D12Resource> resource;
+	if (!D3D12Util::CreateTexture(
+		md3dDevice.Get(),
+		*mStreamingUpload,
+		source,
+		resource.GetAddressOf(),
+		firstMip)) ReturnFalse(L"Failed to stream texture " << texture);
+
+	// The frames recorded so far still sample the current copy through its descriptor, so the new copy
+	// takes the other one and the current copy retires with the last of those frames.
+	UINT srvIndex = texMap->DescriptorIndex;
+	if (texMap->Resource != nullptr) {
+		if (texMap->SrvIndex == texMap->DescriptorIndex) ++srvIndex;
+
+		texMap->Retired = texMap->Resource;
+		texMap->RetireFence = GetCurrentFence();
+	}
 
 	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
@@ -1004,17 +1191,39 @@ UINT DxRenderer::AddTexture(const std::string& file, const Material& material) {
 	srvDesc.Format = resource->GetDesc().Format;
 
 	auto hDescriptor = mhCpuDescForTexMaps;
-	hDescriptor.Offset(texMap->DescriptorIndex, GetCbvSrvUavDescriptorSize());
+	hDescriptor.Offset(srvIndex, GetCbvSrvUavDescriptorSize());
 
 	md3dDevice->CreateShaderResourceView(resource.Get(), &srvDesc, hDescriptor);
 
-	CheckHRESULT(cmdList->Close());
-	mCommandQueue->ExecuteCommandLists(1, reinterpret_cast<ID3D12CommandList*const*>(&cmdList));
-	CheckReturn(FlushCommandQueue());
+	texMap->Resource = resource;
+	texMap->SrvIndex = srvIndex;
 
-	mTextures[file] = std::move(texMap);
+	return TRUE;
+}
 
-	return mCurrDescriptorIndex++;
+BOOL DxRenderer::IsReplacing(UINT texture) const {
+	const auto iter = mTextures.find(texture);
+	return iter != mTextures.end() && iter->second->Retired != nullptr;
+}
+
+void DxRenderer::ReleaseTexture(UINT texture) {
+	const auto iter = mTextures.find(texture);
+	if (iter == mTextures.end()) return;
+
+	// Textures are only removed with their models, so waiting for the frames that sample it is fine here.
+	SubmitStreamingUploads();
+	FlushCommandQueue();
+
+	mTextures.erase(iter);
+}
+
+BOOL DxRenderer::SubmitStreamingUploads() {
+	if (!bStreamingUploadOpen) return TRUE;
+	bStreamingUploadOpen = FALSE;
+
+	mStreamingUploads.push_back(mStreamingUpload->End(mCommandQueue.Get()));
+
+	return TRUE;
 }
 
 BOOL DxRenderer::UpdateShadingObjects(FLOAT delta) {
@@ -1027,7 +1236,6 @@ BOOL DxRenderer::UpdateShadingObjects(FLOAT delta) {
 		mCbvSrvUavHeap.Get(),
 		cmdList,
 		mEquirectangularConverter.get(),
-		mCurrFrameResource->CB_Pass.Resource()->GetGPUVirtualAddress(),
 		mCurrFrameResource->CB_Irradiance.Resource()->GetGPUVirtualAddress(),
 		mMipmapGenerator.get()
 	));
@@ -1098,7 +1306,7 @@ BOOL DxRenderer::UpdateCB_Main(FLOAT delta) {
 				XMStoreFloat3(&light.Position, lightPos);
 			}
 			else if (light.Type == LightType::E_Point || light.Type == LightType::E_Spot || light.Type == LightType::E_Tube) {
-				const auto proj = XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.f, 1.f, 50.f);
+				const auto proj = XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.f, ShadowCubeNearZ, ShadowCubeFarZ);
 				const auto pos = XMLoadFloat3(&light.Position);
 				
 				// Positive +X
@@ -1195,6 +1403,15 @@ BOOL DxRenderer::UpdateCB_Main(FLOAT delta) {
 		XMStoreFloat3(&mMainPassCB->EyePosW, mCamera->Position());
 		mMainPassCB->JitteredOffset = bTaaEnabled ? mFittedToBakcBufferHaltonSequence[offsetIndex] : XMFLOAT2(0.f, 0.f);
 
+		mMainPassCB->IrradianceSHEnabled = ShaderArgument::IrradianceMap::UseIrradianceSH && mIrradianceMap->IrradianceSHAvailable();
+		if (mMainPassCB->IrradianceSHEnabled) {
+			const auto& sh = mIrradianceMap->IrradianceSH();
+			for (UINT i = 0; i < SphericalHarmonics::CoefficientCount; ++i) {
+				const XMFLOAT3& c = sh.Coefficients[i];
+				mMainPassCB->IrradianceSH[i] = XMFLOAT4(c.x, c.y, c.z, 0.f);
+			}
+		}
+
 		auto& currCB = mCurrFrameResource->CB_Pass;
 		currCB.CopyData(0, *mMainPassCB);
 	}
@@ -1202,6 +1419,154 @@ BOOL DxRenderer::UpdateCB_Main(FLOAT delta) {
 	return TRUE;
 }
 
+BOOL DxRenderer::CullRenderItems() {
+	const XMMATRIX view = XMLoadFloat4x4(&mCamera->View());
+	const XMMATRIX proj = XMLoadFloat4x4(&mCamera->Proj());
+	const XMMATRIX viewProj = XMMatrixMultiply(view, proj);
+
+	// Camera
+	{
+		Culling::Frustum frustum;
+		Culling::ExtractFrustum(frustum, viewProj);
+
+		for (UINT type = 0; type < RenderType::Count; ++type) {
+			CheckReturn(Culling::CullRenderItems(frustum, mRitemRefs[type], mVisibleRitemRefs[type], mWorkerPool.get()));
+
+			// Both paths keep the input order, so any difference is a disagreement of the plane tests.
+			if (ShaderArgument::Debug::ValidateCulling) {
+				std::vector<RenderItem*> reference;
+				Culling::CullRenderItemsReference(frustum, mRitemRefs[type], reference);
+
+				if (reference != mVisibleRitemRefs[type]) {
+					WLogln(L"Batched culling kept ", std::to_wstring(mVisibleRitemRefs[type].size()),
+						L" items of render type ", std::to_wstring(type), L" but the reference kept ", std::to_wstring(reference.size()));
+				}
+			}
+		}
+	}
+	// Occlusion
+	{
+		auto& visibles = mVisibleRitemRefs[RenderType::E_Opaque];
+
+		mOcclusionCuller->BeginFrame(viewProj);
+		for (const auto ri : visibles) {
+			if (ri->Occluder) mOcclusionCuller->AddOccluder(ri->Geometry->OccluderMeshIndex, XMLoadFloat4x4(&ri->World));
+		}
+
+		if (mOcclusionCuller->OccluderCount() > 0) {
+			CheckReturn(mOcclusionCuller->Rasterize(mWorkerPool.get()));
+
+			std::vector<RenderItem*> unoccluded;
+			mOcclusionCuller->CullRenderItems(visibles, unoccluded);
+			visibles.swap(unoccluded);
+		}
+	}
+	// Lights
+	{
+		const auto& receivers = mVisibleRitemRefs[RenderType::E_Opaque];
+		const auto& opaques = mRitemRefs[RenderType::E_Opaque];
+
+		for (UINT i = 0; i < mLightCount; ++i) {
+			CheckReturn(Culling::CullShadowCasters(
+				mMainPassCB->Lights[i], 
+				ShadowCubeFarZ, 
+				receivers, 
+				opaques, 
+				mShadowCasters[i],
+				mWorkerPool.get()));
+		}
+	}
+
+	return TRUE;
+}
+
+void DxRenderer::SelectLods() {
+	const XMVECTOR eyePos = mCamera->Position();
+	const FLOAT projScaleY = mCamera->Proj()(1, 1);
+
+	const auto Select = [&](RenderItem* ri) {
+		const auto& lods = ri->Geometry->Lods;
+		if (lods.size() < 2) return;
+
+		const FLOAT scale = LodSelector::ProjectedScale(
+			ri->AABB, XMLoadFloat4x4(&ri->World), eyePos, projScaleY, mClientHeight, mCamera->NearZ());
+		const UINT lod = LodSelector::SelectLod(lods.data(), static_cast<UINT>(lods.size()), ri->LodIndex, scale);
+		if (lod == ri->LodIndex) return;
+
+		ri->LodIndex = lod;
+		ri->IndexCount = lods[lod].IndexCount;
+		ri->StartIndexLocation = lods[lod].StartIndexLocation;
+
+		const auto& geo = ri->Geometry;
+		for (size_t i = 0, end = ri->Subsets.size(); i < end; ++i) {
+			const auto& subset = geo->Subsets[lod * geo->SubsetCount + i];
+			ri->Subsets[i].IndexCount = subset.IndexCount;
+			ri->Subsets[i].StartIndexLocation = subset.StartIndexLocation;
+		}
+	};
+
+	for (UINT type = 0; type < RenderType::Count; ++type) {
+		for (const auto ri : mVisibleRitemRefs[type])
+			Select(ri);
+	}
+
+	// Casters outside the view are drawn into the shadow maps as well, so they are selected by their
+	// distance to the camera too. Selecting an item twice picks the same level.
+	for (UINT i = 0; i < mLightCount; ++i) {
+		for (const auto& view : mShadowCasters[i].Views) {
+			for (const auto ri : view)
+				Select(ri);
+		}
+	}
+}
+
+BOOL DxRenderer::StreamTextures() {
+	const XMVECTOR eyePos = mCamera->Position();
+	const FLOAT projScaleY = mCamera->Proj()(1, 1);
+
+	// Copies replaced by earlier frames are released once the GPU is past the frames that read them.
+	const UINT64 completed = mFence->GetCompletedValue();
+	for (const auto& pair : mTextures) {
+		const auto& texMap = pair.second;
+		if (texMap->Retired != nullptr && completed >= texMap->RetireFence) texMap->Retired = nullptr;
+	}
+
+	mStreamingUploads.erase(std::remove_if(mStreamingUploads.begin(), mStreamingUploads.end(), [](std::future<void>& upload) {
+		return upload.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}), mStreamingUploads.end());
+
+	for (UINT type = 0; type < RenderType::Count; ++type) {
+		for (const auto ri : mVisibleRitemRefs[type]) {
+			if (ri->Material == nullptr) continue;
+
+			// Texture coordinates are assumed to span the largest extent of the item once.
+			const FLOAT extent = std::max(std::max(ri->AABB.Extents.x, ri->AABB.Extents.y), ri->AABB.Extents.z);
+			if (extent <= 0.f) continue;
+
+			const FLOAT pixelsPerUnit = LodSelector::ProjectedScale(
+				ri->AABB, XMLoadFloat4x4(&ri->World), eyePos, projScaleY, mClientHeight, mCamera->NearZ());
+
+			const auto Request = [&](const MaterialData* mat) {
+				if (mat->DiffuseSrvHeapIndex >= 0)
+					mTextureStreamer->Request(static_cast<UINT>(mat->DiffuseSrvHeapIndex), 0.5f / extent, pixelsPerUnit);
+			};
+
+			if (ri->Subsets.empty()) {
+				Request(ri->Material);
+			}
+			else {
+				for (const auto& subset : ri->Subsets)
+					Request(subset.Material);
+			}
+		}
+	}
+
+	CheckReturn(mTextureStreamer->Update());
+	CheckReturn(SubmitStreamingUploads());
+
+	return TRUE;
+}
+
 BOOL DxRenderer::UpdateCB_SSAO(FLOAT delta) {
 	ConstantBuffer_SSAO ssaoCB;
 	ssaoCB.View = mMainPassCB->View;
@@ -1297,6 +1662,7 @@ BOOL DxRenderer::UpdateCB_Objects(FLOAT delta) {
 			objCB.PrevWorld = e->PrevWolrd;
 			XMStoreFloat4x4(&objCB.World, XMMatrixTranspose(world));
 			XMStoreFloat4x4(&objCB.TexTransform, XMMatrixTranspose(texTransform));
+			XMStoreFloat4x4(&objCB.QuantizedWorld, XMMatrixTranspose(XMMatrixMultiply(XMLoadFloat4x4(&e->Geometry->Dequantize), world)));
 			objCB.Center = { e->AABB.Center.x, e->AABB.Center.y, e->AABB.Center.z, 1.f };
 			objCB.Extents = { e->AABB.Extents.x, e->AABB.Extents.y, e->AABB.Extents.z, 0.f };
 
@@ -1324,7 +1690,9 @@ BOOL DxRenderer::UpdateCB_Materials(FLOAT delta) {
 			const XMMATRIX matTransform = XMLoadFloat4x4(&mat->MatTransform);
 
 			ConstantBuffer_Material matCB;
-			matCB.DiffuseSrvIndex = mat->DiffuseSrvHeapIndex;
+			// Streamed textures sample through the descriptor of their current copy.
+			const auto tex = mTextures.find(static_cast<UINT>(mat->DiffuseSrvHeapIndex));
+			matCB.DiffuseSrvIndex = tex == mTextures.end() ? mat->DiffuseSrvHeapIndex : static_cast<INT>(tex->second->SrvIndex);
 			matCB.Albedo = mat->Albedo;
 			matCB.Roughness = mat->Roughness;
 			matCB.Metalic = mat->Metailic;
@@ -1704,7 +2072,7 @@ BOOL DxRenderer::DrawShadow() {
 			D3D12Util::CalcConstantBufferByteSize(sizeof(ConstantBuffer_Material)),
 			mGBuffer->PositionMapSrv(),
 			mhGpuDescForTexMaps,
-			mRitemRefs[RenderType::E_Opaque],
+			mShadowCasters[i],
 			mZDepth->ZDepthMap(i),
 			mZDepth->FaceIDCubeMap(i),
 			mLights[i].Type,
@@ -1749,7 +2117,7 @@ BOOL DxRenderer::DrawGBuffer() {
 		D3D12Util::CalcConstantBufferByteSize(sizeof(ConstantBuffer_Object)),
 		D3D12Util::CalcConstantBufferByteSize(sizeof(ConstantBuffer_Material)),
 		mhGpuDescForTexMaps,
-		mRitemRefs[RenderType::E_Opaque],
+		mVisibleRitemRefs[RenderType::E_Opaque],
 		ShaderArgument::GBuffer::Dither::MaxDistance,
 		ShaderArgument::GBuffer::Dither::MinDistance
 	);
@@ -3088,6 +3456,7 @@ BOOL DxRenderer::DrawImGui() {
 			}
 
 			ImGui::Checkbox("Show Collision Box", reinterpret_cast<bool*>(&ShaderArgument::Debug::ShowCollisionBox));
+			ImGui::Checkbox("Validate Culling", reinterpret_cast<bool*>(&ShaderArgument::Debug::ValidateCulling));
 		}
 		if (ImGui::CollapsingHeader("Effects")) {
 			ImGui::Checkbox("TAA", reinterpret_cast<bool*>(&bTaaEnabled));
@@ -3118,6 +3487,7 @@ BOOL DxRenderer::DrawImGui() {
 
 		}
 		if (ImGui::CollapsingHeader("Environment")) {
+			ImGui::Checkbox("Spherical Harmonics Irradiance", reinterpret_cast<bool*>(&ShaderArgument::IrradianceMap::UseIrradianceSH));
 			ImGui::Checkbox("Show Irradiance CubeMap", reinterpret_cast<bool*>(&ShaderArgument::IrradianceMap::ShowIrradianceCubeMap));
 			if (ShaderArgument::IrradianceMap::ShowIrradianceCubeMap) {
 				ImGui::RadioButton(
@@ -461,11 +461,21 @@ void GBufferClass::DrawRenderItems(
 		const D3D12_GPU_VIRTUAL_ADDRESS currRitemObjCBAddress = cb_obj + static_cast<UINT64>(ri->ObjCBIndex) * static_cast<UINT64>(objCBByteSize);
 		cmdList->SetGraphicsRootConstantBufferView(RootSignature::Default::ECB_Obj, currRitemObjCBAddress);
 
-		if (ri->Material != nullptr) {
-			const D3D12_GPU_VIRTUAL_ADDRESS currRitemMatCBAddress = cb_mat + static_cast<UINT64>(ri->Material->MatCBIndex) * static_cast<UINT64>(matCBByteSize);
-			cmdList->SetGraphicsRootConstantBufferView(RootSignature::Default::ECB_Mat, currRitemMatCBAddress);
+		if (ri->Subsets.empty()) {
+			if (ri->Material != nullptr) {
+				const D3D12_GPU_VIRTUAL_ADDRESS currRitemMatCBAddress = cb_mat + static_cast<UINT64>(ri->Material->MatCBIndex) * static_cast<UINT64>(matCBByteSize);
+				cmdList->SetGraphicsRootConstantBufferView(RootSignature::Default::ECB_Mat, currRitemMatCBAddress);
+			}
+
+			cmdList->DrawIndexedInstanced(ri->IndexCount, 1, ri->StartIndexLocation, ri->BaseVertexLocation, 0);
+			continue;
 		}
 
-		cmdList->DrawIndexedInstanced(ri->IndexCount, 1, ri->StartIndexLocation, ri->BaseVertexLocation, 0);
+		for (const auto& subset : ri->Subsets) {
+			const D3D12_GPU_VIRTUAL_ADDRESS currSubsetMatCBAddress = cb_mat + static_cast<UINT64>(subset.Material->MatCBIndex) * static_cast<UINT64>(matCBByteSize);
+			cmdList->SetGraphicsRootConstantBufferView(RootSignature::Default::ECB_Mat, currSubsetMatCBAddress);
+
+			cmdList->DrawIndexedInstanced(subset.IndexCount, 1, subset.StartIndexLocation, ri->BaseVertexLocation, 0);
+		}
 	}
 }
\ No newline at end of file
@@ -1,16 +1,20 @@
 #include "DirectX/Shading/IrradianceMap.h"
 #include "Common/Debug/Logger.h"
+#include "Common/Light/EnvironmentCook.h"
 #include "Common/Mesh/Vertex.h"
 #include "Common/Render/RenderItem.h"
+#include "Common/Texture/DdsFile.h"
+#include "Common/Texture/HdrDecoder.h"
 #include "DirectX/Infrastructure/GpuResource.h"
 #include "DirectX/Util/D3D12Util.h"
 #include "DirectX/Util/ShaderManager.h"
 #include "DirectX/Util/EquirectangularConverter.h"
 #include "DxMesh.h"
-#include "DDSTextureLoader.h"
 #include "ResourceUploadBatch.h"
 
+#include <filesystem>
 #include <string>
+#include <thread>
 #include <ddraw.h>
 #include <DirectX/DDS.h>
 #include <ScreenGrab/ScreenGrab12.h>
@@ -23,25 +27,10 @@ namespace {
 	const CHAR* const GS_ConvoluteDiffuseIrradiance = "GS_ConvoluteDiffuseIrradiance";
 	const CHAR* const PS_ConvoluteDiffuseIrradiance = "PS_ConvoluteDiffuseIrradiance";
 
-	const CHAR* const VS_ConvoluteSpecularIrradiance = "VS_ConvoluteSpecularIrradiance";
-	const CHAR* const GS_ConvoluteSpecularIrradiance = "GS_ConvoluteSpecularIrradiance";
-	const CHAR* const PS_ConvoluteSpecularIrradiance = "PS_ConvoluteSpecularIrradiance";
-
-	const CHAR* const VS_IntegrateBRDF = "VS_IntegrateBRDF";
-	const CHAR* const PS_IntegrateBRDF = "PS_IntegrateBRDF";
-
 	const CHAR* const VS_SkySphere = "VS_SkySphere";
 	const CHAR* const PS_SkySphere = "PS_SkySphere";
 
 	const std::wstring GenDiffuseIrradianceCubeMap = L"./../../assets/textures/gen_diffuse_irradiance_cubemap.dds";
-	const std::wstring GenPrefilteredEnvironmentCubeMaps[5] = {
-		L"./../../assets/textures/gen_prefiltered_environment_cubemap_ml0.dds",
-		L"./../../assets/textures/gen_prefiltered_environment_cubemap_ml1.dds",
-		L"./../../assets/textures/gen_prefiltered_environment_cubemap_ml2.dds",
-		L"./../../assets/textures/gen_prefiltered_environment_cubemap_ml3.dds",
-		L"./../../assets/textures/gen_prefiltered_environment_cubemap_ml4.dds"
-	};
-	const std::wstring GenIntegratedBrdfMap = L"./../../assets/textures/gen_integrated_brdf_map.dds";
 	const std::wstring GenEnvironmentCubeMap = L"./../../assets/textures/gen_environment_cubemap.dds";
 }
 
@@ -51,7 +40,10 @@ namespace {
 	const UINT EquirectangularMapWidth = 4096;
 	const UINT EquirectangularMapHeight = 2048;
 
-	const UINT IntegratedBrdfMapSize = 1024;
+	static_assert(MaxMipLevel == EnvironmentCook::PrefilteredMipLevels, "The cook step bakes every mip of the prefiltered environment");
+
+	// Size of the placeholder until the baked LUT is loaded.
+	const UINT IntegratedBrdfMapSize = 1;
 }
 
 IrradianceMapClass::IrradianceMapClass() {
@@ -95,22 +87,6 @@ BOOL IrradianceMapClass::CompileShaders(const std::wstring& filePath) {
 		CheckReturn(mShaderManager->CompileShader(gsInfo, GS_ConvoluteDiffuseIrradiance));
 		CheckReturn(mShaderManager->CompileShader(psInfo, PS_ConvoluteDiffuseIrradiance));
 	}
-	{
-		const std::wstring actualPath = filePath + L"ConvoluteSpecularIrradiance.hlsl";
-		const auto vsInfo = D3D12ShaderInfo(actualPath.c_str(), L"VS", L"vs_6_3");
-		const auto gsInfo = D3D12ShaderInfo(actualPath.c_str(), L"GS", L"gs_6_3");
-		const auto psInfo = D3D12ShaderInfo(actualPath.c_str(), L"PS", L"ps_6_3");
-		CheckReturn(mShaderManager->CompileShader(vsInfo, VS_ConvoluteSpecularIrradiance));
-		CheckReturn(mShaderManager->CompileShader(gsInfo, GS_ConvoluteSpecularIrradiance));
-		CheckReturn(mShaderManager->CompileShader(psInfo, PS_ConvoluteSpecularIrradiance));
-	}
-	{
-		const std::wstring actualPath = filePath + L"IntegrateBRDF.hlsl";
-		const auto vsInfo = D3D12ShaderInfo(actualPath.c_str(), L"VS", L"vs_6_3");
-		const auto psInfo = D3D12ShaderInfo(actualPath.c_str(), L"PS", L"ps_6_3");
-		CheckReturn(mShaderManager->CompileShader(vsInfo, VS_IntegrateBRDF));
-		CheckReturn(mShaderManager->CompileShader(psInfo, PS_IntegrateBRDF));
-	}
 	{
 		const std::wstring actualPath = filePath + L"SkySphere.hlsl";
 		const auto vsInfo = D3D12ShaderInfo(actualPath.c_str(), L"VS", L"vs_6_3");
@@ -143,39 +119,6 @@ BOOL IrradianceMapClass::BuildRootSignature(const StaticSamplers& samplers) {
 		
 		builder.Enqueue(rootSigDesc, IID_PPV_ARGS(&mRootSignatures[RootSignature::E_ConvoluteDiffuseIrradiance]), L"Irradiance_RS_ConvoluteDiffuseIrradiance");
 	}
-	// ConvoluteSpecularIrradiance
-	{
-		CD3DX12_DESCRIPTOR_RANGE texTables[1] = {}; UINT index = 0;
-		texTables[index++].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0, 0);
-
-		index = 0;
-
-		CD3DX12_ROOT_PARAMETER slotRootParameter[RootSignature::ConvoluteSpecularIrradiance::Count] = {};
-		slotRootParameter[RootSignature::ConvoluteSpecularIrradiance::ECB_ConvEquirectToConv].InitAsConstantBufferView(0);
-		slotRootParameter[RootSignature::ConvoluteSpecularIrradiance::EC_Consts].InitAsConstants(RootConstant::ConvoluteSpecularIrradiance::Count, 1);
-		slotRootParameter[RootSignature::ConvoluteSpecularIrradiance::ESI_Environment].InitAsDescriptorTable(1, &texTables[index++]);
-
-		CD3DX12_ROOT_SIGNATURE_DESC rootSigDesc(
-			_countof(slotRootParameter), slotRootParameter,
-			static_cast<UINT>(samplers.size()), samplers.data(),
-			D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT
-		);
-		
-		builder.Enqueue(rootSigDesc, IID_PPV_ARGS(&mRootSignatures[RootSignature::E_ConvolutePrefilteredIrradiance]), L"Irradiance_RS_ConvolutePrefilteredIrradiance");
-	}
-	// IntegrateBRDF
-	{
-		CD3DX12_ROOT_PARAMETER slotRootParameter[RootSignature::IntegrateBRDF::Count] = {};
-		slotRootParameter[RootSignature::IntegrateBRDF::ECB_Pass].InitAsConstantBufferView(0);
-
-		CD3DX12_ROOT_SIGNATURE_DESC rootSigDesc(
-			_countof(slotRootParameter), slotRootParameter,
-			static_cast<UINT>(samplers.size()), samplers.data(),
-			D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT
-		);
-		
-		builder.Enqueue(rootSigDesc, IID_PPV_ARGS(&mRootSignatures[RootSignature::E_IntegrateBRDF]), L"Irradiance_RS_IntegrateBRDF");
-	}
 	// DrawSkySphere
 	{
 		CD3DX12_DESCRIPTOR_RANGE texTables[1] = {}; UINT index = 0;
@@ -211,7 +154,7 @@ BOOL IrradianceMapClass::BuildPSO() {
 	D3D12_INPUT_LAYOUT_DESC inputLayoutDesc = { nullptr, 0 };
 
 	D3D12Util::Descriptor::PipelineState::Builder builder;
-	// ConvoluteDiffuseIrradiance & ConvoluteSpecularIrradiance
+	// ConvoluteDiffuseIrradiance
 	{
 		D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = D3D12Util::DefaultPsoDesc(inputLayoutDesc, DXGI_FORMAT_UNKNOWN);
 		{
@@ -231,34 +174,6 @@ BOOL IrradianceMapClass::BuildPSO() {
 			
 			builder.Enqueue(psoDesc, IID_PPV_ARGS(&mPSOs[PipelineState::EG_ConvoluteDiffuseIrradiance]), L"Irradiance_GPS_ConvoluteDiffuseIrradiance");
 		}
-		{
-			psoDesc.pRootSignature = mRootSignatures[RootSignature::E_ConvolutePrefilteredIrradiance].Get();
-			{
-				const auto vs = mShaderManager->GetDxcShader(VS_ConvoluteSpecularIrradiance);
-				const auto gs = mShaderManager->GetDxcShader(GS_ConvoluteSpecularIrradiance);
-				const auto ps = mShaderManager->GetDxcShader(PS_ConvoluteSpecularIrradiance);
-				psoDesc.VS = { reinterpret_cast<BYTE*>(vs->GetBufferPointer()), vs->GetBufferSize() };
-				psoDesc.GS = { reinterpret_cast<BYTE*>(gs->GetBufferPointer()), gs->GetBufferSize() };
-				psoDesc.PS = { reinterpret_cast<BYTE*>(ps->GetBufferPointer()), ps->GetBufferSize() };
-			}
-
-			builder.Enqueue(psoDesc, IID_PPV_ARGS(&mPSOs[PipelineState::EG_ConvolutePrefilteredIrradiance]), L"Irradiance_GPS_ConvolutePrefilteredIrradiance");
-		}
-	}
-	// IntegrateBRDF
-	{
-		D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = D3D12Util::QuadPsoDesc();
-		psoDesc.pRootSignature = mRootSignatures[RootSignature::E_IntegrateBRDF].Get();
-		{
-			const auto vs = mShaderManager->GetDxcShader(VS_IntegrateBRDF);
-			const auto ps = mShaderManager->GetDxcShader(PS_IntegrateBRDF);
-			psoDesc.VS = { reinterpret_cast<BYTE*>(vs->GetBufferPointer()), vs->GetBufferSize() };
-			psoDesc.PS = { reinterpret_cast<BYTE*>(ps->GetBufferPointer()), ps->GetBufferSize() };
-		}
-		psoDesc.NumRenderTargets = 1;
-		psoDesc.RTVFormats[0] = IntegratedBrdfMapFormat;
-
-		builder.Enqueue(psoDesc, IID_PPV_ARGS(&mPSOs[PipelineState::EG_IntegrateBRDF]), L"Irradiance_GPS_");
 	}
 	// DrawSkySphere
 	{
@@ -322,7 +237,6 @@ void IrradianceMapClass::AllocateDescriptors(
 	}
 	
 	mhDiffuseIrradianceEquirectMapCpuRtv = hCpuRtv.Offset(1, rtvDescSize);
-	mhIntegratedBrdfMapCpuRtv = hCpuRtv.Offset(1, rtvDescSize);
 
 	for (UINT mipLevel = 0; mipLevel < MaxMipLevel; ++mipLevel) {
 		mhEnvironmentCubeMapCpuRtvs[mipLevel] = hCpuRtv.Offset(1, rtvDescSize);
@@ -431,12 +345,6 @@ BOOL IrradianceMapClass::BuildDescriptors() {
 		for (UINT i = 0; i < MaxMipLevel; ++i) {
 			builder.Enqueue(mPrefilteredEnvironmentEquirectMaps[i]->Resource(), rtvDesc, mhPrefilteredEnvironmentEquirectMapCpuRtvs[i]);
 		}
-		{
-			rtvDesc.Format = IntegratedBrdfMapFormat;
-			rtvDesc.Texture2D.MipSlice = 0;
-
-			builder.Enqueue(mIntegratedBrdfMap->Resource(), rtvDesc, mhIntegratedBrdfMapCpuRtv);
-		}
 	}
 
 	{
@@ -452,11 +360,31 @@ BOOL IrradianceMapClass::BuildDescriptors() {
 BOOL IrradianceMapClass::SetEquirectangularMap(ID3D12CommandQueue* const queue, const std::string& file) {
 	auto tex = std::make_unique<Texture>();
 
-	std::wstring filename;
-	filename.assign(file.begin(), file.end());
+	std::string filename = file;
+
+	const auto index = filename.rfind('.');
+	filename = filename.replace(filename.begin() + index, filename.end(), ".dds");
+
+	// Radiance and OpenEXR sources are cooked into the DDS next to them whenever they change.
+	if (HdrDecoder::IsHdrSource(file) && std::filesystem::exists(file)) {
+		const std::string manifest = file.substr(0, index) + ".manifest";
+		HdrDecoder::Settings settings;
 
-	const auto index = filename.rfind(L'.');
-	filename = filename.replace(filename.begin() + index, filename.end(), L".dds");
+		if (!HdrDecoder::IsCookCurrent(file, manifest, settings))
+			CheckReturn(HdrDecoder::Cook(file, filename, manifest, settings, std::thread::hardware_concurrency()));
+	}
+
+	DdsFile dds;
+	if (!dds.Open(filename)) ReturnFalse(L"Failed to create texture: " << filename.c_str());
+
+	// The SH projection runs on the CPU from the mapped file and replaces the irradiance cube map
+	// in shading; the map itself is still rendered for the sky and the debug views.
+	SphericalHarmonics::SH9 radiance;
+	bIrradianceSHAvailable = SphericalHarmonics::ProjectEnvironment(dds, radiance);
+	if (bIrradianceSHAvailable)
+		SphericalHarmonics::ConvolveIrradiance(radiance, SphericalHarmonics::DefaultWindowWidth, mIrradianceSH);
+	else
+		WLogln(L"Falling back to the irradiance cube map: ", std::wstring(filename.begin(), filename.end()));
 
 	{
 		ID3D12Device5* device;
@@ -466,39 +394,39 @@ BOOL IrradianceMapClass::SetEquirectangularMap(ID3D12CommandQueue* const queue,
 
 		resourceUpload.Begin();
 
-		const HRESULT status = DirectX::CreateDDSTextureFromFile(
+		const BOOL status = D3D12Util::CreateTexture(
 			device,
 			resourceUpload,
-			filename.c_str(),
+			dds,
 			tex->Resource.ReleaseAndGetAddressOf()
 		);
 
 		auto finished = resourceUpload.End(queue);
 		finished.wait();
 
-		if (FAILED(status)) {
-			std::wstringstream wsstream;
-			wsstream << "Returned " << std::hex << status << "; when creating texture:  " << filename;
-			WLogln(wsstream.str());
-			return FALSE;
-		}
+		if (!status) ReturnFalse(L"Failed to create texture: " << filename.c_str());
 	}
 
 	mTemporaryEquirectangularMap->Swap(tex->Resource, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 	mTemporaryEquirectangularMap->Resource()->SetName(L"Irradiance_TemporaryEquirectangularMap");
 
+	mEquirectangularMapPath = filename;
+
 	bNeedToUpdate = TRUE;
 
 	return TRUE;
 }
 
+void IrradianceMapClass::SetBrdfLutSettings(const BrdfLut::Settings& settings) {
+	mBrdfLutSettings = settings;
+}
+
 BOOL IrradianceMapClass::Update(
 		ID3D12Device5* const device,
 		ID3D12CommandQueue* const queue,
 		ID3D12DescriptorHeap* const descHeap,
 		ID3D12GraphicsCommandList* const cmdList,
 		EquirectangularConverter::EquirectangularConverterClass* converter,
-		D3D12_GPU_VIRTUAL_ADDRESS cbPass,
 		D3D12_GPU_VIRTUAL_ADDRESS cbConvEquirectToCube,
 		MipmapGenerator::MipmapGeneratorClass* const generator) {
 	if (mNeedToSave & Save::E_DiffuseIrradiance) {
@@ -508,23 +436,6 @@ BOOL IrradianceMapClass::Update(
 
 		WLogln(L"Saved diffuse irradiance cubemap.");
 	}
-	if (mNeedToSave & Save::E_IntegratedBRDF) {
-		Save(queue, mIntegratedBrdfMap.get(), GenIntegratedBrdfMap);
-
-		mNeedToSave = static_cast<Save::Type>(mNeedToSave & ~Save::E_IntegratedBRDF);
-
-		WLogln(L"Saved integrated BRDF map.");
-	}
-	for (UINT i = 0; i < MaxMipLevel; ++i) {
-		Save::Type type = static_cast<Save::Type>(Save::E_PrefilteredL0 << i);
-		if (mNeedToSave & type) {
-			Save(queue, mPrefilteredEnvironmentEquirectMaps[i].get(), GenPrefilteredEnvironmentCubeMaps[i]);
-
-			mNeedToSave = static_cast<Save::Type>(mNeedToSave & ~type);
-
-			WLogln(L"Saved prefiltered environment cubemap mip-level: ", std::to_wstring(i), L".");
-		}
-	}
 
 	if (!bNeedToUpdate) return TRUE;
 
@@ -615,91 +526,61 @@ BOOL IrradianceMapClass::Update(
 		}
 	}
 	{
-		const BOOL exists = Check(GenIntegratedBrdfMap);
-		if (exists) {
-			WLogln(L"Pre-generated integrated BRDF map detected. Loading it...");
+		// Only the cook step bakes the LUT; a stale one is still loaded and a missing one fails to load.
+		if (!BrdfLut::IsBakeCurrent(EnvironmentCook::IntegratedBrdfManifestPath, mBrdfLutSettings))
+			WLogln(L"Integrated BRDF map is missing or was baked with other settings. Run the game with -cook to bake it again.");
 
-			Load(
-				device,
-				queue,
-				mIntegratedBrdfMap.get(),
-				mhIntegratedBrdfMapCpuSrv,
-				GenIntegratedBrdfMap,
-				L"IntegratedBrdfMap");
-		}
-		else {
-			WLogln(L"Pre-generated integrated BRDF map doesn't detected. Generating new one..."); \
+		WLogln(L"Loading integrated BRDF map...");
 
-				GenerateIntegratedBrdf(
-				cmdList,
-				cbPass
-			);
+		const std::string path = EnvironmentCook::IntegratedBrdfMapPath;
 
-			mNeedToSave = static_cast<Save::Type>(mNeedToSave | Save::E_IntegratedBRDF);
-		}
+		CheckReturn(Load(
+			device,
+			queue,
+			mIntegratedBrdfMap.get(),
+			mhIntegratedBrdfMapCpuSrv,
+			std::wstring(path.begin(), path.end()),
+			L"IntegratedBrdfMap"));
 	}
 	{
-		BOOL defected = FALSE;
+		EnvironmentPrefilter::Settings settings;
+		settings.Width = EquirectangularMapWidth;
+		settings.Height = EquirectangularMapHeight;
+		settings.MipLevels = MaxMipLevel;
+
+		// The maps are only baked by the cook step. Stale ones are still loaded, so the scene keeps its
+		// lighting until the environment is cooked again, and missing ones fail to load.
+		if (!EnvironmentPrefilter::IsBakeCurrent(mEquirectangularMapPath, EnvironmentCook::PrefilteredEnvironmentManifestPath, settings))
+			WLogln(L"Prefiltered environment is missing or was baked from another source. Run the game with -cook to bake it again.");
+
+		WLogln(L"Loading prefiltered environment...");
+
 		for (UINT mipLevel = 0; mipLevel < MaxMipLevel; ++mipLevel) {
-			const BOOL exists = Check(GenPrefilteredEnvironmentCubeMaps[mipLevel]);
-			if (!exists) {
-				mNeedToSave = static_cast<Save::Type>(mNeedToSave | (Save::E_PrefilteredL0 << mipLevel));
-				defected = TRUE;
-			}
-		}
+			std::wstring name = L"PrefilteredEnvironmentEquirectMap_";
+			name.append(std::to_wstring(mipLevel));
 
-		if (defected) {			
-			WLogln(L"Pre-generated prefiltered environment cubemap doesn't detected. Generating new one...");
+			const UINT size = static_cast<UINT>(CubeMapSize / std::pow(2.0f, mipLevel));
 
-			GeneratePrefilteredEnvironment(cmdList, cbConvEquirectToCube);
+			const D3D12_VIEWPORT viewport = { 0.f, 0.f, static_cast<FLOAT>(size), static_cast<FLOAT>(size), 0.f, 1.f };
+			const D3D12_RECT rect = { 0, 0, static_cast<INT>(size), static_cast<INT>(size) };
 
-			for (UINT mipLevel = 0; mipLevel < MaxMipLevel; ++mipLevel) {
-				if (mNeedToSave & (Save::E_PrefilteredL0 << mipLevel)) {
-					const UINT width = static_cast<UINT>(EquirectangularMapWidth / std::pow(2.0f, mipLevel));
-					const UINT height = static_cast<UINT>(EquirectangularMapHeight / std::pow(2.0f, mipLevel));
-
-					const D3D12_VIEWPORT viewport = { 0.f, 0.f, static_cast<FLOAT>(width), static_cast<FLOAT>(height), 0.f, 1.f };
-					const D3D12_RECT rect = { 0, 0, static_cast<INT>(width), static_cast<INT>(height) };
-
-					converter->ConvertCubeToEquirectangular(
-						cmdList,
-						viewport,
-						rect,
-						mPrefilteredEnvironmentEquirectMaps[mipLevel].get(),
-						mhPrefilteredEnvironmentEquirectMapCpuRtvs[mipLevel],
-						mhPrefilteredEnvironmentCubeMapGpuSrv,
-						mipLevel);
-				}
-			}
-		}
-		else {
-			WLogln(L"Pre-generated prefiltered environment cubemap detected. Loading it...");
+			const std::string path = EnvironmentCook::PrefilteredEnvironmentPaths[mipLevel];
 
-			for (UINT mipLevel = 0; mipLevel < MaxMipLevel; ++mipLevel) {
-				std::wstring name = L"PrefilteredEnvironmentEquirectMap_";
-				name.append(std::to_wstring(mipLevel));
-
-				const UINT size = static_cast<UINT>(CubeMapSize / std::pow(2.0f, mipLevel));
-
-				const D3D12_VIEWPORT viewport = { 0.f, 0.f, static_cast<FLOAT>(size), static_cast<FLOAT>(size), 0.f, 1.f };
-				const D3D12_RECT rect = { 0, 0, static_cast<INT>(size), static_cast<INT>(size) };
-
-				Load(
-					device,
-					queue,
-					mPrefilteredEnvironmentEquirectMaps[mipLevel].get(),
-					mhPrefilteredEnvironmentEquirectMapCpuSrvs[mipLevel],
-					GenPrefilteredEnvironmentCubeMaps[mipLevel],
-					name.c_str());
-				converter->ConvertEquirectangularToCube(
-					cmdList,
-					viewport,
-					rect,
-					mPrefilteredEnvironmentCubeMap.get(),
-					cbConvEquirectToCube,
-					mhPrefilteredEnvironmentEquirectMapGpuSrvs[mipLevel],
-					mhPrefilteredEnvironmentCubeMapCpuRtvs[mipLevel]);
-			}
+			CheckReturn(Load(
+				device,
+				queue,
+				mPrefilteredEnvironmentEquirectMaps[mipLevel].get(),
+				mhPrefilteredEnvironmentEquirectMapCpuSrvs[mipLevel],
+				std::wstring(path.begin(), path.end()),
+				name.c_str()));
+			converter->ConvertEquirectangularToCube(
+				cmdList,
+				viewport,
+				rect,
+				mPrefilteredEnvironmentCubeMap.get(),
+				cbConvEquirectToCube,
+				mhPrefilteredEnvironmentEquirectMapGpuSrvs[mipLevel],
+				mhPrefilteredEnvironmentCubeMapCpuRtvs[mipLevel]);
 		}
 	}
 
@@ -915,26 +796,24 @@ BOOL IrradianceMapClass::Load(
 		LPCWSTR setname) {
 	auto tex = std::make_unique<Texture>();
 
+	DdsFile dds;
+	if (!dds.Open(std::string(filepath.begin(), filepath.end()))) ReturnFalse(L"Failed to create texture: " << filepath);
+
 	ResourceUploadBatch resourceUpload(device);
 
 	resourceUpload.Begin();
 
-	const HRESULT status = DirectX::CreateDDSTextureFromFile(
+	const BOOL status = D3D12Util::CreateTexture(
 		device,
 		resourceUpload,
-		filepath.c_str(),
+		dds,
 		tex->Resource.ReleaseAndGetAddressOf()
 	);
 
 	auto finished = resourceUpload.End(queue);
 	finished.wait();
 
-	if (FAILED(status)) {
-		std::wstringstream wsstream;
-		wsstream << "Returned " << std::hex << status << "; when creating texture:  " << filepath;
-		WLogln(wsstream.str());
-		return FALSE;
-	}
+	if (!status) ReturnFalse(L"Failed to create texture: " << filepath);
 
 	auto& resource = tex->Resource;
 	tex->Resource->SetName(setname);
@@ -988,72 +867,4 @@ void IrradianceMapClass::GenerateDiffuseIrradiance(
 	cmdList->DrawInstanced(36, 1, 0, 0);
 
 	mDiffuseIrradianceCubeMap->Transite(cmdList, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-}
-
-void IrradianceMapClass::GeneratePrefilteredEnvironment(
-		ID3D12GraphicsCommandList* const cmdList,
-		D3D12_GPU_VIRTUAL_ADDRESS cbConvEquirectToCube) {	
-	cmdList->SetPipelineState(mPSOs[PipelineState::EG_ConvolutePrefilteredIrradiance].Get());
-	cmdList->SetGraphicsRootSignature(mRootSignatures[RootSignature::E_ConvolutePrefilteredIrradiance].Get());
-
-	cmdList->SetGraphicsRootConstantBufferView(
-		RootSignature::ConvoluteSpecularIrradiance::ECB_ConvEquirectToConv, cbConvEquirectToCube);
-	cmdList->SetGraphicsRootDescriptorTable(
-		RootSignature::ConvoluteSpecularIrradiance::ESI_Environment, mhEnvironmentCubeMapGpuSrv);
-	
-	mPrefilteredEnvironmentCubeMap->Transite(cmdList, D3D12_RESOURCE_STATE_RENDER_TARGET);
-
-	for (UINT mipLevel = 0; mipLevel < IrradianceMap::MaxMipLevel; ++mipLevel) {
-		UINT size = static_cast<UINT>(CubeMapSize / std::pow(2.0, mipLevel));
-
-		D3D12_VIEWPORT viewport = { 0.0f, 0.0f, static_cast<FLOAT>(size), static_cast<FLOAT>(size), 0.0f, 1.0f };
-		D3D12_RECT rect = { 0, 0, static_cast<INT>(size), static_cast<INT>(size) };
-
-		cmdList->RSSetViewports(1, &viewport);
-		cmdList->RSSetScissorRects(1, &rect);
-
-		RootConstant::ConvoluteSpecularIrradiance::Struct rc;
-		rc.gMipLevel = mipLevel;
-		rc.gResolution = CubeMapSize;
-		rc.gRoughness = 0.16667f * static_cast<FLOAT>(mipLevel);
-
-		std::array<std::uint32_t, RootConstant::ConvoluteSpecularIrradiance::Count> consts;
-		std::memcpy(consts.data(), &rc, sizeof(RootConstant::ConvoluteSpecularIrradiance::Struct));
-
-		cmdList->SetComputeRoot32BitConstants(
-			RootSignature::ConvoluteSpecularIrradiance::EC_Consts, RootConstant::ConvoluteSpecularIrradiance::Count, consts.data(), 0);
-
-		cmdList->OMSetRenderTargets(1, &mhPrefilteredEnvironmentCubeMapCpuRtvs[mipLevel], TRUE, nullptr);
-
-		cmdList->IASetVertexBuffers(0, 0, nullptr);
-		cmdList->IASetIndexBuffer(nullptr);
-		cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-		cmdList->DrawInstanced(36, 1, 0, 0);
-	}
-
-	mPrefilteredEnvironmentCubeMap->Transite(cmdList, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-}
-
-void IrradianceMapClass::GenerateIntegratedBrdf(
-		ID3D12GraphicsCommandList* const cmdList,
-		D3D12_GPU_VIRTUAL_ADDRESS cbPass) {
-	cmdList->SetPipelineState(mPSOs[PipelineState::EG_IntegrateBRDF].Get());
-	cmdList->SetGraphicsRootSignature(mRootSignatures[RootSignature::E_IntegrateBRDF].Get());
-
-	cmdList->RSSetViewports(1, &mCubeMapViewport);
-	cmdList->RSSetScissorRects(1, &mCubeMapScissorRect);
-
-	mIntegratedBrdfMap->Transite(cmdList, D3D12_RESOURCE_STATE_RENDER_TARGET);
-
-	cmdList->OMSetRenderTargets(1, &mhIntegratedBrdfMapCpuRtv, TRUE, nullptr);
-
-	cmdList->SetGraphicsRootConstantBufferView(
-		RootSignature::IntegrateBRDF::ECB_Pass, cbPass);
-
-	cmdList->IASetVertexBuffers(0, 0, nullptr);
-	cmdList->IASetIndexBuffer(nullptr);
-	cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	cmdList->DrawInstanced(6, 1, 0, 0);
-
-	mIntegratedBrdfMap->Transite(cmdList, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
\ No newline at end of file
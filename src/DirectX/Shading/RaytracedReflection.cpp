@@ -117,6 +117,7 @@ BOOL RaytracedReflectionClass::BuildRootSignatures(const StaticSamplers& sampler
 		slotRootParameter[RootSignature::Local::ECB_Mat].InitAsConstantBufferView(1, 1);
 		slotRootParameter[RootSignature::Local::ESB_Vertices].InitAsShaderResourceView(0, 1);
 		slotRootParameter[RootSignature::Local::ESB_Indices].InitAsShaderResourceView(1, 1);
+		slotRootParameter[RootSignature::Local::EC_Consts].InitAsConstants(RootSignature::Local::RootConstantsLayout::Count, 2, 1);
 
 		CD3DX12_ROOT_SIGNATURE_DESC globalRootSignatureDesc(
 			_countof(slotRootParameter), slotRootParameter,
@@ -259,6 +260,7 @@ BOOL RaytracedReflectionClass::BuildShaderTables(
 					rootArgs.CB_Material = cb_mat + static_cast<UINT64>(ritem->Material->MatCBIndex) * static_cast<UINT64>(matCBByteSize);
 					rootArgs.SB_Vertices = ritem->Geometry->VertexBufferGPU->GetGPUVirtualAddress();
 					rootArgs.AB_Indices = ritem->Geometry->IndexBufferGPU->GetGPUVirtualAddress();
+					rootArgs.IndexStride = ritem->Geometry->IndexFormat == DXGI_FORMAT_R16_UINT ? sizeof(USHORT) : sizeof(UINT);
 
 					ShaderRecord hitGroupShaderRecord = ShaderRecord(shaderId, shaderIdentifierSize, &rootArgs, sizeof(rootArgs));
 
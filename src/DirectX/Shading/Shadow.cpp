@@ -1,6 +1,7 @@
 #include "DirectX/Shading/Shadow.h"
 #include "Common/Debug/Logger.h"
 #include "Common/Mesh/Vertex.h"
+#include "Common/Mesh/VertexFormat.h"
 #include "Common/Render/RenderItem.h"
 #include "DirectX/Util/D3D12Util.h"
 #include "DirectX/Util/ShaderManager.h"
@@ -11,10 +12,15 @@ using namespace Shadow;
 
 namespace {
 	const CHAR* const VS_ZDepth = "VS_ZDepth";
+	const CHAR* const VS_ZDepthQuantized = "VS_ZDepthQuantized";
 	const CHAR* const GS_ZDepth = "GS_ZDepth";
 	const CHAR* const PS_ZDepth = "PS_ZDepth";
+	const CHAR* const PS_ZDepthAlphaTested = "PS_ZDepthAlphaTested";
 
 	const CHAR* const CS_Shadow = "CS_Shadow";
+
+	// Outlives the pipeline state descriptions that point into its input layout.
+	const VertexFormat PositionFormat = VertexFormat::PositionOnly();
 }
 
 ShadowClass::ShadowClass() {
@@ -44,11 +50,20 @@ BOOL ShadowClass::CompileShaders(const std::wstring& filePath) {
 	{
 		const std::wstring actualPath = filePath + L"ZDepth.hlsl";
 		const auto vsInfo = D3D12ShaderInfo(actualPath.c_str(), L"VS", L"vs_6_3");
+		const auto vsQuantizedInfo = D3D12ShaderInfo(actualPath.c_str(), L"VS_Quantized", L"vs_6_3");
 		const auto gsInfo = D3D12ShaderInfo(actualPath.c_str(), L"GS", L"gs_6_3");
 		const auto psInfo = D3D12ShaderInfo(actualPath.c_str(), L"PS", L"ps_6_3");
 		CheckReturn(mShaderManager->CompileShader(vsInfo, VS_ZDepth));
+		CheckReturn(mShaderManager->CompileShader(vsQuantizedInfo, VS_ZDepthQuantized));
 		CheckReturn(mShaderManager->CompileShader(gsInfo, GS_ZDepth));
 		CheckReturn(mShaderManager->CompileShader(psInfo, PS_ZDepth));
+
+		DxcDefine defines[] = {
+			{ L"ALPHA_TEST", L"1" }
+		};
+
+		const auto psAlphaTestedInfo = D3D12ShaderInfo(actualPath.c_str(), L"PS", L"ps_6_3", defines, _countof(defines));
+		CheckReturn(mShaderManager->CompileShader(psAlphaTestedInfo, PS_ZDepthAlphaTested));
 	}
 	{
 		const std::wstring actualPath = filePath + L"ShadowCS.hlsl";
@@ -145,6 +160,23 @@ BOOL ShadowClass::BuildPSO() {
 		psoDesc.RasterizerState.DepthBiasClamp = 0.1f;
 
 		builder.Enqueue(psoDesc, IID_PPV_ARGS(&mPSOs[PipelineState::EG_ZDepth]), L"Shadow_GPS_ZDepth");
+
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC quantizedPsoDesc = psoDesc;
+		quantizedPsoDesc.InputLayout = PositionFormat.InputLayoutDesc();
+		{
+			const auto vs = mShaderManager->GetDxcShader(VS_ZDepthQuantized);
+			quantizedPsoDesc.VS = { reinterpret_cast<BYTE*>(vs->GetBufferPointer()), vs->GetBufferSize() };
+		}
+
+		builder.Enqueue(quantizedPsoDesc, IID_PPV_ARGS(&mPSOs[PipelineState::EG_ZDepthQuantized]), L"Shadow_GPS_ZDepthQuantized");
+
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC alphaTestedPsoDesc = psoDesc;
+		{
+			const auto ps = mShaderManager->GetDxcShader(PS_ZDepthAlphaTested);
+			alphaTestedPsoDesc.PS = { reinterpret_cast<BYTE*>(ps->GetBufferPointer()), ps->GetBufferSize() };
+		}
+
+		builder.Enqueue(alphaTestedPsoDesc, IID_PPV_ARGS(&mPSOs[PipelineState::EG_ZDepthAlphaTested]), L"Shadow_GPS_ZDepthAlphaTested");
 	}
 	// Draw shadow on compute shader
 	{
@@ -178,7 +210,7 @@ void ShadowClass::Run(
 		UINT matCBByteSize,
 		D3D12_GPU_DESCRIPTOR_HANDLE si_pos,
 		D3D12_GPU_DESCRIPTOR_HANDLE si_texMaps,
-		const std::vector<RenderItem*>& ritems,
+		const Culling::ShadowCasterLists& casters,
 		GpuResource* const dst_zdepth,
 		GpuResource* const dst_faceIDCube,
 		UINT lightType,
@@ -187,7 +219,7 @@ void ShadowClass::Run(
 
 	BOOL needCubemap = lightType == LightType::E_Point || lightType == LightType::E_Spot;
 
-	DrawZDepth(cmdList, cb_pass, cb_obj, cb_mat, objCBByteSize, matCBByteSize, si_texMaps, needCubemap, index, ritems);
+	DrawZDepth(cmdList, cb_pass, cb_obj, cb_mat, objCBByteSize, matCBByteSize, si_texMaps, needCubemap, index, casters);
 	CopyZDepth(cmdList, dst_zdepth, dst_faceIDCube, needCubemap);
 	DrawShadow(cmdList, cb_pass, si_pos, index);
 }
@@ -466,8 +498,7 @@ void ShadowClass::DrawZDepth(
 		UINT objCBByteSize, UINT matCBByteSize,
 		D3D12_GPU_DESCRIPTOR_HANDLE si_texMaps,
 		BOOL needCubemap, UINT index,
-		const std::vector<RenderItem*>& ritems) {
-	cmdList->SetPipelineState(mPSOs[PipelineState::EG_ZDepth].Get());
+		const Culling::ShadowCasterLists& casters) {
 	cmdList->SetGraphicsRootSignature(mRootSignatures[RootSignature::E_ZDepth].Get());
 
 	cmdList->RSSetViewports(1, &mViewport);
@@ -499,31 +530,77 @@ void ShadowClass::DrawZDepth(
 
 	cmdList->SetGraphicsRootConstantBufferView(RootSignature::ZDepth::ECB_Pass, cb_pass);
 
-	RootConstant::ZDepth::Struct rc;
-	rc.gLightIndex = index;
+	cmdList->SetGraphicsRootDescriptorTable(RootSignature::ZDepth::ESI_TexMaps, si_texMaps);
 
-	std::array<std::uint32_t, RootConstant::ZDepth::Count> consts;
-	std::memcpy(consts.data(), &rc, sizeof(RootConstant::ZDepth::Struct));
+	UINT boundPso = PipelineState::Count;
 
-	cmdList->SetGraphicsRoot32BitConstants(RootSignature::ZDepth::EC_Consts, RootConstant::ZDepth::Count, consts.data(), 0);
-	cmdList->SetGraphicsRootDescriptorTable(RootSignature::ZDepth::ESI_TexMaps, si_texMaps);
+	const UINT numFaces = needCubemap ? Culling::MaxShadowViews : 1;
+	for (UINT face = 0; face < numFaces; ++face) {
+		const auto& ritems = casters.Views[face];
+		// Faces without casters keep the cleared depth and cost no draws.
+		if (ritems.empty()) continue;
 
-	for (UINT i = 0; i < ritems.size(); ++i) {
-		auto& ri = ritems[i];
+		RootConstant::ZDepth::Struct rc;
+		rc.gLightIndex = index;
+		rc.gFaceIndex = face;
 
-		cmdList->IASetVertexBuffers(0, 1, &ri->Geometry->VertexBufferView());
-		cmdList->IASetIndexBuffer(&ri->Geometry->IndexBufferView());
-		cmdList->IASetPrimitiveTopology(ri->PrimitiveType);
+		std::array<std::uint32_t, RootConstant::ZDepth::Count> consts;
+		std::memcpy(consts.data(), &rc, sizeof(RootConstant::ZDepth::Struct));
 
-		D3D12_GPU_VIRTUAL_ADDRESS currRitemObjCBAddress = cb_obj + static_cast<UINT64>(ri->ObjCBIndex) * static_cast<UINT64>(objCBByteSize);
-		cmdList->SetGraphicsRootConstantBufferView(RootSignature::ZDepth::ECB_Obj, currRitemObjCBAddress);
+		cmdList->SetGraphicsRoot32BitConstants(RootSignature::ZDepth::EC_Consts, RootConstant::ZDepth::Count, consts.data(), 0);
 
-		if (ri->Material != nullptr) {
-			D3D12_GPU_VIRTUAL_ADDRESS currRitemMatCBAddress = cb_mat + static_cast<UINT64>(ri->Material->MatCBIndex) * static_cast<UINT64>(matCBByteSize);
-			cmdList->SetGraphicsRootConstantBufferView(RootSignature::ZDepth::ECB_Mat, currRitemMatCBAddress);
-		}
+		for (UINT i = 0; i < ritems.size(); ++i) {
+			auto& ri = ritems[i];
+
+			cmdList->IASetIndexBuffer(&ri->Geometry->IndexBufferView());
+			cmdList->IASetPrimitiveTopology(ri->PrimitiveType);
+
+			D3D12_GPU_VIRTUAL_ADDRESS currRitemObjCBAddress = cb_obj + static_cast<UINT64>(ri->ObjCBIndex) * static_cast<UINT64>(objCBByteSize);
+			cmdList->SetGraphicsRootConstantBufferView(RootSignature::ZDepth::ECB_Obj, currRitemObjCBAddress);
+
+			// Geometries cooked with a position-only stream draw from it, the others from the full vertices.
+			// Alpha-tested materials always take the full vertices, whose texture coordinates they sample.
+			const BOOL hasPositionStream = ri->Geometry->PositionBufferGPU != nullptr;
+			BOOL streamBound = FALSE;
+			BOOL boundQuantized = FALSE;
+
+			const auto BindMaterial = [&](const MaterialData* const mat) {
+				const BOOL alphaTested = mat != nullptr && mat->AlphaTested;
+				const BOOL quantized = hasPositionStream && !alphaTested;
+
+				const UINT pso = alphaTested ? PipelineState::EG_ZDepthAlphaTested :
+					quantized ? PipelineState::EG_ZDepthQuantized : PipelineState::EG_ZDepth;
+				if (pso != boundPso) {
+					cmdList->SetPipelineState(mPSOs[pso].Get());
+					boundPso = pso;
+				}
 
-		cmdList->DrawIndexedInstanced(ri->IndexCount, 1, ri->StartIndexLocation, ri->BaseVertexLocation, 0);
+				if (!streamBound || quantized != boundQuantized) {
+					const D3D12_VERTEX_BUFFER_VIEW vbv = quantized ? ri->Geometry->PositionBufferView() : ri->Geometry->VertexBufferView();
+					cmdList->IASetVertexBuffers(0, 1, &vbv);
+					streamBound = TRUE;
+					boundQuantized = quantized;
+				}
+
+				if (mat != nullptr) {
+					D3D12_GPU_VIRTUAL_ADDRESS currMatCBAddress = cb_mat + static_cast<UINT64>(mat->MatCBIndex) * static_cast<UINT64>(matCBByteSize);
+					cmdList->SetGraphicsRootConstantBufferView(RootSignature::ZDepth::ECB_Mat, currMatCBAddress);
+				}
+			};
+
+			if (ri->Subsets.empty()) {
+				BindMaterial(ri->Material);
+
+				cmdList->DrawIndexedInstanced(ri->IndexCount, 1, ri->StartIndexLocation, ri->BaseVertexLocation, 0);
+				continue;
+			}
+
+			for (const auto& subset : ri->Subsets) {
+				BindMaterial(subset.Material);
+
+				cmdList->DrawIndexedInstanced(subset.IndexCount, 1, subset.StartIndexLocation, ri->BaseVertexLocation, 0);
+			}
+		}
 	}
 
 	if (needCubemap) faceID->Transite(cmdList, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
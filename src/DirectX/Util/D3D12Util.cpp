@@ -1,6 +1,8 @@
 #include "DirectX/Util/D3D12Util.h"
 #include "Common/Debug/Logger.h"
 #include "DirectX/Infrastructure/GpuResource.h"
+#include "Common/Texture/DdsFile.h"
+#include "ResourceUploadBatch.h"
 
 #include <d3dcompiler.h>
 #include <fstream>
@@ -222,6 +224,65 @@ BOOL D3D12Util::CreateConstantBuffer(ID3D12Device* const device, ID3D12Resource*
 	return TRUE;
 }
 
+BOOL D3D12Util::CreateTexture(
+		ID3D12Device* const device,
+		DirectX::ResourceUploadBatch& resourceUpload,
+		const DdsFile& dds,
+		ID3D12Resource** resource,
+		UINT firstMip) {
+	const auto& desc = dds.Desc();
+	if (firstMip >= desc.MipLevels) ReturnFalse(L"First mip " << firstMip << L" is out of range");
+
+	const UINT width = TextureFormat::MipExtent(desc.Width, firstMip);
+	const UINT height = TextureFormat::MipExtent(desc.Height, firstMip);
+	const UINT depth = TextureFormat::MipExtent(desc.Depth, firstMip);
+	const UINT16 mipLevels = static_cast<UINT16>(desc.MipLevels - firstMip);
+
+	D3D12_RESOURCE_DESC rscDesc;
+	switch (desc.Dimension) {
+	case TextureDimension::E_Texture1D:
+		rscDesc = CD3DX12_RESOURCE_DESC::Tex1D(
+			desc.Format, width, static_cast<UINT16>(desc.ArraySize), mipLevels);
+		break;
+	case TextureDimension::E_Texture3D:
+		rscDesc = CD3DX12_RESOURCE_DESC::Tex3D(
+			desc.Format, width, height, static_cast<UINT16>(depth), mipLevels);
+		break;
+	default:
+		rscDesc = CD3DX12_RESOURCE_DESC::Tex2D(
+			desc.Format, width, height, static_cast<UINT16>(desc.ArraySize), mipLevels);
+		break;
+	}
+
+	CheckHRESULT(device->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+		D3D12_HEAP_FLAG_NONE,
+		&rscDesc,
+		D3D12_RESOURCE_STATE_COPY_DEST,
+		nullptr,
+		IID_PPV_ARGS(resource)));
+
+	// Subresources are ordered slice by slice with the mips of each slice inside.
+	std::vector<D3D12_SUBRESOURCE_DATA> data;
+	data.reserve(static_cast<size_t>(desc.ArraySize) * mipLevels);
+	for (UINT slice = 0; slice < desc.ArraySize; ++slice) {
+		for (UINT mip = firstMip; mip < desc.MipLevels; ++mip) {
+			const auto& subresource = dds.GetSubresource(mip, slice);
+
+			D3D12_SUBRESOURCE_DATA subresourceData;
+			subresourceData.pData = subresource.Data;
+			subresourceData.RowPitch = static_cast<LONG_PTR>(subresource.RowPitch);
+			subresourceData.SlicePitch = static_cast<LONG_PTR>(subresource.SlicePitch);
+			data.push_back(subresourceData);
+		}
+	}
+
+	resourceUpload.Upload(*resource, 0, data.data(), static_cast<UINT>(data.size()));
+	resourceUpload.Transition(*resource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+	return TRUE;
+}
+
 D3D12_CPU_DESCRIPTOR_HANDLE D3D12Util::GetCpuHandle(ID3D12DescriptorHeap* const descHeap, INT index, UINT descriptorSize) {
 	auto handle = CD3DX12_CPU_DESCRIPTOR_HANDLE(descHeap->GetCPUDescriptorHandleForHeapStart());
 	handle.Offset(index, descriptorSize);
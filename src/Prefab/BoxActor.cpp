@@ -16,6 +16,7 @@ BoxActor::~BoxActor() {}
 
 BOOL BoxActor::OnInitialzing() {
 	CheckReturn(mMeshComp->LoadMesh("box.obj"));
+	mMeshComp->SetOccluder(TRUE);
 
 	return TRUE;
 }
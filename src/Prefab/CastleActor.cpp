@@ -16,6 +16,7 @@ CastleActor::~CastleActor() {}
 
 BOOL CastleActor::OnInitialzing() {
 	CheckReturn(mMeshComp->LoadMesh("castle.obj"));
+	mMeshComp->SetOccluder(TRUE);
 
 	return TRUE;
 }
@@ -474,6 +474,26 @@ void VulkanHelper::CopyBufferToImage(
 	EndSingleTimeCommands(inDevice, inQueue, inCommandPool, commandBuffer);
 }
 
+void VulkanHelper::CopyBufferToImage(
+		const VkDevice& inDevice,
+		const VkQueue& inQueue,
+		const VkCommandPool& inCommandPool,
+		const VkBuffer& inBuffer,
+		const VkImage& inImage,
+		const std::vector<VkBufferImageCopy>& inRegions) {
+	VkCommandBuffer commandBuffer = BeginSingleTimeCommands(inDevice, inCommandPool);
+
+	vkCmdCopyBufferToImage(
+		commandBuffer,
+		inBuffer,
+		inImage,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		static_cast<UINT>(inRegions.size()),
+		inRegions.data());
+
+	EndSingleTimeCommands(inDevice, inQueue, inCommandPool, commandBuffer);
+}
+
 BOOL VulkanHelper::GenerateMipmaps(
 		const VkPhysicalDevice& inPhysicalDevice,
 		const VkDevice& inDevice,
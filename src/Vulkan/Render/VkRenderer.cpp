@@ -1,8 +1,10 @@
 #include "Vulkan/Render/VkRenderer.h"
 #include "Common/Debug/Logger.h"
+#include "Common/Texture/MipGenerator.h"
 #include "Vulkan/Helper/VulkanHelper.h"
 
 #include <fstream>
+#include <thread>
 #include <stb/stb_image.h>
 
 #undef min
@@ -218,6 +220,8 @@ void VkRenderer::SetModelVisibility(void* const model, BOOL visible) {
 
 void VkRenderer::SetModelPickable(void* const model, BOOL pickable) {}
 
+void VkRenderer::SetModelOccluder(void* const model, BOOL occluder) {}
+
 BOOL VkRenderer::SetCubeMap(const std::string& file) {
 	return TRUE;
 }
@@ -1265,8 +1269,11 @@ void VkRenderer::CleanUpSwapChain() {
 
 BOOL VkRenderer::AddGeometry(const std::string& file) {
 	Mesh mesh;
-	Material mat;
-	CheckReturn(MeshImporter::LoadObj(file, mesh, mat));
+	std::vector<Material> materials;
+	CheckReturn(MeshImporter::LoadObj(file, mesh, materials));
+
+	// The whole index buffer is drawn at once, so only the first subset's material is used.
+	const Material mat = materials.empty() ? Material() : materials.front();
 
 	std::unique_ptr<MeshData> meshData = std::make_unique<MeshData>();
 
@@ -1392,9 +1399,50 @@ void* VkRenderer::AddRenderItem(const std::string& file, const Transform& trans,
 }
 
 BOOL VkRenderer::CreateTextureImage(INT width, INT height, void* const data, MaterialData* mat) {
-	VkDeviceSize imageSize = width * height * 4;
-
-	mat->MipLevels = static_cast<UINT>(std::floor(std::log2(std::max(width, height)))) + 1;
+	DdsFile::Subresource source = {};
+	source.Data = reinterpret_cast<const BYTE*>(data);
+	source.Width = static_cast<UINT>(width);
+	source.Height = static_cast<UINT>(height);
+	source.Depth = 1;
+	source.RowCount = source.Height;
+	source.RowPitch = static_cast<UINT64>(width) * 4;
+	source.SlicePitch = source.RowPitch * height;
+
+	// The texels are stored as they are, but the mips are filtered as the sRGB colors they hold.
+	std::vector<BYTE> mipTexels;
+	std::vector<DdsFile::Subresource> mips;
+	CheckReturn(MipGenerator::Generate(
+		source,
+		DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,
+		MipGenerator::Settings(),
+		std::max(std::thread::hardware_concurrency(), 1u),
+		mipTexels,
+		mips));
+
+	mat->MipLevels = static_cast<UINT>(mips.size()) + 1;
+
+	const VkDeviceSize imageSize = source.SlicePitch + mipTexels.size();
+
+	std::vector<VkBufferImageCopy> regions(mat->MipLevels);
+	VkDeviceSize offset = 0;
+	for (UINT mip = 0; mip < mat->MipLevels; ++mip) {
+		const auto& subresource = mip == 0 ? source : mips[mip - 1];
+
+		VkBufferImageCopy& region = regions[mip];
+		region.bufferOffset = offset;
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = mip;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = { subresource.Width, subresource.Height, 1 };
+
+		offset += subresource.SlicePitch;
+	}
 
 	VkBuffer stagingBuffer;
 	VkDeviceMemory stagingBufferMemory;
@@ -1411,7 +1459,9 @@ BOOL VkRenderer::CreateTextureImage(INT width, INT height, void* const data, Mat
 
 	void* pData;
 	vkMapMemory(mDevice, stagingBufferMemory, 0, imageSize, 0, &pData);
-	std::memcpy(pData, data, static_cast<size_t>(imageSize));
+	std::memcpy(pData, data, static_cast<size_t>(source.SlicePitch));
+	if (!mipTexels.empty())
+		std::memcpy(reinterpret_cast<BYTE*>(pData) + source.SlicePitch, mipTexels.data(), mipTexels.size());
 	vkUnmapMemory(mDevice, stagingBufferMemory);
 
 	CheckReturn(VulkanHelper::CreateImage(
@@ -1423,7 +1473,7 @@ BOOL VkRenderer::CreateTextureImage(INT width, INT height, void* const data, Mat
 		VK_SAMPLE_COUNT_1_BIT,
 		ImageFormat,
 		VK_IMAGE_TILING_OPTIMAL,
-		VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
 		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 		mat->TextureImage,
 		mat->TextureImageMemory)
@@ -1444,19 +1494,17 @@ BOOL VkRenderer::CreateTextureImage(INT width, INT height, void* const data, Mat
 		mCommandPool,
 		stagingBuffer,
 		mat->TextureImage,
-		static_cast<UINT>(width),
-		static_cast<UINT>(height)
+		regions
 	);
-	VulkanHelper::GenerateMipmaps(
-		mPhysicalDevice,
+	CheckReturn(VulkanHelper::TransitionImageLayout(
 		mDevice,
 		mGraphicsQueue,
 		mCommandPool,
 		mat->TextureImage,
 		ImageFormat,
-		width,
-		height,
-		mat->MipLevels
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		mat->MipLevels)
 	);
 
 	vkDestroyBuffer(mDevice, stagingBuffer, nullptr);